@@ -0,0 +1,96 @@
+// bench/http_client_bench.cpp
+// Request latency against the local HTTPS stand-in: pooled keep-alive
+// connections vs a new connection per request with TLS session resumption vs a
+// new connection and full handshake per request. The server can add a simulated
+// round trip (a handshake costs two more), which is what a real broker API adds
+// on top of the CPU cost measured on loopback. The async modes issue all requests
+// at once through the async API with a per-host concurrency limit, as a bulk
+// quote or candle pull would.
+//
+//   http_client_bench [requests=200] [rtt_us=0]
+#include "http_client.h"
+#include "latency_histogram.h"
+#include "local_https_server.h"
+#include "logger.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <string>
+#include <vector>
+
+namespace {
+
+void bench(const char* mode, LocalHttpsServer& srv, std::size_t max_idle, bool resume, int requests) {
+    HTTPClient::Options o;
+    o.ca_file = srv.cert_file();
+    o.max_idle_per_host = max_idle;
+    o.tls_session_reuse = resume;
+    HTTPClient c(o);
+    const std::string url = srv.url() + "/ping";
+    c.get(url);                        // warm up: SSL context, DNS, first session
+
+    LatencyHistogram h;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < requests; ++i) {
+        const auto a = tsc_now();
+        const auto r = c.get(url);
+        h.record(tsc_now() - a);
+        if (r.status != 200) std::fprintf(stderr, "status %d\n", r.status);
+    }
+    const auto wall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    const auto s = h.summary();
+    const auto st = c.stats();
+    std::printf("%-8s requests=%d  p50=%.0fus p99=%.0fus max=%.0fus  wall=%.1fms connects=%llu resumed=%llu\n",
+                mode, requests, s.p50_ns / 1e3, s.p99_ns / 1e3, s.max_ns / 1e3, wall,
+                static_cast<unsigned long long>(st.connects), static_cast<unsigned long long>(st.resumed));
+}
+
+void bench_async(LocalHttpsServer& srv, std::size_t concurrency, int requests) {
+    HTTPClient::Options o;
+    o.ca_file = srv.cert_file();
+    o.max_concurrent_per_host = concurrency;
+    o.max_idle_per_host = concurrency;
+    HTTPClient c(o);
+    const std::string url = srv.url() + "/ping";
+    c.get_async(url).get();
+
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::future<HttpResponse>> fs;
+    fs.reserve(static_cast<std::size_t>(requests));
+    for (int i = 0; i < requests; ++i) fs.push_back(c.get_async(url));
+    for (auto& f : fs) {
+        if (f.get().status != 200) std::fprintf(stderr, "bad status\n");
+    }
+    const auto wall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    const auto st = c.stats();
+    std::printf("async x%-2zu requests=%d  wall=%.1fms  %.0f req/s connects=%llu\n", concurrency, requests, wall,
+                requests / (wall / 1e3), static_cast<unsigned long long>(st.connects));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int requests = argc > 1 ? std::atoi(argv[1]) : 200;
+    const int rtt_us = argc > 2 ? std::atoi(argv[2]) : 0;
+
+    Logger log("bench");
+    log.set_level(LogLevel::WARN);
+    LocalHttpsServer::Options so;
+    so.rtt = std::chrono::microseconds(rtt_us);
+    LocalHttpsServer srv(log, so);
+    srv.route("GET", "/ping", [](const LocalHttpsServer::Request&) {
+        LocalHttpsServer::Response r;
+        r.body = R"({"status":"ok"})";
+        return r;
+    });
+    if (!srv.start()) return 1;
+
+    bench("pooled", srv, 4, true, requests);
+    bench("resumed", srv, 0, true, requests);
+    bench("full", srv, 0, false, requests);
+    bench_async(srv, 1, requests);
+    bench_async(srv, 8, requests);
+    return 0;
+}
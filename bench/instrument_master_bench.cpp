@@ -0,0 +1,84 @@
+// bench/instrument_master_bench.cpp
+// Startup cost of the instrument master: parsing a synthetic scrip master (NSE
+// equities plus NFO options, the real file's shape) against loading the same day
+// from the mmap'd cache, then lookup latency by token and by symbol.
+//
+//   instrument_master_bench [records=150000]
+#include "instrument_master.h"
+#include "logger.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+double ms_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int n = argc > 1 ? std::atoi(argv[1]) : 150000;
+    std::string doc = "[";
+    std::vector<std::string> tokens, symbols;
+    for (int i = 0; i < n; ++i) {
+        const bool option = i % 5 != 0;
+        const std::string token = std::to_string(100000 + i);
+        const std::string symbol = option ? "NIFTY26DEC24" + std::to_string(20000 + i) + (i % 2 ? "CE" : "PE")
+                                          : "SYM" + std::to_string(i) + "-EQ";
+        if (i) doc += ',';
+        doc += R"({"token":")" + token + R"(","symbol":")" + symbol + R"(","name":")" + (option ? "NIFTY" : "SYM")
+             + R"(","expiry":")" + (option ? "26DEC2024" : "") + R"(","strike":")" + (option ? "2000000.000000" : "-1.000000")
+             + R"(","lotsize":")" + (option ? "25" : "1") + R"(","instrumenttype":")" + (option ? "OPTIDX" : "")
+             + R"(","exch_seg":")" + (option ? "NFO" : "NSE") + R"(","tick_size":"5.000000"})";
+        if (i % 97 == 0) {
+            tokens.push_back((option ? "NFO|" : "NSE|") + token);
+            symbols.push_back((option ? "NFO:" : "NSE:") + symbol);
+        }
+    }
+    doc += "]";
+
+    Logger log("instrument_master_bench");
+    log.set_level(LogLevel::WARN);
+    const std::string path = (std::filesystem::temp_directory_path() / "alpha-instrument-bench.bin").string();
+
+    InstrumentMaster parsed(log);
+    std::istringstream in(doc);
+    auto t0 = std::chrono::steady_clock::now();
+    if (!parsed.parse_json(in, "2024-12-02")) return 1;
+    const double parse_ms = ms_since(t0);
+    if (!parsed.save_cache(path)) return 1;
+
+    InstrumentMaster cached(log);
+    t0 = std::chrono::steady_clock::now();
+    if (!cached.load_cache(path, "2024-12-02")) return 1;
+    const double load_ms = ms_since(t0);
+
+    std::printf("%d instruments, json %.1f MB, image %.1f MB\n", n, doc.size() / 1e6,
+                cached.stats().image_bytes / 1e6);
+    std::printf("parse json    %8.1f ms\n", parse_ms);
+    std::printf("load cache    %8.2f ms  (%.0fx)\n", load_ms, parse_ms / load_ms);
+
+    const int rounds = 200;
+    std::size_t hits = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const auto& t : tokens) hits += cached.by_token(std::string_view(t).substr(0, 3), std::string_view(t).substr(4)).has_value();
+    }
+    const double token_ns = ms_since(t0) * 1e6 / (rounds * tokens.size());
+    t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const auto& s : symbols) hits += cached.find(s).has_value();
+    }
+    const double symbol_ns = ms_since(t0) * 1e6 / (rounds * symbols.size());
+    std::printf("by_token      %8.0f ns\n", token_ns);
+    std::printf("find(symbol)  %8.0f ns\n", symbol_ns);
+    std::filesystem::remove(path);
+    return hits == 2 * rounds * tokens.size() ? 0 : 1;
+}
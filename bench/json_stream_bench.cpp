@@ -0,0 +1,67 @@
+// bench/json_stream_bench.cpp
+// Instrument-master-shaped JSON (an array of flat string records): JsonStreamParser
+// fed in 64 KiB chunks vs nlohmann::json::parse of the whole text. Reports
+// throughput and the growth of peak RSS; the streaming pass runs first so its
+// peak is not hidden by the DOM's.
+//
+//   json_stream_bench [records=300000]
+#include "json_stream.h"
+
+#include <nlohmann/json.hpp>
+#include <sys/resource.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+long peak_rss_kb() {
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+struct CountRecords : JsonSaxHandler {
+    int depth = 0;
+    long records = 0;
+    std::size_t chars = 0;
+    bool start_object() override { ++depth; return true; }
+    bool end_object() override { if (--depth == 0) ++records; return true; }
+    bool string(std::string_view s) override { chars += s.size(); return true; }
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int n = argc > 1 ? std::atoi(argv[1]) : 300000;
+    std::string doc = "[";
+    for (int i = 0; i < n; ++i) {
+        if (i) doc += ',';
+        doc += R"({"token":")" + std::to_string(100000 + i) + R"(","symbol":"SYM)" + std::to_string(i)
+             + R"(-EQ","name":"SYMBOL NUMBER )" + std::to_string(i)
+             + R"(","expiry":"26DEC2024","strike":"-1.000000","lotsize":"1","instrumenttype":"OPTIDX","exch_seg":"NFO","tick_size":"5.000000"})";
+    }
+    doc += "]";
+    const double mb = static_cast<double>(doc.size()) / (1024.0 * 1024.0);
+    const auto secs = [](auto d) { return std::chrono::duration<double>(d).count(); };
+
+    long base = peak_rss_kb();
+    CountRecords h;
+    JsonStreamParser p(h);
+    auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t at = 0; at < doc.size(); at += 64 * 1024) p.feed(std::string_view(doc).substr(at, 64 * 1024));
+    const bool ok = p.finish();
+    double t = secs(std::chrono::steady_clock::now() - t0);
+    std::printf("stream    %.1f MB  %.3fs  %.0f MB/s  records=%ld ok=%d  peak RSS +%ld KB\n",
+                mb, t, mb / t, h.records, ok, peak_rss_kb() - base);
+
+    base = peak_rss_kb();
+    t0 = std::chrono::steady_clock::now();
+    const auto j = nlohmann::json::parse(doc);
+    t = secs(std::chrono::steady_clock::now() - t0);
+    std::printf("nlohmann  %.1f MB  %.3fs  %.0f MB/s  records=%zu       peak RSS +%ld KB\n",
+                mb, t, mb / t, j.size(), peak_rss_kb() - base);
+    return 0;
+}
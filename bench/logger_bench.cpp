@@ -0,0 +1,115 @@
+// bench/logger_bench.cpp
+// Caller-side cost of one log call: synchronous (format + lock + flush per line)
+// vs asynchronous (copy into the thread's ring) vs binary (site id + raw
+// arguments into the thread's ring, formatted offline by binlog_decode). Lines go to a file so the sink
+// is a real write(2). Calls come in bursts with a short pause in between (as log
+// traffic does); each burst is timed with the TSC and divided by its length, so
+// the clock reads do not dominate what is measured. With fewer cores than
+// logging threads + 1, the formatter's time slices land inside timed bursts.
+//
+//   logger_bench [calls=200000] [threads=1] [burst=100] [path=/tmp/alpha-logger-bench.log]
+#include "logger.h"
+#include "binary_log.h"
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void bench(const char* mode, bool async, int calls, int threads, int burst, const std::string& path) {
+    std::ofstream out(path, std::ios::trunc);
+    Logger log("bench", out);
+    if (async) {
+        Logger::AsyncOptions o;
+        o.ring_bytes = 1 << 20;
+        log.start_async(o);
+    }
+
+    std::vector<LatencyHistogram> hist(static_cast<std::size_t>(threads));
+    std::vector<std::string> lines;
+    for (int i = 0; i < burst; ++i) lines.push_back("tick token=26000 ltp=101.25 seq=" + std::to_string(i));
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> ws;
+    for (int t = 0; t < threads; ++t) {
+        ws.emplace_back([&, t] {
+            auto& h = hist[static_cast<std::size_t>(t)];
+            for (int done = 0; done < calls; done += burst) {
+                const auto a = tsc_now();
+                for (const auto& line : lines) log.info(line);
+                h.record((tsc_now() - a) / static_cast<std::uint64_t>(burst));
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        });
+    }
+    for (auto& w : ws) w.join();
+    const auto t1 = std::chrono::steady_clock::now();
+    log.stop_async();
+    const auto t2 = std::chrono::steady_clock::now();
+
+    LatencyHistogram all;
+    for (const auto& h : hist) all.merge_from(h);
+    const auto s = all.summary();
+    const auto ms = [](auto d) { return std::chrono::duration<double, std::milli>(d).count(); };
+    std::printf("%-6s threads=%d calls=%d  per call: p50=%.0fns p99=%.0fns max=%.0fns  wall=%.1fms drain=%.1fms dropped=%llu\n",
+                mode, threads, calls * threads, s.p50_ns, s.p99_ns, s.max_ns,
+                ms(t1 - t0), ms(t2 - t1), static_cast<unsigned long long>(log.dropped()));
+}
+
+void bench_binary(int calls, int threads, int burst, const std::string& path) {
+    Logger log("bench");
+    BinaryLogger bl(log, "bench");
+    BinaryLogger::Options o;
+    o.ring_bytes = 1 << 20;
+    bl.open(path, o);
+
+    std::vector<LatencyHistogram> hist(static_cast<std::size_t>(threads));
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> ws;
+    for (int t = 0; t < threads; ++t) {
+        ws.emplace_back([&, t] {
+            auto& h = hist[static_cast<std::size_t>(t)];
+            for (int done = 0; done < calls; done += burst) {
+                const auto a = tsc_now();
+                for (int i = 0; i < burst; ++i) {
+                    ALPHA_BINLOG(bl, LogLevel::INFO, "tick token={} ltp={} seq={}", 26000, 101.25, i);
+                }
+                h.record((tsc_now() - a) / static_cast<std::uint64_t>(burst));
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        });
+    }
+    for (auto& w : ws) w.join();
+    const auto t1 = std::chrono::steady_clock::now();
+    bl.close();
+    const auto t2 = std::chrono::steady_clock::now();
+
+    LatencyHistogram all;
+    for (const auto& h : hist) all.merge_from(h);
+    const auto s = all.summary();
+    const auto ms = [](auto d) { return std::chrono::duration<double, std::milli>(d).count(); };
+    std::printf("%-6s threads=%d calls=%d  per call: p50=%.0fns p99=%.0fns max=%.0fns  wall=%.1fms drain=%.1fms dropped=%llu bytes=%llu\n",
+                "binary", threads, calls * threads, s.p50_ns, s.p99_ns, s.max_ns,
+                ms(t1 - t0), ms(t2 - t1), static_cast<unsigned long long>(bl.stats().dropped),
+                static_cast<unsigned long long>(bl.stats().bytes));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int calls = argc > 1 ? std::atoi(argv[1]) : 200000;
+    const int threads = argc > 2 ? std::atoi(argv[2]) : 1;
+    const int burst = argc > 3 ? std::max(1, std::atoi(argv[3])) : 100;
+    const std::string path = argc > 4 ? argv[4] : "/tmp/alpha-logger-bench.log";
+
+    bench("sync", false, calls, threads, burst, path);
+    bench("async", true, calls, threads, burst, path);
+    bench_binary(calls, threads, burst, path);
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,157 @@
+// bench/sharder_bench.cpp
+// Sharder end to end against the local MarketDataServer: thread-per-connection
+// vs a shared io_context pool. Reports delivered ticks/s, tick latency
+// (server stamp to Consumer sink), per-stage latency of shard 0, process CPU
+// and reconnect recovery.
+//
+//   sharder_bench [tokens=1000] [rate_per_token=10] [seconds=5] [tokens_per_conn=200]
+//
+// Server and client share the process, so CPU includes the generator; compare
+// modes against each other rather than as absolute numbers.
+#include "sharder.h"
+#include "market_data_server.h"
+#include "parser.h"
+#include "ltp_store.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+double cpu_seconds() {
+    timespec ts{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) * 1e-9;
+}
+
+struct Run {
+    const char* name;
+    std::size_t io_threads;
+    std::size_t consumer_threads;
+};
+
+void bench(Logger& log, MarketDataServer& server, const Run& run, const std::vector<std::string>& tokens,
+           std::size_t per_conn, std::chrono::seconds duration) {
+    Parser parser;
+    parser.set_strip_prefix("nse_cm|");
+    LTPStore store;
+
+    Sharder::Options opt;
+    opt.wss_url = server.url();
+    opt.ca_file = server.cert_file();
+    opt.max_tokens_per_conn = per_conn;
+    opt.io_threads = run.io_threads;
+    opt.consumer_threads = run.consumer_threads;
+    opt.stage_timing = true;
+
+    std::mutex mu;
+    std::vector<std::int64_t> lat_ns;
+    std::atomic<bool> measuring{false};
+    std::atomic<std::uint64_t> ticks{0};
+    lat_ns.reserve(1 << 20);
+
+    Sharder mgr(log, parser, store, opt);
+    mgr.set_sink([&](const LTP& l) {
+        if (!measuring.load(std::memory_order_relaxed)) return;
+        const auto lat = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now() - l.ts).count();
+        ticks.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lk(mu);
+        if (lat_ns.size() < lat_ns.capacity()) lat_ns.push_back(lat);
+    });
+    mgr.set_tokens(tokens);
+    if (!mgr.start()) {
+        std::fprintf(stderr, "%s: start failed\n", run.name);
+        return;
+    }
+
+    // Warm up until every instrument has ticked once
+    const auto deadline = std::chrono::steady_clock::now() + 30s;
+    while (store.size() < tokens.size() && std::chrono::steady_clock::now() < deadline) std::this_thread::sleep_for(50ms);
+
+    const double cpu0 = cpu_seconds();
+    const auto t0 = std::chrono::steady_clock::now();
+    measuring = true;
+    std::this_thread::sleep_for(duration);
+    measuring = false;
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    const double cpu = cpu_seconds() - cpu0;
+
+    // Outage: every session dropped at once; recovery = drop to first frame per shard
+    const auto before = mgr.recovery_stats().recoveries;
+    server.drop_all();
+    for (int i = 0; i < 400 && mgr.recovery_stats().recoveries < before + mgr.num_workers(); ++i)
+        std::this_thread::sleep_for(25ms);
+    const auto rs = mgr.recovery_stats();
+    const std::size_t conns = mgr.num_workers();
+    const auto stages = mgr.stage_latency();
+    mgr.stop();
+
+    std::sort(lat_ns.begin(), lat_ns.end());
+    auto pct = [&](double p) -> double {
+        if (lat_ns.empty()) return 0;
+        return static_cast<double>(lat_ns[static_cast<std::size_t>(p * static_cast<double>(lat_ns.size() - 1))]) / 1000.0;
+    };
+    std::printf("%-22s conns=%-3zu ticks/s=%-9.0f lat_us p50=%-8.1f p99=%-8.1f p99.9=%-8.1f max=%-9.1f "
+                "cpu=%.0f%% recovered=%llu/%zu max_recover_ms=%.1f\n",
+                run.name, conns, static_cast<double>(ticks.load()) / wall,
+                pct(0.50), pct(0.99), pct(0.999), pct(1.0), 100.0 * cpu / wall,
+                static_cast<unsigned long long>(rs.recoveries - before), conns,
+                static_cast<double>(rs.max_recover.count()) / 1000.0);
+    if (!stages.empty()) {
+        // Shard 0 breakdown (includes the warm-up and reconnect)
+        for (std::size_t i = 0; i < kStageCount; ++i) {
+            const auto& s = stages[0][i];
+            std::printf("    %-16s n=%-8llu p50=%-8.1f p99=%-8.1f p99.9=%-8.1f max=%.1f us\n",
+                        stage_name(static_cast<Stage>(i)), static_cast<unsigned long long>(s.count),
+                        s.p50_ns / 1000.0, s.p99_ns / 1000.0, s.p999_ns / 1000.0, s.max_ns / 1000.0);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t n_tokens = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+    const double rate          = argc > 2 ? std::strtod(argv[2], nullptr) : 10.0;
+    const auto seconds         = std::chrono::seconds(argc > 3 ? std::strtol(argv[3], nullptr, 10) : 5);
+    const std::size_t per_conn = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 200;
+
+    Logger log("sharder_bench");
+    MarketDataServer::Options so;
+    so.default_rate = rate;
+    so.threads = 1;
+    so.max_queue = 1 << 16;
+    MarketDataServer server(log, so);
+    if (!server.start()) return 1;
+
+    std::vector<std::string> tokens;
+    for (std::size_t i = 0; i < n_tokens; ++i) tokens.push_back(std::to_string(100000 + i));
+
+    std::printf("tokens=%zu rate=%.1f/s/token (%.0f ticks/s offered) per_conn=%zu\n",
+                n_tokens, rate, rate * static_cast<double>(n_tokens), per_conn);
+    const Run runs[] = {
+        {"thread-per-connection", 0, 0},
+        {"pooled io=1 cons=1", 1, 1},
+        {"pooled io=2 cons=2", 2, 2},
+    };
+    for (const auto& r : runs) bench(log, server, r, tokens, per_conn, seconds);
+
+    const auto st = server.stats();
+    std::printf("server: sessions=%llu ticks=%llu frames_sent=%llu dropped=%llu\n",
+                static_cast<unsigned long long>(st.sessions), static_cast<unsigned long long>(st.ticks),
+                static_cast<unsigned long long>(st.frames_sent), static_cast<unsigned long long>(st.dropped));
+    server.stop();
+    return 0;
+}
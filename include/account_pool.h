@@ -0,0 +1,101 @@
+// include/account_pool.h
+#pragma once
+#include "config.h"
+#include "token_refresher.h"
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class HTTPClient;
+class Logger;
+class Auth;
+class TOTP;
+
+// Several broker accounts, each with its own credentials, TOTP and session, so
+// the per-account WebSocket connection and subscription caps add up. Accounts
+// log in in parallel; each session is then kept alive by its own TokenRefresher
+// (relogin with the account's TOTP once refreshing fails). A Sharder given the
+// pool (Sharder::set_accounts) spreads its shards over the accounts that are up
+// and moves them off an account whose session fails.
+//
+//   AccountPool pool(http, log, {});
+//   pool.add({Config::load_from_file("acct1.json"), "JBSWY3DPEHPK3PXP", 3, 1000});
+//   pool.add({Config::load_from_file("acct2.json"), "KRSXG5CTMVRXEZLU", 3, 1000});
+//   pool.start();
+class AccountPool {
+public:
+    struct Account {
+        Config config;                      // api_key, client_id, client_secret (password)
+        std::string totp_secret;            // base32
+        std::size_t max_connections = 3;    // broker cap on WebSocket connections
+        std::size_t max_tokens = 1000;      // broker cap on subscribed instruments
+    };
+
+    struct Options {
+        std::string base_url;               // API host; empty = SmartAPI
+        TokenRefresher::Options refresh;    // relogin is set by the pool
+    };
+
+    // What a connection needs to use an account
+    struct Session {
+        std::string name;                   // client code
+        bool up = false;                    // logged in and not failed since
+        std::size_t max_connections = 0;
+        std::size_t max_tokens = 0;
+        // Handshake headers: Authorization, x-api-key, x-client-code, x-feed-token
+        std::map<std::string, std::string> headers;
+    };
+
+    // Account index; called on login, every renewal, and when a session fails.
+    // Runs on the thread that noticed (a refresher's, or start()'s).
+    using Listener = std::function<void(std::size_t account)>;
+
+    AccountPool(HTTPClient& http, Logger& log, Options opts);
+    ~AccountPool();
+
+    AccountPool(const AccountPool&) = delete;
+    AccountPool& operator=(const AccountPool&) = delete;
+
+    // Before start()
+    std::size_t add(Account account);
+
+    // Log every account in (in parallel), then start their refreshers. Returns how
+    // many are up; the others keep retrying in the background.
+    std::size_t start();
+    void stop();
+
+    std::size_t size() const;
+    Session session(std::size_t account) const;
+    std::vector<Session> sessions() const;
+
+    std::size_t add_listener(Listener l);       // returns an id for remove_listener()
+    void remove_listener(std::size_t id);
+
+    // The account's session was rejected (e.g. handshakes refused): renew it now,
+    // marking the account down if that fails. Blocks on the broker; not from a listener.
+    bool renew(std::size_t account);
+
+private:
+    struct Slot;
+
+    bool login(Slot& s);
+    void set_up(std::size_t account, bool up, const Auth::Tokens* tokens);
+    void notify(std::size_t account);
+
+    HTTPClient& http_;
+    Logger& log_;
+    Options opts_;
+
+    std::vector<std::unique_ptr<Slot>> slots_;  // fixed once started
+
+    mutable std::mutex mu_;                     // Slot::session, listeners_
+    std::map<std::size_t, Listener> listeners_;
+    std::size_t next_listener_ = 0;
+    std::mutex notify_mu_;                      // listeners run one at a time, in order
+    bool started_ = false;
+};
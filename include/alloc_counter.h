@@ -0,0 +1,12 @@
+// include/alloc_counter.h
+#pragma once
+#include <cstdint>
+
+// Per-thread heap allocation counter for proving hot paths allocation-free.
+// Counting is compiled in only with -DALPHA_COUNT_ALLOCS=ON (global operator new
+// is replaced); otherwise enabled() is false and the counters stay at 0.
+class AllocCounter {
+public:
+    static bool enabled() noexcept;
+    static std::uint64_t thread_allocations() noexcept;  // calls to operator new on this thread
+};
@@ -2,6 +2,7 @@
 #include <string>
 #include <map>
 #include <chrono>
+#include <mutex>
 
 class Config;
 class HTTPClient;
@@ -18,6 +19,8 @@ public:
 
     // Borrow existing instances; no ownership.
     Auth(const Config& cfg, HTTPClient& http, Logger& log);
+    // Same, against another API host (e.g. a local stand-in): "https://host[:port]"
+    Auth(const Config& cfg, HTTPClient& http, Logger& log, std::string base_url);
 
     // Login (password + TOTP). SmartAPI commonly uses TOTP; COTP can call this too.
     bool login_with_totp(const std::string& totp);
@@ -30,13 +33,18 @@ public:
 
     // Helpers
     bool is_expired(std::chrono::seconds skew = std::chrono::seconds(60)) const;
-    const Tokens& tokens() const noexcept { return tokens_; }
+    Tokens tokens() const;      // a copy: refresh() may replace them from another thread
     std::map<std::string,std::string> auth_headers() const; // {"Authorization":"Bearer <jwt>"}
+    // Everything a secure REST call needs: the common SmartAPI headers + auth_headers()
+    std::map<std::string,std::string> request_headers() const;
+    const std::string& base_url() const noexcept { return base_url_; }
 
 private:
     const Config& cfg_;
     HTTPClient& http_;
     Logger& log_;
+    std::string base_url_;
+    mutable std::mutex mu_;     // tokens_; requests run unlocked
     Tokens tokens_;
 
     bool login_impl(const std::string& otp);
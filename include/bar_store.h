@@ -0,0 +1,56 @@
+// include/bar_store.h
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Bar {
+    std::chrono::system_clock::time_point start{};   // bar open time
+    double open = 0;
+    double high = 0;
+    double low = 0;
+    double close = 0;
+    std::uint64_t volume = 0;
+};
+
+// Candles of one interval per instrument, sorted by start time. Backfilled history
+// is merged in (in any order, a bar with the same start replaces the stored one),
+// and live ticks extend the newest bar or open the next one on the same grid, so
+// aggregation carries on where the history ends. Thread-safe.
+class BarStore {
+public:
+    explicit BarStore(std::chrono::seconds interval);
+
+    BarStore(const BarStore&) = delete;
+    BarStore& operator=(const BarStore&) = delete;
+
+    std::chrono::seconds interval() const noexcept { return interval_; }
+
+    // Returns how many bars were new (not replacing one with the same start)
+    std::size_t merge(const std::string& key, std::vector<Bar> bars);
+
+    // Live trade: updates the bar containing ts, or opens one. Bar starts continue
+    // the grid of the newest stored bar (e.g. 09:15 hourly candles), else are
+    // aligned to the interval since the epoch. Ticks older than the newest bar
+    // are ignored (false): that range is history's.
+    bool on_tick(const std::string& key, std::chrono::system_clock::time_point ts, double price, std::uint64_t qty = 0);
+
+    std::vector<Bar> bars(const std::string& key) const;
+    // Bars with from <= start < to
+    std::vector<Bar> bars(const std::string& key, std::chrono::system_clock::time_point from,
+                          std::chrono::system_clock::time_point to) const;
+    std::optional<Bar> last(const std::string& key) const;
+
+    std::size_t instruments() const;
+    std::size_t size() const;        // bars over all instruments
+
+private:
+    const std::chrono::seconds interval_;
+    mutable std::shared_mutex mu_;
+    std::unordered_map<std::string, std::vector<Bar>> map_;
+};
@@ -0,0 +1,198 @@
+// include/binary_log.h
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "logger.h"
+
+// Deferred-format binary logging (NanoLog style) for trace volume on hot threads.
+//
+// Every ALPHA_BINLOG site owns a static descriptor (level, format, file:line and
+// the argument types, fixed at compile time). A call copies only the site id, a
+// TSC stamp and the raw argument bytes into the calling thread's ring; a
+// background thread merges the rings and appends them to a binary file, writing
+// each descriptor the first time it is used. Nothing is formatted until the file
+// is decoded offline (decode_binary_log(), tools/binlog_decode). The format is
+// checked against the arguments at compile time. Unlike Logger sites these are not
+// removed by ALPHA_MIN_LOG_LEVEL: they are the trace that stays on in release
+// builds, switched at runtime by open() / set_level().
+//
+//   ALPHA_BINLOG(trace, LogLevel::TRACE, "frame shard={} bytes={}", si, msg.size());
+namespace binlog {
+
+// Wire type of one argument. Integers and floats are stored as 8 bytes; strings
+// as a uint32 length and the bytes (at most kMaxString, longer ones are cut).
+enum class ArgType : std::uint8_t { I64 = 1, U64, F64, Bool, Char, Str };
+
+inline constexpr std::size_t kMaxString = 1024;
+
+template<typename T>
+constexpr ArgType arg_type() {
+    using U = std::remove_cv_t<T>;
+    if constexpr (std::is_same_v<U, bool>) return ArgType::Bool;
+    else if constexpr (std::is_same_v<U, char>) return ArgType::Char;
+    else if constexpr (std::is_enum_v<U>) return std::is_signed_v<std::underlying_type_t<U>> ? ArgType::I64 : ArgType::U64;
+    else if constexpr (std::is_integral_v<U>) return std::is_signed_v<U> ? ArgType::I64 : ArgType::U64;
+    else if constexpr (std::is_floating_point_v<U>) return ArgType::F64;
+    else {
+        static_assert(std::is_convertible_v<const U&, std::string_view>,
+                      "binary log arguments: integers, floats, bool, char, enums or strings");
+        return ArgType::Str;
+    }
+}
+
+template<typename... Args>
+struct TypeList {
+    static constexpr std::uint8_t size = sizeof...(Args);
+    static constexpr ArgType codes[sizeof...(Args) + 1] = {arg_type<Args>()..., ArgType::I64};
+};
+
+// Only used in decltype: the decayed argument types of a call ("abc" -> const char*)
+template<typename... Args>
+TypeList<std::decay_t<Args>...> type_list_of(const Args&...);
+
+// A log site. Constant-initialised (a static per ALPHA_BINLOG expansion); the id
+// is handed out on first use and is the same for every BinaryLogger.
+struct Site {
+    constexpr Site(LogLevel l, const char* f, const char* fl, int ln, const ArgType* t, std::uint8_t n) noexcept
+        : level(l), fmt(f), file(fl), line(ln), types(t), nargs(n) {}
+
+    LogLevel level;
+    const char* fmt;
+    const char* file;
+    int line;
+    const ArgType* types;
+    std::uint8_t nargs;
+    std::atomic<std::uint32_t> id{0};
+};
+
+std::uint32_t register_site(Site& site);
+
+template<typename T>
+std::size_t arg_size(const T& v) noexcept {
+    if constexpr (arg_type<T>() == ArgType::Str) {
+        return sizeof(std::uint32_t) + std::min(std::string_view(v).size(), kMaxString);
+    } else {
+        return 8;
+    }
+}
+
+template<typename T>
+void put_arg(char*& p, const T& v) noexcept {
+    constexpr ArgType t = arg_type<T>();
+    if constexpr (t == ArgType::Str) {
+        const std::string_view s(v);
+        const std::uint32_t n = static_cast<std::uint32_t>(std::min(s.size(), kMaxString));
+        std::memcpy(p, &n, sizeof(n));
+        std::memcpy(p + sizeof(n), s.data(), n);
+        p += sizeof(n) + n;
+        return;
+    } else if constexpr (t == ArgType::F64) {
+        const double d = static_cast<double>(v);
+        std::memcpy(p, &d, 8);
+    } else if constexpr (t == ArgType::I64) {
+        const std::int64_t i = static_cast<std::int64_t>(v);
+        std::memcpy(p, &i, 8);
+    } else {
+        const std::uint64_t u = static_cast<std::uint64_t>(v);
+        std::memcpy(p, &u, 8);
+    }
+    p += 8;
+}
+
+} // namespace binlog
+
+class BinaryLogger {
+public:
+    struct Options {
+        std::size_t ring_bytes = 256 * 1024;           // per logging thread (power of two)
+        std::chrono::microseconds poll_interval{1000}; // writer wake-up when idle
+        bool block_when_full = false;                  // false: drop the record and count it
+    };
+
+    struct Stats {
+        std::uint64_t records = 0;   // written to the file
+        std::uint64_t dropped = 0;   // ring full (or record larger than a quarter ring)
+        std::uint64_t bytes = 0;     // file size so far
+    };
+
+    // `log` reports file errors; `name` is printed by the decoder in place of the logger name
+    BinaryLogger(Logger& log, std::string name);
+    ~BinaryLogger();
+
+    BinaryLogger(const BinaryLogger&) = delete;
+    BinaryLogger& operator=(const BinaryLogger&) = delete;
+
+    // Create / truncate path and start the writer thread. false if it cannot be opened.
+    bool open(const std::string& path);
+    bool open(const std::string& path, Options opts);
+    // Write out everything logged so far and close the file; later calls are dropped silently
+    void close();
+    bool is_open() const noexcept { return accepting_.load(std::memory_order_relaxed); }
+    // Block until records logged before the call are in the file
+    void flush();
+
+    // Sites below the level are skipped before any argument is touched (default TRACE)
+    void set_level(LogLevel lvl) noexcept { level_.store(lvl, std::memory_order_relaxed); }
+    bool enabled(LogLevel lvl) const noexcept {
+        return static_cast<int>(lvl) >= static_cast<int>(level_.load(std::memory_order_relaxed))
+            && accepting_.load(std::memory_order_relaxed);
+    }
+
+    Stats stats() const noexcept;
+
+    // Use ALPHA_BINLOG; the argument types must match the site's
+    template<typename... Args>
+    void write(binlog::Site& site, const Args&... args) {
+        std::uint32_t id = site.id.load(std::memory_order_acquire);
+        if (id == 0) id = binlog::register_site(site);
+        Reservation r;
+        if (!reserve(id, (std::size_t{0} + ... + binlog::arg_size(args)), r)) return;
+        if constexpr (sizeof...(Args) > 0) {
+            char* p = r.data;
+            (binlog::put_arg(p, args), ...);
+        }
+        commit(r);
+    }
+
+private:
+    struct Impl;
+    struct Reservation {
+        void* ring;
+        char* data;
+        std::size_t next;
+    };
+    bool reserve(std::uint32_t site_id, std::size_t payload, Reservation& r);
+    void commit(const Reservation& r) noexcept;
+
+    std::atomic<LogLevel> level_{LogLevel::TRACE};
+    std::atomic<bool> accepting_{false};
+    Impl* impl_;
+};
+
+// Render a binary log as text, one line per record:
+//   <date> <time>.<us> [LEVEL] name: formatted message
+// Records are in time order within each writer pass. false (and err set) on a
+// malformed or truncated file; the lines before the damage are still written.
+struct BinaryLogDecodeOptions {
+    bool show_location = false;      // append " (file:line)"
+};
+bool decode_binary_log(std::istream& in, std::ostream& out, const BinaryLogDecodeOptions& opts, std::string* err = nullptr);
+
+#define ALPHA_BINLOG(blog, lvl, fmt, ...)                                                     \
+    do {                                                                                      \
+        using alpha_bl_types_ = decltype(::binlog::type_list_of(__VA_ARGS__));               \
+        static_assert(::logger_detail::count_placeholders(fmt) == alpha_bl_types_::size,      \
+                      "binary log format: {} placeholders do not match the arguments");      \
+        static ::binlog::Site alpha_bl_site_{(lvl), (fmt), __FILE__, __LINE__,                \
+                                             alpha_bl_types_::codes, alpha_bl_types_::size};  \
+        auto& alpha_bl_ = (blog);                                                             \
+        if (alpha_bl_.enabled(lvl)) alpha_bl_.write(alpha_bl_site_ __VA_OPT__(,) __VA_ARGS__); \
+    } while (0)
@@ -0,0 +1,113 @@
+// include/candle_backfill.h
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Auth;
+class BarStore;
+class HTTPClient;
+class Logger;
+
+// Historical candle backfill (SmartAPI getCandleData) into a BarStore. Each
+// (instrument, range) job is split into chunks no longer than the broker allows
+// per request for the interval; the chunks run on `concurrency` workers under a
+// requests-per-second budget. Throttling (HTTP 429, 403 "access rate"), 5xx and
+// transport errors are retried with exponential backoff and full jitter; an
+// invalid or expired token is refreshed once through Auth, then retried.
+//
+//   BarStore bars(std::chrono::minutes(1));
+//   CandleBackfill bf(http, auth, log, bars, {});
+//   auto r = bf.run({{"NSE", "3045", day_open, now}});
+class CandleBackfill {
+public:
+    enum class Interval { OneMinute, ThreeMinute, FiveMinute, TenMinute, FifteenMinute, ThirtyMinute, OneHour, OneDay };
+
+    struct Job {
+        std::string exchange;                        // "NSE", "NFO", ...
+        std::string token;                           // symboltoken
+        std::chrono::system_clock::time_point from;
+        std::chrono::system_clock::time_point to;
+        std::string key;                             // BarStore key; empty = token
+    };
+
+    struct Options {
+        std::string base_url;                        // empty = Auth::base_url()
+        Interval interval = Interval::OneMinute;     // should match the BarStore's
+        int max_days_per_request = 0;                // 0 = broker maximum for the interval
+        std::size_t concurrency = 3;                 // requests in flight
+        double requests_per_second = 3;              // getCandleData limit (0 = off)
+        int max_attempts = 5;                        // per chunk, first try included
+        std::chrono::milliseconds backoff_base{250}; // delay before retry n is random in [0, min(max, base * 2^n))
+        std::chrono::milliseconds backoff_max{8000};
+        int utc_offset_minutes = 330;                // request dates are exchange local time (IST)
+    };
+
+    struct Stats {
+        std::uint64_t requests = 0;
+        std::uint64_t retries = 0;
+        std::uint64_t throttled = 0;                 // responses telling us to slow down
+        std::uint64_t refreshes = 0;                 // token refreshes triggered
+        std::uint64_t bars = 0;                      // candles received
+    };
+
+    struct Result {
+        std::size_t chunks = 0;
+        std::size_t failed = 0;                      // chunks given up on
+        std::size_t bars = 0;                        // new bars in the store
+        std::vector<std::string> errors;             // one per failed chunk
+        bool ok() const noexcept { return failed == 0; }
+    };
+
+    CandleBackfill(HTTPClient& http, Auth& auth, Logger& log, BarStore& store, Options opts);
+
+    CandleBackfill(const CandleBackfill&) = delete;
+    CandleBackfill& operator=(const CandleBackfill&) = delete;
+
+    // Blocks until every chunk has succeeded or failed (or cancel()).
+    Result run(const std::vector<Job>& jobs);
+    // Makes a running run() return after the requests in flight; chunks not
+    // started are reported as failed ("cancelled").
+    void cancel();
+
+    Stats stats() const;
+
+    static const char* interval_name(Interval i) noexcept;   // "ONE_MINUTE", ...
+    static int max_days(Interval i) noexcept;                // per request
+
+private:
+    struct Chunk {
+        const Job* job;
+        std::chrono::system_clock::time_point from;
+        std::chrono::system_clock::time_point to;
+    };
+    enum class Outcome { Done, Retry, Refresh, Fail };
+
+    Outcome fetch(const Chunk& c, std::size_t& added, std::string& err);
+    bool refresh_token(std::uint64_t seen_generation);
+    std::map<std::string, std::string> headers(std::uint64_t& generation);
+    std::chrono::milliseconds backoff(int attempt);
+    std::string local_time(std::chrono::system_clock::time_point t) const;
+
+    HTTPClient& http_;
+    Auth& auth_;
+    Logger& log_;
+    BarStore& store_;
+    Options opts_;
+    std::atomic<bool> cancelled_{false};
+    std::mutex cancel_mu_;
+    std::condition_variable cancel_cv_;          // cuts backoff sleeps short
+
+    mutable std::mutex mu_;                          // stats_, auth_, rng_, the two below
+    Stats stats_;
+    std::uint64_t token_generation_ = 0;             // bumped by each refresh
+    bool refreshing_ = false;                        // auth_ is refreshing outside mu_
+    std::condition_variable refresh_cv_;             // refreshing_ cleared
+    std::uint64_t rng_;
+};
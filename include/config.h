@@ -13,6 +13,8 @@ public:
     const std::string& client_code() const {return client_id_; }
     const std::string& client_secret() const {return client_secret_; }
     const std::vector<std::string>& token() const {return tokens_; }
+    // optional: "EXCH:SYMBOL" specs resolved through the instrument master
+    const std::vector<std::string>& symbols() const {return symbols_; }
     const std::unordered_map<std::string, int>& splits() const {return splits_; }
 
 private:
@@ -23,6 +25,7 @@ private:
     std::string client_id_;
     std::string client_secret_;
     std::vector<std::string> tokens_;
+    std::vector<std::string> symbols_;
     std::unordered_map<std::string, int> splits_;
 
 };
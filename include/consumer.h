@@ -4,29 +4,82 @@
 #include "parser.h"
 #include "ltp_store.h"
 #include "logger.h"
+#include "thread_affinity.h"
+#include "tick_rate_tracker.h"
+#include "feed_arbiter.h"
+#include "latency_histogram.h"
+#include "metrics.h"
+#include "overload_guard.h"
 #include <atomic>
 #include <thread>
 #include <functional>
+#include <vector>
+#include <mutex>
+#include <string>
 
 class Consumer {
 public:
     using SinkFn = std::function<void(const LTP&)>; // optional side-effect (print/persist)
 
+    // Per-queue counters (any may be null)
+    struct Metrics {
+        MetricsRegistry::Counter* ticks = nullptr;           // parsed and stored
+        MetricsRegistry::Counter* parse_failures = nullptr;  // neither a tick nor an ack
+        MetricsRegistry::Counter* subscribe_acks = nullptr;  // {"type":"ack","action":"subscribe",...}
+    };
+
+    // How frames from one queue are handled
+    struct SourceOptions {
+        FeedArbiter* arb = nullptr;       // redundant feeds: admit as leg `leg` (stamped pushes)
+        std::size_t leg = 0;
+        StageHistograms* timing = nullptr;// per-stage latencies of frames pushed with read/enqueue stamps
+        Metrics metrics;
+        OverloadGuard* overload = nullptr;// Conflate: frames parked by q's guard, taken once q is empty
+    };
+
     Consumer(IngestQueue& q, Parser& parser, LTPStore& store, Logger& log);
     ~Consumer();
 
     void set_sink(SinkFn fn);             // optional
+    void add_queue(IngestQueue& q);       // drain more queues round-robin (safe while running)
+    void add_queue(IngestQueue& q, const SourceOptions& o);
+    // Redundant feeds: frames from q pass through arb as leg `leg` (stamped pushes)
+    void add_queue(IngestQueue& q, FeedArbiter& arb, std::size_t leg);
+    // Same options for the constructor's queue (before start())
+    void configure(const SourceOptions& o);
+    void set_arbiter(FeedArbiter& arb, std::size_t leg);
+    void set_stage_timing(StageHistograms* timing);
+    // Optional; records one tick per parsed frame (before start()). Ticks are keyed
+    // by the parsed token minus key_prefix, so they match the subscribed token when
+    // the parser keeps the exchange prefix ("nse_cm|26000" -> "26000").
+    void set_rate_tracker(TickRateTracker* t, std::string key_prefix = {});
+    void set_placement(ThreadPlacement p, std::string thread_name = "consumer"); // before start()
     bool start();                         // spawn thread
     void stop();                          // join
 
 private:
     void run();
+    void process(const SourceOptions& o, const std::string& msg, const IngestQueue::Stamp& stamp);
+
+    struct Source {
+        IngestQueue* q;
+        SourceOptions o;
+    };
+    std::vector<Source> queues_;          // consumer thread only once started
+    std::vector<OverloadGuard::Parked> parked_;  // consumer thread only; buffers swap with the guards
 
-    IngestQueue& q_;
+    // queues added while running, picked up by the consumer thread
+    std::mutex pending_mu_;
+    std::vector<Source> pending_;
+    std::atomic<bool> has_pending_{false};
     Parser& parser_;
     LTPStore& store_;
     Logger& log_;
     SinkFn sink_;
+    TickRateTracker* rates_ = nullptr;
+    std::string rate_prefix_;
+    ThreadPlacement placement_;
+    std::string thread_name_ = "consumer";
 
     std::atomic<bool> running_{false};
     std::thread thr_;
@@ -0,0 +1,68 @@
+// include/feed_arbiter.h
+#pragma once
+#include "parser.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// First-arrival-wins merge of one shard's instruments delivered over two
+// independent connections (A/B legs). A tick is identified by instrument +
+// exchange timestamp + price; the first copy is forwarded, the other leg's copy
+// is dropped. admit() is called from a single Consumer thread; stats() from any.
+class FeedArbiter {
+public:
+    static constexpr std::size_t kLegs = 2;
+
+    struct LegStats {
+        std::uint64_t forwarded = 0;   // ticks this leg delivered to the store
+        std::uint64_t duplicates = 0;  // late copies from this leg, dropped
+        std::uint64_t wins = 0;        // ticks seen on both legs where this leg's copy arrived first
+        std::uint64_t lead_ns_total = 0; // sum over wins of arrival lead over the other leg
+        std::uint64_t lead_ns_max = 0;
+    };
+    struct Stats {
+        std::array<LegStats, kLegs> legs{};
+        std::uint64_t stale = 0;       // older than everything remembered for the instrument
+    };
+
+    FeedArbiter() = default;
+    FeedArbiter(const FeedArbiter&) = delete;
+    FeedArbiter& operator=(const FeedArbiter&) = delete;
+
+    // true = forward this tick, false = duplicate/stale. arrival_ns is the
+    // steady-clock stamp taken when the frame came off the leg's socket.
+    bool admit(std::size_t leg, const LTP& t, std::int64_t arrival_ns);
+
+    Stats stats() const;
+    std::size_t instruments() const noexcept { return n_instruments_.load(std::memory_order_relaxed); }
+
+private:
+    // A few recent ticks per instrument, so a lagging leg still matches a copy
+    // even after the leading leg has moved on by a tick or two.
+    static constexpr std::size_t kRecent = 4;
+
+    struct Seen {
+        std::int64_t ts_ms = 0;
+        double px = 0;
+        std::int64_t arrival_ns = 0;
+        std::uint8_t legs = 0;         // bit per leg that delivered it
+        std::uint8_t first = 0;        // leg that was forwarded
+    };
+    struct Entry {
+        std::array<Seen, kRecent> recent{};
+        std::uint8_t used = 0;
+        std::uint8_t next = 0;         // ring slot to overwrite
+    };
+
+    struct LegCounters {
+        std::atomic<std::uint64_t> forwarded{0}, duplicates{0}, wins{0}, lead_ns_total{0}, lead_ns_max{0};
+    };
+
+    std::unordered_map<std::string, Entry> table_;   // Consumer thread only
+    std::array<LegCounters, kLegs> legs_;
+    std::atomic<std::uint64_t> stale_{0};
+    std::atomic<std::size_t> n_instruments_{0};
+};
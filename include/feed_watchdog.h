@@ -0,0 +1,99 @@
+// include/feed_watchdog.h
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Logger;
+class LTPStore;
+
+// Application-level stall detection. A timer thread samples each target's
+// frame counter; a connection whose counter has not moved for max_silence
+// during market hours is recycled. Nothing runs on the read path: targets
+// expose counters they already keep.
+class FeedWatchdog {
+public:
+    struct Options {
+        std::chrono::milliseconds check_interval{100};
+        std::chrono::milliseconds max_silence{0};         // connection rule; 0 = off
+        std::chrono::milliseconds instrument_silence{0};  // per-instrument report; 0 = off
+        std::chrono::milliseconds instrument_check_interval{1000};
+        // Market hours in exchange local time (defaults: NSE cash, IST)
+        int open_minute = 9 * 60 + 15;                     // minutes after local midnight
+        int close_minute = 15 * 60 + 30;                   // open == close: always open
+        int utc_offset_minutes = 330;
+        bool weekdays_only = true;
+    };
+
+    struct Target {
+        std::string name;
+        std::function<std::uint64_t()> frames;  // monotonically increasing receive count
+        std::function<bool()> armed;            // false = not expected to stream (down, idle)
+        std::function<void()> recycle;          // drop the session; its own reconnect takes over
+    };
+
+    struct Stats {
+        std::uint64_t checks = 0;
+        std::uint64_t recycles = 0;
+        std::size_t stale_instruments = 0;      // at the last instrument check
+    };
+
+    FeedWatchdog(Logger& log, Options opts);
+    ~FeedWatchdog();
+
+    FeedWatchdog(const FeedWatchdog&) = delete;
+    FeedWatchdog& operator=(const FeedWatchdog&) = delete;
+
+    // Register a connection; safe while running. Returns an id for unwatch().
+    std::size_t watch(Target t);
+    void unwatch(std::size_t id);
+    // Per-instrument last-arrival checks against LTP::recv
+    void watch_store(const LTPStore& store);
+
+    bool start();    // spawn the timer thread (idempotent)
+    void stop();     // join
+
+    bool in_market_hours(std::chrono::system_clock::time_point t) const;
+    Stats stats() const;
+    std::vector<std::string> stale_instruments() const;   // from the last check
+
+    // Milliseconds a target has been silent (0 if streaming or unknown)
+    std::chrono::milliseconds silent_for(std::size_t id) const;
+
+private:
+    struct Watched {
+        std::size_t id;
+        Target t;
+        std::uint64_t last_frames = 0;
+        std::chrono::steady_clock::time_point last_change{};
+        bool active = false;     // armed at the previous check
+    };
+
+    void run();
+    void check_targets(std::chrono::steady_clock::time_point now, bool market);
+    void check_instruments(std::chrono::steady_clock::time_point now);
+
+    Logger& log_;
+    Options opts_;
+
+    mutable std::mutex mu_;                 // targets_, store_, stale_
+    std::vector<Watched> targets_;
+    std::size_t next_id_ = 0;
+    const LTPStore* store_ = nullptr;
+    std::vector<std::string> stale_;
+
+    std::atomic<std::uint64_t> checks_{0};
+    std::atomic<std::uint64_t> recycles_{0};
+
+    std::mutex run_mu_;
+    std::condition_variable run_cv_;
+    bool stop_ = false;
+    std::thread thr_;
+};
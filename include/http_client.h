@@ -2,6 +2,17 @@
 #include <string>
 #include <map>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string_view>
+#include <system_error>
+
+// SSL context, idle connections, DNS and TLS session caches, request limits and
+// the async IO threads (src/http_client.cpp)
+class HttpConnectionPool;
 
 struct HttpResponse {
     int status = 0;
@@ -17,10 +28,53 @@ public:
         std::string ca_file;                             // optional CA bundle path
         std::string user_agent = "alpha-http/1.0";
         std::map<std::string, std::string> default_headers;
+
+        // Connection reuse: requests to the same host:port go over pooled keep-alive
+        // TLS connections (one shared SSL context). A pooled connection the server has
+        // closed meanwhile is replaced, and the request retried once, transparently.
+        std::size_t max_idle_per_host = 4;               // 0 = new connection per request
+        std::chrono::seconds idle_timeout{30};           // pooled connections idle longer are closed
+        std::chrono::seconds dns_ttl{300};               // cached resolver results (0 = resolve every connect)
+        bool tls_session_reuse = true;                   // resume the host's last TLS session on new connections
+
+        // Limits shared by sync and async requests. Over the concurrency limit,
+        // requests wait for a slot in arrival order; then for a rate token.
+        std::size_t max_concurrent_per_host = 8;         // in flight per host:port (0 = unlimited)
+        double max_requests_per_second = 0;              // token bucket over all hosts, e.g. the broker's API limit (0 = off)
+        std::size_t rate_burst = 0;                      // tokens banked while idle (0 = one second's worth)
+        std::size_t async_threads = 1;                   // run the *_async requests; started on first use
+
+        // Bodies: buffered responses larger than body_limit fail ("body limit
+        // exceeded"); get_stream() / download() have no limit and hold one chunk.
+        std::uint64_t body_limit = 64 * 1024 * 1024;
+        std::size_t stream_chunk = 64 * 1024;
     };
 
+    struct Stats {
+        std::uint64_t requests = 0;
+        std::uint64_t connects = 0;                      // new TCP + TLS connections
+        std::uint64_t reused = 0;                        // requests sent on a pooled connection
+        std::uint64_t resumed = 0;                       // connects that resumed a TLS session
+        std::uint64_t dns_lookups = 0;                   // resolver calls (cache misses)
+        std::uint64_t retries = 0;                       // stale pooled connection, request resent
+        std::uint64_t evicted = 0;                       // idle connections closed (timeout, stale, over max)
+        std::uint64_t queued = 0;                        // waited for a host slot
+        std::uint64_t throttled = 0;                     // waited for a rate token
+    };
+
+    // Completion of an async request, on one of the client's IO threads: the
+    // response, or a transport error (connect, TLS, timeout). HTTP error statuses are
+    // responses. Must not block or throw; issuing further *_async requests is fine.
+    using Callback = std::function<void(std::error_code ec, HttpResponse res)>;
+
+    // Receives a streamed body piece by piece (at most Options::stream_chunk bytes,
+    // valid during the call). Return false to stop: the connection is dropped.
+    using BodySink = std::function<bool(std::string_view chunk)>;
+
     HTTPClient();
     explicit HTTPClient(Options opts);
+    // Waits for outstanding async requests; do not destroy the client from a callback
+    ~HTTPClient();
 
     // Simple HTTPS GET: https_url must start with https://
     HttpResponse get(const std::string& https_url,
@@ -40,6 +94,49 @@ public:
                            const std::map<std::string, std::string>& headers = {},
                            const std::map<std::string, std::string>& query = {});
 
+    // Streaming GET: the body goes to sink as it arrives instead of into
+    // HttpResponse::body (left empty), whatever the status. Memory stays at one
+    // chunk however large the download; opts.timeout applies to each read, not to
+    // the whole transfer. Status and headers are returned when the body is done.
+    HttpResponse get_stream(const std::string& https_url,
+                            const BodySink& sink,
+                            const std::map<std::string, std::string>& headers = {},
+                            const std::map<std::string, std::string>& query = {});
+
+    // get_stream() into a file (created / truncated). Throws if it cannot be written.
+    HttpResponse download(const std::string& https_url,
+                          const std::string& path,
+                          const std::map<std::string, std::string>& headers = {},
+                          const std::map<std::string, std::string>& query = {});
+
+    // Asynchronous versions: return at once, no thread is held per request.
+    // URL errors throw here; transport errors go to the callback / the future
+    // (as std::system_error). Do not wait on a future from a callback.
+    void get_async(const std::string& https_url,
+                   const std::map<std::string, std::string>& headers,
+                   const std::map<std::string, std::string>& query,
+                   Callback cb);
+    std::future<HttpResponse> get_async(const std::string& https_url,
+                                        const std::map<std::string, std::string>& headers = {},
+                                        const std::map<std::string, std::string>& query = {});
+
+    void post_async(const std::string& https_url,
+                    const std::string& body,
+                    const std::string& content_type,
+                    const std::map<std::string, std::string>& headers,
+                    const std::map<std::string, std::string>& query,
+                    Callback cb);
+    std::future<HttpResponse> post_async(const std::string& https_url,
+                                         const std::string& body,
+                                         const std::string& content_type = "application/octet-stream",
+                                         const std::map<std::string, std::string>& headers = {},
+                                         const std::map<std::string, std::string>& query = {});
+
+    std::future<HttpResponse> post_json_async(const std::string& https_url,
+                                              const std::string& json_body,
+                                              const std::map<std::string, std::string>& headers = {},
+                                              const std::map<std::string, std::string>& query = {});
+
     // Manage default headers
     void set_default_header(const std::string& key, const std::string& value);
     void erase_default_header(const std::string& key);
@@ -47,6 +144,10 @@ public:
     // Access options
     const Options& options() const noexcept { return opts_; }
 
+    Stats stats() const noexcept;
+    // Close every pooled connection now (e.g. after a network change)
+    void close_idle();
+
 private:
     struct UrlParts {
         std::string host;
@@ -60,9 +161,10 @@ private:
     static std::string build_query_string(const std::map<std::string, std::string>& query);
 
     Options opts_;
+    std::unique_ptr<HttpConnectionPool> pool_;
     // Non-copyable, movable (socket state lives in impl .cpp)
     HTTPClient(const HTTPClient&) = delete;
     HTTPClient& operator=(const HTTPClient&) = delete;
-    HTTPClient(HTTPClient&&) noexcept = default;
-    HTTPClient& operator=(HTTPClient&&) noexcept = default;
+    HTTPClient(HTTPClient&&) noexcept;
+    HTTPClient& operator=(HTTPClient&&) noexcept;
 };
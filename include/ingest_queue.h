@@ -2,13 +2,26 @@
 #pragma once
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 class IngestQueue {
 public:
-    // capacity will be rounded up to next power of two (min 8)
-    explicit IngestQueue(std::size_t capacity);
+    // Timestamps that travel with a frame through the ring
+    struct Stamp {
+        std::int64_t arrival_ns = 0;    // steady clock (A/B arbitration)
+        std::uint64_t read_tsc = 0;     // stage timing: WS read completion (0 = untimed)
+        std::uint64_t enqueue_tsc = 0;  // stage timing: ring push
+    };
+
+    enum class PushResult { Pushed, Evicted, Full };
+
+    // capacity will be rounded up to next power of two (min 8).
+    // allow_evict enables try_push_view_evict; pops then claim their slot with a CAS.
+    explicit IngestQueue(std::size_t capacity, bool allow_evict = false);
 
     IngestQueue(const IngestQueue&) = delete;
     IngestQueue& operator=(const IngestQueue&) = delete;
@@ -19,10 +32,22 @@ public:
     // Returns false if queue is full (item dropped upstream)
     bool try_push(std::string&& msg);
     bool try_push(const std::string& msg); // convenience (copies)
+    // Copies bytes into the slot's existing buffer: no allocation once slots are warm
+    bool try_push_view(std::string_view msg);
+    // Same, tagging the frame with an arrival timestamp (e.g. steady-clock ns)
+    bool try_push_view(std::string_view msg, std::int64_t stamp);
+    bool try_push_view(std::string_view msg, const Stamp& stamp);
+    // Drop-oldest (allow_evict queues only): when full, the oldest queued frame is
+    // discarded to make room. Full only while the consumer is popping that frame.
+    PushResult try_push_view_evict(std::string_view msg, const Stamp& stamp);
 
     // Consumer thread (Parser)
-    // Returns false if queue is empty
+    // Returns false if queue is empty. Swaps with the slot, so out's old buffer
+    // goes back into the ring for reuse by try_push_view.
     bool try_pop(std::string& out);
+    // Also returns the stamp given to try_push_view (unspecified for other pushes)
+    bool try_pop(std::string& out, std::int64_t& stamp);
+    bool try_pop(std::string& out, Stamp& stamp);
 
     // Introspection (non-blocking)
     std::size_t size() const noexcept;     // approximate (lock-free)
@@ -36,14 +61,24 @@ public:
 private:
     // power-of-two ring: index & mask_ for wrap
     std::vector<std::string> buf_;
+    std::vector<Stamp> stamps_;          // parallel to buf_
     const std::size_t mask_;             // capacity - 1
+    const bool evictable_;
+
+    // Per-slot sequence: seq == pos means free for the push at pos, pos + 1 means
+    // it holds that frame. The slot, not tail_, tells the producer it may write.
+    std::unique_ptr<std::atomic<std::size_t>[]> seq_;
 
     // head_ (write index) modified by producer only
-    // tail_ (read index)  modified by consumer only
+    // tail_ (read index)  modified by consumer only (and by evicting pushes)
     // Both atomics so the opposite side can observe progress.
     std::atomic<std::size_t> head_{0};
     std::atomic<std::size_t> tail_{0};
 
+    bool claim_pop(std::size_t& tail) noexcept;
+    void release_pop(std::size_t tail) noexcept;
+    void publish(std::size_t head) noexcept;
+
     static std::size_t next_pow2(std::size_t n) noexcept;
 };
 
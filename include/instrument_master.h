@@ -0,0 +1,98 @@
+// include/instrument_master.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Logger;
+class HTTPClient;
+
+// One scrip master entry. The views point into the master's storage (the mapped
+// cache file or the parsed image) and stay valid while the InstrumentMaster lives.
+struct Instrument {
+    std::string_view token;            // numeric, unique per exchange only
+    std::string_view symbol;           // trading symbol, e.g. "SBIN-EQ", "NIFTY26DEC2424000CE"
+    std::string_view name;             // underlying, e.g. "SBIN"
+    std::string_view exchange;         // exch_seg: "NSE", "NFO", "BSE", "BFO", "MCX", "CDS", ...
+    std::string_view instrument_type;  // "", "OPTIDX", "FUTSTK", ...
+    std::string_view expiry;           // "26DEC2024", "" for cash
+    double strike = 0;                 // as published (x100 for derivatives), -1 for none
+    double tick_size = 0;              // as published (paise)
+    std::int32_t lot_size = 0;
+};
+
+// The broker's instrument (scrip) master, parsed once and kept as a compact binary
+// image: fixed-size records, one deduplicated string blob, and open-addressing
+// hash tables from (exchange, token) and (exchange, symbol) to records. The same
+// image is the on-disk cache, so a cached day loads with one mmap and a bounds
+// check instead of a JSON parse. The cache is host-endian and tied to this build's
+// format version; anything unexpected makes it a miss.
+//
+//   InstrumentMaster im(log);
+//   im.load(http, {"https://.../OpenAPIScripMaster.json", "/var/cache/alpha", ""});
+//   auto sbin = im.find("NSE:SBIN-EQ");
+class InstrumentMaster {
+public:
+    struct LoadOptions {
+        std::string url;               // scrip master JSON (array of objects, string fields)
+        std::string cache_dir;         // <cache_dir>/instruments-<date>.bin; empty = no cache
+        std::string date;              // YYYY-MM-DD the master is for; empty = today (local time)
+    };
+
+    struct Stats {
+        std::size_t instruments = 0;
+        std::size_t image_bytes = 0;   // records + strings + indexes
+        bool from_cache = false;
+        double load_ms = 0;            // last load / parse
+    };
+
+    explicit InstrumentMaster(Logger& log);
+    ~InstrumentMaster();
+
+    InstrumentMaster(const InstrumentMaster&) = delete;
+    InstrumentMaster& operator=(const InstrumentMaster&) = delete;
+
+    // The day's cache if present and valid, else download (streamed and parsed as
+    // it arrives) and write the cache. false (and err) if neither works.
+    bool load(HTTPClient& http, const LoadOptions& opts, std::string* err = nullptr);
+
+    // Individual steps. parse_json() replaces the contents; `date` is recorded in the image.
+    bool parse_json(std::istream& in, const std::string& date, std::string* err = nullptr);
+    bool fetch(HTTPClient& http, const std::string& url, const std::string& date, std::string* err = nullptr);
+    bool save_cache(const std::string& path, std::string* err = nullptr) const;   // atomic (temp + rename)
+    bool load_cache(const std::string& path, const std::string& date, std::string* err = nullptr);
+
+    static std::string cache_path(const std::string& cache_dir, const std::string& date);
+
+    std::size_t size() const noexcept;
+    const std::string& date() const noexcept { return date_; }
+    Instrument at(std::size_t i) const;     // std::out_of_range unless i < size()
+
+    std::optional<Instrument> by_token(std::string_view exchange, std::string_view token) const;
+    std::optional<Instrument> by_symbol(std::string_view exchange, std::string_view symbol) const;
+    // "EXCH:SYMBOL" or "SYMBOL" (NSE)
+    std::optional<Instrument> find(std::string_view spec) const;
+
+    // Websocket subscription key, "<segment>|<token>" (e.g. "nse_fo|43210"), or the
+    // bare token for exchanges the feed has no segment for
+    static std::string feed_key(const Instrument& ins);
+    static std::string_view feed_segment(std::string_view exchange);
+
+    Stats stats() const noexcept { return stats_; }
+
+private:
+    void adopt(std::vector<char> image, const std::string& date);
+    void unmap() noexcept;
+
+    Logger& log_;
+    std::vector<char> owned_;          // parsed image, or empty when mapped
+    void* map_ = nullptr;
+    std::size_t map_size_ = 0;
+    const char* base_ = nullptr;       // image start
+    std::string date_;
+    Stats stats_;
+};
@@ -0,0 +1,95 @@
+// include/json_stream.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// SAX events from JsonStreamParser. Names follow nlohmann::json_sax; string_view
+// arguments point into the parser's buffer and are valid only during the call.
+// Returning false from any event stops the parse.
+class JsonSaxHandler {
+public:
+    virtual ~JsonSaxHandler() = default;
+
+    virtual bool null() { return true; }
+    virtual bool boolean(bool) { return true; }
+    virtual bool number_integer(std::int64_t) { return true; }          // negative integers
+    virtual bool number_unsigned(std::uint64_t) { return true; }        // non-negative integers
+    virtual bool number_float(double, std::string_view /*raw*/) { return true; }  // fractions, exponents, overflow
+    virtual bool string(std::string_view) { return true; }
+    virtual bool key(std::string_view) { return true; }
+    virtual bool start_object() { return true; }
+    virtual bool end_object() { return true; }
+    virtual bool start_array() { return true; }
+    virtual bool end_array() { return true; }
+};
+
+// Incremental (push) JSON parser for documents too large to hold in memory, such
+// as the instrument master while it downloads: feed() takes chunks split at any
+// byte and events are reported as soon as each token is complete. Memory is the
+// nesting stack plus the longest single string or number.
+//
+//   InstrumentHandler h;
+//   JsonStreamParser p(h);
+//   http.get_stream(url, [&p](std::string_view chunk) { return p.feed(chunk); });
+//   if (!p.finish()) log.error(p.error());
+class JsonStreamParser {
+public:
+    struct Options {
+        std::size_t max_depth = 512;
+        std::size_t max_token = 1 << 20;       // longest string or number, bytes
+        bool multiple_values = false;          // a stream of top-level values (NDJSON, concatenated)
+    };
+
+    explicit JsonStreamParser(JsonSaxHandler& handler);
+    JsonStreamParser(JsonSaxHandler& handler, Options opts);
+
+    // false once the input is invalid, a limit is hit or the handler stopped
+    bool feed(std::string_view chunk);
+    // End of input: false if the document is incomplete (or empty)
+    bool finish();
+    // Parse a new document with the same handler
+    void reset();
+
+    bool failed() const noexcept { return !error_.empty(); }
+    const std::string& error() const noexcept { return error_; }   // "<what> at byte <n>"
+    std::uint64_t bytes() const noexcept { return offset_; }
+    std::uint64_t values() const noexcept { return values_; }     // completed top-level values
+
+private:
+    enum class Expect : std::uint8_t { Value, ValueOrEnd, Key, KeyOrEnd, Colon, CommaOrEnd, Done };
+    enum class Token : std::uint8_t { None, String, Number, Literal };
+
+    const char* scan_string(const char* p, const char* end);
+    bool string_escape(char c);
+    void append_code_point(std::uint32_t cp);
+    void flush_surrogate();
+    bool end_string();
+    bool end_number();
+    bool structural(char c);
+    bool begin_value(char c);
+    bool close(char c);
+    void value_done();
+    bool fail(const char* what);
+    bool stopped(bool ok) { return ok || fail("stopped by handler"); }
+
+    JsonSaxHandler& h_;
+    Options opts_;
+
+    Expect expect_ = Expect::Value;
+    Token tok_ = Token::None;
+    std::vector<char> stack_;          // '{' / '['
+    std::string buf_;                  // current string / number
+    bool key_ = false;                 // the string is an object key
+    std::uint8_t esc_ = 0;             // 0, 1 after '\', 2..5 reading \uXXXX digits
+    std::uint32_t code_ = 0;
+    std::uint32_t high_ = 0;           // pending high surrogate
+    const char* lit_ = nullptr;        // "true" / "false" / "null"
+    std::size_t lit_pos_ = 0;
+
+    std::uint64_t offset_ = 0;
+    std::uint64_t values_ = 0;
+    std::string error_;
+};
@@ -0,0 +1,129 @@
+// include/latency_histogram.h
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Per-stage timing is compiled in unless built with -DALPHA_STAGE_TIMING=OFF;
+// it is then switched on per Sharder (Options::stage_timing).
+#ifdef ALPHA_NO_STAGE_TIMING
+inline constexpr bool kStageTimingCompiled = false;
+#else
+inline constexpr bool kStageTimingCompiled = true;
+#endif
+
+// Cheap timestamp: the TSC on x86 (invariant on anything recent), steady_clock
+// ns elsewhere. Only differences on one machine are meaningful.
+inline std::uint64_t tsc_now() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Nanoseconds per tsc_now() tick; calibrated against steady_clock on first call (~20ms)
+double tsc_ns_per_tick();
+
+// HDR-style log-linear histogram of tick counts: 2^kSubBits linear buckets per
+// power of two, so every value is kept to ~3% precision from 1 tick to 2^44.
+// One writer thread (record() is a relaxed load/store per counter, no RMW);
+// any thread may read or merge a copy at the same time.
+class LatencyHistogram {
+public:
+    static constexpr unsigned kSubBits = 5;
+    static constexpr std::size_t kSub = std::size_t{1} << kSubBits;
+    static constexpr unsigned kMaxBits = 44;                 // larger values are clamped
+    static constexpr std::size_t kBuckets = (kMaxBits - kSubBits + 1) * kSub;
+
+    struct Summary {
+        std::uint64_t count = 0;
+        double p50_ns = 0, p99_ns = 0, p999_ns = 0, max_ns = 0;
+    };
+
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram& o) noexcept { merge_from(o); }
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    // Writer thread only
+    void record(std::uint64_t ticks) noexcept {
+        bump(counts_[index(ticks)], 1);
+        bump(count_, 1);
+        if (ticks > max_.load(std::memory_order_relaxed)) max_.store(ticks, std::memory_order_relaxed);
+    }
+
+    // Add o's counts into this one (this must not have a concurrent writer)
+    void merge_from(const LatencyHistogram& o) noexcept;
+    void reset() noexcept;                                   // writer paused
+
+    std::uint64_t count() const noexcept { return count_.load(std::memory_order_relaxed); }
+    std::uint64_t max() const noexcept { return max_.load(std::memory_order_relaxed); }
+    // Highest value equivalent to the q-quantile (0 < q <= 1), in ticks
+    std::uint64_t quantile(double q) const noexcept;
+    Summary summary() const;                                 // in ns
+
+    static std::size_t index(std::uint64_t v) noexcept {
+        constexpr std::uint64_t top = (std::uint64_t{1} << kMaxBits) - 1;
+        if (v > top) v = top;
+        if (v < kSub) return static_cast<std::size_t>(v);
+        const unsigned shift = static_cast<unsigned>(std::bit_width(v)) - 1 - kSubBits;
+        return shift * kSub + static_cast<std::size_t>(v >> shift);
+    }
+    static std::uint64_t highest_equivalent(std::size_t i) noexcept;
+
+private:
+    static void bump(std::atomic<std::uint64_t>& a, std::uint64_t n) noexcept {
+        a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<std::uint64_t>, kBuckets> counts_{};
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> max_{0};
+};
+
+// Where a frame's time goes between the socket and LTPStore::upsert
+enum class Stage : std::size_t {
+    ReadToEnqueue,   // WS read completion -> ingest ring push
+    QueueWait,       // ring push -> Consumer pop
+    Parse,           // pop -> parsed LTP
+    Publish,         // parsed -> stored (arbitration, rate tracking, upsert)
+    Total,           // read -> stored
+    Count
+};
+inline constexpr std::size_t kStageCount = static_cast<std::size_t>(Stage::Count);
+const char* stage_name(Stage s) noexcept;
+
+// One histogram per stage for one stream of frames, written by the thread that
+// publishes them (the Consumer): every stamp rides with the frame, so nothing
+// here is shared between writers.
+class StageHistograms {
+public:
+    using Summaries = std::array<LatencyHistogram::Summary, kStageCount>;
+
+    void record(std::uint64_t read, std::uint64_t enqueued, std::uint64_t dequeued,
+                std::uint64_t parsed, std::uint64_t published) noexcept {
+        h_[0].record(span(read, enqueued));
+        h_[1].record(span(enqueued, dequeued));
+        h_[2].record(span(dequeued, parsed));
+        h_[3].record(span(parsed, published));
+        h_[4].record(span(read, published));
+    }
+
+    const LatencyHistogram& operator[](Stage s) const noexcept { return h_[static_cast<std::size_t>(s)]; }
+    void merge_from(const StageHistograms& o) noexcept;
+    Summaries summaries() const;
+
+private:
+    // stamps come from different cores: never let skew wrap to a huge value
+    static std::uint64_t span(std::uint64_t from, std::uint64_t to) noexcept { return to > from ? to - from : 0; }
+
+    std::array<LatencyHistogram, kStageCount> h_;
+};
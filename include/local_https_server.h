@@ -0,0 +1,87 @@
+// include/local_https_server.h
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+class Logger;
+
+// Local HTTPS/1.1 stand-in for the broker REST API, for offline tests and
+// benchmarks. Requests are dispatched by method + path (query string excluded) to
+// registered handlers; anything else gets 404. Connections are kept alive as the
+// client asks. Counts connections, full and resumed TLS handshakes and requests,
+// and can add a simulated network round trip.
+class LocalHttpsServer {
+public:
+    struct Request {
+        std::string method;                          // "GET", "POST", ...
+        std::string target;                          // path + query as sent
+        std::string path;
+        std::map<std::string, std::string> query;    // decoded
+        std::map<std::string, std::string> headers;  // names lower-cased
+        std::string body;
+        std::uint64_t connection = 0;                // 1-based id of the TCP connection
+    };
+
+    struct Response {
+        int status = 200;
+        std::string body;
+        std::string content_type = "application/json";
+        std::map<std::string, std::string> headers;
+        bool close = false;                          // send "Connection: close" and hang up
+        bool drop = false;                           // hang up without responding
+    };
+
+    using Handler = std::function<Response(const Request&)>;
+
+    struct Options {
+        std::string address = "127.0.0.1";
+        unsigned short port = 0;                     // 0 = ephemeral, see port()
+        std::size_t threads = 1;                     // IO threads
+        // TLS: PEM files, or empty to generate a self-signed cert for 127.0.0.1/localhost
+        std::string cert_file;
+        std::string key_file;
+        // Simulated network: every response is delayed by one rtt, a new connection's
+        // TLS handshake by two more (TCP + TLS). 0 = loopback speed.
+        std::chrono::microseconds rtt{0};
+        // Close keep-alive connections idle this long (0 = never), as real servers do
+        std::chrono::milliseconds idle_close{0};
+        std::size_t max_requests_per_connection = 0; // then "Connection: close" (0 = unlimited)
+    };
+
+    struct Stats {
+        std::uint64_t connections = 0;               // accepted
+        std::uint64_t live_connections = 0;
+        std::uint64_t handshakes = 0;                // completed TLS handshakes
+        std::uint64_t resumed = 0;                   // of which resumed a session
+        std::uint64_t requests = 0;
+    };
+
+    LocalHttpsServer(Logger& log, Options opts);
+    ~LocalHttpsServer();
+
+    LocalHttpsServer(const LocalHttpsServer&) = delete;
+    LocalHttpsServer& operator=(const LocalHttpsServer&) = delete;
+
+    // Handlers run on the IO threads; register before start()
+    void route(const std::string& method, const std::string& path, Handler h);
+
+    bool start();     // bind, listen, spawn IO threads; false on bind/TLS error
+    void stop();
+
+    unsigned short port() const noexcept;
+    std::string url() const;                         // https://127.0.0.1:<port>
+    const std::string& cert_file() const noexcept;   // CA file for clients
+
+    // Close every connection abruptly (TCP close, no TLS close_notify)
+    void drop_all();
+
+    Stats stats() const;
+
+private:
+    struct Impl;      // keeps Beast/Asio out of the header
+    Impl* impl_;
+};
@@ -1,17 +1,88 @@
 #pragma once
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <mutex>
 #include <ostream>
 #include <memory>
 #include <iostream>
+#include <limits>
 
 enum class LogLevel {TRACE, DEBUG, INFO, WARN, ERROR };
 
+// Compile-time minimum level: log calls below it compile to nothing (the ALPHA_LOG
+// macros, the *_fmt functions, trace()..error()). Set by CMake (ALPHA_MIN_LOG_LEVEL;
+// release builds default to INFO); the runtime level filters on top of it.
+#ifndef ALPHA_LOG_MIN_LEVEL
+#define ALPHA_LOG_MIN_LEVEL TRACE
+#endif
+inline constexpr LogLevel kMinLogLevel = LogLevel::ALPHA_LOG_MIN_LEVEL;
+
+constexpr bool log_compiled(LogLevel lvl) noexcept {
+    return static_cast<int>(lvl) >= static_cast<int>(kMinLogLevel);
+}
+
+namespace logger_detail {
+
+// Number of "{}" placeholders in fmt ("{{" and "}}" are literal braces); -1 if a
+// brace is neither (format specs are not supported)
+constexpr int count_placeholders(std::string_view fmt) noexcept {
+    int n = 0;
+    for (std::size_t i = 0; i < fmt.size(); ++i) {
+        const char c = fmt[i];
+        if (c != '{' && c != '}') continue;
+        if (i + 1 < fmt.size() && fmt[i + 1] == c) {
+            ++i;
+        } else if (c == '{' && i + 1 < fmt.size() && fmt[i + 1] == '}') {
+            ++n;
+            ++i;
+        } else {
+            return -1;
+        }
+    }
+    return n;
+}
+
+} // namespace logger_detail
+
+// A format string checked against its argument count at compile time, like
+// std::format_string: "{}" per argument, "{{" / "}}" for literal braces.
+template<typename... Args>
+struct LogFormat {
+    template<typename S>
+        requires std::is_convertible_v<const S&, std::string_view>
+    consteval LogFormat(const S& s) : str(s) {
+        const int n = logger_detail::count_placeholders(str);
+        if (n < 0) throw "log format: stray brace (only {} placeholders and {{ }} escapes)";
+        if (n != static_cast<int>(sizeof...(Args))) throw "log format: {} placeholders do not match the arguments";
+    }
+
+    std::string_view str;
+};
+
+template<typename... Args>
+using LogFormatFor = LogFormat<std::type_identity_t<Args>...>;
+
 class Logger {
 public:
+    // Asynchronous mode: a log call copies the message into a lock-free ring owned
+    // by the calling thread and returns; a background thread merges the rings in
+    // timestamp order, formats (date/time cached per second) and writes in batches.
+    struct AsyncOptions {
+        std::size_t ring_bytes = 64 * 1024;            // per logging thread (power of two)
+        std::chrono::microseconds poll_interval{1000}; // background wake-up when idle
+        bool block_when_full = false;                  // false: drop the record and count it
+    };
+
     // create with program wide name and option output stream 
     explicit Logger(std::string name, std::ostream& out = std::cout);
+    ~Logger();
 
     // non-copyyable, movable
     Logger(const Logger&) = delete;
@@ -22,38 +93,218 @@ public:
     void set_level(LogLevel level) noexcept;
     LogLevel level() const noexcept;
 
+    // Switch to / from asynchronous mode. stop_async() (and the destructor) write
+    // out every record logged before it; later calls are written synchronously.
+    // Neither may race with moving or destroying the Logger.
+    void start_async();
+    void start_async(AsyncOptions opts);
+    void stop_async();
+    bool is_async() const noexcept;
+    // Async: block until records logged before the call are written
+    void flush();
+    // Async: records lost to a full ring (block_when_full = false)
+    std::uint64_t dropped() const noexcept;
+
+
+    // Would a message at lvl be written? Check before building an expensive one
+    bool enabled(LogLevel lvl) const noexcept {
+        return static_cast<int>(lvl) >= static_cast<int>(level_.load(std::memory_order_relaxed));
+    }
 
     // Basic loging API (thread-safe)
-    void log(LogLevel lvl, const std::string& msg);
-    void trace(const std::string& msg);
-    void debug(const std::string& msg);
-    void info(const std::string& msg);
-    void warn(const std::string& msg);
-    void error(const std::string& msg);
-
-    // convenience: formated log 
+    void log(LogLevel lvl, std::string_view msg);
+    void trace(std::string_view msg) { if constexpr (log_compiled(LogLevel::TRACE)) log(LogLevel::TRACE, msg); }
+    void debug(std::string_view msg) { if constexpr (log_compiled(LogLevel::DEBUG)) log(LogLevel::DEBUG, msg); }
+    void info(std::string_view msg)  { if constexpr (log_compiled(LogLevel::INFO))  log(LogLevel::INFO, msg); }
+    void warn(std::string_view msg)  { if constexpr (log_compiled(LogLevel::WARN))  log(LogLevel::WARN, msg); }
+    void error(std::string_view msg) { if constexpr (log_compiled(LogLevel::ERROR)) log(LogLevel::ERROR, msg); }
+
+    // Formatted log: info_fmt("token={} ltp={}", tok, px). The format is checked at
+    // compile time; arguments are formatted (into a reused per-thread buffer) only
+    // when the level is enabled. Arguments must not log themselves while formatted.
+    template<typename... Args>
+    void log_fmt(LogLevel lvl, LogFormatFor<Args...> fmt, const Args&... args);
+    template<typename... Args>
+    void trace_fmt(LogFormatFor<Args...> fmt, const Args&... args) {
+        if constexpr (log_compiled(LogLevel::TRACE)) log_fmt(LogLevel::TRACE, fmt, args...);
+    }
+    template<typename... Args>
+    void debug_fmt(LogFormatFor<Args...> fmt, const Args&... args) {
+        if constexpr (log_compiled(LogLevel::DEBUG)) log_fmt(LogLevel::DEBUG, fmt, args...);
+    }
+    template<typename... Args>
+    void info_fmt(LogFormatFor<Args...> fmt, const Args&... args) {
+        if constexpr (log_compiled(LogLevel::INFO)) log_fmt(LogLevel::INFO, fmt, args...);
+    }
+    template<typename... Args>
+    void warn_fmt(LogFormatFor<Args...> fmt, const Args&... args) {
+        if constexpr (log_compiled(LogLevel::WARN)) log_fmt(LogLevel::WARN, fmt, args...);
+    }
     template<typename... Args>
-    void info_fmt(const std::string& fmt, Args&&... args);
+    void error_fmt(LogFormatFor<Args...> fmt, const Args&... args) {
+        if constexpr (log_compiled(LogLevel::ERROR)) log_fmt(LogLevel::ERROR, fmt, args...);
+    }
 
 private:
+    struct Async;     // rings + formatter thread (src/logger.cpp)
+
     std::string name_;
-    LogLevel level_;
+    std::atomic<LogLevel> level_;
     std::ostream* out_;
     std::unique_ptr<std::mutex> mutex_;
-    void emit(LogLevel lvl, const std::string& payload);
+    std::atomic<Async*> async_{nullptr};   // created by the first start_async(), kept until destruction
+    void emit(LogLevel lvl, std::string_view payload);
 
 };
 
-template<typename... Args>
-inline void Logger::info_fmt(const std::string& /*fmt*/, Args&&... args) {
-    std::ostringstream oss;
-    (oss << ... << std::forward<Args>(args));
-    info(oss.str());
+// At most max_per_interval messages per interval from one log site; the next
+// message let through reports how many were suppressed. Lock-free.
+class LogRateLimiter {
+public:
+    LogRateLimiter(std::uint32_t max_per_interval, std::chrono::nanoseconds interval) noexcept
+        : max_(max_per_interval), interval_ns_(interval.count()) {}
+
+    // true = write it; `suppressed` is set to the count skipped since the last one written
+    bool allow(std::uint64_t& suppressed) noexcept {
+        const std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        std::int64_t start = window_start_.load(std::memory_order_relaxed);
+        if (now - start >= interval_ns_ && window_start_.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+            in_window_.store(0, std::memory_order_relaxed);
+        }
+        if (in_window_.fetch_add(1, std::memory_order_relaxed) < max_) {
+            suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+            return true;
+        }
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+private:
+    const std::uint32_t max_;
+    const std::int64_t interval_ns_;
+    std::atomic<std::int64_t> window_start_{std::numeric_limits<std::int64_t>::min() / 2};
+    std::atomic<std::uint64_t> in_window_{0};
+    std::atomic<std::uint64_t> suppressed_{0};
+};
+
+// 1-in-N sampling for one log site
+class LogSampler {
+public:
+    explicit LogSampler(std::uint32_t every_n) noexcept : n_(every_n ? every_n : 1) {}
+    bool sample() noexcept { return n_ == 1 || count_.fetch_add(1, std::memory_order_relaxed) % n_ == 0; }
+
+private:
+    const std::uint32_t n_;
+    std::atomic<std::uint64_t> count_{0};
+};
+
+namespace logger_detail {
+
+template<typename T>
+void append_arg(std::string& out, const T& v) {
+    if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        out += std::string_view(v);
+    } else if constexpr (std::is_same_v<T, char>) {
+        out += v;
+    } else if constexpr (std::is_same_v<T, bool>) {
+        out += v ? "true" : "false";
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        char buf[64];
+        const auto r = std::to_chars(buf, buf + sizeof(buf), v);
+        out.append(buf, r.ptr);
+    } else {
+        std::ostringstream oss;
+        oss << v;
+        out += oss.str();
+    }
+}
+
+// Copy fmt up to the next "{}" (unescaping "{{" / "}}"); false when there is none
+inline bool append_until_placeholder(std::string& out, std::string_view& fmt) {
+    std::size_t i = 0;
+    while (i < fmt.size()) {
+        const char c = fmt[i];
+        if ((c == '{' || c == '}') && i + 1 < fmt.size() && fmt[i + 1] == c) {
+            out += c;
+            i += 2;
+        } else if (c == '{' && i + 1 < fmt.size() && fmt[i + 1] == '}') {
+            fmt.remove_prefix(i + 2);
+            return true;
+        } else {
+            out += c;
+            ++i;
+        }
+    }
+    fmt = {};
+    return false;
 }
 
+// Per-thread scratch for formatted messages; keeps its capacity between calls
+inline std::string& format_buffer() {
+    thread_local std::string buf;
+    return buf;
+}
 
+// out = fmt with each "{}" replaced by the next argument
+template<typename... Args>
+void format_into(std::string& out, LogFormatFor<Args...> fmt, const Args&... args) {
+    std::string_view rest = fmt.str;
+    out.clear();
+    ((append_until_placeholder(out, rest), append_arg(out, args)), ...);
+    append_until_placeholder(out, rest);
+}
 
+} // namespace logger_detail
 
+template<typename... Args>
+inline void Logger::log_fmt(LogLevel lvl, LogFormatFor<Args...> fmt, const Args&... args) {
+    if (!log_compiled(lvl) || !enabled(lvl)) return;
+    std::string& buf = logger_detail::format_buffer();
+    logger_detail::format_into(buf, fmt, args...);
+    log(lvl, buf);
+}
 
+// Log-site macros, std::format style: ALPHA_LOG(log, LogLevel::INFO, "token={}", t).
+// lvl must be a constant; sites below kMinLogLevel compile to nothing. The
+// arguments are evaluated and formatted only when the line is actually written
+// (level enabled, sampled in, not rate limited). The sampler / limiter is a static
+// per expansion, i.e. shared by every caller of that line.
+#define ALPHA_LOG(logger, lvl, fmt, ...)                                              \
+    do {                                                                              \
+        if constexpr (::log_compiled(lvl)) {                                          \
+            auto& alpha_log_ = (logger);                                              \
+            if (alpha_log_.enabled(lvl)) alpha_log_.log_fmt((lvl), fmt __VA_OPT__(,) __VA_ARGS__); \
+        }                                                                             \
+    } while (0)
 
+// Every n-th call at this site
+#define ALPHA_LOG_EVERY_N(logger, lvl, n, fmt, ...)                                   \
+    do {                                                                              \
+        if constexpr (::log_compiled(lvl)) {                                          \
+            static LogSampler alpha_sampler_{(n)};                                    \
+            auto& alpha_log_ = (logger);                                              \
+            if (alpha_log_.enabled(lvl) && alpha_sampler_.sample())                   \
+                alpha_log_.log_fmt((lvl), fmt __VA_OPT__(,) __VA_ARGS__);             \
+        }                                                                             \
+    } while (0)
 
+// At most max_n per interval at this site, then "[suppressed K messages]" on the next one
+#define ALPHA_LOG_RATE_LIMITED(logger, lvl, max_n, interval, fmt, ...)                \
+    do {                                                                              \
+        if constexpr (::log_compiled(lvl)) {                                          \
+            static LogRateLimiter alpha_limiter_{(max_n), (interval)};                \
+            auto& alpha_log_ = (logger);                                              \
+            std::uint64_t alpha_suppressed_ = 0;                                      \
+            if (alpha_log_.enabled(lvl) && alpha_limiter_.allow(alpha_suppressed_)) { \
+                std::string& alpha_buf_ = ::logger_detail::format_buffer();           \
+                ::logger_detail::format_into(alpha_buf_, fmt __VA_OPT__(,) __VA_ARGS__); \
+                if (alpha_suppressed_ != 0) {                                         \
+                    alpha_buf_ += " [suppressed ";                                    \
+                    ::logger_detail::append_arg(alpha_buf_, alpha_suppressed_);       \
+                    alpha_buf_ += " messages]";                                       \
+                }                                                                     \
+                alpha_log_.log((lvl), alpha_buf_);                                    \
+            }                                                                         \
+        }                                                                             \
+    } while (0)
@@ -1,19 +1,29 @@
 #pragma once
 #include "parser.h"
 #include <unordered_map>
+#include <unordered_set>
 #include <shared_mutex>
 #include <optional>
 #include <string>
+#include <vector>
 
 class LTPStore {
 public:
-    void upsert(const LTP& v);                          // token -> overwrite {ltp, ts}
+    void upsert(const LTP& v);                          // token -> overwrite {ltp, ts}; ignored while retired
     std::optional<LTP> get(const std::string& token) const;
     std::unordered_map<std::string, LTP> snapshot() const;
     std::size_t size() const;
+    // Tokens whose last tick was received before cutoff (per-instrument staleness)
+    std::vector<std::string> received_before(std::chrono::steady_clock::time_point cutoff) const;
+
+    // The instrument left the subscribed universe: drop its last quote, and ignore
+    // ticks still in flight for it until readmit()
+    void retire(const std::vector<std::string>& tokens);
+    void readmit(const std::vector<std::string>& tokens);
 
 private:
     mutable std::shared_mutex mu_;
     std::unordered_map<std::string, LTP> map_;
+    std::unordered_set<std::string> retired_;
 };
 
@@ -0,0 +1,89 @@
+// include/market_data_server.h
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+class Logger;
+
+// Local synthetic market-data feed over TLS WebSocket, for offline tests and
+// benchmarks. Speaks the SubscriptionManager protocol:
+//   {"action":"subscribe"|"unsubscribe","mode":"ltp","tokens":["nse_cm|26000",...]}
+// acknowledges each subscribe with {"type":"ack","action":"subscribe","count":N},
+// and streams Parser-compatible ticks for subscribed tokens:
+//   {"data":{"token":"nse_cm|26000","ltp":101.25,"exchange_timestamp":<epoch ns>}}
+// One generator drives every instrument, so all sessions subscribed to a token
+// receive byte-identical ticks (as A/B legs of a real feed would). Any other text
+// frame is echoed back.
+class MarketDataServer {
+public:
+    // Periodic rate multiplier, e.g. {1000ms, 100ms, 20.0}: 20x for 100ms every second
+    struct Burst {
+        std::chrono::milliseconds period{0};   // 0 = no bursts
+        std::chrono::milliseconds length{0};
+        double multiplier = 1.0;
+    };
+
+    struct Options {
+        std::string address = "127.0.0.1";
+        unsigned short port = 0;               // 0 = ephemeral, see port()
+        std::size_t threads = 1;               // IO threads
+        // TLS: PEM files, or empty to generate a self-signed cert for 127.0.0.1/localhost
+        std::string cert_file;
+        std::string key_file;
+        bool deflate = false;                  // accept permessage-deflate offers
+
+        double default_rate = 0.0;             // ticks/sec per subscribed instrument
+        std::map<std::string, double> rates;   // per token (as subscribed, prefix included)
+        Burst burst;
+        std::chrono::microseconds tick_interval{1000}; // generator granularity
+        std::size_t max_queue = 4096;          // per-session backlog before ticks are dropped
+    };
+
+    struct Stats {
+        std::uint64_t sessions = 0;            // accepted since start
+        std::uint64_t live_sessions = 0;
+        std::uint64_t subscribes = 0;          // subscribe payloads handled
+        std::uint64_t ticks = 0;               // ticks generated (before fan-out)
+        std::uint64_t frames_sent = 0;         // frames written, all sessions
+        std::uint64_t dropped = 0;             // frames dropped on slow sessions
+        std::uint64_t rejected = 0;            // handshakes refused (see set_authorization())
+    };
+
+    MarketDataServer(Logger& log, Options opts);
+    ~MarketDataServer();
+
+    MarketDataServer(const MarketDataServer&) = delete;
+    MarketDataServer& operator=(const MarketDataServer&) = delete;
+
+    bool start();     // bind, listen, spawn IO + generator threads; false on bind/TLS error
+    void stop();      // close sessions, join
+
+    unsigned short port() const noexcept;
+    std::string url() const;                   // wss://127.0.0.1:<port>
+    const std::string& cert_file() const noexcept; // CA file for clients (self-signed or Options::cert_file)
+
+    void set_rate(const std::string& token, double ticks_per_sec);   // live
+    // Handshakes must carry "Authorization: <value>" or get 401 (empty = no check); live
+    void set_authorization(const std::string& value);
+    // Accept one more value (one per account), or stop accepting one and close its
+    // sessions, as a broker does when a session is terminated
+    void allow_authorization(const std::string& value);
+    void revoke_authorization(const std::string& value);
+    // Live sessions per Authorization value they were accepted with
+    std::map<std::string, std::size_t> live_by_authorization() const;
+
+    // Fault injection for reconnect / stall benchmarks
+    void drop_all();            // close every session abruptly (TCP close, no WS close)
+    void stall_streaming();     // sessions with subscriptions stop sending anything; new sessions are fine
+    void drop_subscribed();     // close every session with subscriptions abruptly; idle ones (standbys) stay up
+    void notify_idle(const std::string& text);  // send text to every session without subscriptions (a broker notice)
+
+    Stats stats() const;
+
+private:
+    struct Impl;      // keeps Beast/Asio out of the header
+    Impl* impl_;
+};
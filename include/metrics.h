@@ -0,0 +1,116 @@
+// include/metrics.h
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Logger;
+
+// Process metrics: counters and gauges registered once (allocating, locked) and
+// then updated through stable references on the hot path without locks or
+// allocation. Read back as a snapshot or in Prometheus text exposition format.
+class MetricsRegistry {
+public:
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+
+    // Monotonic counter striped over cache-line-padded cells: each thread adds
+    // to its own cell (relaxed, uncontended), readers sum them.
+    class Counter {
+    public:
+        static constexpr std::size_t kStripes = 16;
+        void inc(std::uint64_t n = 1) noexcept {
+            cells_[stripe()].v.fetch_add(n, std::memory_order_relaxed);
+        }
+        std::uint64_t value() const noexcept;
+    private:
+        struct alignas(64) Cell { std::atomic<std::uint64_t> v{0}; };
+        static std::size_t stripe() noexcept;
+        std::array<Cell, kStripes> cells_{};
+    };
+
+    // Point-in-time value on its own cache line
+    class alignas(64) Gauge {
+    public:
+        void set(std::int64_t v) noexcept { v_.store(v, std::memory_order_relaxed); }
+        void add(std::int64_t d) noexcept { v_.fetch_add(d, std::memory_order_relaxed); }
+        // High-water mark: a plain load unless v is a new maximum
+        void update_max(std::int64_t v) noexcept {
+            std::int64_t cur = v_.load(std::memory_order_relaxed);
+            while (v > cur && !v_.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+        }
+        std::int64_t value() const noexcept { return v_.load(std::memory_order_relaxed); }
+    private:
+        std::atomic<std::int64_t> v_{0};
+    };
+
+    enum class Kind { Counter, Gauge };
+
+    struct Sample {
+        std::string name;
+        Labels labels;
+        Kind kind;
+        double value;
+    };
+
+    MetricsRegistry() = default;
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    // Get or create. The reference stays valid for the registry's lifetime.
+    // A name must keep one kind (std::invalid_argument otherwise); help is taken
+    // from the first registration.
+    Counter& counter(const std::string& name, const std::string& help, const Labels& labels = {});
+    Gauge& gauge(const std::string& name, const std::string& help, const Labels& labels = {});
+
+    std::vector<Sample> snapshot() const;
+    // Sum over every series of name whose labels include `match`
+    double value(const std::string& name, const Labels& match = {}) const;
+    std::string prometheus_text() const;
+
+private:
+    struct Series {
+        std::string name;
+        std::string help;
+        Labels labels;
+        Kind kind;
+        Counter* counter = nullptr;
+        Gauge* gauge = nullptr;
+    };
+    Series* find_locked(const std::string& name, const Labels& labels);
+    void check_kind_locked(const std::string& name, Kind kind) const;
+
+    mutable std::mutex mu_;          // registration and reads only
+    std::deque<Counter> counters_;   // deque: stable addresses
+    std::deque<Gauge> gauges_;
+    std::vector<Series> series_;     // registration order
+};
+
+// Minimal HTTP/1.1 endpoint serving GET /metrics from a registry (plain text,
+// meant for 127.0.0.1 and a Prometheus scraper). One background thread.
+class MetricsServer {
+public:
+    struct Options {
+        std::string address = "127.0.0.1";
+        unsigned short port = 0;     // 0 = ephemeral, see port()
+    };
+
+    MetricsServer(Logger& log, const MetricsRegistry& registry, Options opts);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    bool start();     // bind + listen; false on error
+    void stop();
+    unsigned short port() const noexcept;
+
+private:
+    struct Impl;      // keeps Beast/Asio out of the header
+    Impl* impl_;
+};
@@ -0,0 +1,113 @@
+// include/overload_guard.h
+#pragma once
+#include "ingest_queue.h"
+#include "metrics.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class Logger;
+
+// What happens to a frame that arrives while the ingest queue is full
+enum class OverloadPolicy {
+    DropNewest,     // discard the arriving frame (cheapest; keeps stale prices queued)
+    DropOldest,     // discard the oldest queued frame (queue built with allow_evict)
+    Conflate,       // park the frame in a side buffer holding the latest update per instrument
+    Backpressure,   // hold the frame and stop reading the socket until the queue has room
+};
+
+const char* overload_policy_name(OverloadPolicy p) noexcept;
+
+// Producer-side front of one IngestQueue. offer() runs on the IO thread for every
+// frame and costs one push while the queue has room; the policy only kicks in when
+// it is full. Overload is counted per policy and reported at most once per
+// report_interval instead of once per frame.
+//
+// Conflate: once the ring is full every frame goes to the side buffer (one slot per
+// instrument, latest wins) until the Consumer has drained the ring and taken the
+// buffer, so an instrument's updates are never reordered.
+class OverloadGuard {
+public:
+    struct Options {
+        OverloadPolicy policy = OverloadPolicy::DropNewest;
+        std::size_t conflate_capacity = 4096;              // instruments parked at once; beyond: drop newest
+        std::chrono::milliseconds report_interval{5000};   // at most one overload warning per interval
+    };
+
+    // Registry series to bump alongside the internal counts (any may be null)
+    struct Counters {
+        MetricsRegistry::Counter* dropped = nullptr;
+        MetricsRegistry::Counter* evicted = nullptr;
+        MetricsRegistry::Counter* conflated = nullptr;
+        MetricsRegistry::Counter* read_pauses = nullptr;
+    };
+
+    struct Stats {
+        std::uint64_t dropped = 0;      // frames lost: arriving frame discarded
+        std::uint64_t evicted = 0;      // frames lost: oldest queued frame discarded (DropOldest)
+        std::uint64_t conflated = 0;    // frames lost: superseded by a newer update of the instrument
+        std::uint64_t parked = 0;       // frames routed through the conflation buffer
+        std::uint64_t read_pauses = 0;  // socket reads held back (Backpressure)
+    };
+
+    // A frame parked by Conflate
+    struct Parked {
+        std::string frame;
+        IngestQueue::Stamp stamp;
+    };
+
+    OverloadGuard(IngestQueue& q, Logger& log, std::string name, Options opts);
+    OverloadGuard(IngestQueue& q, Logger& log, std::string name, Options opts, Counters counters);
+
+    OverloadGuard(const OverloadGuard&) = delete;
+    OverloadGuard& operator=(const OverloadGuard&) = delete;
+
+    // Producer. false = the frame was dropped.
+    bool offer(std::string_view msg, const IngestQueue::Stamp& stamp);
+    // Producer, Backpressure: moves a held frame into the queue; true = reads may go on
+    bool ready();
+
+    // Consumer, Conflate: true while frames are parked
+    bool has_parked() const noexcept { return parking_.load(std::memory_order_acquire); }
+    // Swap the parked frames into `out` (call once the queue is empty). Returns how
+    // many leading entries are valid; the rest are spare buffers kept for reuse.
+    std::size_t take_parked(std::vector<Parked>& out);
+
+    OverloadPolicy policy() const noexcept { return opts_.policy; }
+    Stats stats() const noexcept;
+
+    // Instrument id of a raw tick frame ("token" field), empty if there is none
+    static std::string_view instrument_key(std::string_view frame) noexcept;
+
+private:
+    bool park(std::string_view msg, const IngestQueue::Stamp& stamp);
+    void count(std::atomic<std::uint64_t>& c, MetricsRegistry::Counter* reg) noexcept;
+    void report();
+
+    IngestQueue& q_;
+    Logger& log_;
+    std::string name_;
+    Options opts_;
+    Counters reg_;
+
+    std::atomic<std::uint64_t> dropped_{0}, evicted_{0}, conflated_{0}, parked_{0}, pauses_{0};
+    std::atomic<std::int64_t> last_report_ns_{0};
+
+    // Conflate side buffer (locked only while overloaded)
+    std::atomic<bool> parking_{false};
+    std::mutex park_mu_;
+    std::vector<Parked> parked_buf_;
+    std::size_t n_parked_ = 0;
+    std::unordered_map<std::string, std::size_t> slot_of_;   // instrument -> index in parked_buf_
+
+    // Backpressure: the frame that found the queue full
+    std::string held_;
+    IngestQueue::Stamp held_stamp_{};
+    bool holding_ = false;
+};
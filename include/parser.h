@@ -8,6 +8,7 @@ struct LTP {
     std::string token;                                   // e.g. "nse_cm|26000" or raw "26000"
     double       ltp = 0.0;                              // last traded price
     std::chrono::system_clock::time_point ts{};          // event/server time if present
+    std::chrono::steady_clock::time_point recv{};        // local arrival (set by Consumer)
 };
 
 class Parser {
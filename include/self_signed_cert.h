@@ -0,0 +1,12 @@
+// include/self_signed_cert.h
+#pragma once
+#include <string>
+
+// Throwaway TLS identity for the local stand-in servers (MarketDataServer,
+// LocalHttpsServer): an EC P-256 key and a self-signed CA:TRUE certificate for
+// 127.0.0.1 / localhost, as PEM. false if OpenSSL fails.
+bool make_self_signed_cert(std::string& cert_pem, std::string& key_pem);
+
+// Write pem to a new /tmp/<prefix>XXXXXX file (clients load it as their CA file).
+// Returns the path, or "" on error. The caller unlinks it.
+std::string write_temp_pem(const std::string& pem, const std::string& prefix);
@@ -4,14 +4,41 @@
 #include <vector>
 #include <map>
 #include <cstddef>
+#include <cstdint>
 #include <atomic>
+#include <chrono>
+#include <functional>
+#include "thread_affinity.h"
+#include "feed_arbiter.h"
+#include "feed_watchdog.h"
+#include "latency_histogram.h"
+#include "overload_guard.h"
 
 class Logger;
 class LTPStore;
 class Parser;
+struct LTP;
+class MetricsRegistry;
+class BinaryLogger;
+class InstrumentMaster;
+class AccountPool;
 
 class Sharder {
 public:
+    // Where one shard's threads run
+    struct ShardPlacement {
+        ThreadPlacement io;        // WebSocketClient IO thread
+        ThreadPlacement consumer;  // Consumer thread
+    };
+
+    struct ThreadTopology {
+        std::vector<ShardPlacement> shards;  // explicit; shard i uses shards[i % size()]
+        bool auto_pin = false;               // if shards is empty: same-L3 (io, consumer) pairs from sysfs
+        ThreadPlacement::Policy policy = ThreadPlacement::Policy::OTHER; // for auto-pinned threads
+        int priority = 0;                    // for auto-pinned threads (FIFO/RR)
+        bool numa_local_alloc = true;        // allocate shard queue on its consumer cpu's NUMA node
+    };
+
     struct Options {
         std::string wss_url;                    // e.g. SmartAPI marketdata WSS URL
         std::size_t max_tokens_per_conn = 800;  // shard size (per WS)
@@ -21,6 +48,64 @@ public:
         std::string token_prefix = "nse_cm|";   // applied by SubscriptionManager
         // Extra HTTP headers for WS handshake (e.g., auth)
         std::map<std::string,std::string> headers;
+        // Thread pinning / scheduling (default: unpinned, SCHED_OTHER)
+        ThreadTopology topology;
+        // Thread budget. 0 = one blocking IO thread / one Consumer per connection.
+        // io_threads > 0 multiplexes all connections on that many async io_contexts;
+        // consumer_threads > 0 lets each Consumer drain several shard queues.
+        std::size_t io_threads = 0;
+        std::size_t consumer_threads = 0;
+        // Load-aware assignment: per-instrument tick rates are tracked by the
+        // Consumers and shards are bin-packed by expected throughput, not count.
+        bool load_aware = false;
+        std::chrono::seconds rate_half_life{60};      // decay of the rate estimate
+        std::size_t rate_width = 0;                   // sketch columns; 0 = TickRateTracker::width_for(instruments at first start)
+        std::size_t rate_depth = 4;                   // sketch rows
+        std::chrono::seconds rebalance_interval{0};   // 0 = no periodic rebalancing
+        double rebalance_threshold = 1.25;            // act when hottest shard > threshold x mean
+        // permessage-deflate on every shard connection (see WebSocketClient::Options)
+        bool deflate = false;
+        int deflate_window_bits = 15;
+        int deflate_level = 6;
+        int deflate_mem_level = 8;
+        bool deflate_no_context_takeover = false;
+        bool measure_read_cpu = false;                // per-connection inflate/TLS CPU in stats()
+        // Keep a second, already-handshaken connection per shard. When the active one
+        // drops, the standby is promoted and the shard's subscriptions are replayed on it.
+        bool hot_standby = false;
+        // Subscribe every shard on two independent connections (A/B legs) and keep
+        // the first copy of each tick (FeedArbiter). Leg B uses wss_url_b if set.
+        bool redundant_feeds = false;
+        std::string wss_url_b;
+        // Stall detection: recycle a connection silent for watchdog.max_silence during
+        // market hours; report instruments silent for watchdog.instrument_silence
+        FeedWatchdog::Options watchdog;
+        // Per-stage latency (read, enqueue, dequeue, parse, publish) via TSC stamps
+        // carried with each frame; see stage_latency(). Off: one branch per frame.
+        bool stage_timing = false;
+        // What a full ingest queue does with the next frame: drop it (default), evict
+        // the oldest, conflate per instrument, or pause the socket reads. Counted per
+        // shard and reported at most once per overload.report_interval.
+        OverloadGuard::Options overload;
+    };
+
+    // Outage accounting: time from a shard's connection drop to the first frame on
+    // its replacement (promoted standby, or the reconnected connection without one)
+    struct RecoveryStats {
+        std::uint64_t failovers = 0;    // standby promotions
+        std::uint64_t recoveries = 0;   // outages ended
+        std::uint64_t inactive_frames = 0; // arrived on a standby, dropped
+        std::chrono::microseconds last_recover{0};
+        std::chrono::microseconds max_recover{0};
+    };
+
+    // Where the shards sit on the accounts of set_accounts()
+    struct AccountLoad {
+        std::string name;
+        bool up = false;
+        std::size_t shards = 0;
+        std::size_t connections = 0;    // standbys and B legs included
+        std::size_t tokens = 0;         // subscriptions: instruments x legs
     };
 
     // Dependencies injected:
@@ -36,14 +121,38 @@ public:
 
     // Provide/refresh auth token (sets Authorization header or X-PrivateKey as needed)
     // Example: set_access_token("Bearer <JWT>");
+    // The new handshake headers are swapped into every connection (standbys
+    // included), so the next reconnect of any shard already presents them.
     void set_access_token(const std::string& auth_header_value);
+    // Same, with headers that rotate together with the token (e.g. x-feed-token),
+    // applied in the same swap
+    void set_access_token(const std::string& auth_header_value,
+                          const std::map<std::string,std::string>& session_headers);
 
     // Replace or extend handshake headers (merged with access token header)
     void set_common_headers(const std::map<std::string,std::string>& hdrs);
 
-    // Configure/replace the full desired token list (raw tokens, e.g., "26000")
+    // Spread the shards over the accounts of `pool` (before start(); the pool must
+    // outlive the Sharder). Each shard connects with one account's session headers
+    // (on top of the ones above), within the account's max_connections and
+    // max_tokens: a new shard goes to the up account with the most room, split if
+    // that is less than the shard. Shards of an account whose session fails move to
+    // an account with room and reconnect right away; instruments no account can
+    // take wait in unplaced_tokens() until one has room.
+    void set_accounts(AccountPool& pool);
+
+    // Configure/replace the full desired token list (raw tokens, e.g., "26000").
+    // While running, only the delta is applied: affected shards get targeted
+    // (un)subscribe batches, new shards start only when existing ones are full,
+    // and untouched connections keep streaming.
     void set_tokens(const std::vector<std::string>& tokens);
 
+    // set_tokens() from symbols ("NFO:NIFTY26DEC2424000CE", or "SBIN-EQ" for NSE)
+    // resolved through the instrument master. Instruments on token_prefix's segment
+    // are passed as raw tokens, others as "<segment>|<token>". Returns the specs that
+    // did not resolve.
+    std::vector<std::string> set_symbols(const InstrumentMaster& master, const std::vector<std::string>& specs);
+
     // Start all shards (build N workers, connect, subscribe)
     bool start();
 
@@ -54,6 +163,36 @@ public:
     bool running() const noexcept;
     std::size_t num_workers() const noexcept;
     std::vector<std::string> desired_tokens_snapshot() const;
+    // Per account of set_accounts(), indexed like the pool (empty without one)
+    std::vector<AccountLoad> account_loads() const;
+    std::vector<std::string> unplaced_tokens() const;
+
+    // Per-shard counters and gauges (frames, bytes, drops, queue high water, reconnects,
+    // ticks, parse failures, subscribe acks) go to a registry owned by the Sharder,
+    // or to `registry` if set before start() (it must outlive the Sharder)
+    void set_metrics(MetricsRegistry& registry);
+    MetricsRegistry& metrics() noexcept;
+
+    // Per-frame trace (shard, leg, bytes, queued) from the IO threads into a binary
+    // log; set before start(), `trace` must outlive the Sharder. Off: one branch per frame.
+    void set_trace_log(BinaryLogger& trace);
+
+    // Called by the Consumers for every stored tick (before start(); optional)
+    void set_sink(std::function<void(const LTP&)> fn);
+
+    // Prior tick rate (msgs/sec) for instruments without history yet (load_aware only)
+    void set_rate_hint(const std::string& token, double msgs_per_sec);
+    // Run one rebalance pass now; returns number of tokens moved (load_aware only)
+    std::size_t rebalance_now();
+
+    RecoveryStats recovery_stats() const noexcept;
+    // A/B arbitration summed over shards (redundant_feeds only)
+    FeedArbiter::Stats arbiter_stats() const;
+    FeedWatchdog::Stats watchdog_stats() const;
+    // Overload handling summed over shards and legs
+    OverloadGuard::Stats overload_stats() const;
+    // Per shard (A/B legs merged), indexed by Stage; empty counts unless opts.stage_timing
+    std::vector<StageHistograms::Summaries> stage_latency() const;
 
     bool debug_broadcast_text(const std::string& payload); // test-only helper
 
@@ -39,15 +39,37 @@ public:
     void mark_subscribed(const std::vector<std::string>& tokens);
     void mark_unsubscribed(const std::vector<std::string>& tokens);
 
+    // Build payloads and mark them active/inactive in one step (for feeds without
+    // explicit ACKs). Only the delta since the last call is returned.
+    std::vector<std::string> take_subscribe_batches();
+    std::vector<std::string> take_unsubscribe_batches();
+
+    // take_*_batches() handing each payload to send (e.g. WebSocketClient::send_text).
+    // A batch send refuses, and every batch after it, goes back to pending so the
+    // next call retries it. Returns the number of batches sent.
+    using SendFn = std::function<bool(const std::string& payload)>;
+    std::size_t send_subscribe_batches(const SendFn& send);
+    std::size_t send_unsubscribe_batches(const SendFn& send);
+
+    // Server dropped all subscriptions (e.g. reconnect): everything desired is pending again
+    void reset_active();
+
+    // Merge two payloads built by this class when they share action and mode and the
+    // result stays within max_tokens (for WebSocketClient::set_coalescer). On false,
+    // `into` is unchanged.
+    static bool merge_payloads(std::string& into, const std::string& next, std::size_t max_tokens);
+
     // Snapshots (for metrics/logs)
     std::vector<std::string> desired_snapshot() const;
     std::vector<std::string> active_snapshot() const;
+    std::size_t desired_count() const;
 
 private:
     // Internal helpers
     std::vector<std::string> diff_desired_minus_active() const;   // needs subscribe
     std::vector<std::string> diff_active_minus_desired() const;   // needs unsubscribe
     std::string build_payload(const std::vector<std::string>& batch, bool subscribe) const;
+    std::size_t send_batches(bool subscribe, const SendFn& send);
 
     std::string mode_string() const; // "ltp"/"quote"/"full"
     std::vector<std::vector<std::string>> make_batches(const std::vector<std::string>& items) const;
@@ -0,0 +1,61 @@
+// include/thread_affinity.h
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Logger;
+
+// Placement request for one pipeline thread (WS IO or Consumer).
+// Defaults leave the thread unpinned on the normal scheduler.
+struct ThreadPlacement {
+    enum class Policy { OTHER, FIFO, RR };
+
+    int cpu = -1;                   // pin to this cpu (-1 = let the scheduler decide)
+    Policy policy = Policy::OTHER;  // SCHED_OTHER / SCHED_FIFO / SCHED_RR
+    int priority = 0;               // 1..99 for FIFO/RR, ignored for OTHER
+
+    bool pinned() const noexcept { return cpu >= 0; }
+};
+
+// Apply placement to the calling thread. Failures are logged (e.g. missing
+// CAP_SYS_NICE for real-time policies) and the thread keeps running unpinned.
+bool apply_thread_placement(const ThreadPlacement& p, Logger& log, const std::string& thread_name);
+
+// Effective placement of the calling thread, e.g. "ws-io#0 cpu=3 node=0 allowed=3 policy=fifo/50"
+std::string describe_thread_placement(const std::string& thread_name);
+
+// Run fn on a short-lived thread pinned to cpu, so first-touch allocations land
+// on that cpu's NUMA node. cpu < 0 runs fn inline. fn runs either way; false if
+// the thread could not be pinned (e.g. cpu outside the process's cpuset).
+bool run_on_cpu(int cpu, const std::function<void()>& fn);
+
+// Snapshot of the machine layout from /sys/devices/system/{cpu,node}, limited to
+// the cpus the process may run on (taskset, cgroup cpusets).
+class CpuTopology {
+public:
+    static CpuTopology detect();
+
+    const std::vector<int>& online() const noexcept { return online_; }
+    const std::vector<int>& isolated() const noexcept { return isolated_; }
+    int numa_node(int cpu) const;   // -1 if unknown
+    int l3_id(int cpu) const;       // lowest cpu sharing this cpu's L3 (-1 if unknown)
+
+    // Pick n (io, consumer) cpu pairs. Both cpus of a pair share an L3 where possible;
+    // isolated cpus are preferred over the rest. Pairs are reused round-robin if the
+    // machine has fewer than 2*n usable cpus.
+    std::vector<std::pair<int,int>> plan_pairs(std::size_t n) const;
+
+    // "0-3,8,10-11" -> {0,1,2,3,8,10,11}
+    static std::vector<int> parse_cpu_list(const std::string& s);
+
+private:
+    CpuTopology() = default;
+
+    std::vector<int> online_;
+    std::vector<int> isolated_;
+    std::vector<int> node_of_;   // indexed by cpu
+    std::vector<int> l3_of_;     // indexed by cpu
+};
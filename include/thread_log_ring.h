@@ -0,0 +1,110 @@
+// include/thread_log_ring.h
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "logger.h"
+
+// Shared by Logger's async mode and BinaryLogger (not a public API).
+namespace logring {
+
+const char* level_name(LogLevel lvl) noexcept;
+std::int64_t wall_ns() noexcept;
+
+// Per-thread SPSC record rings plus the writer thread that drains them. A log call
+// reserves room on the calling thread's own ring (created on its first call), so
+// producers never share a lock or a cache line; the writer thread takes every
+// published record in passes, merged by TSC, and the owner turns them into output.
+//
+// Producers and stop() use a Dekker handshake on the owner's `accepting` flag and
+// the ring's busy flag: either stop() sees the producer busy and waits it out, or
+// the producer sees accepting == false and backs off. With membarrier(2) the
+// producer side is a compiler barrier; stop() makes every thread run the fence.
+//
+// A thread's ring is retired when the thread exits; the writer frees it after
+// draining it, so threads that come and go (reshards, reconnects) don't pile up
+// rings for the life of the owner.
+class ThreadRings {
+public:
+    struct Options {
+        std::size_t ring_bytes = 64 * 1024;            // per producer thread, rounded up to a power of two
+        std::chrono::microseconds poll_interval{1000}; // writer wake-up when idle
+        bool block_when_full = false;                  // false: the record is dropped
+    };
+
+    // One record taken by the writer; its bytes are staging[off, off + len)
+    struct Record {
+        std::uint64_t tsc;
+        std::uint32_t tag;
+        std::size_t off, len;
+    };
+
+    struct Reservation {
+        void* ring = nullptr;
+        char* data = nullptr;        // payload bytes go here, then commit()
+        std::size_t next = 0;
+    };
+
+    enum class Reserve { Ok, Closed, Dropped };
+
+    struct Ring;                     // src/thread_log_ring.cpp
+
+    // `accepting` is the owner's on/off switch (BinaryLogger reads it inline)
+    explicit ThreadRings(std::atomic<bool>& accepting);
+    ~ThreadRings();
+
+    ThreadRings(const ThreadRings&) = delete;
+    ThreadRings& operator=(const ThreadRings&) = delete;
+
+    // Start the writer thread; it calls pass() every poll_interval, on flush() and
+    // once more after stop(). Sets accepting.
+    void start(const Options& opts, std::function<void()> pass);
+    // Clear accepting, wait out producers still inside reserve()..commit(), run the
+    // last pass and join. No-op when not started.
+    void stop();
+    bool started() const noexcept { return thr_.joinable(); }
+    // Block until a pass has run after every record committed before the call
+    void flush();
+
+    // Producer: room for `payload` bytes tagged `tag` (> 0) on the calling thread's
+    // ring. Closed: not accepting, or the thread is exiting. Dropped: the ring is
+    // full (and not blocking), or the record exceeds max_payload(). commit()
+    // publishes an Ok reservation.
+    Reserve reserve(std::uint32_t tag, std::size_t payload, Reservation& res);
+    static void commit(const Reservation& res) noexcept;
+    std::size_t max_payload();       // of the calling thread's ring
+    std::size_t ring_count();        // rings held: threads that logged and were not yet retired
+
+    // Writer thread (from pass()): everything published so far, appended to
+    // staging and listed in recs in TSC order
+    void take(std::vector<Record>& recs, std::string& staging);
+
+private:
+    Ring* ring_for_this_thread();    // null once the thread is exiting
+
+    const std::uint64_t id_;
+    std::atomic<bool>& accepting_;
+    Options opts_;
+    bool light_fence_ = false;       // membarrier available (set before accepting)
+
+    std::mutex rings_mu_;            // registration; the writer copies the list
+    std::vector<std::shared_ptr<Ring>> rings_;
+    std::vector<Ring*> snapshot_;    // writer thread only
+
+    std::function<void()> pass_;
+    std::thread thr_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::uint64_t flush_req_ = 0, flush_done_ = 0;
+};
+
+} // namespace logring
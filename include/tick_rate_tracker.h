@@ -0,0 +1,58 @@
+// include/tick_rate_tracker.h
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Per-instrument message-rate estimate for load-aware sharding.
+// A count-min sketch of atomic counters: record() is lock-free and allocation-free
+// (safe from any number of Consumer threads); counts decay exponentially with the
+// configured half-life so the estimate follows the current market regime.
+class TickRateTracker {
+public:
+    explicit TickRateTracker(std::chrono::seconds half_life = std::chrono::seconds(60),
+                             std::size_t width = 4096,
+                             std::size_t depth = 4);
+
+    TickRateTracker(const TickRateTracker&) = delete;
+    TickRateTracker& operator=(const TickRateTracker&) = delete;
+
+    // Columns for a universe of n tokens: the next power of two >= 4n (at least
+    // 4096), which keeps collision noise on cold tokens well under one tick per row
+    static std::size_t width_for(std::size_t n_tokens) noexcept;
+
+    // Hot path: one tick for token
+    void record(std::string_view token) noexcept;
+
+    // Prior for instruments with no history yet (msgs/sec)
+    void seed(std::string_view token, double msgs_per_sec);
+
+    // Estimated msgs/sec (count-min: may overestimate on collisions, never under)
+    double rate(std::string_view token) const;
+
+    // Apply decay for the time elapsed since the last call (also done lazily by rate/assign)
+    void decay();
+
+    // Bin-pack tokens into ceil(n / max_per_conn) shards by estimated rate
+    // (largest first onto the least-loaded shard with room). Ties on rate fall back
+    // to token count, so with no history this degrades to even-sized shards.
+    std::vector<std::vector<std::string>> assign(const std::vector<std::string>& tokens,
+                                                 std::size_t max_per_conn) const;
+
+private:
+    std::size_t slot(std::uint64_t h, std::size_t row) const noexcept;
+    void maybe_decay() const;
+    void apply_decay() const;
+
+    const std::size_t width_;
+    const std::size_t depth_;
+    const double lambda_;                                 // ln2 / half_life, per second
+    std::unique_ptr<std::atomic<std::uint32_t>[]> cells_; // depth_ x width_
+    mutable std::atomic<std::int64_t> last_decay_ns_;
+    const std::chrono::nanoseconds decay_step_;           // lazy decay granularity
+};
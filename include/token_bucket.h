@@ -0,0 +1,54 @@
+// include/token_bucket.h
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
+// Token bucket rate limiter: `rate` tokens per second, at most `burst` banked
+// while idle. reserve() always takes a token and returns how long the caller has
+// to wait before using it (zero if one was banked); the bucket goes into debt, so
+// waiters are served in the order they reserved whether they sleep or arm a timer.
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TokenBucket(double rate_per_sec, double burst)
+        : rate_(rate_per_sec), burst_(std::max(1.0, burst)), tokens_(burst_), last_(Clock::now()) {}
+
+    TokenBucket(const TokenBucket&) = delete;
+    TokenBucket& operator=(const TokenBucket&) = delete;
+
+    Clock::duration reserve(Clock::time_point now = Clock::now()) noexcept {
+        std::lock_guard<std::mutex> lk(mu_);
+        refill(now);
+        tokens_ -= 1.0;
+        if (tokens_ >= 0.0) return Clock::duration::zero();
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(-tokens_ / rate_));
+    }
+
+    // Take a token only if one is banked now
+    bool try_acquire(Clock::time_point now = Clock::now()) noexcept {
+        std::lock_guard<std::mutex> lk(mu_);
+        refill(now);
+        if (tokens_ < 1.0) return false;
+        tokens_ -= 1.0;
+        return true;
+    }
+
+    double rate() const noexcept { return rate_; }
+    double burst() const noexcept { return burst_; }
+
+private:
+    void refill(Clock::time_point now) noexcept {
+        if (now > last_) {
+            tokens_ = std::min(burst_, tokens_ + rate_ * std::chrono::duration<double>(now - last_).count());
+            last_ = now;
+        }
+    }
+
+    std::mutex mu_;
+    const double rate_;
+    const double burst_;
+    double tokens_;
+    Clock::time_point last_;
+};
@@ -0,0 +1,92 @@
+// include/token_refresher.h
+#pragma once
+#include "auth.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Logger;
+
+// Renews the session on a background thread ahead of expiry, so connections that
+// drop reconnect with a valid token on their first attempt instead of failing the
+// handshake and backing off. Each new token set goes to the listeners, e.g.
+//
+//   TokenRefresher tr(auth, log, {});
+//   tr.add_listener([&sharder](const Auth::Tokens& t) {
+//       sharder.set_access_token("Bearer " + t.access_token, {{"x-feed-token", t.feed_token}});
+//   });
+//   tr.start();
+//
+// Expiry comes from Auth::Tokens::expires_at (TTL or the JWT's exp). A failed
+// refresh is retried with doubling delays; once the token has expired, relogin
+// (if set) is tried as well.
+class TokenRefresher {
+public:
+    struct Options {
+        std::chrono::milliseconds lead{std::chrono::minutes(10)};           // refresh this long before expiry
+        std::chrono::milliseconds unknown_expiry_interval{std::chrono::hours(6)}; // expiry unknown (0 = never)
+        std::chrono::milliseconds min_interval{std::chrono::seconds(30)};    // between successful refreshes
+        std::chrono::milliseconds retry_initial{std::chrono::seconds(5)};    // after a failure, doubling
+        std::chrono::milliseconds retry_max{std::chrono::minutes(1)};
+        // Full login (password + TOTP) when refreshing is no longer possible
+        std::function<bool(Auth&)> relogin;
+    };
+
+    // Runs on the thread that renewed the tokens; must not call back into the refresher
+    using Listener = std::function<void(const Auth::Tokens&)>;
+
+    struct Stats {
+        std::uint64_t refreshes = 0;        // successful, relogins included
+        std::uint64_t failures = 0;
+        std::uint64_t relogins = 0;
+        std::chrono::system_clock::time_point next{};   // scheduled attempt
+    };
+
+    TokenRefresher(Auth& auth, Logger& log, Options opts);
+    ~TokenRefresher();
+
+    TokenRefresher(const TokenRefresher&) = delete;
+    TokenRefresher& operator=(const TokenRefresher&) = delete;
+
+    // Called with the current tokens right away (if logged in), then after each renewal
+    void add_listener(Listener l);
+
+    // Refreshes first if already due (so a start after a stale night begins with a
+    // valid token), then spawns the timer thread. false if that refresh failed;
+    // the thread keeps retrying.
+    bool start();
+    void stop();
+
+    // Renew now (e.g. the server rejected the token) and notify the listeners
+    bool refresh_now();
+
+    Stats stats() const;
+
+private:
+    void run();
+    bool renew();                           // under renew_mu_
+    // When the tokens should next be renewed; under mu_
+    std::chrono::system_clock::time_point due(const Auth::Tokens& t, std::chrono::system_clock::time_point now) const;
+
+    Auth& auth_;
+    Logger& log_;
+    Options opts_;
+
+    std::mutex renew_mu_;                   // one renewal at a time, listeners in order
+    mutable std::mutex mu_;                 // listeners_, stats_, failures_in_row_, last_ok_
+    std::vector<Listener> listeners_;
+    Stats stats_;
+    int failures_in_row_ = 0;
+    std::chrono::system_clock::time_point last_ok_{};
+
+    std::mutex run_mu_;
+    std::condition_variable run_cv_;
+    bool stop_ = false;
+    std::thread thr_;
+};
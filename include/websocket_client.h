@@ -1,18 +1,59 @@
 // include/websocket_client.h
 #pragma once
 #include <string>
+#include <string_view>
+#include <cstdint>
 #include <functional>
 #include <atomic>
 #include <chrono>
 #include <map>
+#include <vector>
+#include <cstddef>
+#include "thread_affinity.h"
 
 class Logger;
 
+// Small fixed set of IO threads shared by many WebSocketClients. Each thread runs
+// its own io_context; clients are assigned round-robin and use async reads, so the
+// thread count stays fixed no matter how many connections are open.
+class IoContextPool {
+public:
+    struct Options {
+        std::size_t threads = 2;
+        std::vector<ThreadPlacement> placement;  // thread i uses placement[i % size()]
+        std::string thread_name = "ws-pool";     // used in placement report
+    };
+
+    explicit IoContextPool(Logger& log);
+    IoContextPool(Logger& log, Options opts);
+    ~IoContextPool();
+
+    IoContextPool(const IoContextPool&) = delete;
+    IoContextPool& operator=(const IoContextPool&) = delete;
+
+    bool start();     // spawn threads (idempotent)
+    void stop();      // stop contexts + join; stop clients first
+
+    bool running() const noexcept;
+    std::size_t size() const noexcept;
+
+private:
+    friend class WebSocketClient;
+    struct Impl;      // keeps Asio out of the header
+    Impl* impl_;
+};
+
 class WebSocketClient {
 public:
     using MessageCallback = std::function<void(const std::string& /*msg*/)>;   // raw frames (text/binary)
+    using MessageViewCallback = std::function<void(std::string_view /*msg*/)>; // zero-copy: valid only during the call
     using StateCallback   = std::function<void(const std::string& /*state*/)>; // "connecting","connected","closed","reconnecting","failed"
-    using ResubscribeFn   = std::function<void(WebSocketClient&)>;             // called right after reconnect
+    using ResubscribeFn   = std::function<void(WebSocketClient&)>;             // called right after every (re)connect
+    using RejectedFn      = std::function<void(unsigned /*http status*/)>;      // upgrade refused, e.g. 401 for a stale token
+    // Merge `next` into the queued text frame `pending`; return false to queue it separately
+    using CoalesceFn      = std::function<bool(std::string& pending, const std::string& next)>;
+    // Backpressure: checked after each delivered frame; false holds the next read back
+    using ReadGateFn      = std::function<bool()>;
 
     struct Options {
         std::chrono::seconds ping_interval{15};             // periodic ping
@@ -23,31 +64,89 @@ public:
         // reconnect backoff
         std::chrono::milliseconds backoff_initial{500};
         std::chrono::milliseconds backoff_max{5000};
+        // IO thread placement (applied when the IO thread starts)
+        ThreadPlacement io_placement;
+        std::string thread_name = "ws-io";                   // used in placement report
+        // permessage-deflate (RFC 7692); only used if the server accepts it
+        bool deflate{false};
+        int deflate_window_bits{15};                         // client/server max_window_bits, 9..15
+        int deflate_level{6};                                // compression level for our sends, 0..9
+        int deflate_mem_level{8};                            // zlib memLevel, 1..9
+        bool deflate_no_context_takeover{false};             // lower memory, worse ratio
+        // Per-frame thread CPU accounting of the read (TLS decrypt + inflate + framing).
+        // Costs a clock_gettime per frame; exact only when the IO thread serves one connection.
+        bool measure_read_cpu{false};
+        // Take a tsc_now() stamp as each read completes, exposed by read_tsc()
+        bool stamp_reads{false};
+        // While the read gate is closed it is re-checked at this interval. A paused
+        // connection answers no pings, so long pauses can look idle to the server.
+        std::chrono::microseconds read_gate_poll{200};
     };
 
     WebSocketClient(std::string wss_url, Logger& log);
     WebSocketClient(std::string wss_url, Logger& log, Options opts);
+    // Async mode: no own IO thread; the connection lives on one of pool's contexts.
+    WebSocketClient(std::string wss_url, Logger& log, Options opts, IoContextPool& pool);
     ~WebSocketClient();
 
     WebSocketClient(const WebSocketClient&) = delete;
     WebSocketClient& operator=(const WebSocketClient&) = delete;
 
     // Lifecycle
-    bool start();     // spawn IO thread, connect, begin read loop
+    bool start();     // spawn IO thread (or post to pool), connect, begin read loop
     void stop();      // graceful stop + join
 
-    // I/O
+    // I/O. Thread-safe and non-blocking: frames are queued on the connection's strand
+    // and written in order between reads. false = not connected (frame dropped).
     bool send_text(const std::string& payload);
     bool send_binary(const void* data, size_t len);
 
+    // Drop the current session and reconnect right away (e.g. a stalled feed, or new
+    // credentials); on_resubscribe restores subscriptions as after any reconnect.
+    // While disconnected, cuts the pending reconnect wait short.
+    void recycle();
+
+    // Replace the handshake headers (e.g. a refreshed token). Takes effect on the
+    // next connect or reconnect; the live session is not touched.
+    void set_headers(std::map<std::string,std::string> headers);
+    std::map<std::string,std::string> headers() const;
+
+    // Optional merge of back-to-back queued text frames (e.g. subscribe batches)
+    void set_coalescer(CoalesceFn fn);
+    // Optional flow control: stop reading the socket while gate() returns false,
+    // letting TCP push back on the sender instead of dropping frames here
+    void set_read_gate(ReadGateFn gate);
+
     // Callbacks (set anytime; invoked from IO thread)
     void on_message(MessageCallback cb);
+    void on_message_view(MessageViewCallback cb);   // takes precedence over on_message
     void on_state(StateCallback cb);
     void on_resubscribe(ResubscribeFn fn);
+    void on_rejected(RejectedFn fn);    // before the reconnect it leads to
 
     // Introspection
-    bool is_connected() const noexcept { return connected_.load(); }
+    bool is_connected() const noexcept;
     const std::string& url() const noexcept { return url_; }
+    bool is_async() const noexcept;
+    // Read-completion stamp of the frame being delivered (Options::stamp_reads);
+    // meaningful only inside on_message/on_message_view
+    std::uint64_t read_tsc() const noexcept;
+
+    struct Stats {
+        std::uint64_t frames = 0;       // frames delivered to callbacks
+        std::uint64_t rx_bytes = 0;     // payload bytes delivered (after inflate)
+        std::uint64_t rx_wire_bytes = 0;// TLS bytes read off the socket
+        std::uint64_t tx_bytes = 0;     // payload bytes sent (before deflate)
+        std::uint64_t tx_wire_bytes = 0;// TLS bytes written to the socket
+        std::uint64_t read_cpu_ns = 0;  // thread CPU in reads (Options::measure_read_cpu)
+        std::uint64_t allocations = 0;  // heap allocations on the read path (ALPHA_COUNT_ALLOCS builds)
+        bool deflate = false;           // permessage-deflate negotiated on the current session
+        std::size_t write_queue_depth = 0; // frames queued or in flight
+        std::size_t write_queue_peak = 0;
+        std::uint64_t coalesced = 0;    // frames merged into an earlier queued frame
+        std::uint64_t read_pauses = 0;  // times the read gate held reads back
+    };
+    Stats stats() const noexcept;
 
 private:
     struct Impl;        // pimpl to keep Boost.Beast/Asio out of headers
@@ -56,6 +155,5 @@ private:
     std::string url_;
     Logger& log_;
     Options opts_;
-    std::atomic<bool> connected_{false};
 };
 
@@ -0,0 +1,169 @@
+// src/account_pool.cpp
+#include "account_pool.h"
+#include "auth.h"
+#include "logger.h"
+#include "totp.h"
+
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+struct AccountPool::Slot {
+    Account acct;
+    TOTP totp;
+    std::unique_ptr<Auth> auth;             // borrows acct.config
+    std::unique_ptr<TokenRefresher> refresher;
+    Session session;                        // under AccountPool::mu_
+
+    Slot(Account a, HTTPClient& http, Logger& log, const std::string& base_url)
+        : acct(std::move(a)), totp(acct.totp_secret),
+          auth(base_url.empty() ? std::make_unique<Auth>(acct.config, http, log)
+                                : std::make_unique<Auth>(acct.config, http, log, base_url)) {
+        session.name = acct.config.client_code();
+        session.max_connections = acct.max_connections;
+        session.max_tokens = acct.max_tokens;
+    }
+};
+
+AccountPool::AccountPool(HTTPClient& http, Logger& log, Options opts)
+    : http_(http), log_(log), opts_(std::move(opts)) {}
+
+AccountPool::~AccountPool() { stop(); }
+
+std::size_t AccountPool::add(Account account) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (started_) throw std::logic_error("AccountPool: add() after start()");
+    slots_.push_back(std::make_unique<Slot>(std::move(account), http_, log_, opts_.base_url));
+    return slots_.size() - 1;
+}
+
+bool AccountPool::login(Slot& s) {
+    try {
+        return s.auth->login_with_totp(s.totp.now());
+    } catch (const std::exception& e) {
+        log_.warn_fmt("[accounts] {} login: {}", s.session.name, e.what());
+        return false;
+    }
+}
+
+std::size_t AccountPool::start() {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (started_) return 0;
+        started_ = true;
+    }
+
+    // Logins are independent round trips: run them side by side
+    std::vector<char> ok(slots_.size(), 0);
+    {
+        std::vector<std::thread> th;
+        th.reserve(slots_.size());
+        for (std::size_t i = 0; i < slots_.size(); ++i)
+            th.emplace_back([this, i, &ok] { ok[i] = login(*slots_[i]) ? 1 : 0; });
+        for (auto& t : th) t.join();
+    }
+
+    std::size_t up = 0;
+    for (std::size_t i = 0; i < slots_.size(); ++i) {
+        Slot& s = *slots_[i];
+        if (!ok[i]) log_.warn_fmt("[accounts] {} login failed, retrying in the background", s.session.name);
+        TokenRefresher::Options ro = opts_.refresh;
+        ro.relogin = [this, i](Auth&) {
+            if (login(*slots_[i])) return true;
+            set_up(i, false, nullptr);
+            return false;
+        };
+        s.refresher = std::make_unique<TokenRefresher>(*s.auth, log_, ro);
+        // called right away when logged in: the account is up
+        s.refresher->add_listener([this, i](const Auth::Tokens& t) { set_up(i, true, &t); });
+        s.refresher->start();
+        if (session(i).up) ++up;
+    }
+    log_.info_fmt("[accounts] {}/{} accounts up", up, slots_.size());
+    return up;
+}
+
+void AccountPool::stop() {
+    for (auto& s : slots_) {
+        if (s->refresher) s->refresher->stop();
+    }
+}
+
+std::size_t AccountPool::size() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return slots_.size();
+}
+
+AccountPool::Session AccountPool::session(std::size_t account) const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return slots_.at(account)->session;
+}
+
+std::vector<AccountPool::Session> AccountPool::sessions() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    std::vector<Session> out;
+    out.reserve(slots_.size());
+    for (const auto& s : slots_) out.push_back(s->session);
+    return out;
+}
+
+std::size_t AccountPool::add_listener(Listener l) {
+    std::lock_guard<std::mutex> lk(mu_);
+    listeners_.emplace(next_listener_, std::move(l));
+    return next_listener_++;
+}
+
+void AccountPool::remove_listener(std::size_t id) {
+    std::lock_guard<std::mutex> nk(notify_mu_);     // not running once this returns
+    std::lock_guard<std::mutex> lk(mu_);
+    listeners_.erase(id);
+}
+
+bool AccountPool::renew(std::size_t account) {
+    Slot& s = *slots_.at(account);
+    if (!s.refresher) return false;
+    if (s.refresher->refresh_now()) return true;
+    // a rejected session usually means the refresh token is dead too
+    if (login(s)) {
+        const Auth::Tokens t = s.auth->tokens();
+        set_up(account, true, &t);
+        return true;
+    }
+    set_up(account, false, nullptr);
+    return false;
+}
+
+void AccountPool::set_up(std::size_t account, bool up, const Auth::Tokens* tokens) {
+    bool changed;
+    std::string name;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        Slot& s = *slots_[account];
+        changed = s.session.up != up;
+        s.session.up = up;
+        if (tokens) {
+            s.session.headers = {
+                {"Authorization", "Bearer " + tokens->access_token},
+                {"x-api-key", s.acct.config.api_key()},
+                {"x-client-code", s.acct.config.client_code()},
+                {"x-feed-token", tokens->feed_token},
+            };
+        }
+        name = s.session.name;
+    }
+    if (!up && !changed) return;                    // still down
+    if (!up) log_.warn_fmt("[accounts] {} session failed", name);
+    else if (changed) log_.info_fmt("[accounts] {} up", name);
+    notify(account);
+}
+
+void AccountPool::notify(std::size_t account) {
+    std::lock_guard<std::mutex> nk(notify_mu_);
+    std::vector<Listener> ls;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        for (const auto& [id, l] : listeners_) ls.push_back(l);
+    }
+    for (const auto& l : ls) l(account);
+}
@@ -0,0 +1,48 @@
+// src/alloc_counter.cpp
+#include "alloc_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+thread_local std::uint64_t t_allocs = 0;
+} // namespace
+
+#ifdef ALPHA_COUNT_ALLOCS
+
+void* operator new(std::size_t n) {
+    ++t_allocs;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t n) {
+    ++t_allocs;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept {
+    ++t_allocs;
+    return std::malloc(n ? n : 1);
+}
+
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept {
+    ++t_allocs;
+    return std::malloc(n ? n : 1);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+bool AllocCounter::enabled() noexcept { return true; }
+
+#else
+
+bool AllocCounter::enabled() noexcept { return false; }
+
+#endif
+
+std::uint64_t AllocCounter::thread_allocations() noexcept { return t_allocs; }
@@ -6,6 +6,8 @@
 #include <nlohmann/json.hpp>
 #include <stdexcept>
 #include <cstdlib>
+#include <mutex>
+#include <utility>
 
 using json = nlohmann::json;
 
@@ -27,10 +29,53 @@ std::map<std::string,std::string> common_headers(const Config& cfg) {
         // You can add: X-ClientLocalIP / X-ClientPublicIP / X-MACAddress if needed.
     };
 }
+// SmartAPI login responses carry no TTL; the JWT's own "exp" claim (epoch
+// seconds) does. Epoch (unknown) if the token is not a readable JWT.
+std::chrono::system_clock::time_point jwt_expiry(const std::string& jwt) {
+    const auto a = jwt.find('.');
+    const auto b = a == std::string::npos ? a : jwt.find('.', a + 1);
+    if (b == std::string::npos) return {};
+    std::string payload;
+    unsigned bits = 0, acc = 0;
+    for (std::size_t i = a + 1; i < b; ++i) {      // base64url, no padding
+        const char c = jwt[i];
+        int v;
+        if (c >= 'A' && c <= 'Z') v = c - 'A';
+        else if (c >= 'a' && c <= 'z') v = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') v = c - '0' + 52;
+        else if (c == '-' || c == '+') v = 62;
+        else if (c == '_' || c == '/') v = 63;
+        else if (c == '=') break;
+        else return {};
+        acc = (acc << 6) | static_cast<unsigned>(v);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            payload += static_cast<char>((acc >> bits) & 0xFF);
+        }
+    }
+    const json j = json::parse(payload, nullptr, /*allow_exceptions=*/false);
+    if (!j.is_object() || !j.contains("exp") || !j["exp"].is_number()) return {};
+    return std::chrono::system_clock::time_point(std::chrono::seconds(j["exp"].get<long long>()));
+}
+
+// "expiresIn" / "jwtTokenTTL" seconds if the response has them, else the JWT's exp
+std::chrono::system_clock::time_point token_expiry(const json& d, const std::string& jwt) {
+    int ttl_sec = 0;
+    if (d.contains("expiresIn") && d["expiresIn"].is_number_integer())
+        ttl_sec = d["expiresIn"].get<int>();
+    else if (d.contains("jwtTokenTTL") && d["jwtTokenTTL"].is_number_integer())
+        ttl_sec = d["jwtTokenTTL"].get<int>();
+    if (ttl_sec > 0) return std::chrono::system_clock::now() + std::chrono::seconds(ttl_sec);
+    return jwt_expiry(jwt);
+}
 } // namespace
 
 Auth::Auth(const Config& cfg, HTTPClient& http, Logger& log)
-    : cfg_(cfg), http_(http), log_(log) {}
+    : Auth(cfg, http, log, kBase) {}
+
+Auth::Auth(const Config& cfg, HTTPClient& http, Logger& log, std::string base_url)
+    : cfg_(cfg), http_(http), log_(log), base_url_(std::move(base_url)) {}
 
 bool Auth::login_with_totp(const std::string& totp) {
     return login_impl(totp);
@@ -38,7 +83,7 @@ bool Auth::login_with_totp(const std::string& totp) {
 
 bool Auth::login_impl(const std::string& otp) {
     // Build URL and payload
-    const std::string url = std::string(kBase) + kLoginPath;
+    const std::string url = base_url_ + kLoginPath;
 
     json payload = {
         {"clientcode", cfg_.client_code()},
@@ -63,15 +108,20 @@ bool Auth::login_impl(const std::string& otp) {
 }
 
 bool Auth::refresh() {
-    if (tokens_.refresh_token.empty()) {
+    std::string refresh_token;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        refresh_token = tokens_.refresh_token;
+    }
+    if (refresh_token.empty()) {
         log_.warn("Auth.refresh called without refresh_token");
         return false;
     }
 
-    const std::string url = std::string(kBase) + kGenTok;
+    const std::string url = base_url_ + kGenTok;
 
     json payload = {
-        {"refreshToken", tokens_.refresh_token}
+        {"refreshToken", refresh_token}
         // Some variants also accept {"jwtToken": tokens_.access_token}, but refreshToken is enough.
     };
 
@@ -91,6 +141,7 @@ bool Auth::refresh() {
 }
 
 bool Auth::is_expired(std::chrono::seconds skew) const {
+    std::lock_guard<std::mutex> lk(mu_);
     if (tokens_.access_token.empty()) return true;
     if (tokens_.expires_at.time_since_epoch().count() == 0) {
         // No TTL known → treat as non-expiring (or force refresh by returning true)
@@ -99,11 +150,23 @@ bool Auth::is_expired(std::chrono::seconds skew) const {
     return (std::chrono::system_clock::now() + skew) >= tokens_.expires_at;
 }
 
+Auth::Tokens Auth::tokens() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return tokens_;
+}
+
 std::map<std::string,std::string> Auth::auth_headers() const {
+    std::lock_guard<std::mutex> lk(mu_);
     if (tokens_.access_token.empty()) return {};
     return { {"Authorization", std::string("Bearer ") + tokens_.access_token} };
 }
 
+std::map<std::string,std::string> Auth::request_headers() const {
+    auto hdrs = common_headers(cfg_);
+    for (auto& [k, v] : auth_headers()) hdrs[k] = v;
+    return hdrs;
+}
+
 bool Auth::handle_login_response(const std::string& body) {
     // Expected shape (typical):
     // { "status": true, "data": { "jwtToken": "...", "refreshToken":"...", "feedToken":"..." }, ... }
@@ -115,23 +178,14 @@ bool Auth::handle_login_response(const std::string& body) {
 
     if (!d.contains("jwtToken") || !d.contains("refreshToken")) return false;
 
+    std::lock_guard<std::mutex> lk(mu_);
     tokens_.access_token  = d.value("jwtToken", "");
     tokens_.refresh_token = d.value("refreshToken", "");
     tokens_.feed_token    = d.value("feedToken", "");
 
-    // TTL handling: some responses provide "expiresIn" (seconds) or "jwtTokenTTL".
-    // If present, compute expires_at; otherwise leave at epoch (unknown).
-    int ttl_sec = 0;
-    if (d.contains("expiresIn") && d["expiresIn"].is_number_integer())
-        ttl_sec = d["expiresIn"].get<int>();
-    else if (d.contains("jwtTokenTTL") && d["jwtTokenTTL"].is_number_integer())
-        ttl_sec = d["jwtTokenTTL"].get<int>();
-
-    if (ttl_sec > 0) {
-        tokens_.expires_at = std::chrono::system_clock::now() + std::chrono::seconds(ttl_sec);
-    } else {
-        tokens_.expires_at = std::chrono::system_clock::time_point{}; // unknown
-    }
+    // TTL handling: "expiresIn" (seconds) or "jwtTokenTTL" if present, else the
+    // JWT's exp claim; epoch if neither (unknown)
+    tokens_.expires_at = token_expiry(d, tokens_.access_token);
     return !tokens_.access_token.empty();
 }
 
@@ -147,19 +201,12 @@ bool Auth::handle_refresh_response(const std::string& body) {
     const std::string new_jwt = d.value("jwtToken", "");
     if (new_jwt.empty()) return false;
 
+    std::lock_guard<std::mutex> lk(mu_);
     tokens_.access_token = new_jwt;
     if (d.contains("refreshToken")) tokens_.refresh_token = d.value("refreshToken", tokens_.refresh_token);
     tokens_.feed_token = d.value("feedToken", tokens_.feed_token);
-
-    int ttl_sec = 0;
-    if (d.contains("expiresIn") && d["expiresIn"].is_number_integer())
-        ttl_sec = d["expiresIn"].get<int>();
-    else if (d.contains("jwtTokenTTL") && d["jwtTokenTTL"].is_number_integer())
-        ttl_sec = d["jwtTokenTTL"].get<int>();
-
-    if (ttl_sec > 0) {
-        tokens_.expires_at = std::chrono::system_clock::now() + std::chrono::seconds(ttl_sec);
-    }
+    // the old expiry belongs to the old token
+    tokens_.expires_at = token_expiry(d, new_jwt);
     return true;
 }
 
@@ -0,0 +1,115 @@
+// src/bar_store.cpp
+#include "bar_store.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace {
+
+bool earlier(const Bar& a, const Bar& b) { return a.start < b.start; }
+
+} // namespace
+
+BarStore::BarStore(std::chrono::seconds interval) : interval_(std::max(interval, std::chrono::seconds(1))) {}
+
+std::size_t BarStore::merge(const std::string& key, std::vector<Bar> bars) {
+    if (bars.empty()) return 0;
+    // sorted, and the last copy of a start time wins within the batch as well
+    std::stable_sort(bars.begin(), bars.end(), earlier);
+    std::size_t w = 0;
+    for (std::size_t r = 0; r < bars.size(); ++r) {
+        if (w > 0 && bars[w - 1].start == bars[r].start) bars[w - 1] = bars[r];
+        else bars[w++] = bars[r];
+    }
+    bars.resize(w);
+
+    std::unique_lock<std::shared_mutex> lk(mu_);
+    std::vector<Bar>& have = map_[key];
+    if (have.empty() || have.back().start < bars.front().start) {
+        // the common case: history older than anything stored arrives first, or
+        // chunks arrive in order
+        have.insert(have.end(), bars.begin(), bars.end());
+        return bars.size();
+    }
+    std::vector<Bar> out;
+    out.reserve(have.size() + bars.size());
+    std::size_t added = 0;
+    auto a = have.begin();
+    auto b = bars.begin();
+    while (a != have.end() || b != bars.end()) {
+        if (b == bars.end() || (a != have.end() && a->start < b->start)) {
+            out.push_back(*a++);
+        } else {
+            if (a != have.end() && a->start == b->start) ++a;
+            else ++added;
+            out.push_back(*b++);
+        }
+    }
+    have.swap(out);
+    return added;
+}
+
+bool BarStore::on_tick(const std::string& key, std::chrono::system_clock::time_point ts, double price, std::uint64_t qty) {
+    std::unique_lock<std::shared_mutex> lk(mu_);
+    std::vector<Bar>& have = map_[key];
+    if (!have.empty()) {
+        Bar& cur = have.back();
+        if (ts < cur.start) return false;
+        if (ts < cur.start + interval_) {
+            cur.high = std::max(cur.high, price);
+            cur.low = std::min(cur.low, price);
+            cur.close = price;
+            cur.volume += qty;
+            return true;
+        }
+    }
+    Bar next;
+    if (have.empty()) {
+        const auto since_epoch = std::chrono::duration_cast<std::chrono::seconds>(ts.time_since_epoch());
+        next.start = std::chrono::system_clock::time_point(since_epoch - since_epoch % interval_);
+    } else {
+        const auto gap = std::chrono::duration_cast<std::chrono::seconds>(ts - have.back().start);
+        next.start = have.back().start + (gap - gap % interval_);
+    }
+    next.open = next.high = next.low = next.close = price;
+    next.volume = qty;
+    have.push_back(next);
+    return true;
+}
+
+std::vector<Bar> BarStore::bars(const std::string& key) const {
+    std::shared_lock<std::shared_mutex> lk(mu_);
+    auto it = map_.find(key);
+    if (it == map_.end()) return {};
+    return it->second;
+}
+
+std::vector<Bar> BarStore::bars(const std::string& key, std::chrono::system_clock::time_point from,
+                                std::chrono::system_clock::time_point to) const {
+    std::shared_lock<std::shared_mutex> lk(mu_);
+    auto it = map_.find(key);
+    if (it == map_.end()) return {};
+    const auto& v = it->second;
+    const auto lo = std::lower_bound(v.begin(), v.end(), from, [](const Bar& b, auto t) { return b.start < t; });
+    const auto hi = std::lower_bound(lo, v.end(), to, [](const Bar& b, auto t) { return b.start < t; });
+    return {lo, hi};
+}
+
+std::optional<Bar> BarStore::last(const std::string& key) const {
+    std::shared_lock<std::shared_mutex> lk(mu_);
+    auto it = map_.find(key);
+    if (it == map_.end() || it->second.empty()) return std::nullopt;
+    return it->second.back();
+}
+
+std::size_t BarStore::instruments() const {
+    std::shared_lock<std::shared_mutex> lk(mu_);
+    return map_.size();
+}
+
+std::size_t BarStore::size() const {
+    std::shared_lock<std::shared_mutex> lk(mu_);
+    std::size_t n = 0;
+    for (const auto& [key, v] : map_) n += v.size();
+    return n;
+}
@@ -0,0 +1,361 @@
+// src/binary_log.cpp
+#include "binary_log.h"
+#include "latency_histogram.h"
+#include "thread_log_ring.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// File layout (little endian, as written by this machine):
+//   "ALPHABL1" u32 version, u32 name_len, name, f64 ns_per_tick
+//   then tagged entries:
+//   'S' u32 id, u8 level, u8 nargs, u8 types[nargs], i32 line,
+//       u32 file_len, file, u32 fmt_len, fmt         site descriptor, before its first record
+//   'A' i64 wall_ns, u64 tsc                         clock anchor, once per writer pass
+//   'R' u32 id, u64 tsc, u32 len, args[len]          one call
+//   'D' u64 count                                    records lost to full rings since the last 'D'
+namespace {
+
+constexpr char kMagic[8] = {'A', 'L', 'P', 'H', 'A', 'B', 'L', '1'};
+constexpr std::uint32_t kVersion = 1;
+
+using logring::level_name;
+using logring::wall_ns;
+
+// Process-wide site table: ids are 1-based indexes, sites are statics and never go away
+std::mutex g_sites_mu;
+std::vector<const binlog::Site*> g_sites;
+
+std::size_t site_count() {
+    std::lock_guard<std::mutex> lk(g_sites_mu);
+    return g_sites.size();
+}
+
+const binlog::Site* site_at(std::uint32_t id) {
+    std::lock_guard<std::mutex> lk(g_sites_mu);
+    return g_sites[id - 1];
+}
+
+template<typename T>
+void put(std::string& out, const T& v) {
+    out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+void put_str(std::string& out, std::string_view s) {
+    put(out, static_cast<std::uint32_t>(s.size()));
+    out.append(s.data(), s.size());
+}
+
+} // namespace
+
+std::uint32_t binlog::register_site(Site& site) {
+    std::lock_guard<std::mutex> lk(g_sites_mu);
+    std::uint32_t id = site.id.load(std::memory_order_relaxed);
+    if (id != 0) return id;
+    g_sites.push_back(&site);
+    id = static_cast<std::uint32_t>(g_sites.size());
+    site.id.store(id, std::memory_order_release);
+    return id;
+}
+
+struct BinaryLogger::Impl {
+    Logger& log;
+    std::string name;
+    std::string path;
+    std::ofstream file;
+
+    std::atomic<std::uint64_t> dropped{0};
+    std::atomic<std::uint64_t> records{0};
+    std::atomic<std::uint64_t> bytes{0};
+
+    logring::ThreadRings rings;
+
+    // writer thread only
+    std::vector<logring::ThreadRings::Record> recs;
+    std::string staging, batch;
+    std::size_t sites_written = 0;
+    std::uint64_t dropped_reported = 0;
+    bool write_failed = false;
+
+    Impl(Logger& l, std::string n, std::atomic<bool>& accepting) : log(l), name(std::move(n)), rings(accepting) {}
+
+    // Writer: everything published so far, merged by time, appended in one write
+    void drain() {
+        recs.clear();
+        staging.clear();
+        rings.take(recs, staging);
+
+        batch.clear();
+        // Every site referenced above was registered before its record was published
+        const std::size_t nsites = site_count();
+        for (; sites_written < nsites; ++sites_written) {
+            const binlog::Site& s = *site_at(static_cast<std::uint32_t>(sites_written + 1));
+            batch += 'S';
+            put(batch, static_cast<std::uint32_t>(sites_written + 1));
+            put(batch, static_cast<std::uint8_t>(s.level));
+            put(batch, s.nargs);
+            for (std::uint8_t i = 0; i < s.nargs; ++i) put(batch, static_cast<std::uint8_t>(s.types[i]));
+            put(batch, static_cast<std::int32_t>(s.line));
+            put_str(batch, s.file);
+            put_str(batch, s.fmt);
+        }
+        const std::uint64_t d = dropped.load(std::memory_order_relaxed);
+        if (!recs.empty() || d != dropped_reported) {
+            batch += 'A';
+            put(batch, wall_ns());
+            put(batch, tsc_now());
+        }
+        for (const auto& rec : recs) {
+            batch += 'R';
+            put(batch, rec.tag);         // site id
+            put(batch, rec.tsc);
+            put(batch, static_cast<std::uint32_t>(rec.len));
+            batch.append(staging, rec.off, rec.len);
+        }
+        if (d != dropped_reported) {
+            batch += 'D';
+            put(batch, d - dropped_reported);
+            dropped_reported = d;
+        }
+        if (batch.empty() || write_failed) return;
+        file.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+        file.flush();
+        if (!file) {
+            write_failed = true;
+            log.error("binary log " + path + ": write failed, further records are discarded");
+            return;
+        }
+        records.fetch_add(recs.size(), std::memory_order_relaxed);
+        bytes.fetch_add(batch.size(), std::memory_order_relaxed);
+    }
+};
+
+BinaryLogger::BinaryLogger(Logger& log, std::string name)
+    : impl_(new Impl(log, std::move(name), accepting_)) {}
+
+BinaryLogger::~BinaryLogger() {
+    close();
+    delete impl_;
+}
+
+bool BinaryLogger::open(const std::string& path) { return open(path, Options{}); }
+
+bool BinaryLogger::open(const std::string& path, Options opts) {
+    Impl& m = *impl_;
+    if (m.rings.started()) {
+        m.log.warn("binary log already open: " + m.path);
+        return false;
+    }
+    m.file.open(path, std::ios::binary | std::ios::trunc);
+    if (!m.file) {
+        m.log.error("binary log: cannot open " + path);
+        return false;
+    }
+    m.path = path;
+    m.write_failed = false;
+    m.sites_written = 0;
+    m.dropped_reported = m.dropped.load(std::memory_order_relaxed);
+    m.records.store(0, std::memory_order_relaxed);
+
+    std::string hdr(kMagic, sizeof(kMagic));
+    put(hdr, kVersion);
+    put_str(hdr, m.name);
+    put(hdr, tsc_ns_per_tick());     // calibrates here, not on the first log call
+    m.file.write(hdr.data(), static_cast<std::streamsize>(hdr.size()));
+    m.bytes.store(hdr.size(), std::memory_order_relaxed);
+
+    m.rings.start({opts.ring_bytes, opts.poll_interval, opts.block_when_full}, [&m] { m.drain(); });
+    return true;
+}
+
+void BinaryLogger::close() {
+    Impl& m = *impl_;
+    if (!m.rings.started()) return;
+    m.rings.stop();                  // its last pass drains what is left
+    m.file.close();
+}
+
+void BinaryLogger::flush() { impl_->rings.flush(); }
+
+BinaryLogger::Stats BinaryLogger::stats() const noexcept {
+    Stats s;
+    s.records = impl_->records.load(std::memory_order_relaxed);
+    s.dropped = impl_->dropped.load(std::memory_order_relaxed);
+    s.bytes = impl_->bytes.load(std::memory_order_relaxed);
+    return s;
+}
+
+bool BinaryLogger::reserve(std::uint32_t site_id, std::size_t payload, Reservation& res) {
+    Impl& m = *impl_;
+    logring::ThreadRings::Reservation r;
+    switch (m.rings.reserve(site_id, payload, r)) {
+        case logring::ThreadRings::Reserve::Closed:
+            return false;
+        case logring::ThreadRings::Reserve::Dropped:
+            m.dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        case logring::ThreadRings::Reserve::Ok:
+            break;
+    }
+    res.ring = r.ring;
+    res.data = r.data;
+    res.next = r.next;
+    return true;
+}
+
+void BinaryLogger::commit(const Reservation& res) noexcept {
+    logring::ThreadRings::commit({res.ring, res.data, res.next});
+}
+
+// ---------------- decoder ----------------
+
+namespace {
+
+struct Reader {
+    std::istream& in;
+    bool ok = true;
+
+    template<typename T>
+    T get() {
+        T v{};
+        if (ok && !in.read(reinterpret_cast<char*>(&v), sizeof(v))) ok = false;
+        return v;
+    }
+    std::string bytes(std::size_t n) {
+        std::string s;
+        if (n > (std::size_t{1} << 24)) ok = false;    // no field is anywhere near this
+        if (!ok) return s;
+        s.resize(n);
+        if (n && !in.read(s.data(), static_cast<std::streamsize>(n))) ok = false;
+        return s;
+    }
+    std::string str() { return bytes(get<std::uint32_t>()); }
+};
+
+struct DecodedSite {
+    LogLevel level = LogLevel::INFO;
+    std::vector<binlog::ArgType> types;
+    int line = 0;
+    std::string file, fmt;
+};
+
+// The arguments, formatted like Logger::log_fmt; false if args does not match the types
+bool format_record(std::string& out, const DecodedSite& s, std::string_view args) {
+    std::string_view fmt = s.fmt;
+    std::size_t pos = 0;
+    for (const binlog::ArgType t : s.types) {
+        logger_detail::append_until_placeholder(out, fmt);
+        if (t == binlog::ArgType::Str) {
+            std::uint32_t n;
+            if (args.size() - pos < sizeof(n)) return false;
+            std::memcpy(&n, args.data() + pos, sizeof(n));
+            pos += sizeof(n);
+            if (args.size() - pos < n) return false;
+            out.append(args.data() + pos, n);
+            pos += n;
+            continue;
+        }
+        if (args.size() - pos < 8) return false;
+        const char* p = args.data() + pos;
+        pos += 8;
+        switch (t) {
+            case binlog::ArgType::I64:  { std::int64_t v;  std::memcpy(&v, p, 8); logger_detail::append_arg(out, v); break; }
+            case binlog::ArgType::U64:  { std::uint64_t v; std::memcpy(&v, p, 8); logger_detail::append_arg(out, v); break; }
+            case binlog::ArgType::F64:  { double v;        std::memcpy(&v, p, 8); logger_detail::append_arg(out, v); break; }
+            case binlog::ArgType::Bool: { std::uint64_t v; std::memcpy(&v, p, 8); logger_detail::append_arg(out, v != 0); break; }
+            case binlog::ArgType::Char: { std::uint64_t v; std::memcpy(&v, p, 8); out += static_cast<char>(v); break; }
+            default: return false;
+        }
+    }
+    logger_detail::append_until_placeholder(out, fmt);
+    return pos == args.size();
+}
+
+void append_time(std::string& out, std::int64_t ns) {
+    const std::time_t sec = static_cast<std::time_t>(ns / 1000000000);
+    std::tm tm;
+    localtime_r(&sec, &tm);
+    char buf[48];
+    std::size_t n = std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+    n += static_cast<std::size_t>(std::snprintf(buf + n, sizeof(buf) - n, ".%06d",
+                                                static_cast<int>(ns / 1000 % 1000000)));
+    out.append(buf, n);
+}
+
+} // namespace
+
+bool decode_binary_log(std::istream& in, std::ostream& out, const BinaryLogDecodeOptions& opts, std::string* err) {
+    const auto fail = [err](std::string why) {
+        if (err) *err = std::move(why);
+        return false;
+    };
+    Reader rd{in};
+    const std::string magic = rd.bytes(sizeof(kMagic));
+    if (!rd.ok || magic != std::string_view(kMagic, sizeof(kMagic))) return fail("not a binary log");
+    const auto version = rd.get<std::uint32_t>();
+    if (rd.ok && version != kVersion) return fail("unsupported version " + std::to_string(version));
+    const std::string name = rd.str();
+    const double ns_per_tick = rd.get<double>();
+    if (!rd.ok) return fail("truncated header");
+
+    std::vector<DecodedSite> sites;     // index = id - 1
+    std::int64_t anchor_wall = 0;
+    std::uint64_t anchor_tsc = 0;
+    std::string line;
+    for (;;) {
+        const int tag = in.get();
+        if (tag == std::char_traits<char>::eof()) break;
+        line.clear();
+        if (tag == 'S') {
+            const auto id = rd.get<std::uint32_t>();
+            DecodedSite s;
+            const auto lvl = rd.get<std::uint8_t>();
+            const auto nargs = rd.get<std::uint8_t>();
+            for (std::uint8_t i = 0; i < nargs; ++i) s.types.push_back(static_cast<binlog::ArgType>(rd.get<std::uint8_t>()));
+            s.line = rd.get<std::int32_t>();
+            s.file = rd.str();
+            s.fmt = rd.str();
+            if (!rd.ok) return fail("truncated site descriptor");
+            if (lvl > static_cast<std::uint8_t>(LogLevel::ERROR) || id != sites.size() + 1) return fail("bad site descriptor");
+            s.level = static_cast<LogLevel>(lvl);
+            sites.push_back(std::move(s));
+        } else if (tag == 'A') {
+            anchor_wall = rd.get<std::int64_t>();
+            anchor_tsc = rd.get<std::uint64_t>();
+            if (!rd.ok) return fail("truncated clock anchor");
+        } else if (tag == 'R') {
+            const auto id = rd.get<std::uint32_t>();
+            const auto tsc = rd.get<std::uint64_t>();
+            const std::string args = rd.str();
+            if (!rd.ok) return fail("truncated record");
+            if (id == 0 || id > sites.size()) return fail("record for unknown site " + std::to_string(id));
+            const DecodedSite& s = sites[id - 1];
+            const double dt = static_cast<double>(static_cast<std::int64_t>(tsc - anchor_tsc)) * ns_per_tick;
+            append_time(line, anchor_wall + static_cast<std::int64_t>(dt));
+            line += " [";
+            line += level_name(s.level);
+            line += "] ";
+            line += name;
+            line += ": ";
+            if (!format_record(line, s, args)) return fail("record does not match site " + std::to_string(id));
+            if (opts.show_location) line += " (" + s.file + ":" + std::to_string(s.line) + ")";
+            line += '\n';
+        } else if (tag == 'D') {
+            const auto n = rd.get<std::uint64_t>();
+            if (!rd.ok) return fail("truncated drop count");
+            append_time(line, anchor_wall);
+            line += " [WARN] " + name + ": " + std::to_string(n) + " binary log records dropped (ring full)\n";
+        } else {
+            return fail("unknown entry tag " + std::to_string(tag));
+        }
+        out.write(line.data(), static_cast<std::streamsize>(line.size()));
+    }
+    return true;
+}
@@ -0,0 +1,335 @@
+// src/candle_backfill.cpp
+#include "candle_backfill.h"
+#include "auth.h"
+#include "bar_store.h"
+#include "http_client.h"
+#include "logger.h"
+#include "token_bucket.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <thread>
+
+using json = nlohmann::json;
+
+namespace {
+
+constexpr const char* kCandlePath = "/rest/secure/angelbroking/historical/v1/getCandleData";
+
+// "2024-12-02T09:15:00+05:30" (offset optional, then UTC)
+bool parse_timestamp(const std::string& s, std::chrono::system_clock::time_point& out) {
+    int y, mo, d, h, mi, sec, oh = 0, om = 0;
+    char sign = '+';
+    const int n = std::sscanf(s.c_str(), "%d-%d-%dT%d:%d:%d%c%d:%d", &y, &mo, &d, &h, &mi, &sec, &sign, &oh, &om);
+    if (n != 6 && n != 9) return false;
+    const std::chrono::year_month_day ymd{std::chrono::year(y), std::chrono::month(static_cast<unsigned>(mo)),
+                                          std::chrono::day(static_cast<unsigned>(d))};
+    if (!ymd.ok()) return false;
+    auto offset = std::chrono::hours(oh) + std::chrono::minutes(om);
+    if (sign == '-') offset = -offset;
+    out = std::chrono::sys_days(ymd) + std::chrono::hours(h) + std::chrono::minutes(mi) + std::chrono::seconds(sec) - offset;
+    return true;
+}
+
+bool is_token_error(const std::string& code) {
+    // AG8001 invalid token, AG8002 token expired, AG8003 token missing
+    return code == "AG8001" || code == "AG8002" || code == "AG8003";
+}
+
+bool mentions_rate(const std::string& body) {
+    std::string lower(body);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return lower.find("access rate") != std::string::npos || lower.find("rate limit") != std::string::npos;
+}
+
+} // namespace
+
+CandleBackfill::CandleBackfill(HTTPClient& http, Auth& auth, Logger& log, BarStore& store, Options opts)
+    : http_(http), auth_(auth), log_(log), store_(store), opts_(std::move(opts)),
+      rng_(static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count())) {
+    if (opts_.base_url.empty()) opts_.base_url = auth_.base_url();
+    if (opts_.max_days_per_request <= 0) opts_.max_days_per_request = max_days(opts_.interval);
+    opts_.concurrency = std::max<std::size_t>(1, opts_.concurrency);
+    opts_.max_attempts = std::max(1, opts_.max_attempts);
+}
+
+const char* CandleBackfill::interval_name(Interval i) noexcept {
+    switch (i) {
+    case Interval::OneMinute: return "ONE_MINUTE";
+    case Interval::ThreeMinute: return "THREE_MINUTE";
+    case Interval::FiveMinute: return "FIVE_MINUTE";
+    case Interval::TenMinute: return "TEN_MINUTE";
+    case Interval::FifteenMinute: return "FIFTEEN_MINUTE";
+    case Interval::ThirtyMinute: return "THIRTY_MINUTE";
+    case Interval::OneHour: return "ONE_HOUR";
+    case Interval::OneDay: return "ONE_DAY";
+    }
+    return "ONE_MINUTE";
+}
+
+// SmartAPI's documented maximum range per getCandleData request
+int CandleBackfill::max_days(Interval i) noexcept {
+    switch (i) {
+    case Interval::OneMinute: return 30;
+    case Interval::ThreeMinute: return 60;
+    case Interval::FiveMinute: return 100;
+    case Interval::TenMinute: return 100;
+    case Interval::FifteenMinute: return 200;
+    case Interval::ThirtyMinute: return 200;
+    case Interval::OneHour: return 400;
+    case Interval::OneDay: return 2000;
+    }
+    return 30;
+}
+
+void CandleBackfill::cancel() {
+    {
+        std::lock_guard<std::mutex> lk(cancel_mu_);
+        cancelled_.store(true);
+    }
+    cancel_cv_.notify_all();
+}
+
+CandleBackfill::Stats CandleBackfill::stats() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return stats_;
+}
+
+// "yyyy-MM-dd HH:mm" in exchange local time
+std::string CandleBackfill::local_time(std::chrono::system_clock::time_point t) const {
+    const auto local = std::chrono::floor<std::chrono::minutes>(t) + std::chrono::minutes(opts_.utc_offset_minutes);
+    const auto day = std::chrono::floor<std::chrono::days>(local);
+    const std::chrono::year_month_day ymd(day);
+    const std::chrono::hh_mm_ss hms(local - day);
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%04d-%02u-%02u %02d:%02d", static_cast<int>(ymd.year()),
+                  static_cast<unsigned>(ymd.month()), static_cast<unsigned>(ymd.day()),
+                  static_cast<int>(hms.hours().count()), static_cast<int>(hms.minutes().count()));
+    return buf;
+}
+
+std::chrono::milliseconds CandleBackfill::backoff(int attempt) {
+    const auto cap = std::min<std::int64_t>(opts_.backoff_max.count(),
+                                            opts_.backoff_base.count() << std::min(attempt, 20));
+    if (cap <= 0) return std::chrono::milliseconds(0);
+    std::lock_guard<std::mutex> lk(mu_);
+    // splitmix64
+    std::uint64_t z = (rng_ += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return std::chrono::milliseconds(static_cast<std::int64_t>(z % static_cast<std::uint64_t>(cap)));
+}
+
+std::map<std::string, std::string> CandleBackfill::headers(std::uint64_t& generation) {
+    std::unique_lock<std::mutex> lk(mu_);
+    refresh_cv_.wait(lk, [this] { return !refreshing_; });   // the old token is known dead
+    generation = token_generation_;
+    return auth_.request_headers();
+}
+
+// One refresh however many workers hit the expired token: whoever comes second
+// waits for it, sees the generation moved and just retries with the new token.
+// The broker round trip runs outside mu_, so stats and backoff don't stall on it.
+bool CandleBackfill::refresh_token(std::uint64_t seen_generation) {
+    std::unique_lock<std::mutex> lk(mu_);
+    refresh_cv_.wait(lk, [this] { return !refreshing_; });
+    if (token_generation_ != seen_generation) return true;
+    ++stats_.refreshes;
+    refreshing_ = true;
+    lk.unlock();
+    bool ok = false;
+    try {
+        ok = auth_.refresh();
+    } catch (const std::exception& e) {
+        log_.warn_fmt("backfill: token refresh failed: {}", e.what());
+    }
+    lk.lock();
+    refreshing_ = false;
+    if (ok) ++token_generation_;
+    refresh_cv_.notify_all();
+    return ok;
+}
+
+CandleBackfill::Outcome CandleBackfill::fetch(const Chunk& c, std::size_t& added, std::string& err) {
+    const json payload = {
+        {"exchange", c.job->exchange},
+        {"symboltoken", c.job->token},
+        {"interval", interval_name(opts_.interval)},
+        {"fromdate", local_time(c.from)},
+        {"todate", local_time(c.to)},
+    };
+    std::uint64_t generation = 0;
+    const auto hdrs = headers(generation);
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        ++stats_.requests;
+    }
+    const auto throttled = [this] {
+        std::lock_guard<std::mutex> lk(mu_);
+        ++stats_.throttled;
+        return Outcome::Retry;
+    };
+    const auto token_expired = [this, generation, &err] {
+        if (refresh_token(generation)) return Outcome::Refresh;
+        err = "token refresh failed";
+        return Outcome::Fail;
+    };
+
+    HttpResponse res;
+    try {
+        res = http_.post_json(opts_.base_url + kCandlePath, payload.dump(), hdrs);
+    } catch (const std::exception& e) {
+        err = e.what();
+        return Outcome::Retry;
+    }
+    if (res.status == 429) {
+        err = "HTTP 429";
+        return throttled();
+    }
+    if (res.status == 403 && mentions_rate(res.body)) {
+        err = "HTTP 403 (access rate)";
+        return throttled();
+    }
+    if (res.status >= 500) {
+        err = "HTTP " + std::to_string(res.status);
+        return Outcome::Retry;
+    }
+    if (res.status == 401 || res.status == 403) {
+        err = "HTTP " + std::to_string(res.status);
+        return token_expired();
+    }
+    if (res.status / 100 != 2) {
+        err = "HTTP " + std::to_string(res.status) + " " + res.body.substr(0, 200);
+        return Outcome::Fail;
+    }
+
+    json j;
+    try {
+        j = json::parse(res.body);
+    } catch (const std::exception& e) {
+        err = std::string("bad response: ") + e.what();
+        return Outcome::Retry;
+    }
+    const auto str = [&j](const char* k) {
+        const auto it = j.find(k);
+        return it != j.end() && it->is_string() ? it->get<std::string>() : std::string();
+    };
+    if (const auto st = j.find("status"); st == j.end() || !st->is_boolean() || !st->get<bool>()) {
+        const std::string code = str("errorcode");
+        err = code + " " + str("message");
+        if (is_token_error(code)) return token_expired();
+        if (code == "AB1004" || mentions_rate(err)) return throttled();   // "please try after sometime"
+        return Outcome::Fail;
+    }
+
+    // data: [[timestamp, open, high, low, close, volume], ...] or null for no trading
+    std::vector<Bar> bars;
+    if (const auto it = j.find("data"); it != j.end() && it->is_array()) {
+        bars.reserve(it->size());
+        for (const auto& row : *it) {
+            Bar b;
+            const bool numeric = row.is_array() && row.size() >= 6 && row[1].is_number() && row[2].is_number()
+                              && row[3].is_number() && row[4].is_number() && row[5].is_number_unsigned();
+            if (!numeric || !row[0].is_string() || !parse_timestamp(row[0].get<std::string>(), b.start)) {
+                err = "bad candle row";
+                return Outcome::Fail;
+            }
+            b.open = row[1].get<double>();
+            b.high = row[2].get<double>();
+            b.low = row[3].get<double>();
+            b.close = row[4].get<double>();
+            b.volume = row[5].get<std::uint64_t>();
+            bars.push_back(b);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        stats_.bars += bars.size();
+    }
+    added = store_.merge(c.job->key.empty() ? c.job->token : c.job->key, std::move(bars));
+    return Outcome::Done;
+}
+
+CandleBackfill::Result CandleBackfill::run(const std::vector<Job>& jobs) {
+    const auto t0 = std::chrono::steady_clock::now();
+    cancelled_.store(false);
+
+    std::vector<Chunk> chunks;
+    const auto span = std::chrono::hours(24) * opts_.max_days_per_request;
+    for (const auto& job : jobs) {
+        for (auto from = job.from; from < job.to;) {
+            const auto to = std::min(job.to, from + span);
+            chunks.push_back({&job, from, to});
+            from = to;
+        }
+    }
+
+    Result result;
+    result.chunks = chunks.size();
+    if (chunks.empty()) return result;
+    const std::size_t workers = std::min(opts_.concurrency, chunks.size());
+    log_.info_fmt("[backfill] {} jobs, {} chunks of up to {} days, {} workers", jobs.size(), chunks.size(),
+                  opts_.max_days_per_request, workers);
+
+    std::unique_ptr<TokenBucket> bucket;
+    if (opts_.requests_per_second > 0)
+        bucket = std::make_unique<TokenBucket>(opts_.requests_per_second, std::max(1.0, opts_.requests_per_second));
+
+    std::atomic<std::size_t> next{0};
+    std::mutex result_mu;
+    const auto sleep = [this](std::chrono::steady_clock::duration d) {
+        std::unique_lock<std::mutex> lk(cancel_mu_);
+        cancel_cv_.wait_for(lk, d, [this] { return cancelled_.load(); });
+    };
+    const auto work = [&] {
+        for (std::size_t i; (i = next.fetch_add(1)) < chunks.size();) {
+            const Chunk& c = chunks[i];
+            std::size_t added = 0;
+            std::string err;
+            bool done = false;
+            for (int attempt = 1; !cancelled_.load(); ++attempt) {
+                if (bucket) sleep(bucket->reserve());
+                if (cancelled_.load()) break;
+                const Outcome o = fetch(c, added, err);
+                if (o == Outcome::Done) {
+                    done = true;
+                    break;
+                }
+                if (o == Outcome::Fail || attempt >= opts_.max_attempts) break;
+                {
+                    std::lock_guard<std::mutex> lk(mu_);
+                    ++stats_.retries;
+                }
+                if (o == Outcome::Retry) sleep(backoff(attempt));
+            }
+            if (!done && cancelled_.load()) err = "cancelled";
+
+            std::lock_guard<std::mutex> lk(result_mu);
+            if (done) {
+                result.bars += added;
+                continue;
+            }
+            ++result.failed;
+            result.errors.push_back(c.job->exchange + ":" + c.job->token + " " + local_time(c.from) + " .. "
+                                    + local_time(c.to) + ": " + err);
+            log_.warn_fmt("[backfill] gave up on {}", result.errors.back());
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (std::size_t i = 1; i < workers; ++i) threads.emplace_back(work);
+    work();
+    for (auto& t : threads) t.join();
+
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0);
+    log_.info_fmt("[backfill] {} new bars from {} chunks in {}ms, {} failed", result.bars, result.chunks,
+                  static_cast<long>(ms.count()), result.failed);
+    return result;
+}
@@ -17,6 +17,7 @@ Config Config::load_from_file(const std::string& path) {
     cfg.client_id_     = j.at("client_id").get<std::string>();
     cfg.client_secret_ = j.at("client_secret").get<std::string>();
     cfg.tokens_        = j.at("tokens").get<std::vector<std::string>>();
+    cfg.symbols_       = j.value("symbols", std::vector<std::string>{});
     cfg.splits_        = j.at("splits").get<std::unordered_map<std::string,int>>();
 
     return cfg;
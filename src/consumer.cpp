@@ -1,12 +1,73 @@
 #include "consumer.h"
 
+#include <nlohmann/json.hpp>
+
+namespace {
+
+// {"type":"ack","action":"subscribe",...}; unsubscribe echoes and error frames
+// that merely mention "subscribe" are not acks
+bool is_subscribe_ack(const std::string& msg) {
+    const auto j = nlohmann::json::parse(msg, nullptr, /*allow_exceptions=*/false);
+    if (!j.is_object()) return false;
+    const auto type = j.find("type");
+    const auto action = j.find("action");
+    return type != j.end() && action != j.end() && type->is_string() && action->is_string()
+        && *type == "ack" && *action == "subscribe";
+}
+
+// Off the tick path: only frames the parser rejected get here
+void count_non_tick(const Consumer::Metrics& m, const std::string& msg) {
+    if (!m.subscribe_acks && !m.parse_failures) return;
+    if (is_subscribe_ack(msg)) {
+        if (m.subscribe_acks) m.subscribe_acks->inc();
+    } else if (m.parse_failures) {
+        m.parse_failures->inc();
+    }
+}
+
+} // namespace
+
 Consumer::Consumer(IngestQueue& q, Parser& parser, LTPStore& store, Logger& log)
-    : q_(q), parser_(parser), store_(store), log_(log) {}
+    : queues_{Source{&q, {}}}, parser_(parser), store_(store), log_(log) {}
 
 Consumer::~Consumer() { stop(); }
 
 void Consumer::set_sink(SinkFn fn) { sink_ = std::move(fn); }
 
+void Consumer::add_queue(IngestQueue& q) { add_queue(q, SourceOptions{}); }
+
+void Consumer::add_queue(IngestQueue& q, const SourceOptions& o) {
+    std::lock_guard<std::mutex> lk(pending_mu_);
+    pending_.push_back(Source{&q, o});
+    has_pending_.store(true, std::memory_order_release);
+}
+
+void Consumer::add_queue(IngestQueue& q, FeedArbiter& arb, std::size_t leg) {
+    SourceOptions o;
+    o.arb = &arb;
+    o.leg = leg;
+    add_queue(q, o);
+}
+
+void Consumer::configure(const SourceOptions& o) { queues_.front().o = o; }
+
+void Consumer::set_arbiter(FeedArbiter& arb, std::size_t leg) {
+    queues_.front().o.arb = &arb;
+    queues_.front().o.leg = leg;
+}
+
+void Consumer::set_stage_timing(StageHistograms* timing) { queues_.front().o.timing = timing; }
+
+void Consumer::set_rate_tracker(TickRateTracker* t, std::string key_prefix) {
+    rates_ = t;
+    rate_prefix_ = std::move(key_prefix);
+}
+
+void Consumer::set_placement(ThreadPlacement p, std::string thread_name) {
+    placement_ = p;
+    thread_name_ = std::move(thread_name);
+}
+
 bool Consumer::start() {
     if (running_.exchange(true)) return true;
     thr_ = std::thread([this]{ run(); });
@@ -19,16 +80,56 @@ void Consumer::stop() {
 }
 
 void Consumer::run() {
+    apply_thread_placement(placement_, log_, thread_name_);
+    log_.info("[consumer] placement " + describe_thread_placement(thread_name_));
+
+    // Bounded burst per queue so one busy shard cannot starve the others
+    constexpr int kBurst = 64;
+
     std::string msg;
+    IngestQueue::Stamp stamp;
     while (running_.load()) {
-        if (!q_.try_pop(msg)) {
-            std::this_thread::yield();
-            continue;
+        if (has_pending_.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lk(pending_mu_);
+            queues_.insert(queues_.end(), pending_.begin(), pending_.end());
+            pending_.clear();
+            has_pending_.store(false, std::memory_order_relaxed);
+        }
+        bool any = false;
+        for (const Source& src : queues_) {
+            const SourceOptions& o = src.o;
+            int n = 0;
+            for (; n < kBurst && src.q->try_pop(msg, stamp); ++n) process(o, msg, stamp);
+            any = any || n > 0;
+            // Ring drained: conflated frames are newer than anything that was in it
+            if (n < kBurst && o.overload && o.overload->has_parked()) {
+                const std::size_t k = o.overload->take_parked(parked_);
+                for (std::size_t i = 0; i < k; ++i) process(o, parked_[i].frame, parked_[i].stamp);
+                any = any || k > 0;
+            }
         }
-        auto ltp = parser_.parse_ltp(msg);
-        if (!ltp) continue;
-        store_.upsert(*ltp);
-        if (sink_) sink_(*ltp);
+        if (!any) std::this_thread::yield();
     }
 }
 
+void Consumer::process(const SourceOptions& o, const std::string& msg, const IngestQueue::Stamp& stamp) {
+    const bool timed = kStageTimingCompiled && o.timing && stamp.read_tsc;
+    const std::uint64_t dequeued = timed ? tsc_now() : 0;
+    auto ltp = parser_.parse_ltp(msg);
+    if (!ltp) {
+        count_non_tick(o.metrics, msg);
+        return;
+    }
+    const std::uint64_t parsed = timed ? tsc_now() : 0;
+    if (o.arb && !o.arb->admit(o.leg, *ltp, stamp.arrival_ns)) return;
+    ltp->recv = std::chrono::steady_clock::now();
+    if (rates_) {
+        std::string_view key = ltp->token;
+        if (!rate_prefix_.empty() && key.starts_with(rate_prefix_)) key.remove_prefix(rate_prefix_.size());
+        rates_->record(key);
+    }
+    store_.upsert(*ltp);
+    if (timed) o.timing->record(stamp.read_tsc, stamp.enqueue_tsc, dequeued, parsed, tsc_now());
+    if (o.metrics.ticks) o.metrics.ticks->inc();
+    if (sink_) sink_(*ltp);
+}
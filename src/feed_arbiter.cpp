@@ -0,0 +1,74 @@
+// src/feed_arbiter.cpp
+#include "feed_arbiter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace {
+
+// Counters have a single writer (the Consumer thread): plain load+store, no RMW
+void bump(std::atomic<std::uint64_t>& c, std::uint64_t by = 1) {
+    c.store(c.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+} // namespace
+
+bool FeedArbiter::admit(std::size_t leg, const LTP& t, std::int64_t arrival_ns) {
+    if (leg >= kLegs) return true;
+    const auto bit = static_cast<std::uint8_t>(1u << leg);
+    const std::int64_t ts_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        t.ts.time_since_epoch()).count();
+
+    auto [it, inserted] = table_.try_emplace(t.token);
+    if (inserted) n_instruments_.store(table_.size(), std::memory_order_relaxed);
+    Entry& e = it->second;
+
+    std::int64_t oldest_ts = std::numeric_limits<std::int64_t>::max();
+    for (std::size_t i = 0; i < e.used; ++i) {
+        Seen& s = e.recent[i];
+        oldest_ts = std::min(oldest_ts, s.ts_ms);
+        if (s.ts_ms != ts_ms || s.px != t.ltp) continue;
+        if (s.legs & bit) continue;    // same leg again: a genuine repeat print, not a copy
+
+        // The other leg's copy: drop it and settle who was really first on the wire
+        s.legs |= bit;
+        bump(legs_[leg].duplicates);
+        const std::size_t winner = arrival_ns < s.arrival_ns ? leg : s.first;
+        const auto lead = static_cast<std::uint64_t>(arrival_ns < s.arrival_ns ? s.arrival_ns - arrival_ns
+                                                                               : arrival_ns - s.arrival_ns);
+        auto& w = legs_[winner];
+        bump(w.wins);
+        bump(w.lead_ns_total, lead);
+        if (lead > w.lead_ns_max.load(std::memory_order_relaxed)) w.lead_ns_max.store(lead, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Older than anything still remembered: a lagging leg replaying the past
+    if (e.used == kRecent && ts_ms < oldest_ts) {
+        bump(stale_);
+        return false;
+    }
+
+    Seen& slot = e.recent[e.next];
+    slot = Seen{ts_ms, t.ltp, arrival_ns, bit, static_cast<std::uint8_t>(leg)};
+    e.next = static_cast<std::uint8_t>((e.next + 1) % kRecent);
+    if (e.used < kRecent) ++e.used;
+    bump(legs_[leg].forwarded);
+    return true;
+}
+
+FeedArbiter::Stats FeedArbiter::stats() const {
+    Stats st;
+    for (std::size_t i = 0; i < kLegs; ++i) {
+        const auto& c = legs_[i];
+        auto& o = st.legs[i];
+        o.forwarded     = c.forwarded.load(std::memory_order_relaxed);
+        o.duplicates    = c.duplicates.load(std::memory_order_relaxed);
+        o.wins          = c.wins.load(std::memory_order_relaxed);
+        o.lead_ns_total = c.lead_ns_total.load(std::memory_order_relaxed);
+        o.lead_ns_max   = c.lead_ns_max.load(std::memory_order_relaxed);
+    }
+    st.stale = stale_.load(std::memory_order_relaxed);
+    return st;
+}
@@ -0,0 +1,153 @@
+// src/feed_watchdog.cpp
+#include "feed_watchdog.h"
+#include "logger.h"
+#include "ltp_store.h"
+
+#include <algorithm>
+
+FeedWatchdog::FeedWatchdog(Logger& log, Options opts)
+    : log_(log), opts_(std::move(opts)) {
+    if (opts_.check_interval.count() <= 0) opts_.check_interval = std::chrono::milliseconds(100);
+}
+
+FeedWatchdog::~FeedWatchdog() { stop(); }
+
+std::size_t FeedWatchdog::watch(Target t) {
+    std::lock_guard<std::mutex> lk(mu_);
+    Watched w;
+    w.id = next_id_++;
+    w.t = std::move(t);
+    w.last_change = std::chrono::steady_clock::now();
+    targets_.push_back(std::move(w));
+    return targets_.back().id;
+}
+
+void FeedWatchdog::unwatch(std::size_t id) {
+    std::lock_guard<std::mutex> lk(mu_);
+    targets_.erase(std::remove_if(targets_.begin(), targets_.end(),
+                                  [id](const Watched& w) { return w.id == id; }),
+                   targets_.end());
+}
+
+void FeedWatchdog::watch_store(const LTPStore& store) {
+    std::lock_guard<std::mutex> lk(mu_);
+    store_ = &store;
+}
+
+bool FeedWatchdog::start() {
+    if (thr_.joinable()) return true;
+    {
+        std::lock_guard<std::mutex> lk(run_mu_);
+        stop_ = false;
+    }
+    thr_ = std::thread([this] { run(); });
+    return true;
+}
+
+void FeedWatchdog::stop() {
+    {
+        std::lock_guard<std::mutex> lk(run_mu_);
+        stop_ = true;
+    }
+    run_cv_.notify_all();
+    if (thr_.joinable()) thr_.join();
+}
+
+bool FeedWatchdog::in_market_hours(std::chrono::system_clock::time_point t) const {
+    if (opts_.open_minute == opts_.close_minute) return true;
+    // Exchange-local wall clock by fixed offset: no TZ database, no localtime()
+    const auto local_min = std::chrono::duration_cast<std::chrono::minutes>(t.time_since_epoch()).count() +
+                           opts_.utc_offset_minutes;
+    const long long day = local_min >= 0 ? local_min / 1440 : (local_min - 1439) / 1440;
+    const int minute = static_cast<int>(local_min - day * 1440);
+    if (opts_.weekdays_only) {
+        const int dow = static_cast<int>(((day % 7) + 7 + 4) % 7);   // 1970-01-01 was a Thursday; 0 = Sunday
+        if (dow == 0 || dow == 6) return false;
+    }
+    if (opts_.open_minute < opts_.close_minute) return minute >= opts_.open_minute && minute < opts_.close_minute;
+    return minute >= opts_.open_minute || minute < opts_.close_minute;   // session spans midnight
+}
+
+FeedWatchdog::Stats FeedWatchdog::stats() const {
+    Stats st;
+    st.checks = checks_.load(std::memory_order_relaxed);
+    st.recycles = recycles_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lk(mu_);
+    st.stale_instruments = stale_.size();
+    return st;
+}
+
+std::vector<std::string> FeedWatchdog::stale_instruments() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return stale_;
+}
+
+std::chrono::milliseconds FeedWatchdog::silent_for(std::size_t id) const {
+    std::lock_guard<std::mutex> lk(mu_);
+    for (const auto& w : targets_) {
+        if (w.id != id || !w.active) continue;
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - w.last_change);
+    }
+    return std::chrono::milliseconds(0);
+}
+
+void FeedWatchdog::run() {
+    auto next_instr = std::chrono::steady_clock::now() + opts_.instrument_check_interval;
+    std::unique_lock<std::mutex> lk(run_mu_);
+    while (!run_cv_.wait_for(lk, opts_.check_interval, [this] { return stop_; })) {
+        lk.unlock();
+        const auto now = std::chrono::steady_clock::now();
+        const bool market = in_market_hours(std::chrono::system_clock::now());
+        check_targets(now, market);
+        if (opts_.instrument_silence.count() > 0 && now >= next_instr) {
+            next_instr = now + opts_.instrument_check_interval;
+            if (market) check_instruments(now);
+        }
+        checks_.fetch_add(1, std::memory_order_relaxed);
+        lk.lock();
+    }
+}
+
+void FeedWatchdog::check_targets(std::chrono::steady_clock::time_point now, bool market) {
+    std::vector<std::function<void()>> to_recycle;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        for (auto& w : targets_) {
+            const bool armed = !w.t.armed || w.t.armed();
+            const std::uint64_t f = w.t.frames ? w.t.frames() : 0;
+            // Silence is counted from the last frame or from when streaming became expected
+            if (!armed || !w.active || f != w.last_frames) {
+                w.last_frames = f;
+                w.last_change = now;
+            }
+            w.active = armed;
+            if (!armed || !market || opts_.max_silence.count() <= 0) continue;
+            if (now - w.last_change < opts_.max_silence) continue;
+
+            const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - w.last_change).count();
+            log_.warn("[watchdog] " + w.t.name + ": no data for " + std::to_string(ms) + "ms, recycling");
+            if (w.t.recycle) to_recycle.push_back(w.t.recycle);
+            w.last_change = now;        // give the new session a full window
+            recycles_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    for (auto& r : to_recycle) r();     // outside mu_: may re-enter via callbacks
+}
+
+void FeedWatchdog::check_instruments(std::chrono::steady_clock::time_point now) {
+    const LTPStore* store = nullptr;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        store = store_;
+    }
+    if (!store) return;
+    auto stale = store->received_before(now - opts_.instrument_silence);
+    std::sort(stale.begin(), stale.end());
+
+    std::lock_guard<std::mutex> lk(mu_);
+    if (stale.size() != stale_.size()) {
+        log_.warn("[watchdog] " + std::to_string(stale.size()) + " instruments silent for over " +
+                  std::to_string(opts_.instrument_silence.count()) + "ms");
+    }
+    stale_ = std::move(stale);
+}
@@ -1,4 +1,5 @@
 #include "http_client.h"
+#include "token_bucket.h"
 
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/ssl/stream_base.hpp>
@@ -15,12 +16,31 @@
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/ssl/error.hpp>
 #include <boost/asio/ssl/stream.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <openssl/err.h>
 #include <openssl/tls1.h>
+#include <poll.h>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 
 using tcp = boost::asio::ip::tcp;
+namespace asio = boost::asio;
+namespace beast = boost::beast;
 namespace http = boost::beast::http;
 
 
@@ -42,9 +62,404 @@ static std::string url_encode(const std::string& s) {
     return out;
 }
 
+// ================= connection pool ===================
+// Keep-alive TLS connections per host:port, plus the per-host concurrency gate,
+// the rate limiter and the threads that run async requests. A sync connection has
+// its own io_context: operations are started async (so opts.timeout really
+// bounds them) and run to completion on the calling thread. Async connections
+// live on one shared io_context run by opts.async_threads threads.
+class HttpConnectionPool {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Conn {
+        // sync: its own io_context
+        Conn(asio::ssl::context& ctx, std::string k)
+            : key(std::move(k)), own_ioc(std::make_unique<asio::io_context>()), stream(*own_ioc, ctx) {}
+        // async: the pool's shared io_context
+        Conn(asio::ssl::context& ctx, std::string k, asio::io_context& shared)
+            : key(std::move(k)), stream(shared, ctx) {}
+        // OpenSSL drops the TLS session of a connection freed without close_notify
+        // (an evicted or broken one); the host's next connection should still resume it.
+        ~Conn() { SSL_set_shutdown(stream.native_handle(), SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN); }
+        Conn(const Conn&) = delete;
+        Conn& operator=(const Conn&) = delete;
+
+        bool async() const noexcept { return !own_ioc; }
+
+        std::string key;                                   // host:port (SSL ex_data)
+        std::unique_ptr<asio::io_context> own_ioc;         // null for async connections
+        beast::ssl_stream<beast::tcp_stream> stream;
+        Clock::time_point last_used;
+    };
+
+    explicit HttpConnectionPool(const HTTPClient::Options& opts) : opts_(opts) {
+        if (opts_.max_requests_per_second > 0) {
+            const double burst = opts_.rate_burst > 0 ? static_cast<double>(opts_.rate_burst)
+                                                      : std::ceil(opts_.max_requests_per_second);
+            bucket_ = std::make_unique<TokenBucket>(opts_.max_requests_per_second, burst);
+        }
+    }
+
+    // Waits for outstanding async requests (their callbacks included)
+    ~HttpConnectionPool() {
+        if (work_) {
+            work_.reset();
+            for (auto& t : threads_) t.join();
+        }
+        idle_.clear();
+        idle_async_.clear();
+        for (auto& [key, sess] : sessions_) SSL_SESSION_free(sess);
+    }
+
+    HttpConnectionPool(const HttpConnectionPool&) = delete;
+    HttpConnectionPool& operator=(const HttpConnectionPool&) = delete;
+
+    // Run one async operation on sync connection c to completion (or opts.timeout)
+    template<typename Start>
+    static beast::error_code run(Conn& c, std::chrono::milliseconds timeout, Start start) {
+        beast::error_code result = asio::error::would_block;
+        beast::get_lowest_layer(c.stream).expires_after(timeout);
+        start([&result](beast::error_code ec, auto&&...) { result = ec; });
+        c.own_ioc->restart();
+        c.own_ioc->run();
+        return result;
+    }
+
+    // The shared io_context; its threads start on first use
+    asio::io_context& io() {
+        std::call_once(io_once_, [this] {
+            work_.emplace(asio::make_work_guard(ioc_));
+            const std::size_t n = std::max<std::size_t>(1, opts_.async_threads);
+            for (std::size_t i = 0; i < n; ++i) threads_.emplace_back([this] { ioc_.run(); });
+        });
+        return ioc_;
+    }
+
+    // Most recently used idle connection to key, or null. Expired or stale ones are closed.
+    std::unique_ptr<Conn> checkout(const std::string& key, bool async) {
+        std::lock_guard<std::mutex> lk(mu_);
+        auto& idle = async ? idle_async_ : idle_;
+        auto it = idle.find(key);
+        if (it == idle.end()) return nullptr;
+        auto& list = it->second;
+        const auto now = Clock::now();
+        while (!list.empty()) {
+            std::unique_ptr<Conn> c = std::move(list.back());
+            list.pop_back();
+            if (now - c->last_used <= opts_.idle_timeout && !peer_closed(*c)) return c;
+            evicted_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return nullptr;
+    }
+
+    void checkin(std::unique_ptr<Conn> c) {
+        std::lock_guard<std::mutex> lk(mu_);
+        const auto now = Clock::now();
+        c->last_used = now;
+        auto& idle = c->async() ? idle_async_ : idle_;
+        auto& list = idle[c->key];
+        list.push_back(std::move(c));
+        while (list.size() > opts_.max_idle_per_host) {
+            list.erase(list.begin());
+            evicted_.fetch_add(1, std::memory_order_relaxed);
+        }
+        // idle eviction for every host, oldest first
+        for (auto& [key, l] : idle) {
+            while (!l.empty() && now - l.front()->last_used > opts_.idle_timeout) {
+                l.erase(l.begin());
+                evicted_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // New TCP + TLS connection, resuming the host's last TLS session if there is one
+    std::unique_ptr<Conn> connect(const std::string& host, const std::string& port, const std::string& key) {
+        auto c = std::make_unique<Conn>(context(), key);
+        std::vector<tcp::endpoint> eps;
+        if (!cached_endpoints(key, eps)) {
+            dns_lookups_.fetch_add(1, std::memory_order_relaxed);
+            tcp::resolver resolver(*c->own_ioc);
+            for (const auto& r : resolver.resolve(host, port)) eps.push_back(r.endpoint());
+            remember_endpoints(key, eps);
+        }
+        auto ec = run(*c, opts_.timeout, [&](auto handler) {
+            beast::get_lowest_layer(c->stream).async_connect(eps, std::move(handler));
+        });
+        if (ec) {
+            forget_dns(key);           // the address may have moved
+            throw beast::system_error(ec);
+        }
+        prepare_tls(*c, host);
+        ec = run(*c, opts_.timeout, [&](auto handler) {
+            c->stream.async_handshake(asio::ssl::stream_base::client, std::move(handler));
+        });
+        if (ec) throw beast::system_error(ec);
+        connected(*c);
+        return c;
+    }
+
+    // connect() on the shared io_context; done runs on an IO thread
+    void connect_async(const std::string& host, const std::string& port, const std::string& key,
+                       std::function<void(beast::error_code, std::unique_ptr<Conn>)> done) {
+        struct Op {
+            std::unique_ptr<Conn> c;
+            tcp::resolver resolver;
+            std::string host;
+            std::function<void(beast::error_code, std::unique_ptr<Conn>)> done;
+        };
+        auto op = std::make_shared<Op>(Op{std::make_unique<Conn>(context(), key, io()), tcp::resolver(io()),
+                                          host, std::move(done)});
+
+        auto handshake = [this, op](beast::error_code ec) {
+            if (ec) return op->done(ec, nullptr);
+            connected(*op->c);
+            op->done({}, std::move(op->c));
+        };
+        auto connect = [this, op, handshake](const std::vector<tcp::endpoint>& eps) {
+            beast::get_lowest_layer(op->c->stream).expires_after(opts_.timeout);
+            beast::get_lowest_layer(op->c->stream).async_connect(eps,
+                [this, op, handshake](beast::error_code ec, const tcp::endpoint&) {
+                    if (ec) {
+                        forget_dns(op->c->key);
+                        return op->done(ec, nullptr);
+                    }
+                    try {
+                        prepare_tls(*op->c, op->host);
+                    } catch (const beast::system_error& e) {
+                        return op->done(e.code(), nullptr);
+                    }
+                    beast::get_lowest_layer(op->c->stream).expires_after(opts_.timeout);
+                    op->c->stream.async_handshake(asio::ssl::stream_base::client, handshake);
+                });
+        };
+
+        std::vector<tcp::endpoint> eps;
+        if (cached_endpoints(key, eps)) return connect(eps);
+        dns_lookups_.fetch_add(1, std::memory_order_relaxed);
+        op->resolver.async_resolve(host, port,
+            [this, op, connect](beast::error_code ec, tcp::resolver::results_type results) {
+                if (ec) return op->done(ec, nullptr);
+                std::vector<tcp::endpoint> found;
+                for (const auto& r : results) found.push_back(r.endpoint());
+                remember_endpoints(op->c->key, found);
+                connect(found);
+            });
+    }
+
+    // Per-host concurrency gate (max_concurrent_per_host). Requests over the limit
+    // wait in arrival order, sync and async alike; a released slot passes straight
+    // to the first waiter.
+    void acquire_slot(const std::string& key) {
+        if (opts_.max_concurrent_per_host == 0) return;
+        std::unique_lock<std::mutex> lk(gate_mu_);
+        Gate& g = gates_[key];
+        if (g.active < opts_.max_concurrent_per_host) {
+            ++g.active;
+            return;
+        }
+        queued_.fetch_add(1, std::memory_order_relaxed);
+        bool granted = false;
+        g.waiting.push_back([this, &granted] { granted = true; gate_cv_.notify_all(); });
+        gate_cv_.wait(lk, [&granted] { return granted; });
+    }
+
+    // go is posted to the IO threads once the request holds a slot
+    void acquire_slot_async(const std::string& key, std::function<void()> go) {
+        asio::io_context& ioc = io();
+        if (opts_.max_concurrent_per_host > 0) {
+            std::lock_guard<std::mutex> lk(gate_mu_);
+            Gate& g = gates_[key];
+            if (g.active >= opts_.max_concurrent_per_host) {
+                queued_.fetch_add(1, std::memory_order_relaxed);
+                g.waiting.push_back([&ioc, go = std::move(go)] { asio::post(ioc, go); });
+                return;
+            }
+            ++g.active;
+        }
+        asio::post(ioc, std::move(go));
+    }
+
+    void release_slot(const std::string& key) {
+        if (opts_.max_concurrent_per_host == 0) return;
+        std::lock_guard<std::mutex> lk(gate_mu_);
+        Gate& g = gates_[key];
+        if (g.waiting.empty()) {
+            --g.active;
+            return;
+        }
+        auto next = std::move(g.waiting.front());
+        g.waiting.pop_front();
+        next();
+    }
+
+    // How long the next request must wait for the rate limit (a token is taken now)
+    Clock::duration reserve_token() {
+        if (!bucket_) return Clock::duration::zero();
+        const auto d = bucket_->reserve();
+        if (d > Clock::duration::zero()) throttled_.fetch_add(1, std::memory_order_relaxed);
+        return d;
+    }
+
+    void close_idle() {
+        std::lock_guard<std::mutex> lk(mu_);
+        for (auto* idle : {&idle_, &idle_async_}) {
+            for (auto& [key, l] : *idle) evicted_.fetch_add(l.size(), std::memory_order_relaxed);
+            idle->clear();
+        }
+    }
+
+    HTTPClient::Stats stats() const noexcept {
+        HTTPClient::Stats s;
+        s.requests    = requests_.load(std::memory_order_relaxed);
+        s.connects    = connects_.load(std::memory_order_relaxed);
+        s.reused      = reused_.load(std::memory_order_relaxed);
+        s.resumed     = resumed_.load(std::memory_order_relaxed);
+        s.dns_lookups = dns_lookups_.load(std::memory_order_relaxed);
+        s.retries     = retries_.load(std::memory_order_relaxed);
+        s.evicted     = evicted_.load(std::memory_order_relaxed);
+        s.queued      = queued_.load(std::memory_order_relaxed);
+        s.throttled   = throttled_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    const HTTPClient::Options& options() const noexcept { return opts_; }
+
+    std::atomic<std::uint64_t> requests_{0}, reused_{0}, retries_{0};
+
+private:
+    struct Dns {
+        std::vector<tcp::endpoint> endpoints;
+        Clock::time_point expires;
+    };
+
+    struct Gate {
+        std::size_t active = 0;
+        std::deque<std::function<void()>> waiting;     // called under gate_mu_ with the slot
+    };
+
+    // One SSL context for every connection, built on first use (CA loading is slow)
+    asio::ssl::context& context() {
+        std::call_once(ctx_once_, [this] {
+            auto ctx = std::make_unique<asio::ssl::context>(asio::ssl::context::tls_client);
+            ctx->set_default_verify_paths();
+            if (!opts_.ca_file.empty())
+                ctx->load_verify_file(opts_.ca_file);
+            ctx->set_verify_mode(opts_.verify_peer
+                                 ? asio::ssl::verify_peer
+                                 : asio::ssl::verify_none);
+            SSL_CTX* native = ctx->native_handle();
+            SSL_CTX_set_ex_data(native, ctx_pool_index(), this);
+            // sessions are kept here, per host:port, not in OpenSSL's internal cache
+            SSL_CTX_set_session_cache_mode(native, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+            SSL_CTX_sess_set_new_cb(native, &HttpConnectionPool::on_new_session);
+            ctx_ = std::move(ctx);
+        });
+        return *ctx_;
+    }
+
+    // Our own ex_data slots: Asio keeps its verify callbacks in the app_data ones
+    static int ctx_pool_index() {
+        static const int idx = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+        return idx;
+    }
+    static int ssl_key_index() {
+        static const int idx = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+        return idx;
+    }
+
+    // TLS 1.3 tickets arrive after the handshake, while the first response is read
+    static int on_new_session(SSL* ssl, SSL_SESSION* sess) {
+        auto* self = static_cast<HttpConnectionPool*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), ctx_pool_index()));
+        const auto* key = static_cast<const std::string*>(SSL_get_ex_data(ssl, ssl_key_index()));
+        if (!self || !key || !self->opts_.tls_session_reuse) return 0;
+        std::lock_guard<std::mutex> lk(self->mu_);
+        SSL_SESSION*& slot = self->sessions_[*key];
+        if (slot) SSL_SESSION_free(slot);
+        slot = sess;
+        return 1;                      // we own the reference now
+    }
+
+    // TCP is up: SNI and the session to resume
+    void prepare_tls(Conn& c, const std::string& host) {
+        beast::get_lowest_layer(c.stream).socket().set_option(tcp::no_delay(true));
+        SSL* ssl = c.stream.native_handle();
+        if (!SSL_set_tlsext_host_name(ssl, host.c_str()))
+            throw beast::system_error(beast::error_code(static_cast<int>(::ERR_get_error()),
+                                                        asio::error::get_ssl_category()));
+        SSL_set_ex_data(ssl, ssl_key_index(), &c.key);
+        if (opts_.tls_session_reuse) {
+            std::lock_guard<std::mutex> lk(mu_);
+            if (auto it = sessions_.find(c.key); it != sessions_.end()) SSL_set_session(ssl, it->second);
+        }
+    }
+
+    void connected(Conn& c) {
+        connects_.fetch_add(1, std::memory_order_relaxed);
+        if (SSL_session_reused(c.stream.native_handle())) resumed_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool cached_endpoints(const std::string& key, std::vector<tcp::endpoint>& out) {
+        std::lock_guard<std::mutex> lk(mu_);
+        auto it = dns_.find(key);
+        if (it == dns_.end() || Clock::now() >= it->second.expires) return false;
+        out = it->second.endpoints;
+        return true;
+    }
+
+    void remember_endpoints(const std::string& key, const std::vector<tcp::endpoint>& eps) {
+        if (opts_.dns_ttl.count() <= 0) return;
+        std::lock_guard<std::mutex> lk(mu_);
+        dns_[key] = Dns{eps, Clock::now() + opts_.dns_ttl};
+    }
+
+    void forget_dns(const std::string& key) {
+        std::lock_guard<std::mutex> lk(mu_);
+        dns_.erase(key);
+    }
+
+    // An idle connection with something to read has been closed by the server
+    // (FIN or close_notify); nothing else is expected between requests
+    static bool peer_closed(Conn& c) {
+        pollfd pfd{beast::get_lowest_layer(c.stream).socket().native_handle(), POLLIN, 0};
+        return ::poll(&pfd, 1, 0) != 0;
+    }
+
+    const HTTPClient::Options opts_;   // a copy: the owning client may be moved
+    std::once_flag ctx_once_;
+    std::unique_ptr<asio::ssl::context> ctx_;
+
+    // declared before the async connections that live on it
+    asio::io_context ioc_;
+    std::optional<asio::executor_work_guard<asio::io_context::executor_type>> work_;
+    std::vector<std::thread> threads_;
+    std::once_flag io_once_;
+
+    std::mutex mu_;
+    std::map<std::string, std::vector<std::unique_ptr<Conn>>> idle_;         // oldest first
+    std::map<std::string, std::vector<std::unique_ptr<Conn>>> idle_async_;
+    std::map<std::string, Dns> dns_;
+    std::map<std::string, SSL_SESSION*> sessions_;
+
+    std::mutex gate_mu_;
+    std::condition_variable gate_cv_;
+    std::map<std::string, Gate> gates_;
+    std::unique_ptr<TokenBucket> bucket_;
+
+    std::atomic<std::uint64_t> connects_{0}, resumed_{0}, dns_lookups_{0}, evicted_{0}, queued_{0}, throttled_{0};
+};
+
 // ================= HTTPClient ===================
-HTTPClient::HTTPClient() : opts_{} {}
-HTTPClient::HTTPClient(Options opts) : opts_(std::move(opts)) {}
+HTTPClient::HTTPClient() : HTTPClient(Options{}) {}
+HTTPClient::HTTPClient(Options opts)
+  : opts_(std::move(opts)), pool_(std::make_unique<HttpConnectionPool>(opts_)) {}
+HTTPClient::~HTTPClient() = default;
+HTTPClient::HTTPClient(HTTPClient&&) noexcept = default;
+HTTPClient& HTTPClient::operator=(HTTPClient&&) noexcept = default;
+
+HTTPClient::Stats HTTPClient::stats() const noexcept { return pool_->stats(); }
+
+void HTTPClient::close_idle() { pool_->close_idle(); }
 
 void HTTPClient::set_default_header(const std::string& k, const std::string& v) {
     opts_.default_headers[k] = v;
@@ -105,57 +520,266 @@ static void apply_headers(http::request<http::string_body>& req,
     for (auto& [k, v] : headers) req.set(k, v);
 }
 
-static HttpResponse perform_request(const HTTPClient::Options& opts,
+static HttpResponse to_response(http::response<http::string_body>&& res) {
+    HttpResponse out;
+    out.status = static_cast<int>(res.result_int());
+    out.body   = std::move(res.body());
+    for (auto const& f: res.base()) {
+        out.headers.emplace(std::string(f.name_string()), std::string(f.value()));
+    }
+    return out;
+}
+
+static void prepare_request(http::request<http::string_body>& req, const HTTPClient::Options& opts,
+                            const std::string& host) {
+    req.set(http::field::host, host);
+    req.keep_alive(opts.max_idle_per_host > 0);
+}
+
+// A pooled connection that fails before any response byte arrives was closed by
+// the server while idle: the request never reached it, so it is sent again once.
+static bool resend_on_new_connection(bool reused, int attempt, bool got_some, beast::error_code ec) {
+    return reused && attempt == 0 && !got_some && ec != beast::error::timeout;
+}
+
+// ...unless it was written out: then the server may have read it and hung up
+// without answering, and only a request that is safe to repeat goes out again
+// (a POST could place an order twice).
+static bool safe_to_resend(http::verb method, bool written) {
+    return !written || method == http::verb::get || method == http::verb::head;
+}
+
+// How a response was read off a connection
+struct ReadResult {
+    beast::error_code ec;
+    bool got_some = false;       // any response byte arrived
+    bool complete = false;       // the whole message was read
+    bool keep_alive = false;
+};
+
+// Whole body into HttpResponse::body (up to opts.body_limit)
+static ReadResult read_buffered(HttpConnectionPool::Conn& c, const HTTPClient::Options& opts,
+                                beast::flat_buffer& buffer, HttpResponse& out) {
+    http::response_parser<http::string_body> parser;
+    parser.body_limit(opts.body_limit);
+    const auto ec = HttpConnectionPool::run(c, opts.timeout, [&](auto handler) {
+        http::async_read(c.stream, buffer, parser, std::move(handler));
+    });
+    if (ec) return {ec, parser.got_some()};
+    http::response<http::string_body> res = parser.release();
+    const bool keep = res.keep_alive();
+    out = to_response(std::move(res));
+    return {{}, true, true, keep};
+}
+
+// Body handed to sink chunk by chunk as it arrives, nothing kept
+static ReadResult read_streaming(HttpConnectionPool::Conn& c, const HTTPClient::Options& opts,
+                                 beast::flat_buffer& buffer, HttpResponse& out,
+                                 const HTTPClient::BodySink& sink) {
+    http::response_parser<http::buffer_body> parser;
+    parser.body_limit(std::numeric_limits<std::uint64_t>::max());
+    auto ec = HttpConnectionPool::run(c, opts.timeout, [&](auto handler) {
+        http::async_read_header(c.stream, buffer, parser, std::move(handler));
+    });
+    if (ec) return {ec, parser.got_some()};
+    out.status = static_cast<int>(parser.get().result_int());
+    for (auto const& f : parser.get().base()) {
+        out.headers.emplace(std::string(f.name_string()), std::string(f.value()));
+    }
+
+    std::vector<char> chunk(opts.stream_chunk);
+    while (!parser.is_done()) {
+        parser.get().body().data = chunk.data();
+        parser.get().body().size = chunk.size();
+        ec = HttpConnectionPool::run(c, opts.timeout, [&](auto handler) {
+            http::async_read(c.stream, buffer, parser, std::move(handler));
+        });
+        if (ec == http::error::need_buffer) ec = {};
+        if (ec) return {ec, true};
+        const std::size_t n = chunk.size() - parser.get().body().size;
+        if (n > 0 && !sink(std::string_view(chunk.data(), n))) return {{}, true, false, false};
+    }
+    return {{}, true, true, parser.get().keep_alive()};
+}
+
+// Send req over a pooled connection (or a new one) and read the response with
+// read(conn, buffer, out), after taking a host slot and a rate token.
+template<typename Read>
+static HttpResponse perform_request(HttpConnectionPool& pool,
+                                    const HTTPClient::Options& opts,
                                     const std::string& host,
                                     const std::string& port,
-                                    http::request<http::string_body>& req)
+                                    http::request<http::string_body>& req,
+                                    Read read)
 {
-    boost::asio::io_context ioc;
-    boost::asio::ssl::context ssl_ctx(boost::asio::ssl::context::tls_client);
-
-    ssl_ctx.set_default_verify_paths();
-    if (!opts.ca_file.empty())
-        ssl_ctx.load_verify_file(opts.ca_file);
-    ssl_ctx.set_verify_mode(opts.verify_peer
-                            ? boost::asio::ssl::verify_peer
-                            : boost::asio::ssl::verify_none);
+    const std::string key = host + ":" + port;
+    const bool pooled = opts.max_idle_per_host > 0;
+    prepare_request(req, opts, host);
+    pool.requests_.fetch_add(1, std::memory_order_relaxed);
+
+    pool.acquire_slot(key);
+    struct SlotGuard {
+        HttpConnectionPool& pool;
+        const std::string& key;
+        ~SlotGuard() { pool.release_slot(key); }
+    } slot{pool, key};
+    if (const auto wait = pool.reserve_token(); wait > HttpConnectionPool::Clock::duration::zero())
+        std::this_thread::sleep_for(wait);
+
+    for (int attempt = 0;; ++attempt) {
+        std::unique_ptr<HttpConnectionPool::Conn> c = pooled ? pool.checkout(key, false) : nullptr;
+        const bool reused = c != nullptr;
+        if (reused) pool.reused_.fetch_add(1, std::memory_order_relaxed);
+        else c = pool.connect(host, port, key);
+
+        //send
+        auto ec = HttpConnectionPool::run(*c, opts.timeout, [&](auto handler) {
+            http::async_write(c->stream, req, std::move(handler));
+        });
+
+        //receive
+        boost::beast::flat_buffer buffer;
+        HttpResponse out;
+        ReadResult r{ec};
+        if (!ec) r = read(*c, buffer, out);
+        if (r.ec) {
+            if (resend_on_new_connection(reused, attempt, r.got_some, r.ec) && safe_to_resend(req.method(), !ec)) {
+                pool.retries_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            throw beast::system_error(r.ec);
+        }
+
+        if (r.complete && pooled && r.keep_alive) {
+            pool.checkin(std::move(c));
+        } else if (r.complete) {
+            // shutdown (best effort)
+            HttpConnectionPool::run(*c, opts.timeout, [&](auto handler) {
+                c->stream.async_shutdown(std::move(handler));
+            });
+        }
+        // else stopped mid-body: the connection is dropped
+        return out;
+    }
+}
 
-    tcp::resolver resolver(ioc);
-    auto const results = resolver.resolve(host, port);
+// perform_request() as a chain of completion handlers on the pool's IO threads:
+// host slot -> rate token -> pooled or new connection -> write -> read -> callback.
+class AsyncRequest : public std::enable_shared_from_this<AsyncRequest> {
+public:
+    AsyncRequest(HttpConnectionPool& pool, std::string host, std::string port,
+                 http::request<http::string_body> req, HTTPClient::Callback cb)
+        : pool_(pool), host_(std::move(host)), port_(std::move(port)), key_(host_ + ":" + port_),
+          req_(std::move(req)), cb_(std::move(cb)), timer_(pool.io()) {
+        prepare_request(req_, pool_.options(), host_);
+    }
 
-    boost::beast::ssl_stream<boost::beast::tcp_stream> stream(ioc, ssl_ctx);
+    void start() {
+        pool_.requests_.fetch_add(1, std::memory_order_relaxed);
+        pool_.acquire_slot_async(key_, [self = shared_from_this()] { self->throttle(); });
+    }
 
-    //timeouts
-    stream.next_layer().expires_after(opts.timeout);
+private:
+    void throttle() {
+        const auto wait = pool_.reserve_token();
+        if (wait <= HttpConnectionPool::Clock::duration::zero()) return send();
+        timer_.expires_after(wait);
+        timer_.async_wait([self = shared_from_this()](beast::error_code) { self->send(); });
+    }
 
-    //connect
-    boost::asio::connect(stream.next_layer().socket(), results.begin(), results.end());
+    void send() {
+        const bool pooled = pool_.options().max_idle_per_host > 0;
+        conn_ = pooled ? pool_.checkout(key_, true) : nullptr;
+        reused_ = conn_ != nullptr;
+        if (reused_) {
+            pool_.reused_.fetch_add(1, std::memory_order_relaxed);
+            return write();
+        }
+        try {
+            pool_.connect_async(host_, port_, key_,
+                [self = shared_from_this()](beast::error_code ec, std::unique_ptr<HttpConnectionPool::Conn> c) {
+                    if (ec) return self->finish(ec, {});
+                    self->conn_ = std::move(c);
+                    self->write();
+                });
+        } catch (const beast::system_error& e) {     // SSL context setup (CA file)
+            finish(e.code(), {});
+        }
+    }
 
-    // TLS handshake
-    if (! SSL_set_tlsext_host_name(stream.native_handle(), host.c_str()))
-        throw std::runtime_error("SNI set failed");
-    stream.handshake(boost::asio::ssl::stream_base::client);
+    void write() {
+        beast::get_lowest_layer(conn_->stream).expires_after(pool_.options().timeout);
+        http::async_write(conn_->stream, req_, [self = shared_from_this()](beast::error_code ec, std::size_t) {
+            if (ec) return self->failed(ec);
+            self->written_ = true;
+            self->read();
+        });
+    }
 
-    //send 
-    req.set(http::field::host, host);
-    http::write(stream, req);
+    void read() {
+        parser_.emplace();
+        parser_->body_limit(pool_.options().body_limit);
+        beast::get_lowest_layer(conn_->stream).expires_after(pool_.options().timeout);
+        http::async_read(conn_->stream, buffer_, *parser_, [self = shared_from_this()](beast::error_code ec, std::size_t) {
+            if (ec) return self->failed(ec);
+            self->done();
+        });
+    }
 
-    //receive
-    boost::beast::flat_buffer buffer;
-    http::response<http::string_body> res;
-    http::read(stream, buffer, res);
+    void failed(beast::error_code ec) {
+        conn_.reset();
+        buffer_.clear();
+        if (!parser_) parser_.emplace();
+        if (resend_on_new_connection(reused_, attempt_, parser_->got_some(), ec) && safe_to_resend(req_.method(), written_)) {
+            pool_.retries_.fetch_add(1, std::memory_order_relaxed);
+            ++attempt_;
+            written_ = false;
+            parser_.reset();
+            return send();
+        }
+        finish(ec, {});
+    }
 
-    // shutdown (best effort)
-    boost::system::error_code ec;
-    stream.shutdown(ec);
+    void done() {
+        http::response<http::string_body> res = parser_->release();
+        if (pool_.options().max_idle_per_host > 0 && res.keep_alive()) {
+            pool_.checkin(std::move(conn_));
+        } else {
+            // shutdown (best effort), the connection lives until it completes
+            std::shared_ptr<HttpConnectionPool::Conn> c(std::move(conn_));
+            beast::get_lowest_layer(c->stream).expires_after(pool_.options().timeout);
+            c->stream.async_shutdown([c](beast::error_code) {});
+        }
+        finish({}, to_response(std::move(res)));
+    }
 
-    HttpResponse out;
-    out.status = static_cast<int>(res.result_int());
-    out.body   = std::move(res.body());
-    for (auto const& f: res.base()) {
-        out.headers.emplace(std::string(f.name_string()), std::string(f.value()));
+    void finish(beast::error_code ec, HttpResponse res) {
+        pool_.release_slot(key_);
+        auto cb = std::move(cb_);
+        cb(ec, std::move(res));
     }
-    return out;
+
+    HttpConnectionPool& pool_;
+    const std::string host_, port_, key_;
+    http::request<http::string_body> req_;
+    HTTPClient::Callback cb_;
+    asio::steady_timer timer_;
+    std::unique_ptr<HttpConnectionPool::Conn> conn_;
+    beast::flat_buffer buffer_;
+    std::optional<http::response_parser<http::string_body>> parser_;
+    bool reused_ = false;
+    bool written_ = false;      // the request went out on conn_
+    int attempt_ = 0;
+};
+
+static std::future<HttpResponse> as_future(const std::function<void(HTTPClient::Callback)>& submit) {
+    auto promise = std::make_shared<std::promise<HttpResponse>>();
+    auto fut = promise->get_future();
+    submit([promise](std::error_code ec, HttpResponse res) {
+        if (ec) promise->set_exception(std::make_exception_ptr(std::system_error(ec)));
+        else promise->set_value(std::move(res));
+    });
+    return fut;
 }
 
 HttpResponse HTTPClient::get(const std::string& https_url,
@@ -165,7 +789,10 @@ HttpResponse HTTPClient::get(const std::string& https_url,
     auto u = parse_https_url(https_url, query);
     http::request<http::string_body> req{http::verb::get, u.target, 11};
     apply_headers(req, opts_, headers);
-    return perform_request(opts_, u.host, u.port, req);
+    return perform_request(*pool_, opts_, u.host, u.port, req,
+                           [this](HttpConnectionPool::Conn& c, beast::flat_buffer& buf, HttpResponse& out) {
+                               return read_buffered(c, opts_, buf, out);
+                           });
 }
 
 HttpResponse HTTPClient::post(const std::string& https_url,
@@ -180,7 +807,40 @@ HttpResponse HTTPClient::post(const std::string& https_url,
     req.prepare_payload();
     req.set(http::field::content_type, content_type);
     apply_headers(req, opts_, headers);
-    return perform_request(opts_, u.host, u.port, req);
+    return perform_request(*pool_, opts_, u.host, u.port, req,
+                           [this](HttpConnectionPool::Conn& c, beast::flat_buffer& buf, HttpResponse& out) {
+                               return read_buffered(c, opts_, buf, out);
+                           });
+}
+
+HttpResponse HTTPClient::get_stream(const std::string& https_url,
+                                    const BodySink& sink,
+                                    const std::map<std::string, std::string>& headers,
+                                    const std::map<std::string, std::string>& query)
+{
+    auto u = parse_https_url(https_url, query);
+    http::request<http::string_body> req{http::verb::get, u.target, 11};
+    apply_headers(req, opts_, headers);
+    return perform_request(*pool_, opts_, u.host, u.port, req,
+                           [this, &sink](HttpConnectionPool::Conn& c, beast::flat_buffer& buf, HttpResponse& out) {
+                               return read_streaming(c, opts_, buf, out, sink);
+                           });
+}
+
+HttpResponse HTTPClient::download(const std::string& https_url,
+                                  const std::string& path,
+                                  const std::map<std::string, std::string>& headers,
+                                  const std::map<std::string, std::string>& query)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) throw std::runtime_error("HTTPClient: cannot open " + path);
+    auto res = get_stream(https_url, [&file](std::string_view chunk) {
+        file.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        return static_cast<bool>(file);
+    }, headers, query);
+    file.close();
+    if (!file) throw std::runtime_error("HTTPClient: write to " + path + " failed");
+    return res;
 }
 
 HttpResponse HTTPClient::post_json(const std::string& https_url,
@@ -193,34 +853,55 @@ HttpResponse HTTPClient::post_json(const std::string& https_url,
     return post(https_url, json_body, "application/json", h, query);
 }
 
+void HTTPClient::get_async(const std::string& https_url,
+                           const std::map<std::string, std::string>& headers,
+                           const std::map<std::string, std::string>& query,
+                           Callback cb)
+{
+    auto u = parse_https_url(https_url, query);
+    http::request<http::string_body> req{http::verb::get, u.target, 11};
+    apply_headers(req, opts_, headers);
+    std::make_shared<AsyncRequest>(*pool_, u.host, u.port, std::move(req), std::move(cb))->start();
+}
 
+void HTTPClient::post_async(const std::string& https_url,
+                            const std::string& body,
+                            const std::string& content_type,
+                            const std::map<std::string, std::string>& headers,
+                            const std::map<std::string, std::string>& query,
+                            Callback cb)
+{
+    auto u = parse_https_url(https_url, query);
+    http::request<http::string_body> req{http::verb::post, u.target, 11};
+    req.body() = body;
+    req.prepare_payload();
+    req.set(http::field::content_type, content_type);
+    apply_headers(req, opts_, headers);
+    std::make_shared<AsyncRequest>(*pool_, u.host, u.port, std::move(req), std::move(cb))->start();
+}
 
+std::future<HttpResponse> HTTPClient::get_async(const std::string& https_url,
+                                                const std::map<std::string, std::string>& headers,
+                                                const std::map<std::string, std::string>& query)
+{
+    return as_future([&](Callback cb) { get_async(https_url, headers, query, std::move(cb)); });
+}
 
+std::future<HttpResponse> HTTPClient::post_async(const std::string& https_url,
+                                                 const std::string& body,
+                                                 const std::string& content_type,
+                                                 const std::map<std::string, std::string>& headers,
+                                                 const std::map<std::string, std::string>& query)
+{
+    return as_future([&](Callback cb) { post_async(https_url, body, content_type, headers, query, std::move(cb)); });
+}
 
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
+std::future<HttpResponse> HTTPClient::post_json_async(const std::string& https_url,
+                                                      const std::string& json_body,
+                                                      const std::map<std::string, std::string>& headers,
+                                                      const std::map<std::string, std::string>& query)
+{
+    auto h = headers;
+    if (!h.count("Content-Type")) h["Content-Type"] = "application/json";
+    return post_async(https_url, json_body, "application/json", h, query);
+}
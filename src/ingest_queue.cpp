@@ -12,17 +12,42 @@ std::size_t IngestQueue::next_pow2(std::size_t n) noexcept {
     return n + 1;
 }
 
-IngestQueue::IngestQueue(std::size_t capacity)
-    : buf_(next_pow2(capacity)), mask_(buf_.size() - 1) {
+IngestQueue::IngestQueue(std::size_t capacity, bool allow_evict)
+    : buf_(next_pow2(capacity)), stamps_(buf_.size()), mask_(buf_.size() - 1), evictable_(allow_evict),
+      seq_(new std::atomic<std::size_t>[buf_.size()]) {
     assert(is_power_of_two(buf_.size()));
+    for (std::size_t i = 0; i < buf_.size(); ++i) seq_[i].store(i, std::memory_order_relaxed);
+}
+
+void IngestQueue::publish(std::size_t head) noexcept {
+    seq_[head & mask_].store(head + 1, std::memory_order_release);
+    head_.store(head + 1, std::memory_order_release);
+}
+
+// Consumer: find the oldest published frame and own its slot until release_pop
+bool IngestQueue::claim_pop(std::size_t& tail) noexcept {
+    for (;;) {
+        tail = tail_.load(std::memory_order_acquire);
+        if (seq_[tail & mask_].load(std::memory_order_acquire) != tail + 1) {
+            // empty, unless an evicting push moved tail_ between the two loads
+            if (!evictable_ || tail_.load(std::memory_order_acquire) == tail) return false;
+            continue;
+        }
+        if (!evictable_) return true;
+        if (tail_.compare_exchange_weak(tail, tail + 1, std::memory_order_acq_rel, std::memory_order_relaxed)) return true;
+    }
+}
+
+void IngestQueue::release_pop(std::size_t tail) noexcept {
+    seq_[tail & mask_].store(tail + capacity(), std::memory_order_release);
+    if (!evictable_) tail_.store(tail + 1, std::memory_order_release);
 }
 
 bool IngestQueue::try_push(std::string&& msg) {
     const std::size_t head = head_.load(std::memory_order_relaxed);
-    const std::size_t tail = tail_.load(std::memory_order_acquire);
-    if (head - tail == capacity()) return false; // full
+    if (seq_[head & mask_].load(std::memory_order_acquire) != head) return false; // full
     buf_[head & mask_] = std::move(msg);
-    head_.store(head + 1, std::memory_order_release);
+    publish(head);
     return true;
 }
 
@@ -31,12 +56,73 @@ bool IngestQueue::try_push(const std::string& msg) {
     return try_push(std::move(tmp));
 }
 
+bool IngestQueue::try_push_view(std::string_view msg) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (seq_[head & mask_].load(std::memory_order_acquire) != head) return false; // full
+    buf_[head & mask_].assign(msg.data(), msg.size());
+    publish(head);
+    return true;
+}
+
+bool IngestQueue::try_push_view(std::string_view msg, std::int64_t stamp) {
+    return try_push_view(msg, Stamp{stamp, 0, 0});
+}
+
+bool IngestQueue::try_push_view(std::string_view msg, const Stamp& stamp) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (seq_[head & mask_].load(std::memory_order_acquire) != head) return false; // full
+    buf_[head & mask_].assign(msg.data(), msg.size());
+    stamps_[head & mask_] = stamp;
+    publish(head);
+    return true;
+}
+
+IngestQueue::PushResult IngestQueue::try_push_view_evict(std::string_view msg, const Stamp& stamp) {
+    assert(evictable_);
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    const std::atomic<std::size_t>& slot = seq_[head & mask_];
+    PushResult res = PushResult::Pushed;
+    if (slot.load(std::memory_order_acquire) != head) {
+        // Full: the slot holds the oldest frame (head - capacity). Take it back by
+        // advancing tail_ ourselves, unless the consumer has already claimed it.
+        std::size_t oldest = head - capacity();
+        if (tail_.compare_exchange_strong(oldest, oldest + 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            res = PushResult::Evicted;
+        } else {
+            // claimed: the consumer is swapping it out right now; give it a moment
+            int spins = 0;
+            while (slot.load(std::memory_order_acquire) != head) {
+                if (++spins == 64) return PushResult::Full;
+            }
+        }
+    }
+    buf_[head & mask_].assign(msg.data(), msg.size());
+    stamps_[head & mask_] = stamp;
+    publish(head);
+    return res;
+}
+
+bool IngestQueue::try_pop(std::string& out, std::int64_t& stamp) {
+    Stamp s;
+    if (!try_pop(out, s)) return false;
+    stamp = s.arrival_ns;
+    return true;
+}
+
+bool IngestQueue::try_pop(std::string& out, Stamp& stamp) {
+    std::size_t tail;
+    if (!claim_pop(tail)) return false; // empty
+    out.swap(buf_[tail & mask_]);
+    stamp = stamps_[tail & mask_];
+    release_pop(tail);
+    return true;
+}
+
 bool IngestQueue::try_pop(std::string& out) {
-    const std::size_t tail = tail_.load(std::memory_order_relaxed);
-    const std::size_t head = head_.load(std::memory_order_acquire);
-    if (head == tail) return false; // empty
-    out = std::move(buf_[tail & mask_]);
-    tail_.store(tail + 1, std::memory_order_release);
+    std::size_t tail;
+    if (!claim_pop(tail)) return false; // empty
+    out.swap(buf_[tail & mask_]);
+    release_pop(tail);
     return true;
 }
 
@@ -58,6 +144,9 @@ void IngestQueue::clear() noexcept {
     // Only call when producer/consumer paused.
     head_.store(0, std::memory_order_relaxed);
     tail_.store(0, std::memory_order_relaxed);
-    for (auto& s : buf_) s.clear();
+    for (std::size_t i = 0; i < buf_.size(); ++i) {
+        buf_[i].clear();
+        seq_[i].store(i, std::memory_order_relaxed);
+    }
 }
 
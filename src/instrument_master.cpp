@@ -0,0 +1,556 @@
+// src/instrument_master.cpp
+#include "instrument_master.h"
+#include "http_client.h"
+#include "json_stream.h"
+#include "logger.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+// ---- image layout (also the cache file) ----
+//   Header | Record[count] | strings | token index | symbol index
+// Index slots are uint32 record number + 1 (0 = empty), linear probing.
+constexpr char kMagic[8] = {'A', 'L', 'P', 'H', 'A', 'I', 'M', '1'};
+constexpr std::uint32_t kVersion = 1;
+
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t count;
+    char date[16];                 // NUL padded
+    std::uint64_t records_off;
+    std::uint64_t strings_off;
+    std::uint64_t strings_size;
+    std::uint64_t token_index_off;
+    std::uint64_t symbol_index_off;
+    std::uint32_t index_slots;     // power of two, both tables
+    std::uint32_t reserved;
+    std::uint64_t total_size;
+};
+
+enum Field { kToken, kSymbol, kName, kExchange, kType, kExpiry, kFields };
+
+struct Record {
+    std::uint32_t off[kFields];    // into the string blob
+    std::uint16_t len[kFields];
+    std::int32_t lot_size;
+    double strike;
+    double tick_size;
+};
+static_assert(sizeof(Record) == 56);
+
+std::uint64_t align8(std::uint64_t n) { return (n + 7) & ~std::uint64_t{7}; }
+
+// FNV-1a of "<exchange>|<key>"; fixed, since the tables are persisted
+std::uint64_t key_hash(std::string_view exchange, std::string_view key) {
+    std::uint64_t h = 14695981039346656037ULL;
+    const auto mix = [&h](std::string_view s) {
+        for (unsigned char c : s) {
+            h ^= c;
+            h *= 1099511628211ULL;
+        }
+    };
+    mix(exchange);
+    mix("|");
+    mix(key);
+    return h;
+}
+
+Header read_header(const char* base) {
+    Header h;
+    std::memcpy(&h, base, sizeof(h));
+    return h;
+}
+
+Record read_record(const char* base, const Header& h, std::size_t i) {
+    Record r;
+    std::memcpy(&r, base + h.records_off + i * sizeof(Record), sizeof(r));
+    return r;
+}
+
+std::uint32_t read_slot(const char* base, std::uint64_t table_off, std::size_t i) {
+    std::uint32_t v;
+    std::memcpy(&v, base + table_off + i * sizeof(v), sizeof(v));
+    return v;
+}
+
+std::string_view field(const char* base, const Header& h, const Record& r, Field f) {
+    return {base + h.strings_off + r.off[f], r.len[f]};
+}
+
+// Builds an image from parsed records
+class ImageBuilder {
+public:
+    struct Fields {
+        std::string str[kFields];
+        double strike = -1;
+        double tick_size = 0;
+        std::int32_t lot_size = 0;
+    };
+
+    void add(const Fields& f) {
+        Record r{};
+        for (int i = 0; i < kFields; ++i) {
+            const std::string& s = f.str[i];
+            // token and symbol are unique; the rest repeat a lot
+            const bool intern = i != kToken && i != kSymbol;
+            r.off[i] = intern ? interned(s) : append(s);
+            r.len[i] = static_cast<std::uint16_t>(std::min<std::size_t>(s.size(), 0xFFFF));
+        }
+        r.lot_size = f.lot_size;
+        r.strike = f.strike;
+        r.tick_size = f.tick_size;
+        records_.push_back(r);
+    }
+
+    std::size_t size() const noexcept { return records_.size(); }
+
+    std::vector<char> finish(const std::string& date) {
+        Header h{};
+        std::memcpy(h.magic, kMagic, sizeof(kMagic));
+        h.version = kVersion;
+        h.count = static_cast<std::uint32_t>(records_.size());
+        std::memcpy(h.date, date.data(), std::min(date.size(), sizeof(h.date) - 1));
+        std::uint32_t slots = 16;
+        while (slots < 2 * records_.size()) slots <<= 1;
+        h.index_slots = slots;
+        h.records_off = align8(sizeof(Header));
+        h.strings_off = h.records_off + records_.size() * sizeof(Record);
+        h.strings_size = strings_.size();
+        h.token_index_off = align8(h.strings_off + h.strings_size);
+        h.symbol_index_off = h.token_index_off + std::uint64_t{slots} * 4;
+        h.total_size = h.symbol_index_off + std::uint64_t{slots} * 4;
+
+        std::vector<char> img(h.total_size, 0);
+        std::memcpy(img.data(), &h, sizeof(h));
+        if (!records_.empty()) std::memcpy(img.data() + h.records_off, records_.data(), records_.size() * sizeof(Record));
+        if (!strings_.empty()) std::memcpy(img.data() + h.strings_off, strings_.data(), strings_.size());
+        index(img, h, h.token_index_off, kToken);
+        index(img, h, h.symbol_index_off, kSymbol);
+        return img;
+    }
+
+private:
+    std::uint32_t append(const std::string& s) {
+        const auto off = static_cast<std::uint32_t>(strings_.size());
+        strings_.append(s, 0, std::min<std::size_t>(s.size(), 0xFFFF));
+        return off;
+    }
+
+    std::uint32_t interned(const std::string& s) {
+        auto it = interned_.find(s);
+        if (it != interned_.end()) return it->second;
+        const std::uint32_t off = append(s);
+        interned_.emplace(s, off);
+        return off;
+    }
+
+    // Entries already present (same exchange and key) keep the first record
+    void index(std::vector<char>& img, const Header& h, std::uint64_t table_off, Field key) {
+        const std::size_t mask = h.index_slots - 1;
+        const char* base = img.data();
+        for (std::size_t r = 0; r < records_.size(); ++r) {
+            const std::string_view exch = field(base, h, records_[r], kExchange);
+            const std::string_view k = field(base, h, records_[r], key);
+            for (std::size_t i = key_hash(exch, k) & mask;; i = (i + 1) & mask) {
+                const std::uint32_t slot = read_slot(base, table_off, i);
+                if (slot == 0) {
+                    const auto v = static_cast<std::uint32_t>(r + 1);
+                    std::memcpy(img.data() + table_off + i * 4, &v, 4);
+                    break;
+                }
+                const Record& o = records_[slot - 1];
+                if (field(base, h, o, kExchange) == exch && field(base, h, o, key) == k) break;
+            }
+        }
+    }
+
+    std::vector<Record> records_;
+    std::string strings_;
+    std::unordered_map<std::string, std::uint32_t> interned_;
+};
+
+// Scrip master records from SAX events: the objects directly inside the top-level
+// array; fields are strings ("lotsize":"1") but numbers are accepted too
+class MasterHandler : public JsonSaxHandler {
+public:
+    explicit MasterHandler(ImageBuilder& b) : b_(b) {}
+
+    std::size_t skipped = 0;       // records without token or exchange
+
+    bool start_object() override {
+        if (++depth_ == 2) {
+            f_ = {};
+            target_ = Target::None;
+        }
+        return true;
+    }
+    bool end_object() override {
+        if (depth_-- == 2) {
+            if (f_.str[kToken].empty() || f_.str[kExchange].empty()) ++skipped;
+            else b_.add(f_);
+        }
+        return true;
+    }
+    bool start_array() override { ++depth_; return true; }
+    bool end_array() override { --depth_; return true; }
+
+    bool key(std::string_view k) override {
+        target_ = Target::None;
+        if (depth_ != 2) return true;
+        if (k == "token") target_ = Target::Token;
+        else if (k == "symbol") target_ = Target::Symbol;
+        else if (k == "name") target_ = Target::Name;
+        else if (k == "exch_seg") target_ = Target::Exchange;
+        else if (k == "instrumenttype") target_ = Target::Type;
+        else if (k == "expiry") target_ = Target::Expiry;
+        else if (k == "strike") target_ = Target::Strike;
+        else if (k == "lotsize") target_ = Target::Lot;
+        else if (k == "tick_size") target_ = Target::Tick;
+        return true;
+    }
+
+    bool string(std::string_view s) override {
+        switch (target_) {
+        case Target::None: break;
+        case Target::Strike: f_.strike = to_double(s); break;
+        case Target::Tick: f_.tick_size = to_double(s); break;
+        case Target::Lot: f_.lot_size = static_cast<std::int32_t>(to_double(s)); break;
+        default: f_.str[static_cast<int>(target_)].assign(s); break;
+        }
+        target_ = Target::None;
+        return true;
+    }
+    bool number_unsigned(std::uint64_t v) override { return number(static_cast<double>(v)); }
+    bool number_integer(std::int64_t v) override { return number(static_cast<double>(v)); }
+    bool number_float(double v, std::string_view) override { return number(v); }
+
+private:
+    // Field order matches the Field enum for the string ones
+    enum class Target { Token, Symbol, Name, Exchange, Type, Expiry, Strike, Lot, Tick, None };
+
+    bool number(double v) {
+        switch (target_) {
+        case Target::Strike: f_.strike = v; break;
+        case Target::Tick: f_.tick_size = v; break;
+        case Target::Lot: f_.lot_size = static_cast<std::int32_t>(v); break;
+        case Target::Token: f_.str[kToken] = std::to_string(static_cast<std::uint64_t>(v)); break;
+        default: break;
+        }
+        target_ = Target::None;
+        return true;
+    }
+
+    static double to_double(std::string_view s) {
+        double d = 0;
+        std::from_chars(s.data(), s.data() + s.size(), d);
+        return d;
+    }
+
+    ImageBuilder& b_;
+    ImageBuilder::Fields f_;
+    Target target_ = Target::None;
+    int depth_ = 0;
+};
+
+// The structure of an image of `size` bytes for `date` is sound (every offset in
+// bounds), so lookups need no further checks
+bool validate(const char* base, std::size_t size, const std::string& date, std::string* err) {
+    const auto bad = [err](const char* what) {
+        if (err) *err = what;
+        return false;
+    };
+    if (size < sizeof(Header)) return bad("cache truncated");
+    const Header h = read_header(base);
+    if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) return bad("not an instrument cache");
+    if (h.version != kVersion) return bad("cache format version mismatch");
+    if (std::string_view(h.date, strnlen(h.date, sizeof(h.date))) != date) return bad("cache is for another date");
+    const std::uint64_t slots = h.index_slots;
+    // every offset is checked against size before it takes part in arithmetic, so
+    // nothing below can wrap
+    if (h.total_size != size || h.records_off < sizeof(Header) || h.records_off % 8 != 0
+        || h.strings_off > size || h.token_index_off > size || h.symbol_index_off > size || h.strings_size > size
+        || h.strings_off < h.records_off
+        || h.strings_off - h.records_off != std::uint64_t{h.count} * sizeof(Record)
+        || h.token_index_off < h.strings_off || h.token_index_off - h.strings_off < h.strings_size
+        || h.symbol_index_off < h.token_index_off || h.symbol_index_off - h.token_index_off != slots * 4
+        || size - h.symbol_index_off != slots * 4
+        || slots == 0 || (slots & (slots - 1)) != 0 || slots <= h.count)
+        return bad("cache layout corrupt");
+    for (std::size_t i = 0; i < h.count; ++i) {
+        const Record r = read_record(base, h, i);
+        for (int f = 0; f < kFields; ++f) {
+            if (std::uint64_t{r.off[f]} + r.len[f] > h.strings_size) return bad("cache record corrupt");
+        }
+    }
+    // probe() stops at an empty slot, so each table needs at least one
+    for (const std::uint64_t table : {h.token_index_off, h.symbol_index_off}) {
+        bool has_empty = false;
+        for (std::size_t i = 0; i < slots; ++i) {
+            const std::uint32_t slot = read_slot(base, table, i);
+            if (slot > h.count) return bad("cache index corrupt");
+            has_empty = has_empty || slot == 0;
+        }
+        if (!has_empty) return bad("cache index corrupt");
+    }
+    return true;
+}
+
+std::string today() {
+    const std::time_t t = std::time(nullptr);
+    std::tm tm{};
+    localtime_r(&t, &tm);
+    char buf[16];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
+    return buf;
+}
+
+double ms_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace
+
+InstrumentMaster::InstrumentMaster(Logger& log) : log_(log) {}
+
+InstrumentMaster::~InstrumentMaster() { unmap(); }
+
+void InstrumentMaster::unmap() noexcept {
+    if (map_) ::munmap(map_, map_size_);
+    map_ = nullptr;
+    map_size_ = 0;
+}
+
+void InstrumentMaster::adopt(std::vector<char> image, const std::string& date) {
+    unmap();
+    owned_ = std::move(image);
+    base_ = owned_.data();
+    date_ = date;
+    stats_.instruments = size();
+    stats_.image_bytes = owned_.size();
+    stats_.from_cache = false;
+}
+
+std::string InstrumentMaster::cache_path(const std::string& cache_dir, const std::string& date) {
+    return (std::filesystem::path(cache_dir) / ("instruments-" + date + ".bin")).string();
+}
+
+bool InstrumentMaster::parse_json(std::istream& in, const std::string& date, std::string* err) {
+    const auto t0 = std::chrono::steady_clock::now();
+    ImageBuilder b;
+    MasterHandler h(b);
+    JsonStreamParser p(h);
+    std::vector<char> buf(64 * 1024);
+    while (in) {
+        in.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+        if (in.gcount() > 0 && !p.feed(std::string_view(buf.data(), static_cast<std::size_t>(in.gcount())))) break;
+    }
+    if (!p.finish()) {
+        if (err) *err = "scrip master: " + p.error();
+        return false;
+    }
+    adopt(b.finish(date), date);
+    stats_.load_ms = ms_since(t0);
+    return true;
+}
+
+bool InstrumentMaster::fetch(HTTPClient& http, const std::string& url, const std::string& date, std::string* err) {
+    const auto t0 = std::chrono::steady_clock::now();
+    ImageBuilder b;
+    MasterHandler h(b);
+    JsonStreamParser p(h);
+    HttpResponse res;
+    try {
+        res = http.get_stream(url, [&p](std::string_view chunk) { return p.feed(chunk); });
+    } catch (const std::exception& e) {
+        if (err) *err = std::string("scrip master download: ") + e.what();
+        return false;
+    }
+    if (res.status != 200) {
+        if (err) *err = "scrip master download: HTTP " + std::to_string(res.status);
+        return false;
+    }
+    if (!p.finish()) {
+        if (err) *err = "scrip master: " + p.error();
+        return false;
+    }
+    adopt(b.finish(date), date);
+    stats_.load_ms = ms_since(t0);
+    log_.info_fmt("[instruments] {} instruments downloaded ({} skipped) in {}ms", size(), h.skipped,
+                  static_cast<long>(stats_.load_ms));
+    return true;
+}
+
+bool InstrumentMaster::save_cache(const std::string& path, std::string* err) const {
+    if (!base_) {
+        if (err) *err = "nothing loaded";
+        return false;
+    }
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(base_, static_cast<std::streamsize>(read_header(base_).total_size));
+        if (!out.flush()) {
+            if (err) *err = "cannot write " + tmp;
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        if (err) *err = "cannot rename " + tmp + ": " + std::strerror(errno);
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool InstrumentMaster::load_cache(const std::string& path, const std::string& date, std::string* err) {
+    const auto t0 = std::chrono::steady_clock::now();
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (err) *err = "no cache " + path;
+        return false;
+    }
+    struct stat st{};
+    void* m = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0)
+        m = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) {
+        if (err) *err = "cannot map " + path;
+        return false;
+    }
+    const std::size_t n = static_cast<std::size_t>(st.st_size);
+    if (!validate(static_cast<const char*>(m), n, date, err)) {
+        ::munmap(m, n);
+        return false;
+    }
+    unmap();
+    owned_.clear();
+    owned_.shrink_to_fit();
+    map_ = m;
+    map_size_ = n;
+    base_ = static_cast<const char*>(m);
+    date_ = date;
+    stats_.instruments = size();
+    stats_.image_bytes = n;
+    stats_.from_cache = true;
+    stats_.load_ms = ms_since(t0);
+    return true;
+}
+
+bool InstrumentMaster::load(HTTPClient& http, const LoadOptions& opts, std::string* err) {
+    const std::string date = opts.date.empty() ? today() : opts.date;
+    const std::string path = opts.cache_dir.empty() ? std::string() : cache_path(opts.cache_dir, date);
+    std::string why;
+    if (!path.empty()) {
+        if (load_cache(path, date, &why)) {
+            log_.info_fmt("[instruments] {} instruments from {} in {}us", size(), path,
+                          static_cast<long>(stats_.load_ms * 1000));
+            return true;
+        }
+        log_.info_fmt("[instruments] cache miss ({}), downloading", why);
+    }
+    if (!fetch(http, opts.url, date, err)) return false;
+    if (!path.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(opts.cache_dir, ec);
+        if (!save_cache(path, &why)) log_.warn_fmt("[instruments] cache not written: {}", why);
+    }
+    return true;
+}
+
+std::size_t InstrumentMaster::size() const noexcept {
+    return base_ ? read_header(base_).count : 0;
+}
+
+Instrument InstrumentMaster::at(std::size_t i) const {
+    if (i >= size()) {
+        throw std::out_of_range("InstrumentMaster::at: index " + std::to_string(i) + " >= " + std::to_string(size()));
+    }
+    const Header h = read_header(base_);
+    const Record r = read_record(base_, h, i);
+    Instrument ins;
+    ins.token = field(base_, h, r, kToken);
+    ins.symbol = field(base_, h, r, kSymbol);
+    ins.name = field(base_, h, r, kName);
+    ins.exchange = field(base_, h, r, kExchange);
+    ins.instrument_type = field(base_, h, r, kType);
+    ins.expiry = field(base_, h, r, kExpiry);
+    ins.strike = r.strike;
+    ins.tick_size = r.tick_size;
+    ins.lot_size = r.lot_size;
+    return ins;
+}
+
+namespace {
+
+std::optional<std::size_t> probe(const char* base, std::uint64_t table_off, Field key,
+                                 std::string_view exchange, std::string_view k) {
+    if (!base) return std::nullopt;
+    const Header h = read_header(base);
+    const std::size_t mask = h.index_slots - 1;
+    for (std::size_t i = key_hash(exchange, k) & mask;; i = (i + 1) & mask) {
+        const std::uint32_t slot = read_slot(base, table_off, i);
+        if (slot == 0) return std::nullopt;
+        const Record r = read_record(base, h, slot - 1);
+        if (field(base, h, r, key) == k && field(base, h, r, kExchange) == exchange) return slot - 1;
+    }
+}
+
+} // namespace
+
+std::optional<Instrument> InstrumentMaster::by_token(std::string_view exchange, std::string_view token) const {
+    if (!base_) return std::nullopt;
+    const auto i = probe(base_, read_header(base_).token_index_off, kToken, exchange, token);
+    if (!i) return std::nullopt;
+    return at(*i);
+}
+
+std::optional<Instrument> InstrumentMaster::by_symbol(std::string_view exchange, std::string_view symbol) const {
+    if (!base_) return std::nullopt;
+    const auto i = probe(base_, read_header(base_).symbol_index_off, kSymbol, exchange, symbol);
+    if (!i) return std::nullopt;
+    return at(*i);
+}
+
+std::optional<Instrument> InstrumentMaster::find(std::string_view spec) const {
+    const auto colon = spec.find(':');
+    if (colon == std::string_view::npos) return by_symbol("NSE", spec);
+    return by_symbol(spec.substr(0, colon), spec.substr(colon + 1));
+}
+
+std::string_view InstrumentMaster::feed_segment(std::string_view exchange) {
+    if (exchange == "NSE") return "nse_cm";
+    if (exchange == "NFO") return "nse_fo";
+    if (exchange == "BSE") return "bse_cm";
+    if (exchange == "BFO") return "bse_fo";
+    if (exchange == "MCX") return "mcx_fo";
+    if (exchange == "CDS") return "cde_fo";
+    if (exchange == "NCDEX") return "ncx_fo";
+    return {};
+}
+
+std::string InstrumentMaster::feed_key(const Instrument& ins) {
+    const std::string_view seg = feed_segment(ins.exchange);
+    if (seg.empty()) return std::string(ins.token);
+    std::string key(seg);
+    key += '|';
+    key += ins.token;
+    return key;
+}
@@ -0,0 +1,351 @@
+// src/json_stream.cpp
+#include "json_stream.h"
+
+#include <charconv>
+#include <limits>
+
+namespace {
+
+bool is_ws(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+bool is_number_char(char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+bool valid_number(std::string_view s, bool& integral) {
+    std::size_t i = 0;
+    const auto digits = [&] {
+        const std::size_t from = i;
+        while (i < s.size() && s[i] >= '0' && s[i] <= '9') ++i;
+        return i > from;
+    };
+    if (i < s.size() && s[i] == '-') ++i;
+    if (i < s.size() && s[i] == '0') ++i;
+    else if (!digits()) return false;
+    integral = true;
+    if (i < s.size() && s[i] == '.') {
+        ++i;
+        integral = false;
+        if (!digits()) return false;
+    }
+    if (i < s.size() && (s[i] == 'e' || s[i] == 'E')) {
+        ++i;
+        integral = false;
+        if (i < s.size() && (s[i] == '+' || s[i] == '-')) ++i;
+        if (!digits()) return false;
+    }
+    return i == s.size();
+}
+
+} // namespace
+
+JsonStreamParser::JsonStreamParser(JsonSaxHandler& handler) : JsonStreamParser(handler, Options{}) {}
+
+JsonStreamParser::JsonStreamParser(JsonSaxHandler& handler, Options opts) : h_(handler), opts_(opts) {}
+
+void JsonStreamParser::reset() {
+    expect_ = Expect::Value;
+    tok_ = Token::None;
+    stack_.clear();
+    buf_.clear();
+    esc_ = 0;
+    high_ = 0;
+    lit_ = nullptr;
+    offset_ = 0;
+    values_ = 0;
+    error_.clear();
+}
+
+bool JsonStreamParser::fail(const char* what) {
+    if (error_.empty()) error_ = std::string(what) + " at byte " + std::to_string(offset_);
+    return false;
+}
+
+bool JsonStreamParser::feed(std::string_view chunk) {
+    if (failed()) return false;
+    const char* p = chunk.data();
+    const char* const end = p + chunk.size();
+    while (p < end) {
+        switch (tok_) {
+        case Token::String:
+            p = scan_string(p, end);
+            if (failed()) return false;
+            break;
+        case Token::Number:
+            if (is_number_char(*p)) {
+                buf_ += *p++;
+                ++offset_;
+                if (buf_.size() > opts_.max_token) return fail("number too long");
+            } else if (!end_number()) {
+                return false;          // the terminating character is handled next round
+            }
+            break;
+        case Token::Literal:
+            if (*p != lit_[lit_pos_]) return fail("invalid literal");
+            ++p;
+            ++offset_;
+            if (lit_[++lit_pos_] == '\0') {
+                tok_ = Token::None;
+                bool ok;
+                if (lit_[0] == 'n') ok = h_.null();
+                else ok = h_.boolean(lit_[0] == 't');
+                if (!stopped(ok)) return false;
+                value_done();
+            }
+            break;
+        case Token::None:
+            if (!structural(*p)) return false;
+            ++p;
+            ++offset_;
+            break;
+        }
+    }
+    return true;
+}
+
+bool JsonStreamParser::finish() {
+    if (failed()) return false;
+    if (tok_ == Token::Number && !end_number()) return false;
+    if (tok_ != Token::None) return fail("unexpected end of input");
+    if (expect_ == Expect::Done) return true;
+    if (opts_.multiple_values && expect_ == Expect::Value && stack_.empty()) return true;
+    return fail(values_ == 0 && stack_.empty() ? "empty input" : "unexpected end of input");
+}
+
+bool JsonStreamParser::structural(char c) {
+    if (is_ws(c)) return true;
+    switch (expect_) {
+    case Expect::Value:
+        return begin_value(c);
+    case Expect::ValueOrEnd:
+        if (c == ']') return close(c);
+        return begin_value(c);
+    case Expect::KeyOrEnd:
+        if (c == '}') return close(c);
+        [[fallthrough]];
+    case Expect::Key:
+        if (c != '"') return fail("expected object key");
+        tok_ = Token::String;
+        key_ = true;
+        buf_.clear();
+        return true;
+    case Expect::Colon:
+        if (c != ':') return fail("expected ':'");
+        expect_ = Expect::Value;
+        return true;
+    case Expect::CommaOrEnd:
+        if (c == ',') {
+            expect_ = stack_.back() == '{' ? Expect::Key : Expect::Value;
+            return true;
+        }
+        if (c == '}' || c == ']') return close(c);
+        return fail("expected ',' or end of container");
+    case Expect::Done:
+        if (!opts_.multiple_values) return fail("trailing characters");
+        return begin_value(c);
+    }
+    return fail("internal error");
+}
+
+bool JsonStreamParser::begin_value(char c) {
+    switch (c) {
+    case '{':
+    case '[':
+        if (stack_.size() >= opts_.max_depth) return fail("nesting too deep");
+        stack_.push_back(c);
+        expect_ = c == '{' ? Expect::KeyOrEnd : Expect::ValueOrEnd;
+        return stopped(c == '{' ? h_.start_object() : h_.start_array());
+    case '"':
+        tok_ = Token::String;
+        key_ = false;
+        buf_.clear();
+        return true;
+    case 't': lit_ = "true"; break;
+    case 'f': lit_ = "false"; break;
+    case 'n': lit_ = "null"; break;
+    default:
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            tok_ = Token::Number;
+            buf_.assign(1, c);
+            return true;
+        }
+        return fail("unexpected character");
+    }
+    tok_ = Token::Literal;
+    lit_pos_ = 1;
+    return true;
+}
+
+bool JsonStreamParser::close(char c) {
+    const char open = c == '}' ? '{' : '[';
+    if (stack_.empty() || stack_.back() != open) return fail("mismatched bracket");
+    stack_.pop_back();
+    if (!stopped(c == '}' ? h_.end_object() : h_.end_array())) return false;
+    value_done();
+    return true;
+}
+
+void JsonStreamParser::value_done() {
+    if (stack_.empty()) {
+        expect_ = Expect::Done;
+        ++values_;
+    } else {
+        expect_ = Expect::CommaOrEnd;
+    }
+}
+
+// Plain runs are appended in one go; escapes go through string_escape()
+const char* JsonStreamParser::scan_string(const char* p, const char* end) {
+    while (p < end) {
+        if (esc_ != 0) {
+            const char c = *p++;
+            ++offset_;
+            if (!string_escape(c)) return p;
+            continue;
+        }
+        const char* run = p;
+        while (p < end && *p != '"' && *p != '\\' && static_cast<unsigned char>(*p) >= 0x20) ++p;
+        if (p != run) {
+            flush_surrogate();
+            buf_.append(run, static_cast<std::size_t>(p - run));
+            offset_ += static_cast<std::uint64_t>(p - run);
+            if (buf_.size() > opts_.max_token) {
+                fail("string too long");
+                return p;
+            }
+        }
+        if (p == end) break;
+        const char c = *p++;
+        ++offset_;
+        if (c == '"') {
+            end_string();
+            return p;
+        }
+        if (c == '\\') {
+            esc_ = 1;
+        } else {
+            fail("control character in string");
+            return p;
+        }
+    }
+    return p;
+}
+
+bool JsonStreamParser::string_escape(char c) {
+    if (esc_ == 1) {
+        if (c == 'u') {
+            esc_ = 2;
+            code_ = 0;
+            return true;
+        }
+        char out;
+        switch (c) {
+        case '"': out = '"'; break;
+        case '\\': out = '\\'; break;
+        case '/': out = '/'; break;
+        case 'b': out = '\b'; break;
+        case 'f': out = '\f'; break;
+        case 'n': out = '\n'; break;
+        case 'r': out = '\r'; break;
+        case 't': out = '\t'; break;
+        default: return fail("invalid escape");
+        }
+        flush_surrogate();
+        buf_ += out;
+        esc_ = 0;
+        return true;
+    }
+    const int v = hex_value(c);
+    if (v < 0) return fail("invalid \\u escape");
+    code_ = (code_ << 4) | static_cast<std::uint32_t>(v);
+    if (++esc_ < 6) return true;
+    esc_ = 0;
+
+    if (high_ != 0) {
+        if (code_ >= 0xDC00 && code_ <= 0xDFFF) {
+            append_code_point(0x10000 + ((high_ - 0xD800) << 10) + (code_ - 0xDC00));
+            high_ = 0;
+            return true;
+        }
+        flush_surrogate();
+    }
+    if (code_ >= 0xD800 && code_ <= 0xDBFF) high_ = code_;
+    else if (code_ >= 0xDC00 && code_ <= 0xDFFF) append_code_point(0xFFFD);   // unpaired low surrogate
+    else append_code_point(code_);
+    return true;
+}
+
+// A high surrogate not followed by a low one is replaced by U+FFFD
+void JsonStreamParser::flush_surrogate() {
+    if (high_ == 0) return;
+    high_ = 0;
+    append_code_point(0xFFFD);
+}
+
+void JsonStreamParser::append_code_point(std::uint32_t cp) {
+    if (cp < 0x80) {
+        buf_ += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        buf_ += static_cast<char>(0xC0 | (cp >> 6));
+        buf_ += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        buf_ += static_cast<char>(0xE0 | (cp >> 12));
+        buf_ += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        buf_ += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        buf_ += static_cast<char>(0xF0 | (cp >> 18));
+        buf_ += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        buf_ += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        buf_ += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+bool JsonStreamParser::end_string() {
+    flush_surrogate();
+    tok_ = Token::None;
+    if (key_) {
+        expect_ = Expect::Colon;
+        return stopped(h_.key(buf_));
+    }
+    if (!stopped(h_.string(buf_))) return false;
+    value_done();
+    return true;
+}
+
+bool JsonStreamParser::end_number() {
+    tok_ = Token::None;
+    bool integral = false;
+    if (!valid_number(buf_, integral)) return fail("invalid number");
+    const char* const first = buf_.data();
+    const char* const last = first + buf_.size();
+    const bool negative = buf_[0] == '-';
+    std::int64_t i = 0;
+    std::uint64_t u = 0;
+    bool ok;
+    if (integral && negative && std::from_chars(first, last, i).ec == std::errc{}) {
+        ok = h_.number_integer(i);
+    } else if (integral && !negative && std::from_chars(first, last, u).ec == std::errc{}) {
+        ok = h_.number_unsigned(u);
+    } else {
+        // fractions, exponents and integers beyond 64 bits
+        double d = 0;
+        if (std::from_chars(first, last, d).ec == std::errc::result_out_of_range) {
+            const auto e = buf_.find_first_of("eE");
+            const bool tiny = e != std::string::npos && e + 1 < buf_.size() && buf_[e + 1] == '-';
+            d = tiny ? 0.0 : std::numeric_limits<double>::infinity();
+            if (negative) d = -d;
+        }
+        ok = h_.number_float(d, buf_);
+    }
+    if (!stopped(ok)) return false;
+    value_done();
+    return true;
+}
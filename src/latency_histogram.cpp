@@ -0,0 +1,92 @@
+// src/latency_histogram.cpp
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+double tsc_ns_per_tick() {
+    static const double ratio = [] {
+#if defined(__x86_64__) || defined(__i386__)
+        const auto c0 = std::chrono::steady_clock::now();
+        const std::uint64_t t0 = tsc_now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        const std::uint64_t t1 = tsc_now();
+        const auto c1 = std::chrono::steady_clock::now();
+        const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(c1 - c0).count());
+        return t1 > t0 ? ns / static_cast<double>(t1 - t0) : 1.0;
+#else
+        return 1.0;
+#endif
+    }();
+    return ratio;
+}
+
+std::uint64_t LatencyHistogram::highest_equivalent(std::size_t i) noexcept {
+    if (i < 2 * kSub) return i;                         // exact below 2^(kSubBits+1)
+    const std::size_t shift = i / kSub - 1;
+    const std::uint64_t m = i % kSub + kSub;
+    return ((m + 1) << shift) - 1;
+}
+
+void LatencyHistogram::merge_from(const LatencyHistogram& o) noexcept {
+    for (std::size_t i = 0; i < kBuckets; ++i) {
+        const std::uint64_t n = o.counts_[i].load(std::memory_order_relaxed);
+        if (n) bump(counts_[i], n);
+    }
+    bump(count_, o.count_.load(std::memory_order_relaxed));
+    const std::uint64_t m = o.max_.load(std::memory_order_relaxed);
+    if (m > max_.load(std::memory_order_relaxed)) max_.store(m, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::reset() noexcept {
+    for (auto& c : counts_) c.store(0, std::memory_order_relaxed);
+    count_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyHistogram::quantile(double q) const noexcept {
+    // Sum the buckets rather than trusting count_: a concurrent writer may be mid-record
+    std::uint64_t total = 0;
+    for (const auto& c : counts_) total += c.load(std::memory_order_relaxed);
+    if (total == 0) return 0;
+    const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(total))));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < kBuckets; ++i) {
+        seen += counts_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) return std::min(highest_equivalent(i), max());
+    }
+    return max();
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary() const {
+    const double k = tsc_ns_per_tick();
+    Summary s;
+    s.count   = count();
+    s.p50_ns  = static_cast<double>(quantile(0.50)) * k;
+    s.p99_ns  = static_cast<double>(quantile(0.99)) * k;
+    s.p999_ns = static_cast<double>(quantile(0.999)) * k;
+    s.max_ns  = static_cast<double>(max()) * k;
+    return s;
+}
+
+const char* stage_name(Stage s) noexcept {
+    switch (s) {
+        case Stage::ReadToEnqueue: return "read_to_enqueue";
+        case Stage::QueueWait:     return "queue_wait";
+        case Stage::Parse:         return "parse";
+        case Stage::Publish:       return "publish";
+        case Stage::Total:         return "total";
+        default:                   return "?";
+    }
+}
+
+void StageHistograms::merge_from(const StageHistograms& o) noexcept {
+    for (std::size_t i = 0; i < kStageCount; ++i) h_[i].merge_from(o.h_[i]);
+}
+
+StageHistograms::Summaries StageHistograms::summaries() const {
+    Summaries out;
+    for (std::size_t i = 0; i < kStageCount; ++i) out[i] = h_[i].summary();
+    return out;
+}
@@ -0,0 +1,328 @@
+// src/local_https_server.cpp
+#include "local_https_server.h"
+#include "logger.h"
+#include "self_signed_cert.h"
+
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/ssl.hpp>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace asio  = boost::asio;
+namespace beast = boost::beast;
+namespace http  = beast::http;
+using tcp = asio::ip::tcp;
+
+namespace {
+
+std::string url_decode(std::string_view s) {
+    std::string out;
+    out.reserve(s.size());
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        if (s[i] == '+') {
+            out += ' ';
+        } else if (s[i] == '%' && i + 2 < s.size() && std::isxdigit(static_cast<unsigned char>(s[i + 1]))
+                   && std::isxdigit(static_cast<unsigned char>(s[i + 2]))) {
+            out += static_cast<char>(std::stoi(std::string(s.substr(i + 1, 2)), nullptr, 16));
+            i += 2;
+        } else {
+            out += s[i];
+        }
+    }
+    return out;
+}
+
+std::map<std::string, std::string> parse_query(std::string_view q) {
+    std::map<std::string, std::string> out;
+    while (!q.empty()) {
+        const auto amp = q.find('&');
+        const std::string_view kv = q.substr(0, amp);
+        if (!kv.empty()) {
+            const auto eq = kv.find('=');
+            out[url_decode(kv.substr(0, eq))] = eq == std::string_view::npos ? std::string() : url_decode(kv.substr(eq + 1));
+        }
+        if (amp == std::string_view::npos) break;
+        q.remove_prefix(amp + 1);
+    }
+    return out;
+}
+
+} // namespace
+
+struct LocalHttpsServer::Impl {
+    struct Session;
+
+    Logger& log;
+    Options opts;
+    std::map<std::pair<std::string, std::string>, Handler> routes;   // (method, path)
+
+    asio::ssl::context ssl_ctx{asio::ssl::context::tls_server};
+    asio::io_context ioc;
+    std::optional<asio::executor_work_guard<asio::io_context::executor_type>> guard;
+    tcp::acceptor acceptor{ioc};
+    std::vector<std::thread> io_threads;
+    std::atomic<bool> running{false};
+    unsigned short bound_port = 0;
+    std::string ca_path;
+    bool own_ca_file = false;
+
+    std::mutex mu;
+    std::vector<std::weak_ptr<Session>> sessions;
+
+    std::atomic<std::uint64_t> n_conns{0}, n_live{0}, n_handshakes{0}, n_resumed{0}, n_requests{0};
+
+    Impl(Logger& l, Options o) : log(l), opts(std::move(o)) {
+        if (opts.threads == 0) opts.threads = 1;
+    }
+
+    // ---- one client connection ----
+    struct Session : std::enable_shared_from_this<Session> {
+        Impl& srv;
+        const std::uint64_t id;
+        beast::ssl_stream<beast::tcp_stream> stream;
+        asio::steady_timer delay;
+        beast::flat_buffer buf;
+        http::request<http::string_body> req;
+        http::response<http::string_body> res;
+        std::size_t served = 0;
+        bool closed = false;
+
+        Session(Impl& s, std::uint64_t n, tcp::socket&& sock)
+            : srv(s), id(n), stream(std::move(sock), s.ssl_ctx), delay(stream.get_executor()) {}
+
+        // Simulated network time, then fn
+        template<typename Fn>
+        void after(std::chrono::microseconds d, Fn fn) {
+            if (d.count() <= 0) return fn();
+            delay.expires_after(d);
+            delay.async_wait([self = shared_from_this(), fn = std::move(fn)](beast::error_code ec) mutable {
+                if (ec || self->closed) return self->close();
+                fn();
+            });
+        }
+
+        void run() {
+            after(2 * srv.opts.rtt, [self = shared_from_this()] {
+                beast::get_lowest_layer(self->stream).expires_after(std::chrono::seconds(10));
+                self->stream.async_handshake(asio::ssl::stream_base::server, [self](beast::error_code ec) {
+                    if (ec) return self->close();
+                    self->srv.n_handshakes.fetch_add(1, std::memory_order_relaxed);
+                    if (SSL_session_reused(self->stream.native_handle())) self->srv.n_resumed.fetch_add(1, std::memory_order_relaxed);
+                    self->do_read();
+                });
+            });
+        }
+
+        void do_read() {
+            req = {};
+            auto& tcp_layer = beast::get_lowest_layer(stream);
+            if (srv.opts.idle_close.count() > 0) tcp_layer.expires_after(srv.opts.idle_close);
+            else tcp_layer.expires_never();
+            http::async_read(stream, buf, req, [self = shared_from_this()](beast::error_code ec, std::size_t) {
+                if (ec) return self->close();            // eof, idle timeout, reset
+                self->on_request();
+            });
+        }
+
+        void on_request() {
+            srv.n_requests.fetch_add(1, std::memory_order_relaxed);
+            ++served;
+            Request r;
+            r.method = std::string(req.method_string());
+            r.target = std::string(req.target());
+            const auto q = r.target.find('?');
+            r.path = r.target.substr(0, q);
+            if (q != std::string::npos) r.query = parse_query(std::string_view(r.target).substr(q + 1));
+            for (const auto& f : req.base()) {
+                std::string name(f.name_string());
+                std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+                r.headers[name] = std::string(f.value());
+            }
+            r.body = std::move(req.body());
+            r.connection = id;
+
+            Response out;
+            auto it = srv.routes.find({r.method, r.path});
+            if (it == srv.routes.end()) {
+                out.status = 404;
+                out.body = R"({"message":"not found"})";
+            } else {
+                out = it->second(r);
+            }
+            if (out.drop) return close();
+            const std::size_t max = srv.opts.max_requests_per_connection;
+            const bool keep = req.keep_alive() && !out.close && (max == 0 || served < max);
+
+            res = {};
+            res.version(11);
+            res.result(static_cast<unsigned>(out.status));
+            res.set(http::field::server, "alpha-local-https");
+            res.set(http::field::content_type, out.content_type);
+            for (const auto& [k, v] : out.headers) res.set(k, v);
+            res.body() = std::move(out.body);
+            res.keep_alive(keep);
+            res.prepare_payload();
+
+            after(srv.opts.rtt, [self = shared_from_this(), keep] {
+                beast::get_lowest_layer(self->stream).expires_after(std::chrono::seconds(10));
+                http::async_write(self->stream, self->res, [self, keep](beast::error_code ec, std::size_t) {
+                    if (ec) return self->close();
+                    if (keep) return self->do_read();
+                    self->stream.async_shutdown([self](beast::error_code) { self->close(); });
+                });
+            });
+        }
+
+        void kill() {
+            asio::post(stream.get_executor(), [self = shared_from_this()] {
+                beast::error_code ec;
+                beast::get_lowest_layer(self->stream).socket().close(ec);
+                self->delay.cancel();
+                self->close();
+            });
+        }
+
+        void close() {
+            if (closed) return;
+            closed = true;
+            beast::error_code ec;
+            beast::get_lowest_layer(stream).socket().close(ec);
+            srv.n_live.fetch_sub(1, std::memory_order_relaxed);
+        }
+    };
+
+    void do_accept() {
+        acceptor.async_accept(asio::make_strand(ioc), [this](beast::error_code ec, tcp::socket sock) {
+            if (ec) return;                       // acceptor closed
+            sock.set_option(tcp::no_delay(true), ec);
+            auto s = std::make_shared<Session>(*this, n_conns.fetch_add(1, std::memory_order_relaxed) + 1, std::move(sock));
+            n_live.fetch_add(1, std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lk(mu);
+                sessions.erase(std::remove_if(sessions.begin(), sessions.end(),
+                                              [](const std::weak_ptr<Session>& w) { return w.expired(); }),
+                               sessions.end());
+                sessions.push_back(s);
+            }
+            asio::dispatch(s->stream.get_executor(), [s] { s->run(); });
+            do_accept();
+        });
+    }
+
+    template <class Fn>
+    void for_each_session(Fn fn) {
+        std::vector<std::shared_ptr<Session>> live;
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            for (auto& w : sessions) if (auto s = w.lock()) live.push_back(std::move(s));
+        }
+        for (auto& s : live) fn(*s);
+    }
+};
+
+LocalHttpsServer::LocalHttpsServer(Logger& log, Options opts)
+    : impl_(new Impl(log, std::move(opts))) {}
+
+LocalHttpsServer::~LocalHttpsServer() {
+    stop();
+    if (impl_->own_ca_file && !impl_->ca_path.empty()) ::unlink(impl_->ca_path.c_str());
+    delete impl_;
+}
+
+void LocalHttpsServer::route(const std::string& method, const std::string& path, Handler h) {
+    impl_->routes[{method, path}] = std::move(h);
+}
+
+bool LocalHttpsServer::start() {
+    auto& im = *impl_;
+    if (im.running.load()) return true;
+    try {
+        if (!im.opts.cert_file.empty()) {
+            im.ssl_ctx.use_certificate_chain_file(im.opts.cert_file);
+            im.ssl_ctx.use_private_key_file(im.opts.key_file, asio::ssl::context::pem);
+            im.ca_path = im.opts.cert_file;
+        } else {
+            std::string cert, key;
+            if (!make_self_signed_cert(cert, key)) {
+                im.log.error("[https] self-signed certificate generation failed");
+                return false;
+            }
+            im.ssl_ctx.use_certificate_chain(asio::buffer(cert));
+            im.ssl_ctx.use_private_key(asio::buffer(key), asio::ssl::context::pem);
+            im.ca_path = write_temp_pem(cert, "alpha-https-");
+            if (im.ca_path.empty()) {
+                im.log.error("[https] cannot write CA file");
+                return false;
+            }
+            im.own_ca_file = true;
+        }
+        // server-side session cache (TLS 1.2) and tickets (TLS 1.3) are on by default
+        static const unsigned char sid_ctx[] = "alpha-local-https";
+        SSL_CTX_set_session_id_context(im.ssl_ctx.native_handle(), sid_ctx, sizeof(sid_ctx) - 1);
+
+        const tcp::endpoint ep(asio::ip::make_address(im.opts.address), im.opts.port);
+        im.acceptor.open(ep.protocol());
+        im.acceptor.set_option(asio::socket_base::reuse_address(true));
+        im.acceptor.bind(ep);
+        im.acceptor.listen(asio::socket_base::max_listen_connections);
+        im.bound_port = im.acceptor.local_endpoint().port();
+    } catch (const std::exception& e) {
+        im.log.error_fmt("[https] start failed: {}", e.what());
+        return false;
+    }
+
+    im.running.store(true);
+    im.guard.emplace(asio::make_work_guard(im.ioc));
+    im.do_accept();
+    for (std::size_t i = 0; i < im.opts.threads; ++i) im.io_threads.emplace_back([&im] { im.ioc.run(); });
+    im.log.info_fmt("[https] listening on {}", url());
+    return true;
+}
+
+void LocalHttpsServer::stop() {
+    auto& im = *impl_;
+    if (!im.running.exchange(false)) return;
+    asio::post(im.ioc, [&im] { beast::error_code ec; im.acceptor.close(ec); });
+    im.for_each_session([](Impl::Session& s) { s.kill(); });
+    im.guard.reset();
+    for (int i = 0; i < 200 && im.n_live.load() > 0; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    im.ioc.stop();
+    for (auto& t : im.io_threads) if (t.joinable()) t.join();
+    im.io_threads.clear();
+    beast::error_code ec;
+    im.acceptor.close(ec);             // if ioc.stop() beat the posted close
+    std::lock_guard<std::mutex> lk(im.mu);
+    im.sessions.clear();
+}
+
+unsigned short LocalHttpsServer::port() const noexcept { return impl_->bound_port; }
+
+std::string LocalHttpsServer::url() const {
+    return "https://" + impl_->opts.address + ":" + std::to_string(impl_->bound_port);
+}
+
+const std::string& LocalHttpsServer::cert_file() const noexcept { return impl_->ca_path; }
+
+void LocalHttpsServer::drop_all() {
+    impl_->for_each_session([](Impl::Session& s) { s.kill(); });
+}
+
+LocalHttpsServer::Stats LocalHttpsServer::stats() const {
+    Stats st;
+    st.connections      = impl_->n_conns.load(std::memory_order_relaxed);
+    st.live_connections = impl_->n_live.load(std::memory_order_relaxed);
+    st.handshakes       = impl_->n_handshakes.load(std::memory_order_relaxed);
+    st.resumed          = impl_->n_resumed.load(std::memory_order_relaxed);
+    st.requests         = impl_->n_requests.load(std::memory_order_relaxed);
+    return st;
+}
@@ -1,10 +1,125 @@
 #include "logger.h"
+#include "latency_histogram.h"
+#include "thread_log_ring.h"
+#include <algorithm>
 #include <chrono>
-#include <iomanip>
+#include <cstring>
 #include <mutex>
-#include <sstream>
 #include <iostream>
 #include <ctime>
+#include <vector>
+
+namespace {
+
+using logring::level_name;
+using logring::wall_ns;
+
+// "YYYY-mm-dd HH:MM:SS" is rebuilt once per second, not per line
+struct TimeCache {
+    std::int64_t sec = -1;
+    char text[32] = {};
+    std::size_t len = 0;
+};
+
+// <date> <time>.<ms> [LEVEL] name: payload\n
+void append_line(std::string& out, TimeCache& tc, std::int64_t ts_ns, LogLevel lvl,
+                 const std::string& name, const char* payload, std::size_t n) {
+    const std::int64_t sec = ts_ns / 1000000000;
+    if (sec != tc.sec) {
+        const std::time_t t = static_cast<std::time_t>(sec);
+        std::tm tm;
+        localtime_r(&t, &tm);
+        tc.len = std::strftime(tc.text, sizeof(tc.text), "%Y-%m-%d %H:%M:%S", &tm);
+        tc.sec = sec;
+    }
+    const int ms = static_cast<int>(ts_ns / 1000000 % 1000);
+    const char frac[5] = {'.', static_cast<char>('0' + ms / 100), static_cast<char>('0' + ms / 10 % 10),
+                          static_cast<char>('0' + ms % 10), '\0'};
+    out.append(tc.text, tc.len);
+    out.append(frac, 4);
+    out += " [";
+    out += level_name(lvl);
+    out += "] ";
+    out += name;
+    out += ": ";
+    out.append(payload, n);
+    out += '\n';
+}
+
+} // namespace
+
+struct Logger::Async {
+    std::string name;
+    std::ostream* out;
+    std::mutex* out_mu;              // shared with synchronous writes
+
+    std::atomic<bool> accepting{false};
+    std::atomic<std::uint64_t> dropped{0};
+    logring::ThreadRings rings{accepting};
+
+    // formatter thread only
+    std::vector<logring::ThreadRings::Record> recs;
+    std::string staging, batch;
+    TimeCache tc;
+    std::uint64_t dropped_reported = 0;
+
+    Async(std::string n, std::ostream* o, std::mutex* m) : name(std::move(n)), out(o), out_mu(m) {}
+
+    // false: not accepting, the caller writes synchronously
+    bool push(LogLevel lvl, std::string_view msg) {
+        const std::size_t len = std::min(msg.size(), rings.max_payload());   // very long lines are truncated
+        logring::ThreadRings::Reservation res;
+        // tag 0 is the ring's pad record
+        switch (rings.reserve(static_cast<std::uint32_t>(lvl) + 1, len, res)) {
+            case logring::ThreadRings::Reserve::Closed:
+                return false;
+            case logring::ThreadRings::Reserve::Dropped:
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            case logring::ThreadRings::Reserve::Ok:
+                break;
+        }
+        std::memcpy(res.data, msg.data(), len);
+        logring::ThreadRings::commit(res);
+        return true;
+    }
+
+    // Formatter: take everything published so far from every ring, merged by time, write once
+    void drain() {
+        recs.clear();
+        staging.clear();
+        rings.take(recs, staging);
+
+        // Re-anchor TSC -> wall clock every pass so drift never accumulates
+        const double k = tsc_ns_per_tick();
+        const std::int64_t wall0 = wall_ns();
+        const std::uint64_t tsc0 = tsc_now();
+        batch.clear();
+        for (const auto& rec : recs) {
+            const auto ticks = static_cast<std::int64_t>(rec.tsc - tsc0);      // negative: logged before tsc0
+            const std::int64_t ts = wall0 + static_cast<std::int64_t>(static_cast<double>(ticks) * k);
+            append_line(batch, tc, ts, static_cast<LogLevel>(rec.tag - 1), name, staging.data() + rec.off, rec.len);
+        }
+        const std::uint64_t d = dropped.load(std::memory_order_relaxed);
+        if (d != dropped_reported) {
+            const std::string note = std::to_string(d - dropped_reported) + " log records dropped (ring full)";
+            append_line(batch, tc, wall_ns(), LogLevel::WARN, name, note.data(), note.size());
+            dropped_reported = d;
+        }
+        if (batch.empty()) return;
+        std::lock_guard<std::mutex> lk(*out_mu);
+        out->write(batch.data(), static_cast<std::streamsize>(batch.size()));
+        out->flush();
+    }
+
+    void start(const AsyncOptions& o) {
+        rings.start({o.ring_bytes, o.poll_interval, o.block_when_full}, [this] { drain(); });
+    }
+
+    void stop_and_drain() { rings.stop(); }
+
+    void flush() { rings.flush(); }
+};
 
 Logger::Logger(std::string name, std::ostream& out)
   : name_(std::move(name)),
@@ -13,82 +128,91 @@ Logger::Logger(std::string name, std::ostream& out)
     mutex_(std::make_unique<std::mutex>())
 {}
 
+Logger::~Logger() {
+    if (Async* a = async_.exchange(nullptr)) {
+        a->stop_and_drain();
+        delete a;
+    }
+}
+
 Logger::Logger(Logger&& other) noexcept
   : name_(std::move(other.name_)),
-    level_(other.level_),
+    level_(other.level_.load()),
     out_(other.out_),
-    mutex_(std::move(other.mutex_))
+    mutex_(std::move(other.mutex_)),
+    async_(other.async_.exchange(nullptr))
 {}
 
 Logger& Logger::operator=(Logger&& other) noexcept {
     if (this == &other) return *this;
-    std::lock_guard<std::mutex> l1(*mutex_);
-    std::lock_guard<std::mutex> l2(*other.mutex_);
-    name_ = std::move(other.name_);
-    level_ = other.level_;
-    out_ = other.out_;
-    mutex_ = std::move(other.mutex_);
+    if (Async* a = async_.exchange(nullptr)) {
+        a->stop_and_drain();
+        delete a;
+    }
+    {
+        std::scoped_lock lk(*mutex_, *other.mutex_);
+        name_ = std::move(other.name_);
+        level_ = other.level_.load();
+        out_ = other.out_;
+        async_ = other.async_.exchange(nullptr);
+    }
+    // swap rather than destroy the mutex the guard above was holding
+    std::swap(mutex_, other.mutex_);
     return *this;
 }
 
 void Logger::set_level(LogLevel level) noexcept {
-    std::lock_guard<std::mutex> lk(*mutex_);
-    level_ = level;
+    level_.store(level, std::memory_order_relaxed);
 }
 
 LogLevel Logger::level() const noexcept {
-    return level_;
+    return level_.load(std::memory_order_relaxed);
 }
 
-void Logger::emit(LogLevel lvl, const std::string& payload) {
-    auto now = std::chrono::system_clock::now();
-    auto t = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
-
-    std::tm tm;
-    localtime_r(&t, &tm);
-    std::ostringstream header;
-    header << std::put_time(std::localtime(&t), "%Y-%m-%d %H:%M:%S")
-           << '.' << std::setw(3) << std::setfill('0') << ms.count()
-           << " [";
-
-    switch (lvl) {
-        case LogLevel::TRACE: header << "TRACE"; break;
-        case LogLevel::DEBUG: header << "DEBUG"; break;
-        case LogLevel::INFO:  header << "INFO";  break;
-        case LogLevel::WARN:  header << "WARN";  break;
-        case LogLevel::ERROR: header << "ERROR"; break;
-    }
-    header << "] " << name_ << ": ";
+void Logger::start_async() { start_async(AsyncOptions{}); }
 
+void Logger::start_async(AsyncOptions opts) {
     std::lock_guard<std::mutex> lk(*mutex_);
-    (*out_) << header.str() << payload << '\n';
-    out_->flush();
+    Async* a = async_.load();
+    if (!a) {
+        a = new Async(name_, out_, mutex_.get());
+        async_.store(a, std::memory_order_release);
+    }
+    a->start(opts);
 }
 
-void Logger::log(LogLevel lvl, const std::string& msg) {
-    // simple level check
-    if (static_cast<int>(lvl) < static_cast<int>(level_)) return;
-    emit(lvl, msg);
+void Logger::stop_async() {
+    if (Async* a = async_.load(std::memory_order_acquire)) a->stop_and_drain();
 }
 
-void Logger::trace(const std::string& msg) { log(LogLevel::TRACE, msg); }
-void Logger::debug(const std::string& msg) { log(LogLevel::DEBUG, msg); }
-void Logger::info(const std::string& msg)  { log(LogLevel::INFO,  msg); }
-void Logger::warn(const std::string& msg)  { log(LogLevel::WARN,  msg); }
-void Logger::error(const std::string& msg) { log(LogLevel::ERROR, msg); }
-
-
-
-
-
-
-
-
-
-
+bool Logger::is_async() const noexcept {
+    const Async* a = async_.load(std::memory_order_acquire);
+    return a && a->accepting.load(std::memory_order_relaxed);
+}
 
+void Logger::flush() {
+    if (Async* a = async_.load(std::memory_order_acquire)) a->flush();
+}
 
+std::uint64_t Logger::dropped() const noexcept {
+    const Async* a = async_.load(std::memory_order_acquire);
+    return a ? a->dropped.load(std::memory_order_relaxed) : 0;
+}
 
+void Logger::emit(LogLevel lvl, std::string_view payload) {
+    thread_local TimeCache tc;
+    thread_local std::string line;     // keeps its capacity between calls
+    line.clear();
+    append_line(line, tc, wall_ns(), lvl, name_, payload.data(), payload.size());
 
+    std::lock_guard<std::mutex> lk(*mutex_);
+    out_->write(line.data(), static_cast<std::streamsize>(line.size()));
+    out_->flush();
+}
 
+void Logger::log(LogLevel lvl, std::string_view msg) {
+    // simple level check
+    if (static_cast<int>(lvl) < static_cast<int>(level_.load(std::memory_order_relaxed))) return;
+    if (Async* a = async_.load(std::memory_order_acquire); a && a->push(lvl, msg)) return;
+    emit(lvl, msg);
+}
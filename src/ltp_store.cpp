@@ -4,9 +4,24 @@
 
 void LTPStore::upsert(const LTP& v) {
     std::unique_lock<std::shared_mutex> lk(mu_);
+    if (!retired_.empty() && retired_.count(v.token)) return;
     map_[v.token] = v;
 }
 
+void LTPStore::retire(const std::vector<std::string>& tokens) {
+    std::unique_lock<std::shared_mutex> lk(mu_);
+    for (const auto& t : tokens) {
+        map_.erase(t);
+        retired_.insert(t);
+    }
+}
+
+void LTPStore::readmit(const std::vector<std::string>& tokens) {
+    std::unique_lock<std::shared_mutex> lk(mu_);
+    if (retired_.empty()) return;
+    for (const auto& t : tokens) retired_.erase(t);
+}
+
 std::optional<LTP> LTPStore::get(const std::string& token) const {
     std::shared_lock<std::shared_mutex> lk(mu_);
     auto it = map_.find(token);
@@ -19,6 +34,15 @@ std::unordered_map<std::string, LTP> LTPStore::snapshot() const {
     return map_; // copy
 }
 
+std::vector<std::string> LTPStore::received_before(std::chrono::steady_clock::time_point cutoff) const {
+    std::shared_lock<std::shared_mutex> lk(mu_);
+    std::vector<std::string> out;
+    for (const auto& [token, v] : map_) {
+        if (v.recv < cutoff) out.push_back(token);
+    }
+    return out;
+}
+
 std::size_t LTPStore::size() const {
     std::shared_lock<std::shared_mutex> lk(mu_);
     return map_.size();
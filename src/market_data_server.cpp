@@ -0,0 +1,542 @@
+// src/market_data_server.cpp
+#include "market_data_server.h"
+#include "logger.h"
+#include "self_signed_cert.h"
+
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <boost/beast/ssl.hpp>
+#include <boost/beast/websocket.hpp>
+#include <boost/beast/websocket/ssl.hpp>
+
+#include <nlohmann/json.hpp>
+#include <unistd.h>
+
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace asio      = boost::asio;
+namespace beast     = boost::beast;
+namespace websocket = beast::websocket;
+using tcp  = asio::ip::tcp;
+using json = nlohmann::json;
+
+using ws_stream = websocket::stream<beast::ssl_stream<beast::tcp_stream>>;
+using Frame = std::shared_ptr<const std::string>;
+
+namespace {
+
+std::int64_t epoch_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+struct MarketDataServer::Impl {
+    struct Session;
+
+    struct Instrument {
+        double rate = 0;
+        double credit = 0;
+        double px = 100.0;
+        std::vector<std::shared_ptr<Session>> subs;
+    };
+
+    Logger& log;
+    Options opts;
+
+    asio::ssl::context ssl_ctx{asio::ssl::context::tls_server};
+    asio::io_context ioc;
+    std::optional<asio::executor_work_guard<asio::io_context::executor_type>> guard;
+    tcp::acceptor acceptor{ioc};
+    std::vector<std::thread> io_threads;
+    std::thread generator;
+    std::atomic<bool> running{false};
+    unsigned short bound_port = 0;
+    std::string ca_path;
+    bool own_ca_file = false;
+
+    // instruments + sessions
+    mutable std::mutex mu;
+    std::unordered_map<std::string, Instrument> instruments;
+    std::vector<std::weak_ptr<Session>> sessions;
+    std::uint64_t rng = 0x9e3779b97f4a7c15ull;
+
+    std::mutex gen_mu;
+    std::condition_variable gen_cv;
+
+    std::atomic<std::uint64_t> n_sessions{0}, n_live{0}, n_subscribes{0}, n_ticks{0}, n_sent{0}, n_dropped{0};
+    std::atomic<std::uint64_t> n_rejected{0};
+    bool check_auth = false;                    // under mu, with:
+    std::unordered_set<std::string> authorizations; // accepted handshake Authorization values
+
+    Impl(Logger& l, Options o) : log(l), opts(std::move(o)) {
+        if (opts.threads == 0) opts.threads = 1;
+        if (opts.tick_interval.count() <= 0) opts.tick_interval = std::chrono::microseconds(1000);
+    }
+
+    double rate_for(const std::string& token) const {
+        auto it = opts.rates.find(token);
+        return it != opts.rates.end() ? it->second : opts.default_rate;
+    }
+
+    bool authorized(Session& s);
+
+    double next_rand() {                        // xorshift64*, under mu
+        rng ^= rng >> 12; rng ^= rng << 25; rng ^= rng >> 27;
+        return static_cast<double>((rng * 2685821657736338717ull) >> 11) / 9007199254740992.0;
+    }
+
+    // ---- one client connection ----
+    struct Session : std::enable_shared_from_this<Session> {
+        Impl& srv;
+        ws_stream ws;
+        beast::flat_buffer rbuf;
+        beast::http::request<beast::http::string_body> upgrade;
+        std::deque<Frame> outq;                 // strand only
+        bool writing = false;
+        std::atomic<bool> stalled{false};
+        bool open = false;                      // strand only: upgraded, frames may be sent
+        bool closed = false;                    // strand only
+        std::unordered_set<std::string> tokens; // under srv.mu
+        std::string authorization;              // accepted with; under srv.mu, cleared on close
+
+        Session(Impl& s, tcp::socket&& sock) : srv(s), ws(std::move(sock), s.ssl_ctx) {}
+
+        void run() {
+            auto self = shared_from_this();
+            beast::get_lowest_layer(ws).expires_after(std::chrono::seconds(10));
+            ws.next_layer().async_handshake(asio::ssl::stream_base::server, [self](beast::error_code ec) {
+                if (ec) return self->close();
+                beast::get_lowest_layer(self->ws).expires_never();
+                self->ws.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+                if (self->srv.opts.deflate) {
+                    websocket::permessage_deflate pmd;
+                    pmd.server_enable = true;
+                    self->ws.set_option(pmd);
+                }
+                // read the upgrade request ourselves so its Authorization can be checked
+                beast::http::async_read(self->ws.next_layer(), self->rbuf, self->upgrade,
+                                        [self](beast::error_code ec, std::size_t) {
+                    if (ec) return self->close();
+                    if (!self->srv.authorized(*self)) return self->reject();
+                    self->ws.async_accept(self->upgrade, [self](beast::error_code ec) {
+                        if (ec) return self->close();
+                        self->ws.text(true);
+                        self->open = true;
+                        self->do_read();
+                    });
+                });
+            });
+        }
+
+        // 401 to the handshake, as a broker does for a stale token
+        void reject() {
+            srv.n_rejected.fetch_add(1, std::memory_order_relaxed);
+            auto res = std::make_shared<beast::http::response<beast::http::string_body>>(
+                beast::http::status::unauthorized, upgrade.version());
+            res->set(beast::http::field::content_type, "application/json");
+            res->body() = R"({"message":"Invalid token"})";
+            res->keep_alive(false);
+            res->prepare_payload();
+            beast::http::async_write(ws.next_layer(), *res, [self = shared_from_this(), res](beast::error_code, std::size_t) {
+                self->close();
+            });
+        }
+
+        void do_read() {
+            rbuf.clear();
+            ws.async_read(rbuf, [self = shared_from_this()](beast::error_code ec, std::size_t) {
+                if (ec) return self->close();
+                self->on_text(beast::buffers_to_string(self->rbuf.data()));
+                self->do_read();
+            });
+        }
+
+        void on_text(std::string msg) {
+            json j = json::parse(msg, nullptr, /*allow_exceptions=*/false);
+            const bool has_action = j.is_object() && j.contains("action") && j["action"].is_string();
+            const std::string action = has_action ? j["action"].get<std::string>() : "";
+            if ((action == "subscribe" || action == "unsubscribe") && j.contains("tokens") && j["tokens"].is_array()) {
+                std::vector<std::string> toks;
+                for (const auto& t : j["tokens"]) if (t.is_string()) toks.push_back(t.get<std::string>());
+                if (action == "subscribe") {
+                    srv.subscribe(shared_from_this(), toks);
+                    enqueue(std::make_shared<const std::string>(
+                        R"({"type":"ack","action":"subscribe","count":)" + std::to_string(toks.size()) + "}"));
+                } else {
+                    srv.unsubscribe(*this, toks);
+                }
+                return;
+            }
+            enqueue(std::make_shared<const std::string>(std::move(msg)));   // echo
+        }
+
+        void enqueue(Frame f) {
+            if (closed || stalled.load(std::memory_order_relaxed)) return;
+            if (outq.size() >= srv.opts.max_queue) {
+                srv.n_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            outq.push_back(std::move(f));
+            if (!writing) do_write();
+        }
+
+        void do_write() {
+            writing = true;
+            ws.async_write(asio::buffer(*outq.front()), [self = shared_from_this()](beast::error_code ec, std::size_t) {
+                self->writing = false;
+                if (ec) return self->close();
+                self->srv.n_sent.fetch_add(1, std::memory_order_relaxed);
+                self->outq.pop_front();
+                if (!self->outq.empty()) self->do_write();
+            });
+        }
+
+        void kill() {
+            asio::post(ws.get_executor(), [self = shared_from_this()] {
+                beast::error_code ec;
+                beast::get_lowest_layer(self->ws).socket().close(ec);
+                self->close();
+            });
+        }
+
+        void close() {
+            if (closed) return;
+            closed = true;
+            // the in-flight frame must outlive its async_write
+            if (writing) outq.erase(outq.begin() + 1, outq.end());
+            else         outq.clear();
+            srv.forget(*this);
+            srv.n_live.fetch_sub(1, std::memory_order_relaxed);
+        }
+    };
+
+    // ---- subscriptions (any session strand) ----
+    void subscribe(const std::shared_ptr<Session>& s, const std::vector<std::string>& toks) {
+        std::lock_guard<std::mutex> lk(mu);
+        for (const auto& t : toks) {
+            if (!s->tokens.insert(t).second) continue;
+            auto [it, fresh] = instruments.try_emplace(t);
+            if (fresh) {
+                it->second.rate = rate_for(t);
+                it->second.px = 100.0 + std::floor(next_rand() * 90000.0) / 100.0;
+            }
+            it->second.subs.push_back(s);
+        }
+        n_subscribes.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void unsubscribe(Session& s, const std::vector<std::string>& toks) {
+        std::lock_guard<std::mutex> lk(mu);
+        for (const auto& t : toks) {
+            if (!s.tokens.erase(t)) continue;
+            drop_sub_locked(t, s);
+        }
+    }
+
+    void drop_sub_locked(const std::string& token, Session& s) {
+        auto it = instruments.find(token);
+        if (it == instruments.end()) return;
+        auto& subs = it->second.subs;
+        subs.erase(std::remove_if(subs.begin(), subs.end(),
+                                  [&s](const std::shared_ptr<Session>& p) { return p.get() == &s; }),
+                   subs.end());
+    }
+
+    void forget(Session& s) {
+        std::lock_guard<std::mutex> lk(mu);
+        for (const auto& t : s.tokens) drop_sub_locked(t, s);
+        s.tokens.clear();
+        s.authorization.clear();
+    }
+
+    // ---- accept ----
+    void do_accept() {
+        acceptor.async_accept(asio::make_strand(ioc), [this](beast::error_code ec, tcp::socket sock) {
+            if (ec) return;                       // acceptor closed
+            auto s = std::make_shared<Session>(*this, std::move(sock));
+            n_sessions.fetch_add(1, std::memory_order_relaxed);
+            n_live.fetch_add(1, std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lk(mu);
+                sessions.erase(std::remove_if(sessions.begin(), sessions.end(),
+                                              [](const std::weak_ptr<Session>& w) { return w.expired(); }),
+                               sessions.end());
+                sessions.push_back(s);
+            }
+            asio::dispatch(s->ws.get_executor(), [s] { s->run(); });
+            do_accept();
+        });
+    }
+
+    // ---- tick generator: one thread, fans identical frames out to every subscriber ----
+    double burst_multiplier(std::chrono::steady_clock::duration since_start) const {
+        const auto& b = opts.burst;
+        if (b.period.count() <= 0 || b.length.count() <= 0) return 1.0;
+        const auto phase = since_start % std::chrono::duration_cast<std::chrono::steady_clock::duration>(b.period);
+        return phase < b.length ? b.multiplier : 1.0;
+    }
+
+    void run_generator() {
+        const auto t0 = std::chrono::steady_clock::now();
+        auto last = t0;
+        auto next = t0;
+        char buf[256];
+        std::unordered_map<Session*, std::pair<std::shared_ptr<Session>, std::vector<Frame>>> batch;
+
+        std::unique_lock<std::mutex> gl(gen_mu);
+        while (running.load()) {
+            next += opts.tick_interval;
+            gen_cv.wait_until(gl, next, [this] { return !running.load(); });
+            if (!running.load()) break;
+
+            const auto now = std::chrono::steady_clock::now();
+            const double dt = std::chrono::duration<double>(now - last).count();
+            last = now;
+            const double mult = burst_multiplier(now - t0);
+
+            {
+                std::lock_guard<std::mutex> lk(mu);
+                for (auto& [token, in] : instruments) {
+                    if (in.subs.empty() || in.rate <= 0) continue;
+                    in.credit += in.rate * mult * dt;
+                    const auto n = static_cast<std::uint64_t>(in.credit);
+                    if (n == 0) continue;
+                    in.credit -= static_cast<double>(n);
+                    for (std::uint64_t k = 0; k < n; ++k) {
+                        in.px = std::max(0.05, in.px + (next_rand() - 0.5) * 0.1);
+                        const int len = std::snprintf(buf, sizeof(buf),
+                            R"({"data":{"token":"%s","ltp":%.2f,"exchange_timestamp":%lld}})",
+                            token.c_str(), in.px, static_cast<long long>(epoch_ns()));
+                        auto frame = std::make_shared<const std::string>(buf, static_cast<std::size_t>(len));
+                        for (const auto& s : in.subs) {
+                            auto& slot = batch[s.get()];
+                            if (!slot.first) slot.first = s;
+                            slot.second.push_back(frame);
+                        }
+                    }
+                    n_ticks.fetch_add(n, std::memory_order_relaxed);
+                }
+            }
+            for (auto& [ptr, slot] : batch) {
+                auto s = std::move(slot.first);
+                asio::post(s->ws.get_executor(), [s, frames = std::move(slot.second)]() mutable {
+                    for (auto& f : frames) s->enqueue(std::move(f));
+                });
+            }
+            batch.clear();
+        }
+    }
+
+    template <class Fn>
+    void for_each_session(Fn fn) {
+        std::vector<std::shared_ptr<Session>> live;
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            for (auto& w : sessions) if (auto s = w.lock()) live.push_back(std::move(s));
+        }
+        for (auto& s : live) fn(*s);
+    }
+};
+
+// Session strand, once the upgrade request has been read
+bool MarketDataServer::Impl::authorized(Session& s) {
+    const auto v = s.upgrade[beast::http::field::authorization];
+    std::string value(v.data(), v.size());
+    std::lock_guard<std::mutex> lk(mu);
+    if (check_auth && authorizations.count(value) == 0) return false;
+    s.authorization = std::move(value);
+    return true;
+}
+
+MarketDataServer::MarketDataServer(Logger& log, Options opts)
+    : impl_(new Impl(log, std::move(opts))) {}
+
+MarketDataServer::~MarketDataServer() {
+    stop();
+    if (impl_->own_ca_file && !impl_->ca_path.empty()) ::unlink(impl_->ca_path.c_str());
+    delete impl_;
+}
+
+bool MarketDataServer::start() {
+    auto& im = *impl_;
+    if (im.running.load()) return true;
+    try {
+        if (!im.opts.cert_file.empty()) {
+            im.ssl_ctx.use_certificate_chain_file(im.opts.cert_file);
+            im.ssl_ctx.use_private_key_file(im.opts.key_file, asio::ssl::context::pem);
+            im.ca_path = im.opts.cert_file;
+        } else {
+            std::string cert, key;
+            if (!make_self_signed_cert(cert, key)) {
+                im.log.error("[mds] self-signed certificate generation failed");
+                return false;
+            }
+            im.ssl_ctx.use_certificate_chain(asio::buffer(cert));
+            im.ssl_ctx.use_private_key(asio::buffer(key), asio::ssl::context::pem);
+            // clients verify against this file (Options::ca_file)
+            im.ca_path = write_temp_pem(cert, "alpha-mds-");
+            if (im.ca_path.empty()) {
+                im.log.error("[mds] cannot write CA file");
+                return false;
+            }
+            im.own_ca_file = true;
+        }
+
+        const tcp::endpoint ep(asio::ip::make_address(im.opts.address), im.opts.port);
+        im.acceptor.open(ep.protocol());
+        im.acceptor.set_option(asio::socket_base::reuse_address(true));
+        im.acceptor.bind(ep);
+        im.acceptor.listen(asio::socket_base::max_listen_connections);
+        im.bound_port = im.acceptor.local_endpoint().port();
+    } catch (const std::exception& e) {
+        im.log.error(std::string("[mds] start failed: ") + e.what());
+        return false;
+    }
+
+    im.running.store(true);
+    im.guard.emplace(asio::make_work_guard(im.ioc));
+    im.do_accept();
+    for (std::size_t i = 0; i < im.opts.threads; ++i) im.io_threads.emplace_back([&im] { im.ioc.run(); });
+    im.generator = std::thread([&im] { im.run_generator(); });
+    im.log.info("[mds] listening on " + url());
+    return true;
+}
+
+void MarketDataServer::stop() {
+    auto& im = *impl_;
+    if (!im.running.exchange(false)) return;
+    im.gen_cv.notify_all();
+    if (im.generator.joinable()) im.generator.join();
+
+    asio::post(im.ioc, [&im] { beast::error_code ec; im.acceptor.close(ec); });
+    im.for_each_session([](Impl::Session& s) { s.kill(); });
+    im.guard.reset();
+    // sessions finish on their own once their sockets are closed
+    for (int i = 0; i < 200 && im.n_live.load() > 0; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    im.ioc.stop();
+    for (auto& t : im.io_threads) if (t.joinable()) t.join();
+    im.io_threads.clear();
+
+    std::lock_guard<std::mutex> lk(im.mu);
+    im.instruments.clear();
+    im.sessions.clear();
+}
+
+unsigned short MarketDataServer::port() const noexcept { return impl_->bound_port; }
+
+std::string MarketDataServer::url() const {
+    return "wss://" + impl_->opts.address + ":" + std::to_string(impl_->bound_port);
+}
+
+const std::string& MarketDataServer::cert_file() const noexcept { return impl_->ca_path; }
+
+void MarketDataServer::set_rate(const std::string& token, double ticks_per_sec) {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    impl_->opts.rates[token] = ticks_per_sec;
+    auto it = impl_->instruments.find(token);
+    if (it != impl_->instruments.end()) it->second.rate = ticks_per_sec;
+}
+
+void MarketDataServer::set_authorization(const std::string& value) {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    impl_->authorizations.clear();
+    impl_->check_auth = !value.empty();
+    if (impl_->check_auth) impl_->authorizations.insert(value);
+}
+
+void MarketDataServer::allow_authorization(const std::string& value) {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    impl_->check_auth = true;
+    impl_->authorizations.insert(value);
+}
+
+void MarketDataServer::revoke_authorization(const std::string& value) {
+    {
+        std::lock_guard<std::mutex> lk(impl_->mu);
+        impl_->authorizations.erase(value);
+    }
+    impl_->for_each_session([&value, this](Impl::Session& s) {
+        bool hit;
+        {
+            std::lock_guard<std::mutex> lk(impl_->mu);
+            hit = s.authorization == value;
+        }
+        if (hit) s.kill();
+    });
+}
+
+std::map<std::string, std::size_t> MarketDataServer::live_by_authorization() const {
+    std::map<std::string, std::size_t> out;
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    for (const auto& w : impl_->sessions) {
+        const auto s = w.lock();
+        if (s && !s->authorization.empty()) ++out[s->authorization];
+    }
+    return out;
+}
+
+void MarketDataServer::drop_all() {
+    impl_->for_each_session([](Impl::Session& s) { s.kill(); });
+}
+
+void MarketDataServer::stall_streaming() {
+    std::vector<std::shared_ptr<Impl::Session>> subscribed;
+    {
+        std::lock_guard<std::mutex> lk(impl_->mu);
+        for (auto& w : impl_->sessions) {
+            auto s = w.lock();
+            if (s && !s->tokens.empty()) subscribed.push_back(std::move(s));
+        }
+    }
+    for (auto& s : subscribed) s->stalled.store(true);
+}
+
+void MarketDataServer::drop_subscribed() {
+    impl_->for_each_session([this](Impl::Session& s) {
+        bool subscribed;
+        {
+            std::lock_guard<std::mutex> lk(impl_->mu);
+            subscribed = !s.tokens.empty();
+        }
+        if (subscribed) s.kill();
+    });
+}
+
+void MarketDataServer::notify_idle(const std::string& text) {
+    auto frame = std::make_shared<const std::string>(text);
+    impl_->for_each_session([this, &frame](Impl::Session& s) {
+        bool idle;
+        {
+            std::lock_guard<std::mutex> lk(impl_->mu);
+            idle = s.tokens.empty();
+        }
+        if (idle) asio::post(s.ws.get_executor(), [self = s.shared_from_this(), frame] {
+            if (self->open) self->enqueue(frame);
+        });
+    });
+}
+
+MarketDataServer::Stats MarketDataServer::stats() const {
+    Stats st;
+    st.sessions     = impl_->n_sessions.load(std::memory_order_relaxed);
+    st.live_sessions = impl_->n_live.load(std::memory_order_relaxed);
+    st.subscribes   = impl_->n_subscribes.load(std::memory_order_relaxed);
+    st.ticks        = impl_->n_ticks.load(std::memory_order_relaxed);
+    st.frames_sent  = impl_->n_sent.load(std::memory_order_relaxed);
+    st.dropped      = impl_->n_dropped.load(std::memory_order_relaxed);
+    st.rejected     = impl_->n_rejected.load(std::memory_order_relaxed);
+    return st;
+}
@@ -0,0 +1,246 @@
+// src/metrics.cpp
+#include "metrics.h"
+#include "logger.h"
+
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+namespace asio  = boost::asio;
+namespace beast = boost::beast;
+namespace http  = beast::http;
+using tcp = asio::ip::tcp;
+
+// ---------------- MetricsRegistry ----------------
+
+std::size_t MetricsRegistry::Counter::stripe() noexcept {
+    static std::atomic<std::size_t> next{0};
+    thread_local const std::size_t mine = next.fetch_add(1, std::memory_order_relaxed) % kStripes;
+    return mine;
+}
+
+std::uint64_t MetricsRegistry::Counter::value() const noexcept {
+    std::uint64_t sum = 0;
+    for (const auto& c : cells_) sum += c.v.load(std::memory_order_relaxed);
+    return sum;
+}
+
+MetricsRegistry::Series* MetricsRegistry::find_locked(const std::string& name, const Labels& labels) {
+    for (auto& s : series_) {
+        if (s.name == name && s.labels == labels) return &s;
+    }
+    return nullptr;
+}
+
+// One family per name in the exposition: a second kind would add a second # TYPE
+void MetricsRegistry::check_kind_locked(const std::string& name, Kind kind) const {
+    for (const auto& s : series_) {
+        if (s.name == name && s.kind != kind) {
+            throw std::invalid_argument("metric " + name + " is already registered as a " +
+                                        (s.kind == Kind::Counter ? "counter" : "gauge"));
+        }
+    }
+}
+
+MetricsRegistry::Counter& MetricsRegistry::counter(const std::string& name, const std::string& help,
+                                                   const Labels& labels) {
+    std::lock_guard<std::mutex> lk(mu_);
+    check_kind_locked(name, Kind::Counter);
+    if (Series* s = find_locked(name, labels); s && s->counter) return *s->counter;
+    Counter& c = counters_.emplace_back();
+    series_.push_back(Series{name, help, labels, Kind::Counter, &c, nullptr});
+    return c;
+}
+
+MetricsRegistry::Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help,
+                                               const Labels& labels) {
+    std::lock_guard<std::mutex> lk(mu_);
+    check_kind_locked(name, Kind::Gauge);
+    if (Series* s = find_locked(name, labels); s && s->gauge) return *s->gauge;
+    Gauge& g = gauges_.emplace_back();
+    series_.push_back(Series{name, help, labels, Kind::Gauge, nullptr, &g});
+    return g;
+}
+
+std::vector<MetricsRegistry::Sample> MetricsRegistry::snapshot() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    std::vector<Sample> out;
+    out.reserve(series_.size());
+    for (const auto& s : series_) {
+        const double v = s.counter ? static_cast<double>(s.counter->value()) : static_cast<double>(s.gauge->value());
+        out.push_back(Sample{s.name, s.labels, s.kind, v});
+    }
+    return out;
+}
+
+double MetricsRegistry::value(const std::string& name, const Labels& match) const {
+    double sum = 0;
+    for (const auto& s : snapshot()) {
+        if (s.name != name) continue;
+        const bool ok = std::all_of(match.begin(), match.end(), [&s](const auto& kv) {
+            return std::find(s.labels.begin(), s.labels.end(), kv) != s.labels.end();
+        });
+        if (ok) sum += s.value;
+    }
+    return sum;
+}
+
+namespace {
+
+void append_escaped(std::string& out, const std::string& v) {
+    for (char c : v) {
+        if (c == '\\' || c == '"') { out += '\\'; out += c; }
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+}
+
+} // namespace
+
+std::string MetricsRegistry::prometheus_text() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    // Group series by name (first registration decides order, help and type)
+    std::vector<const Series*> order;
+    std::unordered_map<std::string, std::vector<const Series*>> by_name;
+    for (const auto& s : series_) {
+        auto& v = by_name[s.name];
+        if (v.empty()) order.push_back(&s);
+        v.push_back(&s);
+    }
+
+    std::string out;
+    out.reserve(series_.size() * 64);
+    for (const Series* head : order) {
+        out += "# HELP " + head->name + ' ' + head->help + '\n';
+        out += "# TYPE " + head->name + (head->kind == Kind::Counter ? " counter\n" : " gauge\n");
+        for (const Series* s : by_name[head->name]) {
+            out += s->name;
+            if (!s->labels.empty()) {
+                out += '{';
+                for (std::size_t i = 0; i < s->labels.size(); ++i) {
+                    if (i) out += ',';
+                    out += s->labels[i].first + "=\"";
+                    append_escaped(out, s->labels[i].second);
+                    out += '"';
+                }
+                out += '}';
+            }
+            out += ' ';
+            out += s->counter ? std::to_string(s->counter->value()) : std::to_string(s->gauge->value());
+            out += '\n';
+        }
+    }
+    return out;
+}
+
+// ---------------- MetricsServer ----------------
+
+struct MetricsServer::Impl {
+    Logger& log;
+    const MetricsRegistry& registry;
+    Options opts;
+
+    asio::io_context ioc{1};
+    std::optional<asio::executor_work_guard<asio::io_context::executor_type>> guard;
+    tcp::acceptor acceptor{ioc};
+    std::thread thr;
+    unsigned short bound_port = 0;
+
+    struct Session : std::enable_shared_from_this<Session> {
+        Impl& srv;
+        beast::tcp_stream stream;
+        beast::flat_buffer buf;
+        http::request<http::string_body> req;
+        http::response<http::string_body> res;
+
+        Session(Impl& s, tcp::socket&& sock) : srv(s), stream(std::move(sock)) {}
+
+        void run() {
+            stream.expires_after(std::chrono::seconds(10));
+            http::async_read(stream, buf, req, [self = shared_from_this()](beast::error_code ec, std::size_t) {
+                if (ec) return;
+                self->respond();
+            });
+        }
+
+        void respond() {
+            res.version(req.version());
+            res.keep_alive(false);
+            res.set(http::field::server, "alpha-metrics");
+            const auto target = req.target();
+            if (req.method() == http::verb::get && (target == "/metrics" || target.starts_with("/metrics?"))) {
+                res.result(http::status::ok);
+                res.set(http::field::content_type, "text/plain; version=0.0.4; charset=utf-8");
+                res.body() = srv.registry.prometheus_text();
+            } else {
+                res.result(http::status::not_found);
+                res.set(http::field::content_type, "text/plain");
+                res.body() = "not found\n";
+            }
+            res.prepare_payload();
+            http::async_write(stream, res, [self = shared_from_this()](beast::error_code, std::size_t) {
+                beast::error_code ec;
+                self->stream.socket().shutdown(tcp::socket::shutdown_send, ec);
+            });
+        }
+    };
+
+    Impl(Logger& l, const MetricsRegistry& r, Options o) : log(l), registry(r), opts(std::move(o)) {}
+
+    void do_accept() {
+        acceptor.async_accept([this](beast::error_code ec, tcp::socket sock) {
+            if (ec) return;                          // closed
+            std::make_shared<Session>(*this, std::move(sock))->run();
+            do_accept();
+        });
+    }
+};
+
+MetricsServer::MetricsServer(Logger& log, const MetricsRegistry& registry, Options opts)
+    : impl_(new Impl(log, registry, std::move(opts))) {}
+
+MetricsServer::~MetricsServer() {
+    stop();
+    delete impl_;
+}
+
+bool MetricsServer::start() {
+    auto& im = *impl_;
+    if (im.thr.joinable()) return true;
+    try {
+        const tcp::endpoint ep(asio::ip::make_address(im.opts.address), im.opts.port);
+        im.acceptor.open(ep.protocol());
+        im.acceptor.set_option(asio::socket_base::reuse_address(true));
+        im.acceptor.bind(ep);
+        im.acceptor.listen();
+        im.bound_port = im.acceptor.local_endpoint().port();
+    } catch (const std::exception& e) {
+        im.log.error(std::string("[metrics] listen failed: ") + e.what());
+        return false;
+    }
+    im.ioc.restart();
+    im.guard.emplace(asio::make_work_guard(im.ioc));
+    im.do_accept();
+    im.thr = std::thread([&im] { im.ioc.run(); });
+    im.log.info("[metrics] serving http://" + im.opts.address + ":" + std::to_string(im.bound_port) + "/metrics");
+    return true;
+}
+
+void MetricsServer::stop() {
+    auto& im = *impl_;
+    if (!im.thr.joinable()) return;
+    im.guard.reset();
+    im.ioc.stop();
+    im.thr.join();
+    beast::error_code ec;
+    im.acceptor.close(ec);
+}
+
+unsigned short MetricsServer::port() const noexcept { return impl_->bound_port; }
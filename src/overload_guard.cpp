@@ -0,0 +1,158 @@
+// src/overload_guard.cpp
+#include "overload_guard.h"
+#include "logger.h"
+
+#include <utility>
+
+namespace {
+
+std::int64_t steady_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+const char* overload_policy_name(OverloadPolicy p) noexcept {
+    switch (p) {
+        case OverloadPolicy::DropNewest:   return "drop_newest";
+        case OverloadPolicy::DropOldest:   return "drop_oldest";
+        case OverloadPolicy::Conflate:     return "conflate";
+        case OverloadPolicy::Backpressure: return "backpressure";
+        default:                           return "?";
+    }
+}
+
+OverloadGuard::OverloadGuard(IngestQueue& q, Logger& log, std::string name, Options opts)
+    : OverloadGuard(q, log, std::move(name), opts, Counters{}) {}
+
+OverloadGuard::OverloadGuard(IngestQueue& q, Logger& log, std::string name, Options opts, Counters counters)
+    : q_(q), log_(log), name_(std::move(name)), opts_(opts), reg_(counters) {
+    if (opts_.policy == OverloadPolicy::Conflate) {
+        parked_buf_.reserve(opts_.conflate_capacity);
+        slot_of_.reserve(opts_.conflate_capacity);
+    }
+}
+
+bool OverloadGuard::offer(std::string_view msg, const IngestQueue::Stamp& stamp) {
+    switch (opts_.policy) {
+        case OverloadPolicy::DropNewest:
+            if (q_.try_push_view(msg, stamp)) return true;
+            break;
+        case OverloadPolicy::DropOldest:
+            switch (q_.try_push_view_evict(msg, stamp)) {
+                case IngestQueue::PushResult::Pushed:  return true;
+                case IngestQueue::PushResult::Evicted: count(evicted_, reg_.evicted); report(); return true;
+                case IngestQueue::PushResult::Full:    break;
+            }
+            break;
+        case OverloadPolicy::Conflate:
+            // While anything is parked, newer frames must not overtake it through the ring
+            if (!parking_.load(std::memory_order_acquire) && q_.try_push_view(msg, stamp)) return true;
+            return park(msg, stamp);
+        case OverloadPolicy::Backpressure:
+            if (!holding_) {
+                if (q_.try_push_view(msg, stamp)) return true;
+                held_.assign(msg.data(), msg.size());
+                held_stamp_ = stamp;
+                holding_ = true;
+                count(pauses_, reg_.read_pauses);
+                report();
+                return true;
+            }
+            break;    // a second frame while paused: the connection ignores the read gate
+    }
+    count(dropped_, reg_.dropped);
+    report();
+    return false;
+}
+
+bool OverloadGuard::ready() {
+    if (!holding_) return true;
+    if (!q_.try_push_view(held_, held_stamp_)) return false;
+    holding_ = false;
+    return true;
+}
+
+bool OverloadGuard::park(std::string_view msg, const IngestQueue::Stamp& stamp) {
+    const std::string_view key = instrument_key(msg);
+    {
+        std::lock_guard<std::mutex> lk(park_mu_);
+        std::size_t slot = n_parked_;
+        bool replaced = false;
+        if (!key.empty()) {
+            const auto it = slot_of_.find(std::string(key));
+            if (it != slot_of_.end()) { slot = it->second; replaced = true; }
+        }
+        if (!replaced) {
+            if (n_parked_ == opts_.conflate_capacity) {
+                count(dropped_, reg_.dropped);
+                report();
+                return false;
+            }
+            if (slot == parked_buf_.size()) parked_buf_.emplace_back();
+            if (!key.empty()) slot_of_.emplace(std::string(key), slot);
+            ++n_parked_;
+        }
+        parked_buf_[slot].frame.assign(msg.data(), msg.size());
+        parked_buf_[slot].stamp = stamp;
+        parking_.store(true, std::memory_order_release);
+        if (replaced) count(conflated_, reg_.conflated);
+    }
+    parked_.fetch_add(1, std::memory_order_relaxed);
+    report();
+    return true;
+}
+
+std::size_t OverloadGuard::take_parked(std::vector<Parked>& out) {
+    std::lock_guard<std::mutex> lk(park_mu_);
+    const std::size_t n = n_parked_;
+    out.swap(parked_buf_);        // the consumer's spent buffers come back for reuse
+    n_parked_ = 0;
+    slot_of_.clear();
+    parking_.store(false, std::memory_order_release);
+    return n;
+}
+
+void OverloadGuard::count(std::atomic<std::uint64_t>& c, MetricsRegistry::Counter* reg) noexcept {
+    c.fetch_add(1, std::memory_order_relaxed);
+    if (reg) reg->inc();
+}
+
+// Overload path only: one warning per interval with the running totals
+void OverloadGuard::report() {
+    const std::int64_t now = steady_ns();
+    std::int64_t last = last_report_ns_.load(std::memory_order_relaxed);
+    const std::int64_t interval = std::chrono::duration_cast<std::chrono::nanoseconds>(opts_.report_interval).count();
+    if (last != 0 && now - last < interval) return;
+    if (!last_report_ns_.compare_exchange_strong(last, now, std::memory_order_relaxed)) return;
+    const Stats s = stats();
+    log_.warn_fmt("ingest queue overloaded on {} (policy={}): dropped={} evicted={} conflated={} parked={} read_pauses={}",
+                  name_, overload_policy_name(opts_.policy), s.dropped, s.evicted, s.conflated, s.parked, s.read_pauses);
+}
+
+OverloadGuard::Stats OverloadGuard::stats() const noexcept {
+    Stats s;
+    s.dropped     = dropped_.load(std::memory_order_relaxed);
+    s.evicted     = evicted_.load(std::memory_order_relaxed);
+    s.conflated   = conflated_.load(std::memory_order_relaxed);
+    s.parked      = parked_.load(std::memory_order_relaxed);
+    s.read_pauses = pauses_.load(std::memory_order_relaxed);
+    return s;
+}
+
+std::string_view OverloadGuard::instrument_key(std::string_view f) noexcept {
+    const std::size_t k = f.find("\"token\"");
+    if (k == std::string_view::npos) return {};
+    std::size_t i = k + 7;
+    auto skip_ws = [&] { while (i < f.size() && (f[i] == ' ' || f[i] == '\t')) ++i; };
+    skip_ws();
+    if (i >= f.size() || f[i] != ':') return {};
+    ++i;
+    skip_ws();
+    const bool quoted = i < f.size() && f[i] == '"';
+    if (quoted) ++i;
+    const std::size_t b = i;
+    while (i < f.size() && (quoted ? f[i] != '"' : (f[i] != ',' && f[i] != '}' && f[i] != ' '))) ++i;
+    return f.substr(b, i - b);
+}
@@ -52,8 +52,16 @@ static bool get_time_any(const json& j, const std::vector<const char*>& keys, lo
 
 std::chrono::system_clock::time_point
 Parser::to_timepoint(long long ts_sec_or_ms) {
-    // Heuristic: >= 10^12 → milliseconds since epoch; else seconds.
-    if (std::llabs(ts_sec_or_ms) >= 1000000000000LL) {
+    // Heuristic by magnitude: >= 10^18 ns, >= 10^15 µs, >= 10^12 ms, else seconds.
+    const long long mag = std::llabs(ts_sec_or_ms);
+    if (mag >= 1000000000000000000LL) {
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(ts_sec_or_ms)));
+    }
+    if (mag >= 1000000000000000LL) {
+        return std::chrono::system_clock::time_point(std::chrono::microseconds(ts_sec_or_ms));
+    }
+    if (mag >= 1000000000000LL) {
         return std::chrono::system_clock::time_point(std::chrono::milliseconds(ts_sec_or_ms));
     }
     return std::chrono::system_clock::time_point(std::chrono::seconds(ts_sec_or_ms));
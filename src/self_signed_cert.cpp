@@ -0,0 +1,75 @@
+// src/self_signed_cert.cpp
+#include "self_signed_cert.h"
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509v3.h>
+#include <unistd.h>
+
+#include <utility>
+#include <vector>
+
+bool make_self_signed_cert(std::string& cert_pem, std::string& key_pem) {
+    EVP_PKEY* pkey = EVP_EC_gen("P-256");
+    X509* x = X509_new();
+    bool ok = pkey && x;
+    if (ok) {
+        X509_set_version(x, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(x), 1);
+        X509_gmtime_adj(X509_getm_notBefore(x), -3600);
+        X509_gmtime_adj(X509_getm_notAfter(x), 3650L * 24 * 3600);
+        X509_set_pubkey(x, pkey);
+        X509_NAME* name = X509_get_subject_name(x);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                   reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(x, name);
+
+        X509V3_CTX v3;
+        X509V3_set_ctx_nodb(&v3);
+        X509V3_set_ctx(&v3, x, x, nullptr, nullptr, 0);
+        const std::pair<int, const char*> exts[] = {
+            {NID_basic_constraints, "critical,CA:TRUE"},
+            {NID_subject_alt_name, "IP:127.0.0.1,DNS:localhost"},
+        };
+        for (const auto& [nid, value] : exts) {
+            X509_EXTENSION* ext = X509V3_EXT_conf_nid(nullptr, &v3, nid, value);
+            ok = ok && ext && X509_add_ext(x, ext, -1);
+            X509_EXTENSION_free(ext);
+        }
+        ok = ok && X509_sign(x, pkey, EVP_sha256()) > 0;
+    }
+    auto to_pem = [](auto write) {
+        BIO* bio = BIO_new(BIO_s_mem());
+        std::string out;
+        if (write(bio)) {
+            char* data = nullptr;
+            const long n = BIO_get_mem_data(bio, &data);
+            out.assign(data, static_cast<std::size_t>(n));
+        }
+        BIO_free(bio);
+        return out;
+    };
+    if (ok) {
+        cert_pem = to_pem([x](BIO* b) { return PEM_write_bio_X509(b, x); });
+        key_pem  = to_pem([pkey](BIO* b) { return PEM_write_bio_PrivateKey(b, pkey, nullptr, nullptr, 0, nullptr, nullptr); });
+        ok = !cert_pem.empty() && !key_pem.empty();
+    }
+    X509_free(x);
+    EVP_PKEY_free(pkey);
+    return ok;
+}
+
+std::string write_temp_pem(const std::string& pem, const std::string& prefix) {
+    std::string tmpl = "/tmp/" + prefix + "XXXXXX";
+    std::vector<char> path(tmpl.begin(), tmpl.end());
+    path.push_back('\0');
+    const int fd = ::mkstemp(path.data());
+    if (fd < 0) return {};
+    const bool ok = ::write(fd, pem.data(), pem.size()) == static_cast<ssize_t>(pem.size());
+    ::close(fd);
+    if (!ok) {
+        ::unlink(path.data());
+        return {};
+    }
+    return path.data();
+}
@@ -8,21 +8,101 @@
 #include "parser.h"
 #include "ltp_store.h"
 #include "logger.h"
+#include "tick_rate_tracker.h"
+#include "feed_arbiter.h"
+#include "feed_watchdog.h"
+#include "latency_histogram.h"
+#include "metrics.h"
+#include "overload_guard.h"
+#include "binary_log.h"
+#include "instrument_master.h"
+#include "account_pool.h"
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <thread>
 #include <utility>
 #include <algorithm>
 #include <mutex>
+#include <unordered_set>
 
-struct Sharder::Worker {
-    // per-worker stack
+namespace {
+
+constexpr std::size_t kNoAccount = static_cast<std::size_t>(-1);
+
+std::int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+// Per-shard series in the metrics registry (labels: shard="<i>"); A/B legs share them
+struct ShardMetrics {
+    MetricsRegistry::Counter* frames = nullptr;
+    MetricsRegistry::Counter* bytes = nullptr;
+    MetricsRegistry::Counter* dropped = nullptr;
+    MetricsRegistry::Counter* evicted = nullptr;
+    MetricsRegistry::Counter* conflated = nullptr;
+    MetricsRegistry::Counter* read_pauses = nullptr;
+    MetricsRegistry::Counter* reconnects = nullptr;
+    MetricsRegistry::Counter* failovers = nullptr;
+    MetricsRegistry::Counter* recoveries = nullptr;
+    MetricsRegistry::Counter* inactive_frames = nullptr;
+    MetricsRegistry::Gauge*   queue_high_water = nullptr;
+    Consumer::Metrics consumer;
+};
+
+// One connection path of a shard: its own subscriptions and ring. A shard has one
+// leg, or two independent ones (A/B) with opts.redundant_feeds.
+struct FeedLeg {
+    std::size_t index = 0;                         // 0 = A, 1 = B
     std::unique_ptr<WebSocketClient>      ws;
+    std::unique_ptr<WebSocketClient>      standby; // opts.hot_standby: connected, unsubscribed
     std::unique_ptr<SubscriptionManager>  sub;
     std::unique_ptr<IngestQueue>          q;
-    std::unique_ptr<Consumer>             cons;
+    std::unique_ptr<OverloadGuard>        guard;   // producer side of q
+
+    // Connection that carries the subscriptions (ws or standby; swapped on failover)
+    std::atomic<WebSocketClient*> active{nullptr};
+    // Set when the active connection drops, cleared by its replacement's first frame
+    std::atomic<std::int64_t> down_since_ns{0};
+    std::size_t watch_id = 0;                      // FeedWatchdog target
+    std::unique_ptr<StageHistograms> timing;       // opts.stage_timing; written by the Consumer
+    const ShardMetrics* metrics = nullptr;         // the worker's
+
+    WebSocketClient& live() { return *active.load(); }
+};
+
+struct Sharder::Worker {
+    // per-worker stack
+    std::vector<std::unique_ptr<FeedLeg>> legs;
+    std::unique_ptr<FeedArbiter>          arb;    // two legs only
+    std::unique_ptr<Consumer>             cons;   // null when consumers are pooled
+    ShardMetrics                          metrics;
 
     // tokens assigned to this shard (RAW tokens, e.g. "26000")
     std::vector<std::string> tokens;
+    // set_accounts(): whose session it uses; written under Impl::mu, read by IO threads
+    std::atomic<std::size_t> account{kNoAccount};
+
+    void sub_add(const std::string& t)    { for (auto& l : legs) l->sub->add(t); }
+    void sub_remove(const std::string& t) { for (auto& l : legs) l->sub->remove(t); }
+
+    void start_ws() {
+        for (auto& l : legs) {
+            l->ws->start();
+            if (l->standby) l->standby->start();
+        }
+    }
+    void stop_ws() {
+        for (auto& l : legs) {
+            l->ws->stop();
+            if (l->standby) l->standby->stop();
+        }
+    }
 };
 
 struct Sharder::Impl {
@@ -33,19 +113,107 @@ struct Sharder::Impl {
 
     // auth/header state
     std::string auth_header_value; // e.g., "Bearer <JWT>"
+    std::map<std::string,std::string> session_headers; // rotate with the token
     std::map<std::string,std::string> common_headers;
 
     // desired full token list (RAW tokens)
     std::vector<std::string> desired_tokens;
 
+    // set_accounts(): the pool, its sessions as of the last event, and the tokens
+    // no account had room for
+    AccountPool* accounts = nullptr;
+    std::size_t accounts_listener = 0;
+    std::vector<AccountPool::Session> sessions;
+    std::vector<std::string> unplaced;
+    // Accounts whose handshakes were refused, renewed one at a time off mu and the
+    // IO threads. An account is queued once per run of refusals: a connect on it,
+    // or the pool bringing it back up, re-arms it.
+    std::thread renewer;
+    std::mutex renew_mu;
+    std::condition_variable renew_cv;
+    std::deque<std::size_t> renew_queue;
+    std::unordered_set<std::size_t> renew_held;
+    bool renew_stop = false;
+
     // workers
     std::vector<std::unique_ptr<Worker>> workers;
     std::atomic<bool> running{false};
 
+    // shared thread budget (opts.io_threads / opts.consumer_threads > 0)
+    std::unique_ptr<IoContextPool> io_pool;
+    std::vector<std::unique_ptr<Consumer>> pooled_consumers;
+    std::size_t n_pooled = 0;
+    std::atomic<std::size_t> worker_count{0};
+
+    // load-aware sharding (opts.load_aware); survives stop/start so restarts use history
+    std::unique_ptr<TickRateTracker> rates;
+    std::thread rebalancer;
+    std::mutex rb_mu;
+    std::condition_variable rb_cv;
+    bool rb_stop = false;
+
     std::mutex mu; // protects header/desired updates while running
 
+    // failover / recovery accounting (written from IO threads)
+    std::atomic<std::uint64_t> failovers{0};
+    std::atomic<std::uint64_t> recoveries{0};
+    std::atomic<std::uint64_t> inactive_frames{0};
+    std::atomic<std::int64_t> last_recover_us{0};
+    std::atomic<std::int64_t> max_recover_us{0};
+
+    // stall detection (opts.watchdog); survives stop/start
+    std::unique_ptr<FeedWatchdog> watchdog;
+
+    std::function<void(const LTP&)> sink;   // set_sink(); copied into each Consumer
+    BinaryLogger* trace = nullptr;           // set_trace_log()
+
+    // Always present so the hot path never checks; set_metrics() shares an external one
+    MetricsRegistry own_metrics;
+    MetricsRegistry* metrics = &own_metrics;
+
     Impl(Logger& lg, Parser& p, LTPStore& st, Options o)
-        : log(lg), parser(p), store(st), opts(std::move(o)) {}
+        : log(lg), parser(p), store(st), opts(std::move(o)) {
+        if (opts.watchdog.max_silence.count() > 0 || opts.watchdog.instrument_silence.count() > 0) {
+            watchdog = std::make_unique<FeedWatchdog>(log, opts.watchdog);
+            watchdog->watch_store(store);
+        }
+    }
+
+    bool stage_timing() const { return kStageTimingCompiled && opts.stage_timing; }
+
+    // Get-or-create, so a restarted shard keeps counting into the same series
+    ShardMetrics shard_metrics(std::size_t si) const {
+        MetricsRegistry& r = *metrics;
+        const MetricsRegistry::Labels l{{"shard", std::to_string(si)}};
+        ShardMetrics m;
+        m.frames     = &r.counter("alpha_ws_frames_total", "WebSocket frames received", l);
+        m.bytes      = &r.counter("alpha_ws_bytes_total", "WebSocket payload bytes received", l);
+        m.dropped    = &r.counter("alpha_ingest_dropped_total", "Arriving frames dropped on a full ingest queue", l);
+        m.evicted    = &r.counter("alpha_ingest_evicted_total", "Queued frames evicted for newer ones (drop oldest)", l);
+        m.conflated  = &r.counter("alpha_ingest_conflated_total", "Parked updates superseded by a newer one for the instrument", l);
+        m.read_pauses = &r.counter("alpha_ingest_read_pauses_total", "Socket reads held back by a full ingest queue", l);
+        m.reconnects = &r.counter("alpha_ws_reconnects_total", "WebSocket connection drops", l);
+        m.failovers  = &r.counter("alpha_failovers_total", "Hot-standby promotions", l);
+        m.recoveries = &r.counter("alpha_recoveries_total", "Outages ended by a first frame", l);
+        m.inactive_frames = &r.counter("alpha_ws_inactive_frames_total", "Frames from a leg's inactive connection, dropped", l);
+        m.queue_high_water = &r.gauge("alpha_ingest_queue_high_water", "Peak ingest queue depth", l);
+        m.consumer.ticks          = &r.counter("alpha_ticks_total", "Ticks parsed and stored", l);
+        m.consumer.parse_failures = &r.counter("alpha_parse_failures_total", "Frames that are neither ticks nor acks", l);
+        m.consumer.subscribe_acks = &r.counter("alpha_subscribe_acks_total", "Subscribe acknowledgements", l);
+        return m;
+    }
+
+    // Contiguous slices, or bin-packed by observed rate when load-aware
+    std::vector<std::vector<std::string>> assign_shards(const std::vector<std::string>& tokens) const {
+        if (rates) return rates->assign(tokens, opts.max_tokens_per_conn);
+        return shard(tokens, opts.max_tokens_per_conn);
+    }
+
+    double load_of(const Worker& w) const {
+        double sum = 0;
+        for (const auto& t : w.tokens) sum += rates->rate(t);
+        return sum;
+    }
 
     static std::vector<std::vector<std::string>>
     shard(const std::vector<std::string>& tokens, std::size_t max_per_conn) {
@@ -61,87 +229,693 @@ struct Sharder::Impl {
         return out;
     }
 
+    // Resolve per-shard placement from opts.topology (explicit list, auto pairs, or none).
+    std::vector<ShardPlacement> plan_placement(std::size_t n) const {
+        const auto& topo = opts.topology;
+        std::vector<ShardPlacement> out(n);
+        if (!topo.shards.empty()) {
+            for (std::size_t i = 0; i < n; ++i) out[i] = topo.shards[i % topo.shards.size()];
+        } else if (topo.auto_pin) {
+            auto pairs = CpuTopology::detect().plan_pairs(n);
+            for (std::size_t i = 0; i < n; ++i) {
+                out[i].io.cpu       = pairs[i].first;
+                out[i].consumer.cpu = pairs[i].second;
+                out[i].io.policy = out[i].consumer.policy = topo.policy;
+                out[i].io.priority = out[i].consumer.priority = topo.priority;
+            }
+        }
+        return out;
+    }
+
+    void report_placement(const std::vector<ShardPlacement>& plan) const {
+        bool any = false;
+        for (const auto& p : plan) any = any || p.io.pinned() || p.consumer.pinned();
+        if (!any) return;
+
+        const auto topo = CpuTopology::detect();
+        for (std::size_t i = 0; i < plan.size(); ++i) {
+            const auto& p = plan[i];
+            const bool same_l3 = p.io.pinned() && p.consumer.pinned() &&
+                                 topo.l3_id(p.io.cpu) >= 0 && topo.l3_id(p.io.cpu) == topo.l3_id(p.consumer.cpu);
+            log.info_fmt("sharder placement shard={} io_cpu={} consumer_cpu={} node={}{}", i, p.io.cpu,
+                         p.consumer.cpu, topo.numa_node(p.consumer.cpu), same_l3 ? " same_l3" : "");
+        }
+    }
+
     std::map<std::string,std::string> effective_headers_locked() const {
-        std::map<std::string,std::string> h = common_headers;
+        std::map<std::string,std::string> h = opts.headers;
+        for (const auto& [k, v] : common_headers) h[k] = v;
+        for (const auto& [k, v] : session_headers) h[k] = v;
         if (!auth_header_value.empty()) h["Authorization"] = auth_header_value;
         return h;
     }
 
+    // The shared headers, then the account's session on top
+    std::map<std::string,std::string> headers_for_locked(std::size_t account) const {
+        auto h = effective_headers_locked();
+        if (account < sessions.size()) {
+            for (const auto& [k, v] : sessions[account].headers) h[k] = v;
+        }
+        return h;
+    }
+
+    // Every connection's next handshake uses the current headers
+    void push_headers_locked() {
+        for (auto& w : workers) {
+            const auto h = headers_for_locked(w->account);
+            for (auto& leg : w->legs) {
+                if (leg->ws) leg->ws->set_headers(h);
+                if (leg->standby) leg->standby->set_headers(h);
+            }
+        }
+    }
+
+    // ---- account quotas (set_accounts) ----
+    std::size_t legs_per_shard() const { return opts.redundant_feeds ? 2 : 1; }
+    std::size_t conns_per_shard() const { return legs_per_shard() * (opts.hot_standby ? 2 : 1); }
+
+    struct AccountUse {
+        std::size_t conns = 0;
+        std::size_t subs = 0;       // instruments x legs
+    };
+
+    std::vector<AccountUse> account_use_locked() const {
+        std::vector<AccountUse> use(sessions.size());
+        for (const auto& w : workers) add_use(*w, use, w->tokens.size(), true);
+        return use;
+    }
+
+    void add_use(const Worker& w, std::vector<AccountUse>& use, std::size_t tokens, bool conns) const {
+        if (w.account >= use.size()) return;
+        use[w.account].subs += tokens * legs_per_shard();
+        if (conns) use[w.account].conns += conns_per_shard();
+    }
+
+    // Instruments an account can still take; none while it is down
+    std::size_t account_room(std::size_t a, const std::vector<AccountUse>& use) const {
+        const auto& s = sessions[a];
+        if (!s.up || use[a].subs >= s.max_tokens) return 0;
+        return (s.max_tokens - use[a].subs) / legs_per_shard();
+    }
+
+    // Instruments a shard can still take: its connection limit, and its account's
+    std::size_t worker_room(const Worker& w, const std::vector<AccountUse>& use) const {
+        const std::size_t max_per_conn = opts.max_tokens_per_conn ? opts.max_tokens_per_conn : 800;
+        const std::size_t room = w.tokens.size() < max_per_conn ? max_per_conn - w.tokens.size() : 0;
+        if (!accounts) return room;
+        return w.account < sessions.size() ? std::min(room, account_room(w.account, use)) : 0;
+    }
+
+    // The up account with connections left for one more shard and the most room
+    // (at least `need` instruments); kNoAccount if there is none
+    std::size_t pick_account(const std::vector<AccountUse>& use, std::size_t need) const {
+        std::size_t best = kNoAccount, best_room = 0;
+        for (std::size_t a = 0; a < sessions.size(); ++a) {
+            if (!sessions[a].up || use[a].conns + conns_per_shard() > sessions[a].max_connections) continue;
+            const std::size_t room = account_room(a, use);
+            if (room < need) continue;
+            if (best == kNoAccount || room > best_room) {
+                best = a;
+                best_room = room;
+            }
+        }
+        return best;
+    }
+
+    // Give each new shard an account, splitting shards that don't fit; what no
+    // account can take goes to `unplaced`. homes[i] is shards[i]'s account.
+    void place_shards_locked(std::vector<std::vector<std::string>>& shards, std::vector<std::size_t>& homes,
+                             std::vector<AccountUse>& use) {
+        std::vector<std::vector<std::string>> out;
+        homes.clear();
+        for (const auto& sh : shards) {
+            std::size_t pos = 0;
+            while (pos < sh.size()) {
+                const std::size_t a = pick_account(use, 1);
+                if (a == kNoAccount) {
+                    unplaced.insert(unplaced.end(), sh.begin() + static_cast<std::ptrdiff_t>(pos), sh.end());
+                    break;
+                }
+                const std::size_t take = std::min(sh.size() - pos, account_room(a, use));
+                out.emplace_back(sh.begin() + static_cast<std::ptrdiff_t>(pos),
+                                 sh.begin() + static_cast<std::ptrdiff_t>(pos + take));
+                homes.push_back(a);
+                use[a].conns += conns_per_shard();
+                use[a].subs += take * legs_per_shard();
+                pos += take;
+            }
+        }
+        shards.swap(out);
+        if (!unplaced.empty()) {
+            log.warn_fmt("sharder accounts: no room for {} tokens", unplaced.size());
+        }
+    }
+
+    // Shards on a down account (or none) move to an up account with a spare
+    // connection and room for all their instruments, and reconnect with its session
+    void rehome_locked() {
+        auto use = account_use_locked();
+        for (std::size_t si = 0; si < workers.size(); ++si) {
+            Worker& w = *workers[si];
+            if (w.account < sessions.size() && sessions[w.account].up) continue;
+            const std::size_t to = pick_account(use, w.tokens.size());
+            if (to == kNoAccount) {
+                ALPHA_LOG_RATE_LIMITED(log, LogLevel::WARN, 10, std::chrono::seconds(1),
+                                       "sharder shard={}: no account has room to take it over", si);
+                continue;
+            }
+            if (w.account < use.size()) {
+                use[w.account].conns -= conns_per_shard();
+                use[w.account].subs -= w.tokens.size() * legs_per_shard();
+            }
+            const std::string from = w.account < sessions.size() ? sessions[w.account].name : "-";
+            w.account = to;
+            add_use(w, use, w.tokens.size(), true);
+            const auto h = headers_for_locked(to);
+            for (auto& leg : w.legs) {
+                leg->ws->set_headers(h);
+                leg->ws->recycle();
+                if (leg->standby) {
+                    leg->standby->set_headers(h);
+                    leg->standby->recycle();
+                }
+            }
+            metrics->counter("alpha_account_rehomes_total", "Shards moved off a failed account",
+                             {{"account", sessions[to].name}}).inc();
+            log.info_fmt("sharder shard={} moved from account {} to {}", si, from, sessions[to].name);
+        }
+    }
+
+    // AccountPool listener: new tokens, or an account up or down
+    void on_account_event(std::size_t account) {
+        std::lock_guard<std::mutex> lk(mu);
+        const bool was_up = account < sessions.size() && sessions[account].up;
+        sessions = accounts->sessions();
+        if (!was_up && account < sessions.size() && sessions[account].up) rearm_renew(account);
+        if (!running.load()) return;
+        rehome_locked();
+        push_headers_locked();
+        if (!unplaced.empty() && account < sessions.size() && sessions[account].up) reshard_live_locked();
+    }
+
+    // IO thread: a connection on `account` got 401/403 on its handshake
+    void on_handshake_refused(std::size_t account) {
+        if (account == kNoAccount) return;
+        {
+            std::lock_guard<std::mutex> lk(renew_mu);
+            if (renew_stop || !renew_held.insert(account).second) return;
+            renew_queue.push_back(account);
+        }
+        renew_cv.notify_one();
+    }
+
+    void rearm_renew(std::size_t account) {
+        std::lock_guard<std::mutex> lk(renew_mu);
+        renew_held.erase(account);
+    }
+
+    // The pool's listener re-homes the account's shards if the renewal fails
+    void start_renewer() {
+        renewer = std::thread([this] {
+            std::unique_lock<std::mutex> lk(renew_mu);
+            for (;;) {
+                renew_cv.wait(lk, [this] { return renew_stop || !renew_queue.empty(); });
+                if (renew_stop) return;
+                const std::size_t a = renew_queue.front();
+                renew_queue.pop_front();
+                lk.unlock();
+                log.warn_fmt("sharder account {}: handshake refused, renewing its session", a);
+                const bool ok = accounts->renew(a);
+                if (!ok) log.warn_fmt("sharder account {}: renewal failed", a);
+                lk.lock();
+            }
+        });
+    }
+
+    void stop_renewer() {
+        {
+            std::lock_guard<std::mutex> lk(renew_mu);
+            renew_stop = true;
+        }
+        renew_cv.notify_all();
+        if (renewer.joinable()) renewer.join();
+    }
+
+    // Built once, sized for the universe at hand, and kept across stop/start
+    void ensure_rates_locked() {
+        if (!opts.load_aware || rates) return;
+        const std::size_t width = opts.rate_width ? opts.rate_width : TickRateTracker::width_for(desired_tokens.size());
+        rates = std::make_unique<TickRateTracker>(opts.rate_half_life, width, opts.rate_depth);
+    }
+
     void build_workers_locked() {
         // Tear down any previous
         workers.clear();
+        pooled_consumers.clear();
+        io_pool.reset();
 
         // Shard tokens
-        auto shards = shard(desired_tokens, opts.max_tokens_per_conn);
+        auto shards = assign_shards(desired_tokens);
+        std::vector<std::size_t> homes;
+        std::vector<AccountUse> use(sessions.size());
+        if (accounts) {
+            unplaced.clear();
+            place_shards_locked(shards, homes, use);
+        }
         if (shards.empty()) {
             // create at least one idle worker so start/stop works
             shards.emplace_back();
+            if (accounts) homes.push_back(pick_account(use, 0));
         }
 
-        for (auto& shard_tokens : shards) {
-            auto w = std::make_unique<Worker>();
-            w->tokens = shard_tokens;
+        const auto plan = plan_placement(shards.size());
+        report_placement(plan);
+
+        if (opts.io_threads > 0) {
+            IoContextPool::Options popts;
+            popts.threads = opts.io_threads;
+            for (const auto& p : plan_placement(opts.io_threads)) popts.placement.push_back(p.io);
+            io_pool = std::make_unique<IoContextPool>(log, popts);
+        }
+        // the pool grows up to consumer_threads as shards are added (here or by a live reshard)
+        n_pooled = opts.consumer_threads;
+
+        for (std::size_t si = 0; si < shards.size(); ++si) {
+            workers.emplace_back(make_worker_locked(si, shards[si], plan, homes.empty() ? kNoAccount : homes[si]));
+        }
+        worker_count.store(workers.size());
+    }
 
-            // Subscription manager (prefix, batching)
+    // One WS + SubMgr + Queue stack per leg (+ Consumer) for shard si
+    std::unique_ptr<Worker> make_worker_locked(std::size_t si,
+                                               const std::vector<std::string>& shard_tokens,
+                                               const std::vector<ShardPlacement>& plan,
+                                               std::size_t account) {
+        const auto& place = plan[si];
+        auto w = std::make_unique<Worker>();
+        w->tokens = shard_tokens;
+        w->account = account;
+        w->metrics = shard_metrics(si);
+
+        const std::size_t n_legs = opts.redundant_feeds ? 2 : 1;
+        if (n_legs > 1) w->arb = std::make_unique<FeedArbiter>();
+
+        // Rings are built on the consumer's cpu so their pages are first-touched on that NUMA node
+        const ThreadPlacement& cons_place = n_pooled ? plan[si % n_pooled].consumer : place.consumer;
+        const int alloc_cpu = opts.topology.numa_local_alloc ? cons_place.cpu : -1;
+
+        for (std::size_t li = 0; li < n_legs; ++li) {
+            auto leg = std::make_unique<FeedLeg>();
+            leg->index = li;
+            leg->metrics = &w->metrics;
+
+            // Subscription manager (prefix, batching); "seg|token" keys keep their own segment
             auto token_fmt = [pref = opts.token_prefix](const std::string& t){
-                return pref.empty() ? t : (pref + t);
+                return pref.empty() || t.find('|') != std::string::npos ? t : (pref + t);
             };
-            w->sub = std::make_unique<SubscriptionManager>(
+            leg->sub = std::make_unique<SubscriptionManager>(
                 log, SubscriptionManager::Mode::LTP, opts.subscribe_batch_size, token_fmt);
-            if (!w->tokens.empty()) w->sub->add_many(w->tokens);
-
-            // Queue + Consumer
-            w->q = std::make_unique<IngestQueue>(1024 * 8); // 8k ring, tweak later if needed
-            w->cons = std::make_unique<Consumer>(*w->q, parser, store, log);
-
-            // WS client options
-            WebSocketClient::Options wopts;
-            wopts.verify_peer = opts.verify_peer;
-            wopts.ca_file = opts.ca_file;
-            wopts.headers = effective_headers_locked();
-            wopts.ping_interval = std::chrono::seconds(15);
-            wopts.conn_timeout = std::chrono::seconds(10);
-
-            // WS client
-            w->ws = std::make_unique<WebSocketClient>(opts.wss_url, log, wopts);
-
-            // Wire callbacks
-            w->ws->on_state([this](const std::string& s){
-                log.info(std::string("sharder/ws state=") + s);
+            if (!w->tokens.empty()) leg->sub->add_many(w->tokens);
+
+            const bool evict = opts.overload.policy == OverloadPolicy::DropOldest;
+            const bool on_cpu = run_on_cpu(alloc_cpu, [&leg, evict, timed = stage_timing()] {
+                leg->q = std::make_unique<IngestQueue>(1024 * 8, evict); // 8k ring, tweak later if needed
+                if (timed) leg->timing = std::make_unique<StageHistograms>();
             });
+            if (!on_cpu) log.warn_fmt("sharder shard={}: could not pin to cpu {} to allocate its ring", si, alloc_cpu);
+            const ShardMetrics& m = w->metrics;
+            leg->guard = std::make_unique<OverloadGuard>(
+                *leg->q, log, "shard " + std::to_string(si) + (li ? " leg b" : ""), opts.overload,
+                OverloadGuard::Counters{m.dropped, m.evicted, m.conflated, m.read_pauses});
+            w->legs.emplace_back(std::move(leg));
+        }
 
-            // Push raw frames into queue (drop if full)
-            IngestQueue& qref = *w->q;
-            Logger& lref = log;
-            w->ws->on_message([&qref, &lref](const std::string& msg){
-                if (!qref.try_push(msg)) {
-                    lref.warn("ingest queue full: dropped frame");
-                }
+        // Consumer(s): every leg of a shard goes to the same one, so one thread owns its arbiter
+        auto attach = [&](Consumer& c, FeedLeg& leg, bool first) {
+            Consumer::SourceOptions so;
+            so.arb = w->arb.get();
+            so.leg = leg.index;
+            so.timing = leg.timing.get();
+            so.metrics = w->metrics.consumer;
+            so.overload = leg.guard.get();
+            if (first) c.configure(so);
+            else       c.add_queue(*leg.q, so);
+        };
+        Consumer* target = nullptr;
+        bool fresh = false;
+        if (n_pooled == 0) {
+            w->cons = std::make_unique<Consumer>(*w->legs[0]->q, parser, store, log);
+            w->cons->set_placement(place.consumer, "consumer#" + std::to_string(si));
+            w->cons->set_rate_tracker(rates.get(), opts.token_prefix);
+            if (sink) w->cons->set_sink(sink);
+            target = w->cons.get();
+            fresh = true;
+        } else if (pooled_consumers.size() < n_pooled) {
+            auto c = std::make_unique<Consumer>(*w->legs[0]->q, parser, store, log);
+            c->set_placement(cons_place, "consumer#" + std::to_string(si));
+            c->set_rate_tracker(rates.get(), opts.token_prefix);
+            if (sink) c->set_sink(sink);
+            target = c.get();
+            fresh = true;
+            pooled_consumers.emplace_back(std::move(c));
+        } else {
+            target = pooled_consumers[si % n_pooled].get();
+        }
+        for (std::size_t li = 0; li < w->legs.size(); ++li) attach(*target, *w->legs[li], fresh && li == 0);
+
+        // WS client options
+        WebSocketClient::Options wopts;
+        wopts.verify_peer = opts.verify_peer;
+        wopts.ca_file = opts.ca_file;
+        wopts.headers = headers_for_locked(account);
+        wopts.ping_interval = std::chrono::seconds(15);
+        wopts.conn_timeout = std::chrono::seconds(10);
+        wopts.io_placement = place.io;
+        wopts.deflate = opts.deflate;
+        wopts.deflate_window_bits = opts.deflate_window_bits;
+        wopts.deflate_level = opts.deflate_level;
+        wopts.deflate_mem_level = opts.deflate_mem_level;
+        wopts.deflate_no_context_takeover = opts.deflate_no_context_takeover;
+        wopts.measure_read_cpu = opts.measure_read_cpu;
+        wopts.stamp_reads = stage_timing();
+
+        // WS clients (own IO thread, or multiplexed on the shared pool)
+        for (auto& leg : w->legs) {
+            const std::string& url = (leg->index == 1 && !opts.wss_url_b.empty()) ? opts.wss_url_b : opts.wss_url;
+            const std::string tag = std::string(leg->index == 1 ? "b" : "") + "#" + std::to_string(si);
+            auto make_ws = [&](const std::string& thread_name) {
+                auto o = wopts;
+                o.thread_name = thread_name;
+                if (io_pool) return std::make_unique<WebSocketClient>(url, log, o, *io_pool);
+                return std::make_unique<WebSocketClient>(url, log, o);
+            };
+            leg->ws = make_ws("ws-io" + tag);
+            if (opts.hot_standby) leg->standby = make_ws("ws-sb" + tag);
+            leg->active.store(leg->ws.get());
+
+            wire_ws_locked(*leg, *leg->ws, si, w->arb != nullptr, w->account);
+            if (leg->standby) wire_ws_locked(*leg, *leg->standby, si, w->arb != nullptr, w->account);
+
+            // Only the active connection of a leg with instruments is expected to stream
+            if (watchdog) {
+                FeedLeg* lp = leg.get();
+                FeedWatchdog::Target t;
+                t.name = "shard " + std::to_string(si) + " leg " + std::to_string(leg->index);
+                t.frames  = [lp] { return lp->live().stats().frames; };
+                t.armed   = [lp] { return lp->live().is_connected() && lp->sub->desired_count() > 0; };
+                t.recycle = [lp] { lp->live().recycle(); };
+                leg->watch_id = watchdog->watch(std::move(t));
+            }
+        }
+        return w;
+    }
+
+    // Callbacks of one of a leg's connections. Only the active one is subscribed and
+    // only its frames reach the leg's queue: the queue and guard take one producer,
+    // and a standby can still get unsolicited text (notices, a late frame). The
+    // active role passes between IO threads only in on_ws_down, on the old active's
+    // thread, so the acquire load below orders the new producer after the old one.
+    // With an arbiter, frames carry their arrival time for the A/B lead stats.
+    void wire_ws_locked(FeedLeg& leg, WebSocketClient& c, std::size_t si, bool stamped,
+                        const std::atomic<std::size_t>& account) {
+        FeedLeg* lp = &leg;
+        WebSocketClient* self = &c;
+        const std::atomic<std::size_t>* ap = &account;
+
+        c.on_state([this, lp, self, si, ap](const std::string& s){
+            ALPHA_LOG_RATE_LIMITED(log, LogLevel::INFO, 20, std::chrono::seconds(1), "sharder/ws state={}", s);
+            if (s == "reconnecting") {
+                lp->metrics->reconnects->inc();
+                on_ws_down(*lp, *self, si);
+            } else if (s == "connected" && ap->load() != kNoAccount) {
+                rearm_renew(ap->load());
+            }
+        });
+        // A refused handshake usually means the account's session was revoked
+        c.on_rejected([this, ap](unsigned status) {
+            if (status == 401 || status == 403) on_handshake_refused(ap->load());
+        });
+
+        // Copy raw frames straight from the WS buffer into the ring; a full ring is the guard's call
+        IngestQueue& qref = *leg.q;
+        OverloadGuard& guard = *leg.guard;
+        const bool timed = leg.timing != nullptr;
+        c.on_message_view([this, &qref, &guard, lp, self, si, stamped, timed](std::string_view msg){
+            if (lp->active.load(std::memory_order_acquire) != self) {
+                inactive_frames.fetch_add(1, std::memory_order_relaxed);
+                lp->metrics->inactive_frames->inc();
+                return;
+            }
+            IngestQueue::Stamp st;
+            if (stamped) st.arrival_ns = now_ns();
+            if (timed) {
+                st.read_tsc = self->read_tsc();
+                st.enqueue_tsc = tsc_now();
+            }
+            const ShardMetrics& m = *lp->metrics;
+            m.frames->inc();
+            m.bytes->inc(msg.size());
+            const bool queued = guard.offer(msg, st);
+            if (queued) m.queue_high_water->update_max(static_cast<std::int64_t>(qref.size()));
+            if (trace) {
+                ALPHA_BINLOG(*trace, LogLevel::TRACE, "frame shard={} leg={} bytes={} queued={}",
+                             si, lp->index, msg.size(), queued);
+            }
+            if (lp->down_since_ns.load(std::memory_order_relaxed) != 0) on_ws_data(*lp, *self, si);
+        });
+        if (guard.policy() == OverloadPolicy::Backpressure) {
+            c.set_read_gate([&guard] { return guard.ready(); });
+        }
+
+        // Small back-to-back (un)subscribe deltas ride in one frame, up to a full batch
+        const std::size_t batch = opts.subscribe_batch_size ? opts.subscribe_batch_size : 100;
+        c.set_coalescer([batch](std::string& pending, const std::string& next) {
+            return SubscriptionManager::merge_payloads(pending, next, batch);
+        });
+
+        // (Re)subscribe on every connect of the active connection: the server has no
+        // state for a fresh session. A (re)connected standby stays idle.
+        c.on_resubscribe([lp](WebSocketClient& ws){
+            if (lp->active.load() != &ws) return;
+            lp->sub->reset_active();
+            lp->sub->send_subscribe_batches([&ws](const std::string& p) { return ws.send_text(p); });
+        });
+    }
+
+    // Active connection dropped: promote a connected standby and replay the leg's
+    // subscriptions on it. Without one, the dropped connection's own reconnect
+    // resubscribes. The demoted connection reconnects in the background as standby.
+    void on_ws_down(FeedLeg& leg, WebSocketClient& c, std::size_t si) {
+        if (leg.active.load() != &c) return;             // standby dropped: nothing to do
+        std::int64_t zero = 0;
+        leg.down_since_ns.compare_exchange_strong(zero, now_ns());
+
+        WebSocketClient* other = (&c == leg.ws.get()) ? leg.standby.get() : leg.ws.get();
+        if (!other || !other->is_connected()) return;
+        WebSocketClient* expect = &c;
+        if (!leg.active.compare_exchange_strong(expect, other)) return;
+
+        failovers.fetch_add(1, std::memory_order_relaxed);
+        leg.metrics->failovers->inc();
+        leg.sub->reset_active();
+        leg.sub->send_subscribe_batches([other](const std::string& p) { return other->send_text(p); });
+        ALPHA_LOG_RATE_LIMITED(log, LogLevel::WARN, 10, std::chrono::seconds(1),
+                               "sharder failover shard={} leg={}: standby promoted", si, leg.index);
+    }
+
+    // First frame from the active connection after a drop ends the outage
+    void on_ws_data(FeedLeg& leg, WebSocketClient& c, std::size_t si) {
+        if (leg.active.load() != &c) return;
+        const std::int64_t since = leg.down_since_ns.exchange(0);
+        if (since == 0) return;
+        const std::int64_t us = (now_ns() - since) / 1000;
+        recoveries.fetch_add(1, std::memory_order_relaxed);
+        leg.metrics->recoveries->inc();
+        last_recover_us.store(us, std::memory_order_relaxed);
+        std::int64_t prev = max_recover_us.load(std::memory_order_relaxed);
+        while (us > prev && !max_recover_us.compare_exchange_weak(prev, us)) {}
+        ALPHA_LOG_RATE_LIMITED(log, LogLevel::INFO, 10, std::chrono::seconds(1),
+                               "sharder recovered shard={} leg={} in {}us", si, leg.index, us);
+    }
+
+    // Send only the pending adds/removes of one worker (every leg). A leg that is
+    // down keeps them pending: its reconnect resubscribes everything desired.
+    static void sync_subscriptions(Worker& w) {
+        for (auto& leg : w.legs) {
+            WebSocketClient& ws = leg->live();
+            auto send = [&ws](const std::string& p) { return ws.send_text(p); };
+            leg->sub->send_unsubscribe_batches(send);
+            leg->sub->send_subscribe_batches(send);
+        }
+    }
+
+    // Diff the new universe against the live assignment and apply it in place:
+    // removals and additions go to the owning workers as targeted (un)subscribe
+    // batches; new workers are started only for tokens that no shard has room for.
+    void reshard_live_locked() {
+        const std::unordered_set<std::string> want(desired_tokens.begin(), desired_tokens.end());
+
+        std::unordered_set<std::string> have;
+        std::size_t removed = 0;
+        for (auto& w : workers) {
+            auto& toks = w->tokens;
+            auto keep_end = std::remove_if(toks.begin(), toks.end(), [&](const std::string& t) {
+                if (want.count(t)) return false;
+                w->sub_remove(t);
+                ++removed;
+                return true;
             });
+            toks.erase(keep_end, toks.end());
+            have.insert(toks.begin(), toks.end());
+        }
 
-            // Resubscribe on reconnect
-            SubscriptionManager& subref = *w->sub;
-            WebSocketClient* wsptr = w->ws.get();
-            w->ws->on_resubscribe([&subref, wsptr](WebSocketClient&){
-                // Build and send subscribe batches again
-                for (const auto& payload : subref.build_subscribe_batches()) {
-                    wsptr->send_text(payload);
-                }
+        std::vector<std::string> added;
+        for (const auto& t : desired_tokens) {
+            if (have.insert(t).second) added.push_back(t);
+        }
+        auto use = account_use_locked();
+
+        // Fill spare capacity of existing shards first: first fit, or the
+        // least-loaded shard with room when load-aware (hottest tokens first)
+        std::vector<std::string> rest;
+        if (rates) {
+            std::vector<double> load;
+            for (auto& w : workers) load.push_back(load_of(*w));
+            std::stable_sort(added.begin(), added.end(), [&](const std::string& a, const std::string& b) {
+                return rates->rate(a) > rates->rate(b);
             });
+            for (const auto& t : added) {
+                std::size_t best = workers.size();
+                for (std::size_t i = 0; i < workers.size(); ++i) {
+                    if (worker_room(*workers[i], use) == 0) continue;
+                    if (best == workers.size() || load[i] < load[best]) best = i;
+                }
+                if (best == workers.size()) { rest.push_back(t); continue; }
+                workers[best]->tokens.push_back(t);
+                workers[best]->sub_add(t);
+                add_use(*workers[best], use, 1, false);
+                load[best] += rates->rate(t);
+            }
+        } else {
+            std::size_t next = 0;
+            for (auto& w : workers) {
+                while (next < added.size() && worker_room(*w, use) > 0) {
+                    w->tokens.push_back(added[next]);
+                    w->sub_add(added[next]);
+                    add_use(*w, use, 1, false);
+                    ++next;
+                }
+            }
+            rest.assign(added.begin() + static_cast<std::ptrdiff_t>(next), added.end());
+        }
+        for (auto& w : workers) sync_subscriptions(*w);
 
+        // Overflow -> new shards, started right away
+        const std::size_t first_new = workers.size();
+        auto shards = assign_shards(rest);
+        std::vector<std::size_t> homes;
+        if (accounts) {
+            unplaced.clear();
+            place_shards_locked(shards, homes, use);
+        }
+        const auto plan = plan_placement(first_new + shards.size());
+        for (std::size_t i = 0; i < shards.size(); ++i) {
+            const std::size_t pooled_before = pooled_consumers.size();
+            auto w = make_worker_locked(first_new + i, shards[i], plan, homes.empty() ? kNoAccount : homes[i]);
+            if (w->cons) w->cons->start();
+            if (pooled_consumers.size() > pooled_before) pooled_consumers.back()->start();
+            w->start_ws();  // subscribes from on_resubscribe once connected
             workers.emplace_back(std::move(w));
         }
+        worker_count.store(workers.size());
+
+        log.info_fmt("sharder reshard: +{} -{} tokens, new_workers={} workers={}",
+                     added.size(), removed, shards.size(), workers.size());
     }
 
-    void send_initial_subscribes() {
+    // Move hot tokens from the most to the least loaded shard until the hottest is
+    // within opts.rebalance_threshold of the mean. Receivers subscribe before donors
+    // unsubscribe, so a moved instrument is briefly duplicated rather than missing.
+    std::size_t rebalance_locked() {
+        if (!rates || workers.size() < 2) return 0;
+
+        std::vector<double> load;
+        double total = 0;
+        std::size_t total_tokens = 0;
         for (auto& w : workers) {
-            if (!w->ws) continue;
-            // On connect, WebSocketClient already fires "connected" state.
-            // We also explicitly send now in case state hook order varies.
-            for (const auto& payload : w->sub->build_subscribe_batches()) {
-                w->ws->send_text(payload);
+            load.push_back(load_of(*w));
+            total += load.back();
+            total_tokens += w->tokens.size();
+        }
+        const double mean = total / static_cast<double>(workers.size());
+        if (mean <= 0) return 0;
+        auto use = account_use_locked();
+
+        const std::size_t max_moves = std::max<std::size_t>(1, total_tokens / 10);
+        std::vector<bool> gained(workers.size(), false), lost(workers.size(), false);
+        std::size_t moved = 0;
+        while (moved < max_moves) {
+            std::size_t hot = 0, cold = workers.size();
+            for (std::size_t i = 0; i < workers.size(); ++i) {
+                if (load[i] > load[hot]) hot = i;
+                if (worker_room(*workers[i], use) > 0 && (cold == workers.size() || load[i] < load[cold])) cold = i;
+            }
+            if (cold == workers.size() || cold == hot) break;
+            if (load[hot] <= opts.rebalance_threshold * mean) break;
+
+            // hottest token whose move strictly lowers the pair's peak
+            auto& src = workers[hot]->tokens;
+            const double gap = load[hot] - load[cold];
+            std::size_t pick = src.size();
+            double pick_rate = 0;
+            for (std::size_t i = 0; i < src.size(); ++i) {
+                const double r = rates->rate(src[i]);
+                if (r > 0 && r < gap && r > pick_rate) { pick = i; pick_rate = r; }
             }
+            if (pick == src.size()) break;
+
+            const std::string tok = src[pick];
+            src.erase(src.begin() + static_cast<std::ptrdiff_t>(pick));
+            workers[hot]->sub_remove(tok);
+            workers[cold]->tokens.push_back(tok);
+            workers[cold]->sub_add(tok);
+            if (workers[hot]->account < use.size()) use[workers[hot]->account].subs -= legs_per_shard();
+            add_use(*workers[cold], use, 1, false);
+            load[hot] -= pick_rate;
+            load[cold] += pick_rate;
+            gained[cold] = lost[hot] = true;
+            ++moved;
         }
+
+        for (std::size_t i = 0; i < workers.size(); ++i) if (gained[i]) sync_subscriptions(*workers[i]);
+        for (std::size_t i = 0; i < workers.size(); ++i) if (lost[i])   sync_subscriptions(*workers[i]);
+        if (moved) log.info_fmt("sharder rebalance: moved {} tokens", moved);
+        return moved;
+    }
+
+    void start_rebalancer() {
+        if (!rates || opts.rebalance_interval.count() <= 0) return;
+        rb_stop = false;
+        rebalancer = std::thread([this] {
+            std::unique_lock<std::mutex> lk(rb_mu);
+            while (!rb_cv.wait_for(lk, opts.rebalance_interval, [this] { return rb_stop; })) {
+                lk.unlock();
+                {
+                    std::lock_guard<std::mutex> g(mu);
+                    if (running.load()) rebalance_locked();
+                }
+                lk.lock();
+            }
+        });
+    }
+
+    void stop_rebalancer() {
+        {
+            std::lock_guard<std::mutex> lk(rb_mu);
+            rb_stop = true;
+        }
+        rb_cv.notify_all();
+        if (rebalancer.joinable()) rebalancer.join();
     }
 };
 
@@ -151,37 +925,82 @@ Sharder::Sharder(Logger& log, Parser& parser, LTPStore& store, Options opts)
     : impl_(new Impl(log, parser, store, std::move(opts))) {}
 
 Sharder::~Sharder() {
+    // before stop(): a running listener may be waiting for the lock
+    if (impl_->accounts) impl_->accounts->remove_listener(impl_->accounts_listener);
     stop();
+    impl_->stop_renewer();
     delete impl_;
 }
 
 void Sharder::set_access_token(const std::string& auth_header_value) {
     std::lock_guard<std::mutex> lk(impl_->mu);
     impl_->auth_header_value = auth_header_value;
-    // propagate to live workers (for future reconnects)
-    for (auto& w : impl_->workers) {
-        if (!w->ws) continue;
-        auto h = impl_->effective_headers_locked();
-        // rebuild headers on ws options via small trick: stop/start will pick new headers.
-        // For live connections, we rely on reconnect to apply updated headers.
-        (void)h;
-    }
+    impl_->push_headers_locked();
+}
+
+void Sharder::set_access_token(const std::string& auth_header_value,
+                               const std::map<std::string,std::string>& session_headers) {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    impl_->auth_header_value = auth_header_value;
+    impl_->session_headers = session_headers;
+    impl_->push_headers_locked();
 }
 
 void Sharder::set_common_headers(const std::map<std::string,std::string>& hdrs) {
     std::lock_guard<std::mutex> lk(impl_->mu);
     impl_->common_headers = hdrs;
+    impl_->push_headers_locked();
+}
+
+void Sharder::set_accounts(AccountPool& pool) {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    if (impl_->accounts) return;
+    impl_->accounts = &pool;
+    impl_->sessions = pool.sessions();
+    impl_->accounts_listener = pool.add_listener([im = impl_](std::size_t a) { im->on_account_event(a); });
+    impl_->start_renewer();
 }
 
 void Sharder::set_tokens(const std::vector<std::string>& tokens) {
     std::lock_guard<std::mutex> lk(impl_->mu);
-    impl_->desired_tokens = tokens;
+    // de-duplicate, keep first-seen order
+    std::unordered_set<std::string> seen;
+    const std::unordered_set<std::string> before(impl_->desired_tokens.begin(), impl_->desired_tokens.end());
+    impl_->desired_tokens.clear();
+    for (const auto& t : tokens) {
+        if (seen.insert(t).second) impl_->desired_tokens.push_back(t);
+    }
+    // Instruments that left keep no quote readers could take for a live one
+    std::vector<std::string> gone, back;
+    for (const auto& t : before) {
+        if (!seen.count(t)) gone.push_back(t);
+    }
+    for (const auto& t : impl_->desired_tokens) {
+        if (!before.count(t)) back.push_back(t);
+    }
+    impl_->store.retire(gone);
+    impl_->store.readmit(back);
     if (impl_->running.load()) {
-        // Re-slice live: update each worker's desired set (best-effort simple approach: rebuild workers)
-        // For simplicity and safety, rebuild the worker stack while stopped.
-        // Caller can call stop(); set_tokens(); start(); for a clean rebuild.
-        impl_->log.warn("set_tokens while running: changes will apply on next start()");
+        impl_->reshard_live_locked();
+    }
+}
+
+std::vector<std::string> Sharder::set_symbols(const InstrumentMaster& master, const std::vector<std::string>& specs) {
+    const std::string& pref = impl_->opts.token_prefix;
+    std::vector<std::string> tokens, missing;
+    tokens.reserve(specs.size());
+    for (const auto& spec : specs) {
+        const auto ins = master.find(spec);
+        if (!ins) {
+            missing.push_back(spec);
+            continue;
+        }
+        std::string key = InstrumentMaster::feed_key(*ins);
+        if (!pref.empty() && key.size() > pref.size() && key.compare(0, pref.size(), pref) == 0) key.erase(0, pref.size());
+        tokens.push_back(std::move(key));
     }
+    set_tokens(tokens);
+    return missing;
 }
 
 bool Sharder::start() {
@@ -189,42 +1008,53 @@ bool Sharder::start() {
     if (impl_->running.load()) return true;
 
     // Build workers from current tokens/headers
+    if (impl_->accounts) impl_->sessions = impl_->accounts->sessions();
+    impl_->ensure_rates_locked();
     impl_->build_workers_locked();
 
     // Start consumers first so queues are drained
     for (auto& w : impl_->workers) {
         if (w->cons) w->cons->start();
     }
+    for (auto& c : impl_->pooled_consumers) c->start();
+    if (impl_->io_pool) impl_->io_pool->start();
 
-    // Start websockets
+    // Start websockets; each subscribes its shard from on_resubscribe once connected
     for (auto& w : impl_->workers) {
-        if (w->ws) {
-            // Also set a resubscribe that uses the worker-local SubscriptionManager (already wired)
-            w->ws->start();
-        }
+        w->start_ws();
     }
-
-    // Initial subscribe payloads
-    impl_->send_initial_subscribes();
+    impl_->start_rebalancer();
+    if (impl_->watchdog) impl_->watchdog->start();
 
     impl_->running.store(true);
     return true;
 }
 
 void Sharder::stop() {
+    impl_->stop_rebalancer(); // takes mu itself
     std::lock_guard<std::mutex> lk(impl_->mu);
     if (!impl_->running.load()) return;
 
-    // Stop websockets first
-    for (auto& w : impl_->workers) {
-        if (w->ws) w->ws->stop();
+    // No recycles while connections are torn down
+    if (impl_->watchdog) {
+        impl_->watchdog->stop();
+        for (auto& w : impl_->workers)
+            for (auto& leg : w->legs) impl_->watchdog->unwatch(leg->watch_id);
     }
+
+    // Stop websockets first
+    for (auto& w : impl_->workers) w->stop_ws();
+    if (impl_->io_pool) impl_->io_pool->stop();
     // Then consumers
     for (auto& w : impl_->workers) {
         if (w->cons) w->cons->stop();
     }
+    for (auto& c : impl_->pooled_consumers) c->stop();
 
     impl_->workers.clear();
+    impl_->pooled_consumers.clear();
+    impl_->io_pool.reset();
+    impl_->worker_count.store(0);
     impl_->running.store(false);
 }
 
@@ -233,7 +1063,7 @@ bool Sharder::running() const noexcept {
 }
 
 std::size_t Sharder::num_workers() const noexcept {
-    return impl_->workers.size();
+    return impl_->worker_count.load();
 }
 
 std::vector<std::string> Sharder::desired_tokens_snapshot() const {
@@ -241,11 +1071,125 @@ std::vector<std::string> Sharder::desired_tokens_snapshot() const {
     return impl_->desired_tokens;
 }
 
+std::vector<Sharder::AccountLoad> Sharder::account_loads() const {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    std::vector<AccountLoad> out(impl_->sessions.size());
+    for (std::size_t a = 0; a < out.size(); ++a) {
+        out[a].name = impl_->sessions[a].name;
+        out[a].up = impl_->sessions[a].up;
+    }
+    for (const auto& w : impl_->workers) {
+        if (w->account >= out.size()) continue;
+        auto& l = out[w->account];
+        ++l.shards;
+        l.connections += impl_->conns_per_shard();
+        l.tokens += w->tokens.size() * impl_->legs_per_shard();
+    }
+    return out;
+}
+
+std::vector<std::string> Sharder::unplaced_tokens() const {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    return impl_->unplaced;
+}
+
+void Sharder::set_metrics(MetricsRegistry& registry) {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    impl_->metrics = &registry;
+}
+
+MetricsRegistry& Sharder::metrics() noexcept { return *impl_->metrics; }
+
+void Sharder::set_trace_log(BinaryLogger& trace) {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    impl_->trace = &trace;
+}
+
+void Sharder::set_sink(std::function<void(const LTP&)> fn) {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    impl_->sink = std::move(fn);
+}
+
+void Sharder::set_rate_hint(const std::string& token, double msgs_per_sec) {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    impl_->ensure_rates_locked();
+    if (impl_->rates) impl_->rates->seed(token, msgs_per_sec);
+}
+
+std::size_t Sharder::rebalance_now() {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    if (!impl_->running.load()) return 0;
+    return impl_->rebalance_locked();
+}
+
+Sharder::RecoveryStats Sharder::recovery_stats() const noexcept {
+    RecoveryStats st;
+    st.failovers  = impl_->failovers.load(std::memory_order_relaxed);
+    st.recoveries = impl_->recoveries.load(std::memory_order_relaxed);
+    st.inactive_frames = impl_->inactive_frames.load(std::memory_order_relaxed);
+    st.last_recover = std::chrono::microseconds(impl_->last_recover_us.load(std::memory_order_relaxed));
+    st.max_recover  = std::chrono::microseconds(impl_->max_recover_us.load(std::memory_order_relaxed));
+    return st;
+}
+
+OverloadGuard::Stats Sharder::overload_stats() const {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    OverloadGuard::Stats sum;
+    for (auto& w : impl_->workers) {
+        for (auto& l : w->legs) {
+            const auto st = l->guard->stats();
+            sum.dropped += st.dropped;
+            sum.evicted += st.evicted;
+            sum.conflated += st.conflated;
+            sum.parked += st.parked;
+            sum.read_pauses += st.read_pauses;
+        }
+    }
+    return sum;
+}
+
+FeedArbiter::Stats Sharder::arbiter_stats() const {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    FeedArbiter::Stats sum;
+    for (auto& w : impl_->workers) {
+        if (!w->arb) continue;
+        const auto st = w->arb->stats();
+        for (std::size_t i = 0; i < FeedArbiter::kLegs; ++i) {
+            auto& o = sum.legs[i];
+            const auto& l = st.legs[i];
+            o.forwarded += l.forwarded;
+            o.duplicates += l.duplicates;
+            o.wins += l.wins;
+            o.lead_ns_total += l.lead_ns_total;
+            o.lead_ns_max = std::max(o.lead_ns_max, l.lead_ns_max);
+        }
+        sum.stale += st.stale;
+    }
+    return sum;
+}
+
+std::vector<StageHistograms::Summaries> Sharder::stage_latency() const {
+    std::lock_guard<std::mutex> lk(impl_->mu);
+    std::vector<StageHistograms::Summaries> out;
+    out.reserve(impl_->workers.size());
+    for (auto& w : impl_->workers) {
+        StageHistograms merged;
+        for (auto& l : w->legs) if (l->timing) merged.merge_from(*l->timing);
+        out.push_back(merged.summaries());
+    }
+    return out;
+}
+
+FeedWatchdog::Stats Sharder::watchdog_stats() const {
+    return impl_->watchdog ? impl_->watchdog->stats() : FeedWatchdog::Stats{};
+}
+
 bool Sharder::debug_broadcast_text(const std::string& payload) {
+    std::lock_guard<std::mutex> lk(impl_->mu);
     if (!impl_->running.load()) return false;
     bool any = false;
     for (auto& w : impl_->workers) {
-        if (w->ws) { any = w->ws->send_text(payload) || any; }
+        for (auto& leg : w->legs) any = leg->live().send_text(payload) || any;
     }
     return any;
 }
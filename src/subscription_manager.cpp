@@ -88,6 +88,76 @@ void SubscriptionManager::mark_unsubscribed(const std::vector<std::string>& toke
     for (auto& t : tokens) active_.erase(t);
 }
 
+std::vector<std::string> SubscriptionManager::take_subscribe_batches() {
+    std::vector<std::string> need;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        need = diff_desired_minus_active();
+        for (auto& t : need) active_.insert(t);
+    }
+    std::vector<std::string> out;
+    for (auto& batch : make_batches(need)) {
+        out.push_back(build_payload(batch, /*subscribe=*/true));
+    }
+    return out;
+}
+
+std::vector<std::string> SubscriptionManager::take_unsubscribe_batches() {
+    std::vector<std::string> need;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        need = diff_active_minus_desired();
+        for (auto& t : need) active_.erase(t);
+    }
+    std::vector<std::string> out;
+    for (auto& batch : make_batches(need)) {
+        out.push_back(build_payload(batch, /*subscribe=*/false));
+    }
+    return out;
+}
+
+std::size_t SubscriptionManager::send_subscribe_batches(const SendFn& send) {
+    return send_batches(/*subscribe=*/true, send);
+}
+
+std::size_t SubscriptionManager::send_unsubscribe_batches(const SendFn& send) {
+    return send_batches(/*subscribe=*/false, send);
+}
+
+void SubscriptionManager::reset_active() {
+    std::lock_guard<std::mutex> lk(mu_);
+    active_.clear();
+}
+
+// {"action":"subscribe"|"unsubscribe","mode":"...","tokens":["..."]}, exactly as
+// build_payload() writes it. The coalescer sees every queued text frame, so
+// anything else (a probe, a hand-written frame) is left alone.
+static bool built_payload(const json& j) {
+    if (!j.is_object() || j.size() != 3) return false;
+    const auto action = j.find("action");
+    const auto mode = j.find("mode");
+    const auto tokens = j.find("tokens");
+    if (action == j.end() || !action->is_string() || mode == j.end() || !mode->is_string()) return false;
+    if (*action != "subscribe" && *action != "unsubscribe") return false;
+    if (tokens == j.end() || !tokens->is_array()) return false;
+    return std::all_of(tokens->begin(), tokens->end(), [](const json& t) { return t.is_string(); });
+}
+
+bool SubscriptionManager::merge_payloads(std::string& into, const std::string& next, std::size_t max_tokens) {
+    json a = json::parse(into, nullptr, /*allow_exceptions=*/false);
+    json b = json::parse(next, nullptr, /*allow_exceptions=*/false);
+    if (!built_payload(a) || !built_payload(b)) return false;
+    if (a["action"] != b["action"] || a["mode"] != b["mode"]) return false;
+
+    json& ta = a["tokens"];
+    json& tb = b["tokens"];
+    if (ta.size() + tb.size() > max_tokens) return false;
+
+    for (auto& t : tb) ta.push_back(std::move(t));
+    into = a.dump();
+    return true;
+}
+
 std::vector<std::string> SubscriptionManager::desired_snapshot() const {
     std::lock_guard<std::mutex> lk(mu_);
     std::vector<std::string> v; v.reserve(desired_.size());
@@ -95,6 +165,11 @@ std::vector<std::string> SubscriptionManager::desired_snapshot() const {
     return v;
 }
 
+std::size_t SubscriptionManager::desired_count() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return desired_.size();
+}
+
 std::vector<std::string> SubscriptionManager::active_snapshot() const {
     std::lock_guard<std::mutex> lk(mu_);
     std::vector<std::string> v; v.reserve(active_.size());
@@ -129,6 +204,38 @@ std::string SubscriptionManager::build_payload(const std::vector<std::string>& b
     return j.dump();
 }
 
+std::size_t SubscriptionManager::send_batches(bool subscribe, const SendFn& send) {
+    // Claim the delta up front, as take_*_batches() does, so a concurrent call
+    // doesn't send it too; send() runs outside mu_.
+    std::vector<std::vector<std::string>> batches;
+    std::vector<std::string> payloads;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        const auto need = subscribe ? diff_desired_minus_active() : diff_active_minus_desired();
+        for (auto& t : need) {
+            if (subscribe) active_.insert(t);
+            else           active_.erase(t);
+        }
+        batches = make_batches(need);
+        for (auto& batch : batches) payloads.push_back(build_payload(batch, subscribe));
+    }
+
+    std::size_t sent = 0;
+    while (sent < payloads.size() && send(payloads[sent])) ++sent;
+    if (sent == payloads.size()) return sent;
+
+    std::lock_guard<std::mutex> lk(mu_);
+    for (std::size_t i = sent; i < batches.size(); ++i) {
+        for (auto& t : batches[i]) {
+            if (subscribe) active_.erase(t);
+            else if (!desired_.count(t)) active_.insert(t);   // still to be removed
+        }
+    }
+    log_.debug_fmt("[sub] {} of {} {} batches not sent, left pending", batches.size() - sent, batches.size(),
+                   subscribe ? "subscribe" : "unsubscribe");
+    return sent;
+}
+
 std::string SubscriptionManager::mode_string() const {
     switch (mode_) {
         case Mode::LTP:   return "ltp";
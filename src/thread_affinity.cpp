@@ -0,0 +1,251 @@
+// src/thread_affinity.cpp
+#include "thread_affinity.h"
+#include "logger.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+const char* kCpuRoot  = "/sys/devices/system/cpu";
+const char* kNodeRoot = "/sys/devices/system/node";
+
+std::string read_first_line(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    if (in) std::getline(in, line);
+    return line;
+}
+
+int to_sched_policy(ThreadPlacement::Policy p) {
+    switch (p) {
+        case ThreadPlacement::Policy::FIFO: return SCHED_FIFO;
+        case ThreadPlacement::Policy::RR:   return SCHED_RR;
+        case ThreadPlacement::Policy::OTHER: break;
+    }
+    return SCHED_OTHER;
+}
+
+const char* policy_name(int policy) {
+    switch (policy) {
+        case SCHED_FIFO: return "fifo";
+        case SCHED_RR:   return "rr";
+        default:         return "other";
+    }
+}
+
+std::string format_cpu_set(const cpu_set_t& set) {
+    std::ostringstream oss;
+    bool first = true;
+    for (int c = 0; c < CPU_SETSIZE; ++c) {
+        if (!CPU_ISSET(c, &set)) continue;
+        // collapse runs: 0,1,2,3 -> 0-3
+        int end = c;
+        while (end + 1 < CPU_SETSIZE && CPU_ISSET(end + 1, &set)) ++end;
+        if (!first) oss << ',';
+        first = false;
+        oss << c;
+        if (end > c) oss << '-' << end;
+        c = end;
+    }
+    return oss.str();
+}
+
+} // namespace
+
+// ---- per-thread placement ---------------------------------------------------
+
+bool apply_thread_placement(const ThreadPlacement& p, Logger& log, const std::string& thread_name) {
+    bool ok = true;
+
+    if (p.pinned()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(p.cpu, &set);
+        if (int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); rc != 0) {
+            log.warn("[affinity] " + thread_name + ": pin to cpu " + std::to_string(p.cpu) +
+                     " failed: " + std::strerror(rc));
+            ok = false;
+        }
+    }
+
+    if (p.policy != ThreadPlacement::Policy::OTHER) {
+        sched_param sp{};
+        sp.sched_priority = std::clamp(p.priority, 1, 99);
+        if (int rc = pthread_setschedparam(pthread_self(), to_sched_policy(p.policy), &sp); rc != 0) {
+            log.warn("[affinity] " + thread_name + ": real-time policy failed: " + std::strerror(rc));
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+std::string describe_thread_placement(const std::string& thread_name) {
+    std::ostringstream oss;
+    const int cpu = sched_getcpu();
+    oss << thread_name << " cpu=" << cpu;
+
+    static const CpuTopology topo = CpuTopology::detect();
+    oss << " node=" << topo.numa_node(cpu);
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+        oss << " allowed=" << format_cpu_set(set);
+    }
+
+    int policy = SCHED_OTHER;
+    sched_param sp{};
+    if (pthread_getschedparam(pthread_self(), &policy, &sp) == 0) {
+        oss << " policy=" << policy_name(policy);
+        if (policy != SCHED_OTHER) oss << '/' << sp.sched_priority;
+    }
+    return oss.str();
+}
+
+bool run_on_cpu(int cpu, const std::function<void()>& fn) {
+    if (cpu < 0) { fn(); return true; }
+    bool pinned = false;
+    std::thread t([cpu, &fn, &pinned] {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pinned = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+        fn();
+    });
+    t.join();
+    return pinned;
+}
+
+// ---- CpuTopology ------------------------------------------------------------
+
+std::vector<int> CpuTopology::parse_cpu_list(const std::string& s) {
+    std::vector<int> out;
+    std::stringstream ss(s);
+    std::string part;
+    while (std::getline(ss, part, ',')) {
+        if (part.empty()) continue;
+        try {
+            auto dash = part.find('-');
+            if (dash == std::string::npos) {
+                out.push_back(std::stoi(part));
+            } else {
+                int lo = std::stoi(part.substr(0, dash));
+                int hi = std::stoi(part.substr(dash + 1));
+                for (int c = lo; c <= hi; ++c) out.push_back(c);
+            }
+        } catch (...) { /* ignore malformed ranges */ }
+    }
+    return out;
+}
+
+CpuTopology CpuTopology::detect() {
+    CpuTopology t;
+    const std::string root = kCpuRoot;
+
+    t.online_ = parse_cpu_list(read_first_line(root + "/online"));
+    if (t.online_.empty()) {
+        const unsigned n = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned c = 0; c < n; ++c) t.online_.push_back(static_cast<int>(c));
+    }
+    t.isolated_ = parse_cpu_list(read_first_line(root + "/isolated"));
+
+    // Only the cpus the process may use (the main thread's mask, as launched)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(getpid(), sizeof(allowed), &allowed) == 0) {
+        const auto usable = [&allowed](int c) { return c >= 0 && c < CPU_SETSIZE && CPU_ISSET(c, &allowed); };
+        std::vector<int> online;
+        for (int c : t.online_) if (usable(c)) online.push_back(c);
+        if (!online.empty()) {
+            t.online_ = std::move(online);
+            t.isolated_.erase(std::remove_if(t.isolated_.begin(), t.isolated_.end(),
+                                             [&usable](int c) { return !usable(c); }),
+                              t.isolated_.end());
+        }
+    }
+
+    const int max_cpu = *std::max_element(t.online_.begin(), t.online_.end());
+    t.node_of_.assign(static_cast<std::size_t>(max_cpu) + 1, -1);
+    t.l3_of_.assign(static_cast<std::size_t>(max_cpu) + 1, -1);
+
+    // NUMA nodes: node<N>/cpulist
+    for (int node = 0; node < 1024; ++node) {
+        const std::string list = read_first_line(std::string(kNodeRoot) + "/node" + std::to_string(node) + "/cpulist");
+        if (list.empty()) {
+            if (node > 0) break;      // node ids are dense in practice
+            continue;
+        }
+        for (int c : parse_cpu_list(list)) {
+            if (c >= 0 && c <= max_cpu) t.node_of_[static_cast<std::size_t>(c)] = node;
+        }
+    }
+
+    // L3 domains: cache/index<K>/level == 3 -> shared_cpu_list
+    for (int c : t.online_) {
+        for (int idx = 0; idx < 8; ++idx) {
+            const std::string base = root + "/cpu" + std::to_string(c) + "/cache/index" + std::to_string(idx);
+            const std::string level = read_first_line(base + "/level");
+            if (level.empty()) break;
+            if (level != "3") continue;
+            auto shared = parse_cpu_list(read_first_line(base + "/shared_cpu_list"));
+            if (!shared.empty()) t.l3_of_[static_cast<std::size_t>(c)] = *std::min_element(shared.begin(), shared.end());
+            break;
+        }
+    }
+    return t;
+}
+
+int CpuTopology::numa_node(int cpu) const {
+    if (cpu < 0 || static_cast<std::size_t>(cpu) >= node_of_.size()) return -1;
+    return node_of_[static_cast<std::size_t>(cpu)];
+}
+
+int CpuTopology::l3_id(int cpu) const {
+    if (cpu < 0 || static_cast<std::size_t>(cpu) >= l3_of_.size()) return -1;
+    return l3_of_[static_cast<std::size_t>(cpu)];
+}
+
+std::vector<std::pair<int,int>> CpuTopology::plan_pairs(std::size_t n) const {
+    std::vector<std::pair<int,int>> out;
+    if (n == 0 || online_.empty()) return out;
+
+    // Candidate order: isolated cpus first, then the rest of the online set.
+    std::vector<int> cands = isolated_;
+    for (int c : online_) {
+        if (std::find(cands.begin(), cands.end(), c) == cands.end()) cands.push_back(c);
+    }
+
+    // Group by L3 domain, keeping candidate order inside each group.
+    std::map<int, std::vector<int>> by_l3;
+    std::vector<int> l3_order;
+    for (int c : cands) {
+        const int id = l3_id(c);
+        if (!by_l3.count(id)) l3_order.push_back(id);
+        by_l3[id].push_back(c);
+    }
+
+    std::vector<std::pair<int,int>> pairs;
+    std::vector<int> leftovers;
+    for (int id : l3_order) {
+        auto& g = by_l3[id];
+        std::size_t i = 0;
+        for (; i + 1 < g.size(); i += 2) pairs.emplace_back(g[i], g[i + 1]);
+        if (i < g.size()) leftovers.push_back(g[i]);
+    }
+    // cross-L3 pairs only once same-L3 pairs are exhausted
+    for (std::size_t i = 0; i + 1 < leftovers.size(); i += 2) pairs.emplace_back(leftovers[i], leftovers[i + 1]);
+    if (pairs.empty()) pairs.emplace_back(cands.front(), cands.front()); // single-cpu box
+
+    out.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) out.push_back(pairs[i % pairs.size()]);
+    return out;
+}
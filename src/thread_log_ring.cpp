@@ -0,0 +1,288 @@
+// src/thread_log_ring.cpp
+#include "thread_log_ring.h"
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace logring {
+
+const char* level_name(LogLevel lvl) noexcept {
+    switch (lvl) {
+        case LogLevel::TRACE: return "TRACE";
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO:  return "INFO";
+        case LogLevel::WARN:  return "WARN";
+        case LogLevel::ERROR: return "ERROR";
+    }
+    return "?";
+}
+
+std::int64_t wall_ns() noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+namespace {
+
+// Asymmetric fence for the producer/stop handshake. Without membarrier(2)
+// producers fall back to a seq_cst store.
+bool membarrier_ready() noexcept {
+#if defined(__linux__) && defined(SYS_membarrier)
+    static const bool ok = syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0;
+    return ok;
+#else
+    return false;
+#endif
+}
+
+void heavy_barrier() noexcept {
+#if defined(__linux__) && defined(SYS_membarrier)
+    if (membarrier_ready() && syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0) == 0) return;
+#endif
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+std::size_t round_up(std::size_t n, std::size_t a) noexcept { return (n + a - 1) / a * a; }
+
+std::size_t pow2_at_least(std::size_t n) noexcept {
+    std::size_t p = 1024;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+std::atomic<std::uint64_t> g_owner_ids{1};
+
+} // namespace
+
+// One producer thread's records: [Header][payload] padded to kAlign, never split
+// across the end of the buffer (a pad header, tag 0, fills the tail instead)
+struct ThreadRings::Ring {
+    struct Header {
+        std::uint32_t len;       // payload bytes
+        std::uint32_t tag;       // 0 = pad
+        std::uint64_t tsc;
+    };
+    static constexpr std::size_t kAlign = sizeof(Header);
+
+    explicit Ring(std::size_t cap) : buf(cap), mask(cap - 1) {}
+
+    std::vector<char> buf;
+    const std::size_t mask;
+    alignas(64) std::atomic<std::size_t> head{0};   // producer
+    alignas(64) std::atomic<std::size_t> tail{0};   // writer
+    alignas(64) std::atomic<bool> busy{false};      // producer is between reserve() and commit()
+    std::atomic<bool> retired{false};               // producer thread exited after its last commit
+    std::atomic<bool> orphaned{false};              // owner destroyed
+};
+
+namespace {
+
+// Rings of the calling thread, keyed by owner id (ids are never reused). Shared
+// with the owner: whichever of the thread and the owner goes last frees the ring.
+// At thread exit every ring is retired, so its owner frees it once drained.
+struct TlsRing {
+    std::uint64_t id;
+    std::shared_ptr<ThreadRings::Ring> ring;
+};
+
+thread_local bool tls_exited = false;   // trivially destructible: still readable after ~TlsRings
+
+struct TlsRings {
+    std::vector<TlsRing> v;
+    ~TlsRings();
+};
+thread_local TlsRings tls_rings;
+
+} // namespace
+
+TlsRings::~TlsRings() {
+    tls_exited = true;      // a later thread_local destructor that logs gets Closed
+    for (auto& e : v) e.ring->retired.store(true, std::memory_order_release);
+}
+
+ThreadRings::ThreadRings(std::atomic<bool>& accepting)
+    : id_(g_owner_ids.fetch_add(1, std::memory_order_relaxed)), accepting_(accepting) {}
+
+ThreadRings::~ThreadRings() {
+    stop();
+    // threads still alive drop their entries for these rings on their next miss
+    for (auto& r : rings_) r->orphaned.store(true, std::memory_order_relaxed);
+}
+
+ThreadRings::Ring* ThreadRings::ring_for_this_thread() {
+    if (tls_exited) return nullptr;
+    auto& v = tls_rings.v;
+    for (const auto& e : v) {
+        if (e.id == id_) return e.ring.get();
+    }
+    auto orphaned = [](const TlsRing& e) { return e.ring->orphaned.load(std::memory_order_relaxed); };
+    v.erase(std::remove_if(v.begin(), v.end(), orphaned), v.end());
+    auto r = std::make_shared<Ring>(pow2_at_least(opts_.ring_bytes));
+    {
+        std::lock_guard<std::mutex> lk(rings_mu_);
+        rings_.push_back(r);
+    }
+    v.push_back(TlsRing{id_, r});
+    return r.get();
+}
+
+std::size_t ThreadRings::max_payload() {
+    const Ring* r = ring_for_this_thread();
+    return r ? (r->mask + 1) / 4 - sizeof(Ring::Header) : 0;
+}
+
+std::size_t ThreadRings::ring_count() {
+    std::lock_guard<std::mutex> lk(rings_mu_);
+    return rings_.size();
+}
+
+ThreadRings::Reserve ThreadRings::reserve(std::uint32_t tag, std::size_t payload, Reservation& res) {
+    Ring* rp = ring_for_this_thread();
+    if (!rp) return Reserve::Closed;             // thread exiting
+    Ring& r = *rp;
+    // Dekker handshake with stop(): either it sees busy, or we see !accepting
+    if (light_fence_) {
+        r.busy.store(true, std::memory_order_relaxed);
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    } else {
+        r.busy.store(true, std::memory_order_seq_cst);
+    }
+    if (!accepting_.load(std::memory_order_seq_cst)) {
+        r.busy.store(false, std::memory_order_release);
+        return Reserve::Closed;
+    }
+    const std::size_t cap = r.mask + 1;
+    const std::size_t need = round_up(sizeof(Ring::Header) + payload, Ring::kAlign);
+    if (need > cap / 4) {
+        r.busy.store(false, std::memory_order_release);
+        return Reserve::Dropped;
+    }
+    std::size_t head = r.head.load(std::memory_order_relaxed);
+    const std::size_t to_end = cap - (head & r.mask);
+    const std::size_t total = need + (to_end < need ? to_end : 0);
+    for (;;) {
+        const std::size_t tail = r.tail.load(std::memory_order_acquire);
+        if (cap - (head - tail) >= total) break;
+        if (!opts_.block_when_full || !accepting_.load(std::memory_order_relaxed)) {
+            r.busy.store(false, std::memory_order_release);
+            return Reserve::Dropped;
+        }
+        std::this_thread::yield();
+    }
+    if (to_end < need) {
+        const Ring::Header pad{0, 0, 0};
+        std::memcpy(&r.buf[head & r.mask], &pad, sizeof(pad));
+        head += to_end;
+    }
+    const Ring::Header h{static_cast<std::uint32_t>(payload), tag, tsc_now()};
+    char* p = &r.buf[head & r.mask];
+    std::memcpy(p, &h, sizeof(h));
+    res.ring = &r;
+    res.data = p + sizeof(h);
+    res.next = head + need;
+    return Reserve::Ok;
+}
+
+void ThreadRings::commit(const Reservation& res) noexcept {
+    Ring& r = *static_cast<Ring*>(res.ring);
+    r.head.store(res.next, std::memory_order_release);
+    r.busy.store(false, std::memory_order_release);
+}
+
+void ThreadRings::take(std::vector<Record>& recs, std::string& staging) {
+    {
+        std::lock_guard<std::mutex> lk(rings_mu_);
+        snapshot_.clear();
+        for (auto& r : rings_) snapshot_.push_back(r.get());
+    }
+    bool any_retired = false;
+    for (Ring* r : snapshot_) {
+        // read before head: a retired ring's head is final
+        const bool retired = r->retired.load(std::memory_order_acquire);
+        any_retired = any_retired || retired;
+        std::size_t t = r->tail.load(std::memory_order_relaxed);
+        const std::size_t h = r->head.load(std::memory_order_acquire);
+        while (t != h) {
+            Ring::Header hd;
+            std::memcpy(&hd, &r->buf[t & r->mask], sizeof(hd));
+            if (hd.tag == 0) {
+                t += (r->mask + 1) - (t & r->mask);
+                continue;
+            }
+            recs.push_back(Record{hd.tsc, hd.tag, staging.size(), hd.len});
+            staging.append(&r->buf[(t & r->mask) + sizeof(hd)], hd.len);
+            t += round_up(sizeof(hd) + hd.len, Ring::kAlign);
+        }
+        r->tail.store(t, std::memory_order_release);
+    }
+    if (any_retired) {
+        // drained above and never written again: free the rings of exited threads
+        std::lock_guard<std::mutex> lk(rings_mu_);
+        auto drained = [](const std::shared_ptr<Ring>& r) {
+            return r->retired.load(std::memory_order_acquire)
+                && r->tail.load(std::memory_order_relaxed) == r->head.load(std::memory_order_acquire);
+        };
+        rings_.erase(std::remove_if(rings_.begin(), rings_.end(), drained), rings_.end());
+    }
+    std::stable_sort(recs.begin(), recs.end(), [](const Record& a, const Record& b) { return a.tsc < b.tsc; });
+}
+
+void ThreadRings::start(const Options& opts, std::function<void()> pass) {
+    if (thr_.joinable()) return;
+    opts_ = opts;
+    pass_ = std::move(pass);
+    stop_ = false;
+    light_fence_ = membarrier_ready();
+    tsc_ns_per_tick();       // calibrate here, not on the writer's first pass
+    thr_ = std::thread([this] {
+        std::unique_lock<std::mutex> lk(mu_);
+        for (;;) {
+            cv_.wait_for(lk, opts_.poll_interval, [this] { return stop_ || flush_req_ != flush_done_; });
+            const bool last = stop_;
+            const std::uint64_t target = flush_req_;
+            lk.unlock();
+            pass_();
+            lk.lock();
+            flush_done_ = target;
+            cv_.notify_all();
+            if (last) return;
+        }
+    });
+    accepting_.store(true, std::memory_order_seq_cst);
+}
+
+void ThreadRings::stop() {
+    if (!thr_.joinable()) return;
+    accepting_.store(false, std::memory_order_seq_cst);
+    heavy_barrier();
+    // wait out producers that saw accepting == true
+    {
+        std::lock_guard<std::mutex> lk(rings_mu_);
+        for (auto& r : rings_) {
+            while (r->busy.load(std::memory_order_seq_cst)) std::this_thread::yield();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    thr_.join();             // its last pass drains what is left
+}
+
+void ThreadRings::flush() {
+    std::unique_lock<std::mutex> lk(mu_);
+    if (!thr_.joinable() || stop_) return;
+    const std::uint64_t req = ++flush_req_;
+    cv_.notify_all();
+    cv_.wait(lk, [&] { return flush_done_ >= req; });
+}
+
+} // namespace logring
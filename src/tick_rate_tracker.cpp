@@ -0,0 +1,129 @@
+// src/tick_rate_tracker.cpp
+#include "tick_rate_tracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+std::int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::uint64_t hash_token(std::string_view t) noexcept {
+    return std::hash<std::string_view>{}(t);
+}
+
+} // namespace
+
+TickRateTracker::TickRateTracker(std::chrono::seconds half_life, std::size_t width, std::size_t depth)
+    : width_(width ? width : 4096),
+      depth_(depth ? depth : 4),
+      lambda_(std::log(2.0) / static_cast<double>(std::max<std::int64_t>(1, half_life.count()))),
+      cells_(new std::atomic<std::uint32_t>[width_ * depth_]),
+      last_decay_ns_(now_ns()),
+      decay_step_(std::chrono::seconds(1)) {
+    for (std::size_t i = 0; i < width_ * depth_; ++i) cells_[i].store(0, std::memory_order_relaxed);
+}
+
+std::size_t TickRateTracker::width_for(std::size_t n_tokens) noexcept {
+    std::size_t w = 4096;
+    while (w < 4 * n_tokens) w <<= 1;
+    return w;
+}
+
+std::size_t TickRateTracker::slot(std::uint64_t h, std::size_t row) const noexcept {
+    // Kirsch-Mitzenmacher: row hashes derived from two halves of one hash
+    const std::uint64_t h1 = h & 0xffffffffu;
+    const std::uint64_t h2 = (h >> 32) | 1u;
+    return row * width_ + static_cast<std::size_t>((h1 + row * h2) % width_);
+}
+
+void TickRateTracker::record(std::string_view token) noexcept {
+    const std::uint64_t h = hash_token(token);
+    for (std::size_t r = 0; r < depth_; ++r) {
+        cells_[slot(h, r)].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TickRateTracker::seed(std::string_view token, double msgs_per_sec) {
+    if (msgs_per_sec <= 0) return;
+    // steady state of a decayed counter fed at rate r is r / lambda
+    const double want = std::min(msgs_per_sec / lambda_,
+                                 static_cast<double>(std::numeric_limits<std::uint32_t>::max() / 2));
+    const std::uint64_t h = hash_token(token);
+    for (std::size_t r = 0; r < depth_; ++r) {
+        auto& c = cells_[slot(h, r)];
+        const auto cur = c.load(std::memory_order_relaxed);
+        if (cur < want) c.fetch_add(static_cast<std::uint32_t>(want - cur), std::memory_order_relaxed);
+    }
+}
+
+double TickRateTracker::rate(std::string_view token) const {
+    maybe_decay();
+    const std::uint64_t h = hash_token(token);
+    std::uint32_t est = std::numeric_limits<std::uint32_t>::max();
+    for (std::size_t r = 0; r < depth_; ++r) {
+        est = std::min(est, cells_[slot(h, r)].load(std::memory_order_relaxed));
+    }
+    return static_cast<double>(est) * lambda_;
+}
+
+void TickRateTracker::maybe_decay() const {
+    if (now_ns() - last_decay_ns_.load(std::memory_order_relaxed) >= decay_step_.count()) {
+        apply_decay();
+    }
+}
+
+void TickRateTracker::decay() { apply_decay(); }
+
+void TickRateTracker::apply_decay() const {
+    const std::int64_t now = now_ns();
+    std::int64_t prev = last_decay_ns_.load(std::memory_order_relaxed);
+    // one caller applies a given interval
+    if (now <= prev || !last_decay_ns_.compare_exchange_strong(prev, now)) return;
+
+    const double dt = static_cast<double>(now - prev) / 1e9;
+    const double keep = std::exp(-lambda_ * dt);
+    for (std::size_t i = 0; i < width_ * depth_; ++i) {
+        auto& c = cells_[i];
+        const std::uint32_t v = c.load(std::memory_order_relaxed);
+        if (v == 0) continue;
+        // subtract instead of store, so concurrent record() increments are not lost
+        const auto drop = static_cast<std::uint32_t>(static_cast<double>(v) * (1.0 - keep));
+        if (drop) c.fetch_sub(drop, std::memory_order_relaxed);
+    }
+}
+
+std::vector<std::vector<std::string>>
+TickRateTracker::assign(const std::vector<std::string>& tokens, std::size_t max_per_conn) const {
+    std::vector<std::vector<std::string>> out;
+    if (tokens.empty()) return out;
+    if (max_per_conn == 0) max_per_conn = 800;
+    const std::size_t bins = (tokens.size() + max_per_conn - 1) / max_per_conn;
+    out.resize(bins);
+
+    std::vector<double> w(tokens.size());
+    for (std::size_t i = 0; i < tokens.size(); ++i) w[i] = rate(tokens[i]);
+
+    std::vector<std::size_t> order(tokens.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return w[a] > w[b]; });
+
+    std::vector<double> load(bins, 0.0);
+    for (std::size_t i : order) {
+        std::size_t best = bins;
+        for (std::size_t b = 0; b < bins; ++b) {
+            if (out[b].size() >= max_per_conn) continue;
+            if (best == bins || load[b] < load[best] ||
+                (load[b] == load[best] && out[b].size() < out[best].size())) best = b;
+        }
+        out[best].push_back(tokens[i]);
+        load[best] += w[i];
+    }
+    return out;
+}
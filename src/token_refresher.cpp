@@ -0,0 +1,157 @@
+// src/token_refresher.cpp
+#include "token_refresher.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace {
+
+using SysClock = std::chrono::system_clock;
+
+long long seconds_until(SysClock::time_point t, SysClock::time_point now) {
+    return std::chrono::duration_cast<std::chrono::seconds>(t - now).count();
+}
+
+} // namespace
+
+TokenRefresher::TokenRefresher(Auth& auth, Logger& log, Options opts)
+    : auth_(auth), log_(log), opts_(std::move(opts)) {}
+
+TokenRefresher::~TokenRefresher() { stop(); }
+
+void TokenRefresher::add_listener(Listener l) {
+    // not interleaved with a renewal, so the listener sees every token in order
+    std::lock_guard<std::mutex> rk(renew_mu_);
+    const Auth::Tokens t = auth_.tokens();
+    if (!t.access_token.empty()) l(t);
+    std::lock_guard<std::mutex> lk(mu_);
+    listeners_.push_back(std::move(l));
+}
+
+SysClock::time_point TokenRefresher::due(const Auth::Tokens& t, SysClock::time_point now) const {
+    if (t.access_token.empty()) return now;
+    if (t.expires_at != SysClock::time_point{}) return t.expires_at - opts_.lead;
+    if (opts_.unknown_expiry_interval.count() > 0) return last_ok_ + opts_.unknown_expiry_interval;
+    return SysClock::time_point::max();
+}
+
+bool TokenRefresher::start() {
+    if (thr_.joinable()) return true;
+    const auto now = SysClock::now();
+    bool ok = true;
+    bool now_due;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        last_ok_ = now;              // the current token counts as fresh for unknown expiry
+        stats_.next = due(auth_.tokens(), now);
+        now_due = stats_.next <= now;
+    }
+    if (now_due) {
+        std::lock_guard<std::mutex> rk(renew_mu_);
+        ok = renew();
+    }
+    {
+        std::lock_guard<std::mutex> lk(run_mu_);
+        stop_ = false;
+    }
+    thr_ = std::thread([this] { run(); });
+    return ok;
+}
+
+void TokenRefresher::stop() {
+    {
+        std::lock_guard<std::mutex> lk(run_mu_);
+        stop_ = true;
+    }
+    run_cv_.notify_all();
+    if (thr_.joinable()) thr_.join();
+}
+
+bool TokenRefresher::refresh_now() {
+    std::lock_guard<std::mutex> rk(renew_mu_);
+    return renew();
+}
+
+TokenRefresher::Stats TokenRefresher::stats() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return stats_;
+}
+
+void TokenRefresher::run() {
+    std::unique_lock<std::mutex> lk(run_mu_);
+    while (!stop_) {
+        const auto now = SysClock::now();
+        const auto next = stats().next;
+        if (now >= next) {
+            lk.unlock();
+            {
+                std::lock_guard<std::mutex> rk(renew_mu_);
+                // refresh_now() may have renewed meanwhile
+                if (SysClock::now() >= stats().next) renew();
+            }
+            lk.lock();
+            continue;
+        }
+        // short waits: the wall clock can jump (suspend, NTP) and expiry is wall-clock time
+        const auto wait = std::min<SysClock::duration>(next - now, std::chrono::seconds(1));
+        run_cv_.wait_for(lk, wait, [this] { return stop_; });
+    }
+}
+
+bool TokenRefresher::renew() {
+    bool ok = false;
+    bool relogged = false;
+    try {
+        ok = auth_.refresh();
+    } catch (const std::exception& e) {
+        log_.warn_fmt("[auth] token refresh: {}", e.what());
+    }
+    if (!ok && opts_.relogin) {
+        // the refresh token is dead once the session has expired: log in again
+        const Auth::Tokens t = auth_.tokens();
+        const bool expired = t.refresh_token.empty()
+                          || (t.expires_at != SysClock::time_point{} && SysClock::now() >= t.expires_at);
+        if (expired) {
+            try {
+                ok = relogged = opts_.relogin(auth_);
+            } catch (const std::exception& e) {
+                log_.warn_fmt("[auth] relogin: {}", e.what());
+            }
+        }
+    }
+
+    const auto now = SysClock::now();
+    const Auth::Tokens t = auth_.tokens();
+    std::vector<Listener> listeners;
+    SysClock::time_point next;
+    int in_row;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (ok) {
+            ++stats_.refreshes;
+            if (relogged) ++stats_.relogins;
+            failures_in_row_ = 0;
+            last_ok_ = now;
+            stats_.next = std::max(due(t, now), now + opts_.min_interval);
+            listeners = listeners_;
+        } else {
+            ++stats_.failures;
+            ++failures_in_row_;
+            auto delay = opts_.retry_initial;
+            for (int i = 1; i < failures_in_row_ && delay < opts_.retry_max; ++i) delay *= 2;
+            stats_.next = now + std::min(delay, opts_.retry_max);
+        }
+        next = stats_.next;
+        in_row = failures_in_row_;
+    }
+    if (!ok) {
+        log_.warn_fmt("[auth] token renewal failed ({} in a row), retry in {}ms", in_row,
+                      static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count()));
+        return false;
+    }
+    for (const auto& l : listeners) l(t);
+    log_.info_fmt("[auth] token {}, next refresh in {}s", relogged ? "renewed by login" : "refreshed",
+                  next == SysClock::time_point::max() ? -1LL : seconds_until(next, now));
+    return true;
+}
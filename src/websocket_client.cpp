@@ -1,5 +1,7 @@
 #include "websocket_client.h"
 #include "logger.h"
+#include "alloc_counter.h"
+#include "latency_histogram.h"
 
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
@@ -8,41 +10,265 @@
 #include <boost/beast/websocket.hpp>
 #include <boost/beast/websocket/ssl.hpp>
 
+#include <openssl/bio.h>
+#include <openssl/ssl.h>
+#include <time.h>
+
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <vector>
 
 namespace asio      = boost::asio;
 namespace beast     = boost::beast;
 namespace websocket = beast::websocket;
 using tcp = asio::ip::tcp;
 
+using ws_stream = websocket::stream<beast::ssl_stream<beast::tcp_stream>>;
+
+// ---- IoContextPool ----
+
+struct IoContextPool::Impl {
+    using work_guard = asio::executor_work_guard<asio::io_context::executor_type>;
+
+    Logger& log;
+    Options opts;
+    std::vector<std::unique_ptr<asio::io_context>> contexts;
+    std::vector<work_guard> guards;
+    std::vector<std::thread> threads;
+    std::atomic<std::size_t> next{0};
+    std::atomic<bool> running{false};
+
+    Impl(Logger& l, Options o) : log(l), opts(std::move(o)) {
+        if (opts.threads == 0) opts.threads = 1;
+        for (std::size_t i = 0; i < opts.threads; ++i)
+            contexts.push_back(std::make_unique<asio::io_context>(1));
+    }
+
+    // Round-robin assignment of connections to contexts
+    asio::io_context& pick() {
+        return *contexts[next.fetch_add(1) % contexts.size()];
+    }
+};
+
+IoContextPool::IoContextPool(Logger& log) : IoContextPool(log, Options{}) {}
+
+IoContextPool::IoContextPool(Logger& log, Options opts)
+    : impl_(new Impl(log, std::move(opts))) {}
+
+IoContextPool::~IoContextPool() {
+    stop();
+    delete impl_;
+}
+
+bool IoContextPool::start() {
+    if (impl_->running.exchange(true)) return true;
+    for (std::size_t i = 0; i < impl_->contexts.size(); ++i) {
+        auto& ioc = *impl_->contexts[i];
+        ioc.restart();
+        impl_->guards.emplace_back(asio::make_work_guard(ioc));
+        ThreadPlacement place;
+        if (!impl_->opts.placement.empty()) place = impl_->opts.placement[i % impl_->opts.placement.size()];
+        const std::string name = impl_->opts.thread_name + "#" + std::to_string(i);
+        impl_->threads.emplace_back([this, &ioc, place, name] {
+            apply_thread_placement(place, impl_->log, name);
+            impl_->log.info("[ws] placement " + describe_thread_placement(name));
+            ioc.run();
+        });
+    }
+    return true;
+}
+
+void IoContextPool::stop() {
+    if (!impl_->running.exchange(false)) return;
+    impl_->guards.clear();
+    for (auto& c : impl_->contexts) c->stop();
+    for (auto& t : impl_->threads) if (t.joinable()) t.join();
+    impl_->threads.clear();
+}
+
+bool IoContextPool::running() const noexcept { return impl_->running.load(); }
+std::size_t IoContextPool::size() const noexcept { return impl_->contexts.size(); }
+
+// ---- WebSocketClient ----
+
 struct WebSocketClient::Impl {
     std::string url;
     Logger& log;
     Options opts;
 
     MessageCallback on_msg;
+    MessageViewCallback on_msg_view;
     StateCallback   on_state;
+    RejectedFn      on_reject;
     std::function<void()> on_resub_noarg; // wrapper to invoke user ResubscribeFn
 
-    asio::io_context ioc;
+    asio::io_context ioc{1};                        // own context (thread-per-connection mode)
     asio::ssl::context ssl_ctx{asio::ssl::context::tls_client};
-    std::unique_ptr<websocket::stream<beast::ssl_stream<beast::tcp_stream>>> ws;
 
     std::thread io_thread;
     std::atomic<bool> running{false};
     std::atomic<bool> connected{false};
 
+    // read-path counters (written by the IO thread only)
+    std::atomic<std::uint64_t> frames{0};
+    std::atomic<std::uint64_t> rx_bytes{0};
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> read_cpu_ns{0};
+    std::uint64_t cur_read_tsc = 0;     // strand only (Options::stamp_reads)
+    // TLS byte counts: totals of earlier sessions + the live session's BIO counters
+    std::atomic<std::uint64_t> rx_wire{0}, tx_wire{0}, tx_bytes{0};
+    std::uint64_t rx_wire_base = 0, tx_wire_base = 0;   // IO thread only
+    std::atomic<bool> deflate_on{false};
+
+    // Both modes run the same async state machine on a strand; thread-per-connection
+    // mode just gives it a private io_context and thread.
+    IoContextPool* pool = nullptr;
+    std::optional<asio::strand<asio::io_context::executor_type>> strand;
+    std::shared_ptr<ws_stream> ws;                  // current stream (strand only)
+    std::unique_ptr<tcp::resolver> resolver;
+    std::unique_ptr<asio::steady_timer> retry_timer;
+    bool retry_pending = false;                 // strand only: retry_timer armed
+    std::chrono::milliseconds backoff{0};
+    std::string host, port, target;
+    beast::flat_buffer rbuf;
+
+    struct PendingWrite { std::string data; bool text; };
+    std::deque<PendingWrite> write_q;               // strand only; front() is in flight
+    CoalesceFn coalesce;
+    ReadGateFn read_gate;                           // strand only
+    std::unique_ptr<asio::steady_timer> gate_timer;
+    std::atomic<std::uint64_t> read_pauses{0};
+    std::atomic<std::size_t> q_depth{0}, q_peak{0};
+    std::atomic<std::uint64_t> coalesced{0};
+
+    // In-flight async operations; stop() waits for this to drain
+    std::mutex ops_mu;
+    std::condition_variable ops_cv;
+    int ops = 0;
+
+    // Handshake headers: opts.headers, then whatever set_headers() swapped in
+    mutable std::mutex headers_mu;
+    std::map<std::string,std::string> headers;
+
     Impl(std::string u, Logger& l, Options o)
-        : url(std::move(u)), log(l), opts(std::move(o)) {}
+        : url(std::move(u)), log(l), opts(std::move(o)), headers(opts.headers) {
+        init_strand(ioc);
+    }
+
+    Impl(std::string u, Logger& l, Options o, IoContextPool& p)
+        : url(std::move(u)), log(l), opts(std::move(o)), pool(&p), headers(opts.headers) {
+        init_strand(p.impl_->pick());
+    }
+
+    void init_strand(asio::io_context& ctx) {
+        strand.emplace(asio::make_strand(ctx));
+        resolver = std::make_unique<tcp::resolver>(*strand);
+        retry_timer = std::make_unique<asio::steady_timer>(*strand);
+        gate_timer = std::make_unique<asio::steady_timer>(*strand);
+    }
+
+    // Thread-per-connection mode: run the private context until every op has drained
+    void run_own_thread() {
+        apply_thread_placement(opts.io_placement, log, opts.thread_name);
+        log.info("[ws] placement " + describe_thread_placement(opts.thread_name));
+        ioc.run();
+    }
+
+    bool context_running() const {
+        return pool ? pool->running() : !ioc.stopped();
+    }
 
     void notify_state(const std::string& s) {
         if (on_state) on_state(s);
-        log.info("[ws] state=" + s);
+        // a reconnect storm across many connections must not turn into a log storm
+        ALPHA_LOG_RATE_LIMITED(log, LogLevel::INFO, 20, std::chrono::seconds(1), "[ws] state={}", s);
+    }
+
+    // Hand one frame to the callbacks. The view variant reads straight out of the
+    // reused flat_buffer; only the legacy std::string callback copies.
+    void dispatch(const beast::flat_buffer& buf) {
+        const auto data = buf.data();
+        const std::size_t n = data.size();
+        if (on_msg_view) on_msg_view(std::string_view(static_cast<const char*>(data.data()), n));
+        else if (on_msg) on_msg(beast::buffers_to_string(data));
+        frames.store(frames.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        rx_bytes.store(rx_bytes.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void count_allocs(std::uint64_t since) {
+#ifdef ALPHA_COUNT_ALLOCS
+        allocations.fetch_add(AllocCounter::thread_allocations() - since, std::memory_order_relaxed);
+#else
+        (void)since;
+#endif
+    }
+
+    static std::uint64_t thread_cpu_ns() noexcept {
+        timespec ts{};
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return static_cast<std::uint64_t>(ts.tv_sec) * 1'000'000'000ull + static_cast<std::uint64_t>(ts.tv_nsec);
+    }
+
+    // Refresh wire counters from the session's OpenSSL BIOs (bytes of TLS records,
+    // i.e. after deflate on the way out and before inflate on the way in)
+    void sample_wire(ws_stream& s) noexcept {
+        SSL* ssl = s.next_layer().native_handle();
+        if (!ssl) return;
+        if (BIO* r = SSL_get_rbio(ssl)) rx_wire.store(rx_wire_base + BIO_number_read(r), std::memory_order_relaxed);
+        if (BIO* w = SSL_get_wbio(ssl)) tx_wire.store(tx_wire_base + BIO_number_written(w), std::memory_order_relaxed);
+    }
+
+    // A new session starts counting from zero; fold the old one into the base
+    void begin_session() noexcept {
+        rx_wire_base = rx_wire.load(std::memory_order_relaxed);
+        tx_wire_base = tx_wire.load(std::memory_order_relaxed);
+        deflate_on.store(false, std::memory_order_relaxed);
+    }
+
+    // WS-layer options shared by both modes: timeouts, headers, permessage-deflate
+    void configure_ws(ws_stream& s) {
+        s.set_option(websocket::stream_base::timeout::suggested(beast::role_type::client));
+        s.set_option(websocket::stream_base::decorator([this](websocket::request_type& req) {
+            std::lock_guard<std::mutex> lk(headers_mu);
+            for (const auto& kv : headers) req.set(kv.first, kv.second);
+        }));
+        if (opts.deflate) {
+            websocket::permessage_deflate pmd;
+            pmd.client_enable = true;
+            pmd.client_max_window_bits = std::clamp(opts.deflate_window_bits, 9, 15);
+            pmd.server_max_window_bits = std::clamp(opts.deflate_window_bits, 9, 15);
+            pmd.client_no_context_takeover = opts.deflate_no_context_takeover;
+            pmd.server_no_context_takeover = opts.deflate_no_context_takeover;
+            pmd.compLevel = std::clamp(opts.deflate_level, 0, 9);
+            pmd.memLevel = std::clamp(opts.deflate_mem_level, 1, 9);
+            s.set_option(pmd);
+        }
+    }
+
+    // Record what the server agreed to in the upgrade response
+    void on_handshake_response(const websocket::response_type& res) {
+        const auto ext = res[beast::http::field::sec_websocket_extensions];
+        const bool on = ext.find("permessage-deflate") != beast::string_view::npos;
+        deflate_on.store(on, std::memory_order_relaxed);
+        if (opts.deflate) {
+            if (on) log.info_fmt("[ws] permessage-deflate: {}", std::string_view(ext.data(), ext.size()));
+            else log.info("[ws] permessage-deflate declined by server");
+        }
+    }
+
+    // The server answered the upgrade with something other than 101
+    void on_handshake_rejected(const websocket::response_type& res) {
+        log.warn_fmt("[ws] handshake refused: HTTP {}", res.result_int());
+        if (on_reject) on_reject(res.result_int());
     }
 
     static void parse_wss(const std::string& full, std::string& host, std::string& port, std::string& target) {
@@ -61,117 +287,236 @@ struct WebSocketClient::Impl {
         }
     }
 
-    bool connect_once() {
-        try {
-            notify_state("connecting");
-
-            std::string host, port, target;
-            parse_wss(url, host, port, target);
+    // ---- connection state machine (strand) ----
+
+    // RAII marker for one in-flight async op (handler body counts as part of it)
+    struct OpGuard {
+        Impl* self;
+        explicit OpGuard(Impl* s) : self(s) {}
+        ~OpGuard() { self->op_end(); }
+    };
+    void op_begin() { std::lock_guard<std::mutex> lk(ops_mu); ++ops; }
+    void op_end() {
+        std::lock_guard<std::mutex> lk(ops_mu);
+        if (--ops == 0) ops_cv.notify_all();
+    }
 
-            // TLS
-            ssl_ctx.set_default_verify_paths();
-            if (!opts.ca_file.empty()) ssl_ctx.load_verify_file(opts.ca_file);
-            ssl_ctx.set_verify_mode(opts.verify_peer ? asio::ssl::verify_peer : asio::ssl::verify_none);
+    void setup_tls() {
+        ssl_ctx.set_default_verify_paths();
+        if (!opts.ca_file.empty()) ssl_ctx.load_verify_file(opts.ca_file);
+        ssl_ctx.set_verify_mode(opts.verify_peer ? asio::ssl::verify_peer : asio::ssl::verify_none);
+    }
 
-            // DNS + TCP connect
-            tcp::resolver resolver(ioc);
-            auto results = resolver.resolve(host, port);
+    void run() {
+        try {
+            parse_wss(url, host, port, target);
+            setup_tls();
+        } catch (const std::exception& e) {
+            log.error_fmt("[ws] connect failed: {}", e.what());
+            notify_state("failed");
+            return;
+        }
+        backoff = opts.backoff_initial;
+        op_begin();
+        asio::post(*strand, [this] { OpGuard g(this); do_connect(); });
+    }
 
-            ws = std::make_unique<websocket::stream<beast::ssl_stream<beast::tcp_stream>>>(ioc, ssl_ctx);
+    void do_connect() {
+        if (!running.load()) return;
+        notify_state("connecting");
+        ws = std::make_shared<ws_stream>(*strand, ssl_ctx);
+        begin_session();
+
+        op_begin();
+        resolver->async_resolve(host, port,
+            [this, s = ws](beast::error_code ec, tcp::resolver::results_type results) {
+                OpGuard g(this);
+                if (ec) return on_async_error("resolve", ec);
+                beast::get_lowest_layer(*s).expires_after(opts.conn_timeout);
+                op_begin();
+                beast::get_lowest_layer(*s).async_connect(results,
+                    [this, s](beast::error_code ec, const tcp::endpoint&) {
+                        OpGuard g(this);
+                        if (ec) return on_async_error("connect", ec);
+                        on_tcp_connected(s);
+                    });
+            });
+    }
 
-            // Connect timeout at TCP layer
-            beast::get_lowest_layer(*ws).expires_after(opts.conn_timeout);
-            asio::connect(beast::get_lowest_layer(*ws).socket(), results.begin(), results.end());
+    void on_tcp_connected(const std::shared_ptr<ws_stream>& s) {
+        if (!SSL_set_tlsext_host_name(s->next_layer().native_handle(), host.c_str()))
+            return on_async_error("sni", beast::error_code(asio::error::invalid_argument));
+
+        op_begin();
+        s->next_layer().async_handshake(asio::ssl::stream_base::client,
+            [this, s](beast::error_code ec) {
+                OpGuard g(this);
+                if (ec) return on_async_error("tls handshake", ec);
+
+                // websocket layer owns timeouts from here on
+                beast::get_lowest_layer(*s).expires_never();
+                configure_ws(*s);
+
+                op_begin();
+                auto res = std::make_shared<websocket::response_type>();
+                s->async_handshake(*res, host, target, [this, s, res](beast::error_code ec) {
+                    OpGuard g(this);
+                    if (ec) {
+                        if (ec == websocket::error::upgrade_declined) on_handshake_rejected(*res);
+                        return on_async_error("ws handshake", ec);
+                    }
+                    on_handshake_response(*res);
+                    sample_wire(*s);
+                    s->text(true);
+                    backoff = opts.backoff_initial;
+                    connected.store(true);
+                    notify_state("connected");
+                    if (on_resub_noarg) on_resub_noarg();
+                    do_read(s);
+                });
+            });
+    }
 
-            // SNI
-            if (!SSL_set_tlsext_host_name(ws->next_layer().native_handle(), host.c_str()))
-                throw std::runtime_error("SNI set failed");
+    void do_read(const std::shared_ptr<ws_stream>& s) {
+        if (!running.load()) return;
+        rbuf.clear();                                   // keeps capacity
+        const auto allocs0 = AllocCounter::thread_allocations();
+        const auto cpu0 = opts.measure_read_cpu ? thread_cpu_ns() : 0;
+        op_begin();
+        s->async_read(rbuf, [this, s, allocs0, cpu0](beast::error_code ec, std::size_t) {
+            OpGuard g(this);
+            sample_wire(*s);
+            if (ec) return on_async_error("read", ec);
+            if (kStageTimingCompiled && opts.stamp_reads) cur_read_tsc = tsc_now();
+            // includes other handlers run on this context while the read was pending
+            if (opts.measure_read_cpu) read_cpu_ns.fetch_add(thread_cpu_ns() - cpu0, std::memory_order_relaxed);
+            dispatch(rbuf);
+            count_allocs(allocs0);  // exact when this context serves one connection
+            if (read_gate && !read_gate()) {
+                read_pauses.fetch_add(1, std::memory_order_relaxed);
+                return wait_gate(s);
+            }
+            do_read(s);
+        });
+    }
 
-            // TLS handshake
-            ws->next_layer().handshake(asio::ssl::stream_base::client);
+    // Reads stay parked (the socket buffers fill and TCP pushes back) until the gate opens
+    void wait_gate(const std::shared_ptr<ws_stream>& s) {
+        gate_timer->expires_after(opts.read_gate_poll);
+        op_begin();
+        gate_timer->async_wait([this, s](beast::error_code ec) {
+            OpGuard g(this);
+            if (ec || !running.load()) return;
+            // a recycled/closed socket reads on so the failure starts the reconnect
+            const bool open = beast::get_lowest_layer(*s).socket().is_open();
+            if (open && read_gate && !read_gate()) return wait_gate(s);
+            do_read(s);
+        });
+    }
 
-            // WS options + headers via decorator
-            ws->set_option(websocket::stream_base::timeout::suggested(beast::role_type::client));
-            ws->set_option(websocket::stream_base::decorator([this](websocket::request_type& req) {
-                for (const auto& kv : this->opts.headers) req.set(kv.first, kv.second);
-            }));
+    void on_async_error(const char* what, beast::error_code ec) {
+        const bool was_connected = connected.exchange(false);
+        clear_write_q();
+        if (!running.load()) return; // stopping -> exit silently
+
+        if (was_connected && ec == websocket::error::closed) notify_state("closed");
+        else ALPHA_LOG_RATE_LIMITED(log, LogLevel::WARN, 10, std::chrono::seconds(1),
+                                    "[ws] {} error: {}", what, ec.message());
+        notify_state("reconnecting");
+        if (ws) {
+            beast::error_code ignored;
+            beast::get_lowest_layer(*ws).socket().close(ignored);
+        }
 
-            // WS handshake
-            ws->handshake(host, target);
-            ws->text(true);
+        retry_timer->expires_after(backoff);
+        backoff = std::min(std::max(backoff * 2, opts.backoff_initial), opts.backoff_max);
+        retry_pending = true;
+        op_begin();
+        retry_timer->async_wait([this](beast::error_code ec) {
+            OpGuard g(this);
+            retry_pending = false;
+            // cancelled by recycle() while running: reconnect now
+            if (!running.load() || (ec && ec != asio::error::operation_aborted)) return;
+            do_connect();
+        });
+    }
 
-            connected.store(true);
-            notify_state("connected");
-            return true;
-        } catch (const std::exception& e) {
-            log.error(std::string("[ws] connect failed: ") + e.what());
-            connected.store(false);
-            return false;
-        }
+    void clear_write_q() {
+        write_q.clear();
+        q_depth.store(0, std::memory_order_relaxed);
     }
 
+    // Any thread: hand the frame to the strand and return without waiting for the socket
+    bool send(std::string data, bool text) {
+        if (!connected.load()) return false;
+        op_begin();
+        asio::post(*strand, [this, d = std::move(data), text]() mutable {
+            OpGuard g(this);
+            if (!connected.load() || !ws) return;
+            enqueue(std::move(d), text);
+        });
+        return true;
+    }
 
-    void read_loop() {
-    beast::flat_buffer buffer;
-    while (running.load()) {
-        beast::error_code ec;
-        buffer.clear();
-        ws->read(buffer, ec);
-        if (ec) {
-            if (!running.load()) break; // stopping → exit silently
-            if (ec == websocket::error::closed || ec == asio::error::operation_aborted) {
-                connected.store(false);
-                notify_state("closed");
-                break; // graceful close
-            }
-            log.warn(std::string("[ws] read error: ") + ec.message());
-            connected.store(false);
-            notify_state("reconnecting");
-            reconnect_loop();
-            break; // reconnect_loop will re-enter on success
+    void enqueue(std::string&& d, bool text) {
+        // front() is being written; anything behind it may still be merged
+        if (coalesce && text && write_q.size() > 1 && write_q.back().text && coalesce(write_q.back().data, d)) {
+            coalesced.fetch_add(1, std::memory_order_relaxed);
+            return;
         }
-        if (on_msg) on_msg(beast::buffers_to_string(buffer.data()));
+        write_q.push_back({std::move(d), text});
+        const std::size_t n = write_q.size();
+        q_depth.store(n, std::memory_order_relaxed);
+        if (n > q_peak.load(std::memory_order_relaxed)) q_peak.store(n, std::memory_order_relaxed);
+        if (n == 1) do_write(ws);
     }
-}
-
 
-
-    void reconnect_loop() {
-        auto backoff = opts.backoff_initial;
-        while (running.load() && !connected.load()) {
-            if (connect_once()) {
-                if (on_resub_noarg) on_resub_noarg(); // user resubscribe hook
-                read_loop();
+    void do_write(const std::shared_ptr<ws_stream>& s) {
+        auto& front = write_q.front();
+        s->text(front.text);
+        op_begin();
+        s->async_write(asio::buffer(front.data), [this, s](beast::error_code ec, std::size_t n) {
+            OpGuard g(this);
+            sample_wire(*s);
+            if (ec) {                      // read side handles reconnect
+                if (s == ws) clear_write_q();
                 return;
             }
-            std::this_thread::sleep_for(backoff);
-            backoff = std::min(backoff * 2, opts.backoff_max);
-        }
-    }
-
-    void run() {
-        running.store(true);
-        if (!connect_once()) {
-            notify_state("reconnecting");
-            reconnect_loop();
-            return;
-        }
-        read_loop();
+            tx_bytes.fetch_add(n, std::memory_order_relaxed);
+            if (s != ws || write_q.empty()) return;
+            write_q.pop_front();
+            q_depth.store(write_q.size(), std::memory_order_relaxed);
+            if (!write_q.empty()) do_write(s);
+        });
     }
 
     void stop() {
-    running.store(false);
-    if (ws) {
-        beast::error_code ec;
-        // Request a normal WS close (this will make read() return with error::closed)
-        ws->close(websocket::close_code::normal, ec);
-        // Cancel any pending low-level ops and shutdown TCP
-        beast::get_lowest_layer(*ws).socket().cancel(ec);
-        beast::get_lowest_layer(*ws).socket().shutdown(tcp::socket::shutdown_both, ec);
+        running.store(false);
+        op_begin();
+        asio::post(*strand, [this] {
+            OpGuard g(this);
+            beast::error_code ec;
+            resolver->cancel();
+            retry_timer->cancel();
+            gate_timer->cancel();
+            if (ws) {
+                beast::get_lowest_layer(*ws).socket().cancel(ec);
+                beast::get_lowest_layer(*ws).socket().close(ec);
+            }
+            connected.store(false);
+        });
+        // Wait for every handler to run (contexts of a stopped pool never will)
+        {
+            std::unique_lock<std::mutex> lk(ops_mu);
+            while (ops != 0 && context_running()) {
+                ops_cv.wait_for(lk, std::chrono::milliseconds(50));
+            }
+        }
+        if (!pool) {
+            ioc.stop();
+            if (io_thread.joinable()) io_thread.join();
         }
-        ioc.stop();
     }
-
 };
 
 // ---- public API ----
@@ -185,44 +530,98 @@ WebSocketClient::WebSocketClient(std::string wss_url, Logger& log, Options opts)
       log_(log),
       opts_(impl_->opts) {}
 
+WebSocketClient::WebSocketClient(std::string wss_url, Logger& log, Options opts, IoContextPool& pool)
+    : impl_(new Impl(std::move(wss_url), log, std::move(opts), pool)),
+      url_(impl_->url),
+      log_(log),
+      opts_(impl_->opts) {}
+
 WebSocketClient::~WebSocketClient() {
     stop();
     delete impl_;
 }
 
 bool WebSocketClient::start() {
-    if (impl_->running.load()) return true;
-    impl_->io_thread = std::thread([this] { impl_->run(); });
+    if (impl_->running.exchange(true)) return true;
+    if (!impl_->pool) impl_->ioc.restart();
+    impl_->run();
+    if (!impl_->pool) impl_->io_thread = std::thread([this] { impl_->run_own_thread(); });
     return true;
 }
 
 void WebSocketClient::stop() {
     if (!impl_->running.load()) return;
     impl_->stop();
-    if (impl_->io_thread.joinable()) impl_->io_thread.join();
 }
 
 bool WebSocketClient::send_text(const std::string& payload) {
-    if (!impl_->ws || !impl_->connected.load()) return false;
-    try {
-        impl_->ws->text(true);
-        impl_->ws->write(asio::buffer(payload));
-        return true;
-    } catch (...) { return false; }
+    return impl_->send(payload, /*text=*/true);
 }
 
 bool WebSocketClient::send_binary(const void* data, size_t len) {
-    if (!impl_->ws || !impl_->connected.load()) return false;
-    try {
-        impl_->ws->binary(true);
-        impl_->ws->write(asio::buffer(data, len));
-        return true;
-    } catch (...) { return false; }
+    return impl_->send(std::string(static_cast<const char*>(data), len), /*text=*/false);
+}
+
+void WebSocketClient::recycle() {
+    if (!impl_->running.load()) return;
+    impl_->op_begin();
+    asio::post(*impl_->strand, [this] {
+        Impl::OpGuard g(impl_);
+        if (!impl_->connected.load() || !impl_->ws) {
+            if (impl_->retry_pending) impl_->retry_timer->cancel();   // skip the backoff wait
+            return;
+        }
+        impl_->log.warn("[ws] recycling session");
+        impl_->backoff = std::chrono::milliseconds(0);   // first retry immediately
+        beast::error_code ec;
+        beast::get_lowest_layer(*impl_->ws).socket().close(ec);  // pending read fails -> reconnect
+    });
+}
+
+void WebSocketClient::set_headers(std::map<std::string,std::string> headers) {
+    std::lock_guard<std::mutex> lk(impl_->headers_mu);
+    impl_->headers.swap(headers);
+}
+
+std::map<std::string,std::string> WebSocketClient::headers() const {
+    std::lock_guard<std::mutex> lk(impl_->headers_mu);
+    return impl_->headers;
+}
+
+void WebSocketClient::set_coalescer(CoalesceFn fn) {
+    asio::post(*impl_->strand, [this, f = std::move(fn)]() mutable { impl_->coalesce = std::move(f); });
+}
+
+void WebSocketClient::set_read_gate(ReadGateFn gate) {
+    asio::post(*impl_->strand, [this, g = std::move(gate)]() mutable { impl_->read_gate = std::move(g); });
 }
 
 void WebSocketClient::on_message(MessageCallback cb)   { impl_->on_msg = std::move(cb); }
+void WebSocketClient::on_message_view(MessageViewCallback cb) { impl_->on_msg_view = std::move(cb); }
 void WebSocketClient::on_state(StateCallback cb)       { impl_->on_state = std::move(cb); }
+void WebSocketClient::on_rejected(RejectedFn fn)       { impl_->on_reject = std::move(fn); }
 void WebSocketClient::on_resubscribe(ResubscribeFn fn) {
     impl_->on_resub_noarg = [this, f = std::move(fn)]() mutable { if (f) f(*this); };
 }
 
+
+bool WebSocketClient::is_connected() const noexcept { return impl_->connected.load(); }
+bool WebSocketClient::is_async() const noexcept { return impl_->pool != nullptr; }
+std::uint64_t WebSocketClient::read_tsc() const noexcept { return impl_->cur_read_tsc; }
+
+WebSocketClient::Stats WebSocketClient::stats() const noexcept {
+    Stats st;
+    st.frames      = impl_->frames.load(std::memory_order_relaxed);
+    st.rx_bytes    = impl_->rx_bytes.load(std::memory_order_relaxed);
+    st.rx_wire_bytes = impl_->rx_wire.load(std::memory_order_relaxed);
+    st.tx_bytes    = impl_->tx_bytes.load(std::memory_order_relaxed);
+    st.tx_wire_bytes = impl_->tx_wire.load(std::memory_order_relaxed);
+    st.read_cpu_ns = impl_->read_cpu_ns.load(std::memory_order_relaxed);
+    st.allocations = impl_->allocations.load(std::memory_order_relaxed);
+    st.deflate     = impl_->deflate_on.load(std::memory_order_relaxed);
+    st.write_queue_depth = impl_->q_depth.load(std::memory_order_relaxed);
+    st.write_queue_peak  = impl_->q_peak.load(std::memory_order_relaxed);
+    st.coalesced   = impl_->coalesced.load(std::memory_order_relaxed);
+    st.read_pauses = impl_->read_pauses.load(std::memory_order_relaxed);
+    return st;
+}
@@ -0,0 +1,240 @@
+#include "account_pool.h"
+#include "config.h"
+#include "http_client.h"
+#include "local_https_server.h"
+#include "logger.h"
+#include "ltp_store.h"
+#include "market_data_server.h"
+#include "metrics.h"
+#include "parser.h"
+#include "sharder.h"
+#include "totp.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+using json = nlohmann::json;
+
+// loginByPassword / generateTokens for several client codes; every token issued
+// is accepted by the WS stand-in
+struct AuthServer {
+    MarketDataServer& md;
+    std::map<std::string, std::string> secrets;     // client code -> TOTP secret
+    std::mutex mu;
+    std::set<std::string> dead;                     // client codes refused outright
+    std::map<std::string, std::string> refresh_owner;
+    std::map<std::string, std::string> bearer;      // client code -> current "Bearer <jwt>"
+    int issued = 0, in_flight = 0, max_in_flight = 0;
+
+    LocalHttpsServer::Response issue(const std::string& code) {
+        const std::string n = std::to_string(++issued);
+        const std::string jwt = "jwt-" + code + "-" + n, rt = "r-" + code + "-" + n;
+        refresh_owner[rt] = code;
+        bearer[code] = "Bearer " + jwt;
+        md.allow_authorization(bearer[code]);
+        LocalHttpsServer::Response r;
+        r.body = json{{"status", true},
+                      {"data", {{"jwtToken", jwt}, {"refreshToken", rt}, {"feedToken", "f-" + code}, {"expiresIn", 3600}}}}.dump();
+        return r;
+    }
+
+    LocalHttpsServer::Response login(const LocalHttpsServer::Request& req) {
+        const json b = json::parse(req.body);
+        const std::string code = b.at("clientcode");
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            max_in_flight = std::max(max_in_flight, ++in_flight);
+        }
+        std::this_thread::sleep_for(milliseconds(100));
+        std::lock_guard<std::mutex> lk(mu);
+        --in_flight;
+        LocalHttpsServer::Response r;
+        const auto it = secrets.find(code);
+        if (it == secrets.end() || dead.count(code) || !TOTP(it->second).verify(b.at("totp"), system_clock::now())) {
+            r.status = 401;
+            return r;
+        }
+        return issue(code);
+    }
+
+    LocalHttpsServer::Response refresh(const LocalHttpsServer::Request& req) {
+        std::lock_guard<std::mutex> lk(mu);
+        const auto it = refresh_owner.find(json::parse(req.body).at("refreshToken"));
+        if (it == refresh_owner.end() || dead.count(it->second)) {
+            LocalHttpsServer::Response r;
+            r.status = 401;
+            return r;
+        }
+        return issue(it->second);
+    }
+};
+
+template <typename F>
+static bool wait_for(F done, milliseconds timeout = seconds(15)) {
+    const auto end = steady_clock::now() + timeout;
+    while (steady_clock::now() < end) {
+        if (done()) return true;
+        std::this_thread::sleep_for(milliseconds(20));
+    }
+    return done();
+}
+
+static std::vector<std::string> tokens(int n) {
+    std::vector<std::string> v;
+    for (int i = 0; i < n; ++i) v.push_back(std::to_string(31000 + i));
+    return v;
+}
+
+// A tick for `token` received after `since`
+static bool fresh_tick(const LTPStore& store, const std::string& token, steady_clock::time_point since) {
+    const auto t = store.get(token);
+    return t && t->recv > since;
+}
+
+int main() {
+    Logger log("account_pool_test");
+    log.set_level(LogLevel::ERROR);
+
+    MarketDataServer::Options mo;
+    mo.default_rate = 20;
+    MarketDataServer md(log, mo);
+    md.set_authorization("Bearer nobody");        // only tokens the auth server issued
+    assert(md.start());
+
+    const std::vector<std::pair<std::string, std::string>> accts = {
+        {"A1", "JBSWY3DPEHPK3PXP"}, {"B2", "KRSXG5CTMVRXEZLU"}, {"C3", "GEZDGNBVGY3TQOJQ"}};
+    AuthServer as{md, {}, {}, {}, {}, {}};
+    for (const auto& [code, secret] : accts) as.secrets[code] = secret;
+
+    LocalHttpsServer::Options so;
+    so.threads = 4;
+    LocalHttpsServer srv(log, so);
+    srv.route("POST", "/rest/auth/angelbroking/user/v1/loginByPassword",
+              [&as](const LocalHttpsServer::Request& r) { return as.login(r); });
+    srv.route("POST", "/rest/auth/angelbroking/jwt/v1/generateTokens",
+              [&as](const LocalHttpsServer::Request& r) { return as.refresh(r); });
+    assert(srv.start());
+
+    HTTPClient::Options ho;
+    ho.ca_file = srv.cert_file();
+    HTTPClient http(ho);
+
+    // Three accounts of 3 connections / 8 instruments each, logged in side by side
+    AccountPool::Options po;
+    po.base_url = srv.url();
+    AccountPool pool(http, log, po);
+    std::vector<std::string> cfg_paths;
+    for (const auto& [code, secret] : accts) {
+        const std::string path = (std::filesystem::temp_directory_path() / ("alpha-acct-" + code + ".json")).string();
+        {
+            std::ofstream f(path);
+            f << json{{"api_key", "key-" + code}, {"client_id", code}, {"client_secret", "pw"}, {"tokens", json::array()}, {"splits", json::object()}}.dump();
+        }
+        cfg_paths.push_back(path);
+        pool.add({Config::load_from_file(path), secret, 3, 8});
+    }
+    assert(pool.start() == 3);
+    assert(as.max_in_flight >= 2);
+    for (std::size_t a = 0; a < 3; ++a) {
+        const auto s = pool.session(a);
+        assert(s.up && s.name == accts[a].first && s.max_connections == 3 && s.max_tokens == 8);
+        assert(s.headers.at("Authorization") == as.bearer[s.name]);
+        assert(s.headers.at("x-client-code") == s.name && s.headers.at("x-api-key") == "key-" + s.name);
+        assert(s.headers.at("x-feed-token") == "f-" + s.name);
+    }
+
+    Parser parser;
+    parser.set_strip_prefix("nse_cm|");
+    LTPStore store;
+    Sharder::Options opt;
+    opt.wss_url = md.url();
+    opt.ca_file = md.cert_file();
+    opt.max_tokens_per_conn = 4;
+    opt.subscribe_batch_size = 4;
+    Sharder sharder(log, parser, store, opt);
+    sharder.set_accounts(pool);
+
+    auto all_ticking = [&](const std::vector<std::string>& toks, steady_clock::time_point since) {
+        return wait_for([&] {
+            return std::all_of(toks.begin(), toks.end(), [&](const std::string& t) { return fresh_tick(store, t, since); });
+        });
+    };
+
+    // 12 instruments in shards of 4: one per account
+    const auto t0 = steady_clock::now();
+    sharder.set_tokens(tokens(12));
+    assert(sharder.start());
+    auto loads = sharder.account_loads();
+    assert(loads.size() == 3);
+    for (const auto& l : loads) assert(l.up && l.shards == 1 && l.connections == 1 && l.tokens == 4);
+    assert(all_ticking(tokens(12), t0));
+    assert(wait_for([&] { return md.live_by_authorization().size() == 3; }));
+    for (const auto& [auth, n] : md.live_by_authorization()) assert(n == 1);
+
+    // 2 more: the shards are full, so a new one goes to the account with the most room
+    sharder.set_tokens(tokens(14));
+    loads = sharder.account_loads();
+    assert(loads[0].shards == 2 && loads[0].tokens == 6 && loads[0].connections == 2);
+    assert(loads[1].tokens == 4 && loads[2].tokens == 4 && sharder.unplaced_tokens().empty());
+    assert(all_ticking(tokens(14), t0));
+
+    // B's session is terminated: its sockets close and its token is refused. The
+    // refused handshakes renew B (which fails), so its shard moves to C, the only
+    // account with room for 4 more
+    std::string b_bearer;
+    {
+        std::lock_guard<std::mutex> lk(as.mu);
+        as.dead.insert("B2");
+        b_bearer = as.bearer["B2"];
+    }
+    md.revoke_authorization(b_bearer);
+    assert(wait_for([&] { return sharder.account_loads()[1].shards == 0; }));
+    assert(!pool.session(1).up);
+    loads = sharder.account_loads();
+    assert(!loads[1].up && loads[1].shards == 0 && loads[1].tokens == 0);
+    assert(loads[0].shards == 2 && loads[2].shards == 2 && loads[2].tokens == 8);
+    assert(sharder.metrics().value("alpha_account_rehomes_total") == 1);
+    const auto t1 = steady_clock::now();
+    assert(all_ticking(tokens(14), t1));
+    assert(wait_for([&] {
+        const auto live = md.live_by_authorization();
+        return live.count(b_bearer) == 0 && live.size() == 2 && md.stats().live_sessions == 4;
+    }));
+
+    // Beyond what A and C can carry: the rest waits
+    sharder.set_tokens(tokens(18));
+    loads = sharder.account_loads();
+    assert(loads[0].tokens == 8 && loads[2].tokens == 8);
+    const std::vector<std::string> waiting = {"31016", "31017"};
+    assert(sharder.unplaced_tokens() == waiting);
+
+    // B comes back and picks up the waiting instruments
+    {
+        std::lock_guard<std::mutex> lk(as.mu);
+        as.dead.erase("B2");
+    }
+    assert(pool.renew(1) && pool.session(1).up);
+    loads = sharder.account_loads();
+    assert(loads[1].up && loads[1].shards == 1 && loads[1].tokens == 2);
+    assert(sharder.unplaced_tokens().empty());
+    assert(all_ticking(tokens(18), steady_clock::now()));
+
+    sharder.stop();
+    pool.stop();
+    srv.stop();
+    md.stop();
+    for (const auto& p : cfg_paths) std::filesystem::remove(p);
+    std::cout << "account pool test finished\n";
+    return 0;
+}
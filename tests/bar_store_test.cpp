@@ -0,0 +1,79 @@
+#include "bar_store.h"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+using tp = system_clock::time_point;
+
+static tp at(int h, int m, int s = 0) {
+    // 2024-12-02 in IST (UTC+5:30), as UTC time points
+    return sys_days(year{2024} / 12 / 2) + hours(h) + minutes(m) + seconds(s) - minutes(330);
+}
+
+static Bar bar(tp start, double px, std::uint64_t vol = 100) {
+    Bar b;
+    b.start = start;
+    b.open = b.high = b.low = b.close = px;
+    b.volume = vol;
+    return b;
+}
+
+int main() {
+    // Merge: out of order, overlapping, duplicates inside a batch
+    {
+        BarStore s(minutes(1));
+        assert(s.merge("3045", {bar(at(9, 17), 3), bar(at(9, 15), 1), bar(at(9, 16), 2)}) == 3);
+        assert(s.merge("3045", {bar(at(9, 18), 4), bar(at(9, 19), 5)}) == 2);                 // appended
+        assert(s.merge("3045", {bar(at(9, 16), 20), bar(at(9, 14), 0), bar(at(9, 14), 9)}) == 1);  // one new, one replaced
+        const auto v = s.bars("3045");
+        assert(v.size() == 6);
+        for (std::size_t i = 1; i < v.size(); ++i) assert(v[i - 1].start < v[i].start);
+        assert(v[0].close == 9 && v[2].close == 20 && v.back().close == 5);
+        assert(s.merge("3045", {}) == 0 && s.instruments() == 1 && s.size() == 6);
+
+        const auto r = s.bars("3045", at(9, 15), at(9, 18));
+        assert(r.size() == 3 && r.front().start == at(9, 15) && r.back().start == at(9, 17));
+        assert(s.bars("nope").empty() && !s.last("nope"));
+    }
+
+    // Live ticks continue the history's grid
+    {
+        BarStore s(hours(1));
+        s.merge("26000", {bar(at(9, 15), 100), bar(at(10, 15), 101)});
+        assert(s.on_tick("26000", at(11, 0), 105, 5));                 // still the 10:15 bar
+        Bar l = *s.last("26000");
+        assert(l.start == at(10, 15) && l.high == 105 && l.close == 105 && l.low == 101 && l.volume == 105);
+        assert(s.on_tick("26000", at(12, 40), 99, 1));                 // 11:15 has no trades: next is 12:15
+        l = *s.last("26000");
+        assert(l.start == at(12, 15) && l.open == 99 && l.volume == 1 && s.bars("26000").size() == 3);
+        assert(!s.on_tick("26000", at(12, 0), 1));                     // older than the newest bar
+
+        // no history: aligned to the interval
+        BarStore m(minutes(5));
+        assert(m.on_tick("x", at(9, 17, 42), 10));
+        assert(m.last("x")->start == at(9, 15));
+    }
+
+    // Concurrent writers on different and the same keys
+    {
+        BarStore s(minutes(1));
+        std::vector<std::thread> th;
+        for (int t = 0; t < 4; ++t) {
+            th.emplace_back([&s, t] {
+                for (int i = 0; i < 500; ++i) {
+                    s.on_tick("k" + std::to_string(t), at(9, 15) + seconds(i * 10), i);
+                    s.merge("shared", {bar(at(9, 15) + minutes(i), t)});
+                }
+            });
+        }
+        for (auto& x : th) x.join();
+        assert(s.bars("shared").size() == 500);
+        assert(s.bars("k0").size() == 84 && s.size() == 500 + 4 * 84);
+    }
+
+    std::cout << "bar store test finished\n";
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include "binary_log.h"
+#include "logger.h"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+static std::vector<std::string> lines_of(const std::string& s) {
+    std::vector<std::string> out;
+    std::istringstream in(s);
+    for (std::string l; std::getline(in, l);) out.push_back(l);
+    return out;
+}
+
+static std::string decode(const std::string& path, bool location = false, bool* ok = nullptr, std::string* err = nullptr) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream out;
+    BinaryLogDecodeOptions o;
+    o.show_location = location;
+    const bool r = decode_binary_log(in, out, o, err);
+    if (ok) *ok = r;
+    else assert(r);
+    return out.str();
+}
+
+enum class Side : char { Buy = 'B', Sell = 'S' };
+
+int main() {
+    Logger log("binary_log_test");
+    const std::string path = "/tmp/alpha-binlog-test-" + std::to_string(::getpid()) + ".binlog";
+
+    // Every argument type, escapes, leftovers, and the text layout
+    {
+        BinaryLogger bl(log, "trace");
+        assert(!bl.is_open() && !bl.enabled(LogLevel::ERROR));
+        ALPHA_BINLOG(bl, LogLevel::INFO, "not open {}", 1);    // dropped silently
+        assert(bl.open(path));
+        const std::string tok = "26000";
+        ALPHA_BINLOG(bl, LogLevel::INFO, "tick token={} ltp={} qty={} side={} ok={} {{x}}",
+                     tok, 101.25, -3, 'B', true);
+        ALPHA_BINLOG(bl, LogLevel::WARN, "no args");
+        ALPHA_BINLOG(bl, LogLevel::DEBUG, "u={} e={} sv={}", std::uint64_t{18446744073709551615ull}, Side::Sell,
+                     std::string_view("abc"));
+        ALPHA_BINLOG(bl, LogLevel::TRACE, "left over:{}", 7);
+        bl.set_level(LogLevel::DEBUG);
+        ALPHA_BINLOG(bl, LogLevel::TRACE, "filtered {}", 1);
+        bl.close();
+        assert(bl.stats().records == 4 && bl.stats().dropped == 0);
+
+        const auto ls = lines_of(decode(path));
+        assert(ls.size() == 4);
+        // "YYYY-mm-dd HH:MM:SS.uuuuuu [LEVEL] name: payload"
+        assert(ls[0][4] == '-' && ls[0][10] == ' ' && ls[0][19] == '.' && ls[0][26] == ' ');
+        assert(ls[0].substr(26) == " [INFO] trace: tick token=26000 ltp=101.25 qty=-3 side=B ok=true {x}");
+        assert(ls[1].substr(26) == " [WARN] trace: no args");
+        assert(ls[2].substr(26) == " [DEBUG] trace: u=18446744073709551615 e=83 sv=abc");
+        assert(ls[3].substr(26) == " [TRACE] trace: left over:7");
+
+        const auto withloc = lines_of(decode(path, true));
+        assert(withloc[1].find("(") != std::string::npos && withloc[1].find("binary_log_test.cpp:") != std::string::npos);
+    }
+
+    // Several threads: every record is written, each thread's in order
+    {
+        const int threads = 4, per = 5000;
+        BinaryLogger bl(log, "mt");
+        assert(bl.open(path));
+        std::vector<std::thread> ws;
+        for (int t = 0; t < threads; ++t) {
+            ws.emplace_back([&bl, t] {
+                for (int i = 0; i < per; ++i) {
+                    ALPHA_BINLOG(bl, LogLevel::TRACE, "t{} {}", t, i);
+                    if (i % 500 == 0) std::this_thread::yield();
+                }
+            });
+        }
+        for (auto& w : ws) w.join();
+        bl.flush();
+        assert(bl.stats().records == static_cast<std::uint64_t>(threads * per));
+        bl.close();
+
+        std::vector<int> next(threads, 0);
+        const auto ls = lines_of(decode(path));
+        assert(ls.size() == static_cast<std::size_t>(threads * per));
+        for (const auto& l : ls) {
+            const auto p = l.find("mt: t");
+            assert(p != std::string::npos);
+            const int t = l[p + 5] - '0';
+            assert(std::stoi(l.substr(p + 7)) == next[static_cast<std::size_t>(t)]++);
+        }
+    }
+
+    // Full ring without blocking: dropped, counted and reported by the decoder
+    {
+        BinaryLogger bl(log, "drops");
+        BinaryLogger::Options o;
+        o.ring_bytes = 1024;
+        o.poll_interval = std::chrono::seconds(5);
+        assert(bl.open(path, o));
+        const std::string payload(100, 'x');
+        for (int i = 0; i < 100; ++i) ALPHA_BINLOG(bl, LogLevel::INFO, "{}", payload);
+        ALPHA_BINLOG(bl, LogLevel::INFO, "{}", std::string(500, 'y'));  // over a quarter ring
+        const auto d = bl.stats().dropped;
+        assert(d > 0);
+        bl.close();
+        const auto ls = lines_of(decode(path));
+        assert(ls.size() == 100 - (d - 1) + 1);
+        assert(ls.back().find(std::to_string(d) + " binary log records dropped") != std::string::npos);
+    }
+
+    // Reopen truncates; a damaged file decodes up to the damage and reports it
+    {
+        BinaryLogger bl(log, "again");
+        assert(bl.open(path));
+        for (int i = 0; i < 10; ++i) ALPHA_BINLOG(bl, LogLevel::INFO, "n={}", i);
+        bl.close();
+        const std::string full = [&] { std::ifstream in(path, std::ios::binary); std::ostringstream s; s << in.rdbuf(); return s.str(); }();
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out.write(full.data(), static_cast<std::streamsize>(full.size() - 3));
+        }
+        bool ok = true;
+        std::string err;
+        const auto ls = lines_of(decode(path, false, &ok, &err));
+        assert(!ok && err == "truncated record" && ls.size() == 9);
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out << "not a log";
+        }
+        decode(path, false, &ok, &err);
+        assert(!ok && err == "not a binary log");
+    }
+
+    std::remove(path.c_str());
+    std::cout << "binary log test finished\n";
+    return 0;
+}
@@ -0,0 +1,280 @@
+#include "candle_backfill.h"
+#include "auth.h"
+#include "bar_store.h"
+#include "config.h"
+#include "http_client.h"
+#include "local_https_server.h"
+#include "logger.h"
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+using namespace std::chrono;
+using json = nlohmann::json;
+
+static system_clock::time_point ist(int y, unsigned mo, unsigned d, int h = 0, int m = 0) {
+    return sys_days(year{y} / month{mo} / day{d}) + hours(h) + minutes(m) - minutes(330);
+}
+
+// "2024-12-02 09:15" (IST) -> minutes since the epoch, UTC
+static long long parse_local(const std::string& s) {
+    int y, mo, d, h, m;
+    assert(std::sscanf(s.c_str(), "%d-%d-%d %d:%d", &y, &mo, &d, &h, &m) == 5);
+    return duration_cast<minutes>(ist(y, static_cast<unsigned>(mo), static_cast<unsigned>(d), h, m).time_since_epoch()).count();
+}
+
+// getCandleData stand-in: minute candles 09:15..15:29 IST every day, inclusive range;
+// injected failures by request number and by token; tokens rotate on refresh
+struct CandleServer {
+    std::mutex mu;
+    std::string jwt = "jwt-1";
+    bool expire_after_10 = false;
+    int requests = 0, refreshes = 0, in_flight = 0, max_in_flight = 0;
+    std::atomic<int> refresh_delay_ms{0};               // slow token endpoint
+    std::atomic<bool> refreshing{false};                // a delayed refresh has started
+    std::set<std::string> fail_at = {"2", "4", "6"};     // request numbers: 500, 403 rate, 429
+    std::set<std::pair<std::string, std::string>> ranges; // (token, fromdate) seen with a 200
+
+    LocalHttpsServer::Response candles(const LocalHttpsServer::Request& req) {
+        const json body = json::parse(req.body);
+        std::string current;
+        std::string n;
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            n = std::to_string(++requests);
+            ++in_flight;
+            max_in_flight = std::max(max_in_flight, in_flight);
+            if (expire_after_10 && requests == 10) jwt = "expired";
+            current = jwt;
+        }
+        std::this_thread::sleep_for(milliseconds(3));
+        LocalHttpsServer::Response r;
+        const auto done = [this](LocalHttpsServer::Response res) {
+            std::lock_guard<std::mutex> lk(mu);
+            --in_flight;
+            return res;
+        };
+        if (body.at("interval") != "ONE_MINUTE" || req.headers.count("x-privatekey") == 0) {
+            r.status = 400;
+            return done(r);
+        }
+        if (fail_at.count(n)) {
+            if (n == "2") r.status = 500;
+            if (n == "4") { r.status = 403; r.body = "Access denied because of exceeding access rate"; }
+            if (n == "6") r.status = 429;
+            return done(r);
+        }
+        const std::string token = body.at("symboltoken");
+        if (token == "down") {
+            r.status = 503;
+            return done(r);
+        }
+        if (token == "bad") {
+            r.body = R"({"status":false,"message":"Invalid symbol token","errorcode":"AB1019","data":null})";
+            return done(r);
+        }
+        if (req.headers.at("authorization") != "Bearer " + current) {
+            r.body = R"({"status":false,"message":"Invalid Token","errorcode":"AG8001","data":null})";
+            return done(r);
+        }
+        const long long from = parse_local(body.at("fromdate")), to = parse_local(body.at("todate"));
+        json data = json::array();
+        for (long long m = from; m <= to; ++m) {
+            const long long local = m + 330;
+            const long long minute_of_day = ((local % 1440) + 1440) % 1440;
+            if (minute_of_day < 9 * 60 + 15 || minute_of_day >= 15 * 60 + 30) continue;
+            const auto t = system_clock::time_point(minutes(local));
+            const auto dd = floor<days>(t);
+            const year_month_day ymd(dd);
+            char ts[40];
+            std::snprintf(ts, sizeof(ts), "%04d-%02u-%02uT%02lld:%02lld:00+05:30", static_cast<int>(ymd.year()),
+                          static_cast<unsigned>(ymd.month()), static_cast<unsigned>(ymd.day()),
+                          minute_of_day / 60, minute_of_day % 60);
+            const double px = 100 + static_cast<double>(m % 1000) / 10;
+            data.push_back({ts, px, px + 1, px - 1, px + 0.5, static_cast<std::uint64_t>(m % 97)});
+        }
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            ranges.insert({token, body.at("fromdate")});
+        }
+        r.body = json{{"status", true}, {"message", "SUCCESS"}, {"errorcode", ""}, {"data", data}}.dump();
+        return done(r);
+    }
+};
+
+int main() {
+    Logger log("candle_backfill_test");
+    log.set_level(LogLevel::ERROR);
+
+    const std::string cfg_path = (std::filesystem::temp_directory_path() / "alpha-backfill-cfg.json").string();
+    {
+        std::ofstream f(cfg_path);
+        f << R"({"api_key":"k","client_id":"c","client_secret":"s","tokens":[],"splits":{}})";
+    }
+    const Config cfg = Config::load_from_file(cfg_path);
+
+    CandleServer cs;
+    LocalHttpsServer::Options so;
+    so.threads = 4;
+    LocalHttpsServer srv(log, so);
+    srv.route("POST", "/rest/secure/angelbroking/historical/v1/getCandleData",
+              [&cs](const LocalHttpsServer::Request& r) { return cs.candles(r); });
+    srv.route("POST", "/rest/auth/angelbroking/user/v1/loginByPassword", [](const LocalHttpsServer::Request&) {
+        LocalHttpsServer::Response r;
+        r.body = R"({"status":true,"data":{"jwtToken":"jwt-1","refreshToken":"r-1","feedToken":"f-1"}})";
+        return r;
+    });
+    srv.route("POST", "/rest/auth/angelbroking/jwt/v1/generateTokens", [&cs](const LocalHttpsServer::Request& req) {
+        LocalHttpsServer::Response r;
+        if (cs.refresh_delay_ms > 0) {
+            cs.refreshing = true;
+            std::this_thread::sleep_for(milliseconds(cs.refresh_delay_ms.load()));
+        }
+        std::lock_guard<std::mutex> lk(cs.mu);
+        if (json::parse(req.body).at("refreshToken") != "r-1") {
+            r.status = 401;
+            return r;
+        }
+        cs.jwt = "jwt-" + std::to_string(++cs.refreshes + 1);
+        r.body = json{{"status", true}, {"data", {{"jwtToken", cs.jwt}, {"refreshToken", "r-1"}}}}.dump();
+        return r;
+    });
+    assert(srv.start());
+
+    HTTPClient::Options ho;
+    ho.ca_file = srv.cert_file();
+    HTTPClient http(ho);
+    Auth auth(cfg, http, log, srv.url());
+    assert(auth.login_with_totp("123456") && auth.tokens().access_token == "jwt-1");
+
+    // 3 instruments x 10 days in 1-day chunks, through 500 / 403 / 429 and a token
+    // that expires mid-run
+    {
+        cs.expire_after_10 = true;
+        BarStore store(minutes(1));
+        CandleBackfill::Options o;
+        o.max_days_per_request = 1;
+        o.concurrency = 3;
+        o.requests_per_second = 25;
+        o.backoff_base = milliseconds(5);
+        o.backoff_max = milliseconds(20);
+        CandleBackfill bf(http, auth, log, store, o);
+
+        const auto from = ist(2024, 12, 2), to = ist(2024, 12, 12);
+        const auto t0 = steady_clock::now();
+        const auto r = bf.run({{"NSE", "3045", from, to, ""}, {"NSE", "2885", from, to, ""}, {"NFO", "43210", from, to, "nse_fo|43210"}});
+        const double secs = duration<double>(steady_clock::now() - t0).count();
+        const auto st = bf.stats();
+
+        assert(r.ok() && r.chunks == 30 && r.errors.empty());
+        assert(r.bars == 3 * 10 * 375 && store.size() == r.bars && store.instruments() == 3);
+        assert(st.throttled == 2 && st.refreshes == 1 && cs.refreshes == 1 && auth.tokens().access_token == "jwt-2");
+        assert(st.retries >= 4 && st.requests == 30 + st.retries && st.bars >= r.bars);
+        assert(cs.max_in_flight <= 3 && cs.ranges.size() == 30);
+        // the budget: 25 banked, then 25/s
+        assert(st.requests > 25 && secs >= (static_cast<double>(st.requests) - 25) / 25 * 0.9);
+
+        const auto bars = store.bars("nse_fo|43210");
+        assert(bars.size() == 3750 && bars.front().start == ist(2024, 12, 2, 9, 15));
+        assert(bars.back().start == ist(2024, 12, 11, 15, 29));
+        for (std::size_t i = 1; i < bars.size(); ++i) assert(bars[i - 1].start < bars[i].start);
+        const long long m0 = duration_cast<minutes>(bars.front().start.time_since_epoch()).count();
+        assert(bars.front().close == 100 + static_cast<double>(m0 % 1000) / 10 + 0.5);
+        assert(bars.front().volume == static_cast<std::uint64_t>(m0 % 97));
+
+        // live ticks carry on from the history
+        assert(store.on_tick("3045", ist(2024, 12, 11, 15, 29) + seconds(30), 500, 10));
+        assert(store.last("3045")->close == 500 && store.bars("3045").size() == 3750);
+        assert(store.on_tick("3045", ist(2024, 12, 11, 15, 31) + seconds(5), 501));
+        assert(store.last("3045")->start == ist(2024, 12, 11, 15, 31));
+
+        // a second pass over the same range adds nothing
+        cs.fail_at.clear();
+        const auto again = bf.run({{"NSE", "3045", from, ist(2024, 12, 4), ""}});
+        assert(again.ok() && again.chunks == 2 && again.bars == 0 && store.size() == 3 * 3750 + 1);
+    }
+
+    // Permanent errors fail their chunk only; retries stop at max_attempts
+    {
+        cs.fail_at.clear();
+        BarStore store(minutes(1));
+        CandleBackfill::Options o;
+        o.max_attempts = 3;
+        o.requests_per_second = 0;
+        o.backoff_base = milliseconds(1);
+        CandleBackfill bf(http, auth, log, store, o);
+        const auto day = ist(2024, 12, 2);
+        const int before = cs.requests;
+        const auto r = bf.run({{"NSE", "bad", day, day + hours(24), ""},
+                               {"NSE", "down", day, day + hours(24), ""},
+                               {"NSE", "3045", day, day + hours(24), ""}});
+        assert(!r.ok() && r.failed == 2 && r.chunks == 3 && r.bars == 375 && r.errors.size() == 2);
+        bool saw_bad = false, saw_down = false;
+        for (const auto& e : r.errors) {
+            saw_bad |= e.find("NSE:bad 2024-12-02 00:00 .. 2024-12-03 00:00: AB1019 Invalid symbol token") == 0;
+            saw_down |= e.find("NSE:down") == 0 && e.find("HTTP 503") != std::string::npos;
+        }
+        assert(saw_bad && saw_down);
+        assert(cs.requests - before == 1 + 3 + 1 && bf.stats().retries == 2);
+    }
+
+    // A slow refresh runs outside the lock: stats stay readable meanwhile, and the
+    // other workers wait for the new token instead of refreshing again
+    {
+        cs.fail_at.clear();
+        cs.refresh_delay_ms = 300;
+        {
+            std::lock_guard<std::mutex> lk(cs.mu);
+            cs.jwt = "rotated";                         // the client's token is refused
+        }
+        BarStore store(minutes(1));
+        CandleBackfill::Options o;
+        o.concurrency = 3;
+        o.max_days_per_request = 1;
+        o.requests_per_second = 0;
+        CandleBackfill bf(http, auth, log, store, o);
+        const auto day = ist(2024, 12, 2);
+        CandleBackfill::Result r;
+        std::thread t([&] { r = bf.run({{"NSE", "3045", day, day + hours(24 * 3), ""}}); });
+        while (!cs.refreshing) std::this_thread::sleep_for(milliseconds(1));
+        const auto t0 = steady_clock::now();
+        assert(bf.stats().refreshes == 1);
+        assert(steady_clock::now() - t0 < milliseconds(100));
+        t.join();
+        assert(r.ok() && r.chunks == 3 && r.bars == 3 * 375 && bf.stats().refreshes == 1);
+        cs.refresh_delay_ms = 0;
+    }
+
+    // cancel() cuts a long backoff short
+    {
+        BarStore store(minutes(1));
+        CandleBackfill::Options o;
+        o.backoff_base = seconds(30);
+        o.backoff_max = seconds(30);
+        o.max_attempts = 10;
+        CandleBackfill bf(http, auth, log, store, o);
+        const auto day = ist(2024, 12, 2);
+        CandleBackfill::Result r;
+        std::thread t([&] { r = bf.run({{"NSE", "down", day, day + hours(24 * 90), ""}}); });
+        std::this_thread::sleep_for(milliseconds(100));
+        const auto t0 = steady_clock::now();
+        bf.cancel();
+        t.join();
+        assert(steady_clock::now() - t0 < seconds(2));
+        assert(r.chunks == 3 && r.failed == 3 && r.errors.back().find("cancelled") != std::string::npos);
+    }
+
+    srv.stop();
+    std::filesystem::remove(cfg_path);
+    std::cout << "candle backfill test finished\n";
+    return 0;
+}
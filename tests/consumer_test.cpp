@@ -3,6 +3,8 @@
 #include "parser.h"
 #include "ltp_store.h"
 #include "logger.h"
+#include "metrics.h"
+#include "tick_rate_tracker.h"
 #include <cassert>
 #include <chrono>
 #include <thread>
@@ -20,7 +22,7 @@ int main() {
     LTPStore store;
 
     Consumer c(q, p, store, log);
-    c.set_sink([&](const LTP& v){ /* optional: log.info_fmt("ingested ", v.token, " ", v.ltp); */ });
+    c.set_sink([&](const LTP& v){ /* optional: log.info_fmt("ingested {} {}", v.token, v.ltp); */ });
     c.start();
 
     // push a few frames
@@ -42,6 +44,59 @@ int main() {
     assert(b->ltp == 202.25);
 
     c.stop();
+
+    // Tick rates are keyed by the subscribed token even when the parser keeps the prefix
+    {
+        IngestQueue rq(64);
+        Parser keep;                       // no set_strip_prefix: tokens stay "nse_cm|..."
+        LTPStore rstore;
+        TickRateTracker rates;
+        Consumer rc(rq, keep, rstore, log);
+        rc.set_rate_tracker(&rates, "nse_cm|");
+        rc.start();
+        for (int i = 0; i < 10; ++i) assert(rq.try_push(mk_msg("nse_cm|26000", 100.0 + i, 1728123003000 + i)));
+        assert(rq.try_push(mk_msg("bse_cm|500325", 2500.0, 1728123004000)));
+        for (int i = 0; i < 50 && !rstore.get("bse_cm|500325"); ++i) std::this_thread::sleep_for(10ms);
+        rc.stop();
+        assert(rstore.get("nse_cm|26000").has_value());
+        assert(rates.rate("26000") > 0 && rates.rate("nse_cm|26000") == 0);
+        assert(rates.rate("bse_cm|500325") > 0);       // other segments keep their key
+    }
+    // Only real subscribe acks count as acks; other non-tick frames are parse failures
+    {
+        IngestQueue mq(64);
+        LTPStore mstore;
+        MetricsRegistry reg;
+        Consumer mc(mq, p, mstore, log);
+        Consumer::SourceOptions so;
+        so.metrics.subscribe_acks = &reg.counter("acks", "");
+        so.metrics.parse_failures = &reg.counter("failures", "");
+        mc.configure(so);
+        mc.start();
+        assert(mq.try_push(R"({"type":"ack","action":"subscribe","count":2})"));
+        assert(mq.try_push(R"({"type":"ack","action":"unsubscribe","count":1})"));
+        assert(mq.try_push(R"({"type":"error","message":"subscribe failed"})"));
+        assert(mq.try_push(R"({"action":"subscribe","mode":"ltp","tokens":["nse_cm|26000"]})"));
+        assert(mq.try_push("subscribe"));
+        for (int i = 0; i < 50 && reg.value("acks") + reg.value("failures") < 5; ++i) std::this_thread::sleep_for(10ms);
+        mc.stop();
+        assert(reg.value("acks") == 1 && reg.value("failures") == 4);
+    }
+
+    // Retired instruments lose their quote and ignore late ticks until readmitted
+    {
+        LTPStore rs;
+        LTP v; v.token = "26000"; v.ltp = 1;
+        rs.upsert(v);
+        rs.retire({"26000"});
+        assert(!rs.get("26000") && rs.size() == 0);
+        rs.upsert(v);
+        assert(!rs.get("26000"));
+        rs.readmit({"26000"});
+        rs.upsert(v);
+        assert(rs.get("26000") && rs.get("26000")->ltp == 1);
+    }
+
     std::cout << "Consumer/LTPStore test passed.\n";
     return 0;
 }
@@ -0,0 +1,53 @@
+#include "feed_arbiter.h"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+
+static LTP tick(const std::string& tok, double px, long long ts_ms) {
+    LTP t;
+    t.token = tok;
+    t.ltp = px;
+    t.ts = std::chrono::system_clock::time_point(std::chrono::milliseconds(ts_ms));
+    return t;
+}
+
+int main() {
+    FeedArbiter arb;
+    constexpr std::size_t A = 0, B = 1;
+
+    // A first, B's copy 300ns later is dropped; A wins by 300ns
+    assert(arb.admit(A, tick("26000", 100.0, 1000), 1000));
+    assert(!arb.admit(B, tick("26000", 100.0, 1000), 1300));
+
+    // B first on the next tick
+    assert(arb.admit(B, tick("26000", 100.5, 1001), 2000));
+    assert(!arb.admit(A, tick("26000", 100.5, 1001), 2500));
+
+    // Same price, same ms, same leg twice: two prints, both forwarded
+    assert(arb.admit(A, tick("26001", 50.0, 1000), 3000));
+    assert(arb.admit(A, tick("26001", 50.0, 1000), 3100));
+
+    // Dequeued out of wire order: forwarded copy was B, but A's stamp is earlier
+    assert(arb.admit(B, tick("26002", 10.0, 1000), 5000));
+    assert(!arb.admit(A, tick("26002", 10.0, 1000), 4900));
+
+    auto st = arb.stats();
+    assert(st.legs[A].forwarded == 3 && st.legs[B].forwarded == 2);
+    assert(st.legs[A].duplicates == 2 && st.legs[B].duplicates == 1);
+    assert(st.legs[A].wins == 2 && st.legs[B].wins == 1);
+    assert(st.legs[A].lead_ns_total == 400 && st.legs[A].lead_ns_max == 300);
+    assert(st.legs[B].lead_ns_total == 500);
+    assert(arb.instruments() == 3);
+
+    // Leading leg moves 5 ticks ahead; the lagging leg's oldest copy has fallen out
+    // of the recent window and is dropped as stale, newer copies still match
+    for (int i = 0; i < 5; ++i) assert(arb.admit(A, tick("26003", 1.0 + i, 2000 + i), 10000 + i));
+    assert(!arb.admit(B, tick("26003", 1.0, 2000), 20000));
+    assert(!arb.admit(B, tick("26003", 2.0, 2001), 20001));
+    st = arb.stats();
+    assert(st.stale == 1);
+    assert(st.legs[B].duplicates == 2);
+
+    std::cout << "FeedArbiter test passed.\n";
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "feed_watchdog.h"
+#include "ltp_store.h"
+#include "logger.h"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+static std::chrono::system_clock::time_point utc(long long days, int hh, int mm) {
+    return std::chrono::system_clock::time_point(std::chrono::hours(24 * days + hh) + std::chrono::minutes(mm));
+}
+
+int main() {
+    Logger log("watchdog_test");
+
+    // Market hours by fixed UTC offset. Day 19000 since epoch = 2022-01-08 (Saturday).
+    {
+        FeedWatchdog::Options o;                        // NSE 09:15-15:30 IST, weekdays
+        FeedWatchdog wd(log, o);
+        const long long mon = 19002;                    // 2022-01-10
+        assert(!wd.in_market_hours(utc(19000, 5, 0)));  // Saturday 10:30 IST
+        assert(wd.in_market_hours(utc(mon, 3, 45)));    // 09:15 IST: open
+        assert(!wd.in_market_hours(utc(mon, 3, 44)));   // 09:14 IST
+        assert(wd.in_market_hours(utc(mon, 9, 59)));    // 15:29 IST
+        assert(!wd.in_market_hours(utc(mon, 10, 0)));   // 15:30 IST: closed
+    }
+
+    FeedWatchdog::Options o;
+    o.check_interval = 10ms;
+    o.max_silence = 80ms;
+    o.open_minute = o.close_minute = 0;                 // always in market hours
+    o.weekdays_only = false;
+    o.instrument_silence = 50ms;
+    o.instrument_check_interval = 20ms;
+    FeedWatchdog wd(log, o);
+
+    // Streaming target never recycles; a stalled one does; a disarmed one never does
+    std::atomic<std::uint64_t> live_frames{0}, stalled_frames{5}, idle_frames{0};
+    std::atomic<int> live_recycles{0}, stalled_recycles{0}, idle_recycles{0};
+    wd.watch({"live",    [&] { return live_frames.load(); },    nullptr, [&] { ++live_recycles; }});
+    const auto stalled_id =
+    wd.watch({"stalled", [&] { return stalled_frames.load(); }, nullptr, [&] { ++stalled_recycles; }});
+    wd.watch({"idle",    [&] { return idle_frames.load(); },    [] { return false; }, [&] { ++idle_recycles; }});
+
+    LTPStore store;
+    LTP fresh; fresh.token = "26000"; fresh.ltp = 1; fresh.recv = std::chrono::steady_clock::now();
+    LTP old;   old.token = "26001";   old.ltp = 2;   old.recv = std::chrono::steady_clock::now() - 1s;
+    store.upsert(fresh);
+    store.upsert(old);
+    wd.watch_store(store);
+
+    wd.start();
+    for (int i = 0; i < 30; ++i) {
+        ++live_frames;
+        fresh.recv = std::chrono::steady_clock::now();
+        store.upsert(fresh);
+        std::this_thread::sleep_for(10ms);
+    }
+    wd.stop();
+    // stopped: nothing recycles the stalled target any more, so its silence only grows
+    std::this_thread::sleep_for(o.max_silence);
+    assert(wd.silent_for(stalled_id) >= o.max_silence);
+
+    assert(live_recycles == 0);
+    assert(idle_recycles == 0);
+    assert(stalled_recycles >= 1 && stalled_recycles <= 4);  // once per max_silence window
+    const auto st = wd.stats();
+    assert(st.recycles == static_cast<std::uint64_t>(stalled_recycles.load()));
+    assert(st.checks > 0);
+    const auto stale = wd.stale_instruments();
+    assert(stale.size() == 1 && stale[0] == "26001");
+
+    std::cout << "FeedWatchdog test passed.\n";
+    return 0;
+}
@@ -0,0 +1,198 @@
+#include "http_client.h"
+#include "local_https_server.h"
+#include "logger.h"
+#include "token_bucket.h"
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+using Req = LocalHttpsServer::Request;
+using Res = LocalHttpsServer::Response;
+using namespace std::chrono_literals;
+
+static HTTPClient::Options client_opts(const LocalHttpsServer& srv) {
+    HTTPClient::Options o;
+    o.ca_file = srv.cert_file();
+    o.timeout = std::chrono::seconds(5);
+    return o;
+}
+
+// Counts callbacks and lets the test wait for all of them
+struct Latch {
+    std::mutex mu;
+    std::condition_variable cv;
+    int left;
+    explicit Latch(int n) : left(n) {}
+    void count_down() {
+        std::lock_guard<std::mutex> lk(mu);
+        if (--left == 0) cv.notify_all();
+    }
+    void wait() {
+        std::unique_lock<std::mutex> lk(mu);
+        cv.wait(lk, [this] { return left == 0; });
+    }
+};
+
+int main() {
+    Logger log("http_client_async_test");
+    log.set_level(LogLevel::WARN);
+
+    // Token bucket: burst banked, then one token per 1/rate, waiters queue up
+    {
+        const auto t0 = TokenBucket::Clock::now();
+        TokenBucket b(10.0, 2.0);
+        assert(b.reserve(t0) == 0ns && b.reserve(t0) == 0ns);
+        assert(b.reserve(t0) == 100ms && b.reserve(t0) == 200ms);
+        assert(!b.try_acquire(t0 + 250ms) && b.try_acquire(t0 + 350ms));
+        assert(b.try_acquire(t0 + 10s) && b.try_acquire(t0 + 10s) && !b.try_acquire(t0 + 10s));
+    }
+
+    LocalHttpsServer::Options so;
+    so.threads = 2;
+    so.rtt = 2ms;                       // so that requests overlap
+    LocalHttpsServer srv(log, so);
+    srv.route("GET", "/quote", [](const Req& r) {
+        Res out;
+        out.body = "{\"symbol\":\"" + (r.query.count("s") ? r.query.at("s") : std::string()) + "\"}";
+        return out;
+    });
+    srv.route("POST", "/echo", [](const Req& r) {
+        Res out;
+        out.body = r.body;
+        return out;
+    });
+    assert(srv.start());
+
+    // Futures: many requests in flight, at most max_concurrent_per_host connections
+    {
+        auto o = client_opts(srv);
+        o.max_concurrent_per_host = 4;
+        HTTPClient c(o);
+        const auto before = srv.stats().connections;
+        std::vector<std::future<HttpResponse>> fs;
+        for (int i = 0; i < 40; ++i) fs.push_back(c.get_async(srv.url() + "/quote", {}, {{"s", "S" + std::to_string(i)}}));
+        for (int i = 0; i < 40; ++i) {
+            const auto r = fs[static_cast<std::size_t>(i)].get();
+            assert(r.status == 200 && r.body == "{\"symbol\":\"S" + std::to_string(i) + "\"}");
+        }
+        const auto s = c.stats();
+        assert(s.requests == 40 && s.queued > 0 && s.connects <= 4);
+        assert(srv.stats().connections - before == s.connects);
+
+        auto p = c.post_json_async(srv.url() + "/echo", R"({"a":1})").get();
+        assert(p.status == 200 && p.body == R"({"a":1})");
+        // the sync API shares the limits but not the connections
+        assert(c.get(srv.url() + "/quote").status == 200);
+    }
+
+    // Callbacks: no thread per request; a callback can issue the next page
+    {
+        HTTPClient c(client_opts(srv));
+        std::atomic<int> ok{0};
+        Latch latch(20);
+        std::function<void(int)> page = [&](int n) {
+            c.get_async(srv.url() + "/quote", {}, {{"s", std::to_string(n)}}, [&, n](std::error_code ec, HttpResponse r) {
+                if (!ec && r.status == 200) ok.fetch_add(1);
+                if (n % 2 == 0) page(n + 1);      // chained
+                latch.count_down();
+            });
+        };
+        for (int i = 0; i < 20; i += 2) page(i);
+        latch.wait();
+        assert(ok.load() == 20);
+    }
+
+    // Transport errors reach the callback / the future
+    {
+        LocalHttpsServer gone(log, {});
+        assert(gone.start());
+        const std::string url = gone.url() + "/quote";
+        auto o = client_opts(gone);
+        o.timeout = 2s;
+        gone.stop();
+        HTTPClient c(o);
+        std::promise<std::error_code> got;
+        c.get_async(url, {}, {}, [&got](std::error_code ec, HttpResponse) { got.set_value(ec); });
+        assert(got.get_future().get());
+        bool threw = false;
+        try {
+            c.get_async(url).get();
+        } catch (const std::system_error&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    // A request read on a reused connection and answered with a hang-up: the GET
+    // goes out again, the POST only once
+    {
+        LocalHttpsServer flaky(log, {});
+        std::atomic<int> gets{0}, posts{0};
+        flaky.route("GET", "/quote", [&gets](const Req&) {
+            Res out;
+            out.drop = gets.fetch_add(1) == 1;
+            return out;
+        });
+        flaky.route("POST", "/order", [&posts](const Req&) {
+            posts.fetch_add(1);
+            Res out;
+            out.drop = true;
+            return out;
+        });
+        assert(flaky.start());
+        HTTPClient c(client_opts(flaky));
+        assert(c.get_async(flaky.url() + "/quote").get().status == 200);
+        assert(c.get_async(flaky.url() + "/quote").get().status == 200);
+        assert(gets.load() == 3 && c.stats().retries == 1);
+
+        assert(c.get_async(flaky.url() + "/quote").get().status == 200);
+        bool threw = false;
+        try {
+            c.post_json_async(flaky.url() + "/order", R"({"qty":1})").get();
+        } catch (const std::system_error&) {
+            threw = true;
+        }
+        assert(threw && posts.load() == 1 && c.stats().retries == 1);
+    }
+
+    // Rate limit: 20/s with no burst spreads 11 requests over at least half a second
+    {
+        auto o = client_opts(srv);
+        o.max_requests_per_second = 20;
+        o.rate_burst = 1;
+        HTTPClient c(o);
+        const auto t0 = std::chrono::steady_clock::now();
+        std::vector<std::future<HttpResponse>> fs;
+        for (int i = 0; i < 8; ++i) fs.push_back(c.get_async(srv.url() + "/quote"));
+        for (int i = 0; i < 3; ++i) assert(c.get(srv.url() + "/quote").status == 200);
+        for (auto& f : fs) assert(f.get().status == 200);
+        assert(std::chrono::steady_clock::now() - t0 >= 480ms);
+        assert(c.stats().throttled >= 9);
+    }
+
+    // Sync callers share the host gate
+    {
+        auto o = client_opts(srv);
+        o.max_concurrent_per_host = 1;
+        HTTPClient c(o);
+        const auto before = srv.stats().connections;
+        std::vector<std::thread> ts;
+        for (int t = 0; t < 3; ++t) {
+            ts.emplace_back([&] {
+                for (int i = 0; i < 5; ++i) assert(c.get(srv.url() + "/quote").status == 200);
+            });
+        }
+        for (auto& t : ts) t.join();
+        assert(srv.stats().connections - before == 1 && c.stats().queued > 0);
+    }
+
+    std::cout << "http client async test finished\n";
+    return 0;
+}
@@ -0,0 +1,251 @@
+#include "http_client.h"
+#include "local_https_server.h"
+#include "logger.h"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Req = LocalHttpsServer::Request;
+using Res = LocalHttpsServer::Response;
+
+static void add_routes(LocalHttpsServer& srv) {
+    srv.route("GET", "/ping", [](const Req& r) {
+        Res out;
+        out.body = "{\"conn\":" + std::to_string(r.connection) + "}";
+        return out;
+    });
+    srv.route("GET", "/echo", [](const Req& r) {
+        Res out;
+        out.body = r.query.count("q") ? r.query.at("q") : "";
+        return out;
+    });
+    srv.route("POST", "/echo", [](const Req& r) {
+        Res out;
+        out.body = r.body;
+        out.headers["X-Content-Type"] = r.headers.count("content-type") ? r.headers.at("content-type") : "";
+        return out;
+    });
+}
+
+static HTTPClient::Options client_opts(const LocalHttpsServer& srv) {
+    HTTPClient::Options o;
+    o.ca_file = srv.cert_file();
+    o.timeout = std::chrono::seconds(5);
+    return o;
+}
+
+int main() {
+    Logger log("http_client_pool_test");
+    log.set_level(LogLevel::WARN);
+
+    // Sequential requests share one keep-alive connection
+    {
+        LocalHttpsServer srv(log, {});
+        add_routes(srv);
+        assert(srv.start());
+        HTTPClient c(client_opts(srv));
+        for (int i = 0; i < 20; ++i) {
+            auto r = c.get(srv.url() + "/ping");
+            assert(r.status == 200 && r.body == "{\"conn\":1}");
+        }
+        auto g = c.get(srv.url() + "/echo", {}, {{"q", "a b&c"}});
+        assert(g.status == 200 && g.body == "a b&c");
+        auto p = c.post_json(srv.url() + "/echo", R"({"x":1})");
+        assert(p.status == 200 && p.body == R"({"x":1})" && p.headers["X-Content-Type"] == "application/json");
+        assert(c.get(srv.url() + "/missing").status == 404);
+
+        const auto s = c.stats();
+        assert(s.requests == 23 && s.connects == 1 && s.reused == 22 && s.dns_lookups == 1);
+        assert(srv.stats().connections == 1 && srv.stats().requests == 23);
+    }
+
+    // The server closes idle connections: the dead one is noticed and replaced
+    {
+        LocalHttpsServer::Options so;
+        so.idle_close = std::chrono::milliseconds(50);
+        LocalHttpsServer srv(log, so);
+        add_routes(srv);
+        assert(srv.start());
+        HTTPClient c(client_opts(srv));
+        assert(c.get(srv.url() + "/ping").status == 200);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        assert(c.get(srv.url() + "/ping").body == "{\"conn\":2}");
+        const auto s = c.stats();
+        assert(s.connects == 2 && s.evicted + s.retries >= 1);
+        // the second connection resumed the first one's TLS session
+        assert(s.resumed == 1 && srv.stats().resumed == 1);
+    }
+
+    // The server reads a request on a reused connection and hangs up without an
+    // answer: a GET is sent again on a new connection, a POST is not
+    {
+        LocalHttpsServer srv(log, {});
+        add_routes(srv);
+        int gets = 0, posts = 0;
+        srv.route("GET", "/flaky", [&gets](const Req&) {
+            Res out;
+            out.drop = ++gets == 1;
+            return out;
+        });
+        srv.route("POST", "/order", [&posts](const Req&) {
+            ++posts;
+            Res out;
+            out.drop = true;
+            return out;
+        });
+        assert(srv.start());
+        HTTPClient c(client_opts(srv));
+        assert(c.get(srv.url() + "/ping").status == 200);
+        assert(c.get(srv.url() + "/flaky").status == 200);
+        assert(gets == 2 && c.stats().retries == 1);
+
+        assert(c.get(srv.url() + "/ping").status == 200);
+        bool threw = false;
+        try {
+            c.post_json(srv.url() + "/order", R"({"qty":1})");
+        } catch (const std::exception&) {
+            threw = true;
+        }
+        assert(threw && posts == 1 && c.stats().retries == 1);
+    }
+
+    // Connections dropped without close_notify, and the server hanging up after each response
+    {
+        LocalHttpsServer::Options so;
+        so.max_requests_per_connection = 2;
+        LocalHttpsServer srv(log, so);
+        add_routes(srv);
+        assert(srv.start());
+        HTTPClient c(client_opts(srv));
+        for (int i = 0; i < 6; ++i) assert(c.get(srv.url() + "/ping").status == 200);
+        assert(srv.stats().connections == 3);
+        srv.drop_all();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        assert(c.get(srv.url() + "/ping").status == 200);
+        assert(srv.stats().connections == 4);
+    }
+
+    // Client-side idle timeout and close_idle()
+    {
+        LocalHttpsServer srv(log, {});
+        add_routes(srv);
+        assert(srv.start());
+        auto o = client_opts(srv);
+        o.idle_timeout = std::chrono::seconds(1);
+        HTTPClient c(o);
+        assert(c.get(srv.url() + "/ping").status == 200);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+        assert(c.get(srv.url() + "/ping").body == "{\"conn\":2}");
+        assert(c.stats().evicted == 1);
+        c.close_idle();
+        assert(c.get(srv.url() + "/ping").body == "{\"conn\":3}");
+        assert(c.stats().evicted == 2 && c.stats().dns_lookups == 1);
+    }
+
+    // No pooling: a connection per request, but TLS sessions are still resumed
+    {
+        LocalHttpsServer srv(log, {});
+        add_routes(srv);
+        assert(srv.start());
+        auto o = client_opts(srv);
+        o.max_idle_per_host = 0;
+        HTTPClient c(o);
+        for (int i = 0; i < 5; ++i) assert(c.get(srv.url() + "/ping").status == 200);
+        const auto s = c.stats();
+        assert(s.connects == 5 && s.reused == 0 && s.resumed == 4 && s.dns_lookups == 1);
+        assert(srv.stats().connections == 5 && srv.stats().resumed == 4);
+
+        o.tls_session_reuse = false;
+        HTTPClient full(o);
+        for (int i = 0; i < 3; ++i) assert(full.get(srv.url() + "/ping").status == 200);
+        assert(full.stats().resumed == 0);
+    }
+
+    // Concurrent callers: each gets its own connection, at most max_idle_per_host kept
+    {
+        LocalHttpsServer::Options so;
+        so.threads = 2;
+        LocalHttpsServer srv(log, so);
+        add_routes(srv);
+        assert(srv.start());
+        auto o = client_opts(srv);
+        o.max_idle_per_host = 2;
+        HTTPClient c(o);
+        std::vector<std::thread> ts;
+        for (int t = 0; t < 4; ++t) {
+            ts.emplace_back([&] {
+                for (int i = 0; i < 25; ++i) assert(c.get(srv.url() + "/ping").status == 200);
+            });
+        }
+        for (auto& t : ts) t.join();
+        const auto s = c.stats();
+        assert(s.requests == 100 && s.connects + s.reused == 100);
+        assert(s.connects <= 4 + s.evicted);
+        assert(srv.stats().requests == 100);
+    }
+
+    // Streamed bodies: chunks to a sink or a file; a stopped stream drops its connection
+    {
+        LocalHttpsServer srv(log, {});
+        std::string big;
+        for (int i = 0; big.size() < 1000000; ++i) big += std::to_string(i) + ',';
+        srv.route("GET", "/big", [&big](const Req&) {
+            Res out;
+            out.body = big;
+            out.content_type = "text/plain";
+            return out;
+        });
+        add_routes(srv);
+        assert(srv.start());
+        auto o = client_opts(srv);
+        o.stream_chunk = 8192;
+        HTTPClient c(o);
+
+        std::string got;
+        std::size_t chunks = 0;
+        auto r = c.get_stream(srv.url() + "/big", [&](std::string_view chunk) {
+            assert(chunk.size() <= 8192);
+            ++chunks;
+            got.append(chunk);
+            return true;
+        });
+        assert(r.status == 200 && r.body.empty() && got == big && chunks >= big.size() / 8192);
+        assert(c.get(srv.url() + "/ping").body == "{\"conn\":1}");     // kept alive
+
+        std::size_t seen = 0;
+        r = c.get_stream(srv.url() + "/big", [&](std::string_view chunk) {
+            seen += chunk.size();
+            return seen < 100000;
+        });
+        assert(r.status == 200 && seen < big.size());
+        assert(c.get(srv.url() + "/ping").body == "{\"conn\":2}");     // the stopped one was dropped
+
+        const std::string path = "/tmp/alpha-http-download-test.txt";
+        r = c.download(srv.url() + "/big", path);
+        std::ifstream in(path, std::ios::binary);
+        std::ostringstream file;
+        file << in.rdbuf();
+        assert(r.status == 200 && file.str() == big);
+        std::remove(path.c_str());
+
+        // buffered responses over body_limit fail; the stream has no limit
+        o.body_limit = 4096;
+        HTTPClient small(o);
+        bool threw = false;
+        try {
+            small.get(srv.url() + "/big");
+        } catch (const std::exception&) {
+            threw = true;
+        }
+        assert(threw);
+        assert(small.get_stream(srv.url() + "/big", [](std::string_view) { return true; }).status == 200);
+    }
+
+    std::cout << "http client pool test finished\n";
+    return 0;
+}
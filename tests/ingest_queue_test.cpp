@@ -1,4 +1,6 @@
 #include "ingest_queue.h"
+#include "alloc_counter.h"
+#include <atomic>
 #include <cassert>
 #include <iostream>
 #include <thread>
@@ -67,6 +69,67 @@ int main() {
     cons.join();
     assert(q2.empty());
 
+    // View pushes copy into recycled slot buffers: no allocation in steady state
+    IngestQueue q3(8);
+    const std::string frame(200, 'x');           // longer than SSO
+    std::string out;
+    for (int i = 0; i < 32; ++i) {                // warm every slot + out
+        assert(q3.try_push_view(frame));
+        assert(q3.try_pop(out) && out == frame);
+    }
+    const auto a0 = AllocCounter::thread_allocations();
+    for (int i = 0; i < 1000; ++i) {
+        assert(q3.try_push_view(frame));
+        assert(q3.try_pop(out));
+    }
+    assert(out == frame);
+    assert(AllocCounter::enabled());
+    assert(AllocCounter::thread_allocations() == a0);
+
+    // Drop-oldest: a full queue keeps the newest capacity() frames
+    IngestQueue qe(8, /*allow_evict=*/true);
+    const IngestQueue::Stamp st{};
+    for (int i = 0; i < 8; ++i) assert(qe.try_push_view_evict(std::to_string(i), st) == IngestQueue::PushResult::Pushed);
+    assert(!qe.try_push_view("x"));
+    for (int i = 8; i < 11; ++i) assert(qe.try_push_view_evict(std::to_string(i), st) == IngestQueue::PushResult::Evicted);
+    assert(qe.size() == 8);
+    for (int i = 3; i < 11; ++i) assert(qe.try_pop(tmp) && tmp == std::to_string(i));
+    assert(!qe.try_pop(tmp));
+
+    // Evicting producer vs consumer: order preserved, nothing torn or duplicated,
+    // and every frame is either consumed or counted as evicted
+    {
+        IngestQueue q4(16, true);
+        const int M = 200000;
+        int evicted = 0, full = 0;
+        std::atomic<bool> done{false};
+        std::thread p([&] {
+            for (int i = 0; i < M; ++i) {
+                const std::string v = std::to_string(i) + ":" + std::string(static_cast<std::size_t>(i % 50), 'y');
+                switch (q4.try_push_view_evict(v, IngestQueue::Stamp{i, 0, 0})) {
+                    case IngestQueue::PushResult::Evicted: ++evicted; break;
+                    case IngestQueue::PushResult::Full:    ++full; break;
+                    default: break;
+                }
+            }
+            done = true;
+        });
+        int consumed = 0, last = -1;
+        std::string s;
+        IngestQueue::Stamp ps;
+        while (!done.load() || !q4.empty()) {
+            if (!q4.try_pop(s, ps)) { std::this_thread::yield(); continue; }
+            const int v = std::stoi(s);
+            assert(v > last && ps.arrival_ns == v);
+            assert(s.size() == std::to_string(v).size() + 1 + static_cast<std::size_t>(v % 50));
+            last = v;
+            ++consumed;
+        }
+        p.join();
+        assert(consumed + evicted + full == M);
+        assert(last == M - 1 || full > 0);
+    }
+
     std::cout << "IngestQueue test passed.\n";
     return 0;
 }
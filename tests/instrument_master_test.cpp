@@ -0,0 +1,191 @@
+#include "instrument_master.h"
+#include "http_client.h"
+#include "local_https_server.h"
+#include "logger.h"
+#include "ltp_store.h"
+#include "parser.h"
+#include "sharder.h"
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const char* kMaster = R"([
+ {"token":"3045","symbol":"SBIN-EQ","name":"SBIN","expiry":"","strike":"-1.000000","lotsize":"1","instrumenttype":"","exch_seg":"NSE","tick_size":"5.000000"},
+ {"token":"500112","symbol":"SBIN","name":"SBIN","expiry":"","strike":"-1.000000","lotsize":"1","instrumenttype":"","exch_seg":"BSE","tick_size":"5.000000"},
+ {"token":"43210","symbol":"NIFTY26DEC2424000CE","name":"NIFTY","expiry":"26DEC2024","strike":"2400000.000000","lotsize":"25","instrumenttype":"OPTIDX","exch_seg":"NFO","tick_size":"5.000000"},
+ {"token":"3045","symbol":"SOMETHING","name":"X","expiry":"","strike":"-1","lotsize":"1","instrumenttype":"","exch_seg":"NFO","tick_size":"5"},
+ {"token":"26000","symbol":"Nifty 50","name":"NIFTY","expiry":"","strike":-1,"lotsize":1,"instrumenttype":"AMXIDX","exch_seg":"NSE","tick_size":0.05,"extra":{"ignored":["x"]}},
+ {"token":"3045","symbol":"SBIN-DUP","name":"SBIN","expiry":"","strike":"-1","lotsize":"1","instrumenttype":"","exch_seg":"NSE","tick_size":"5"},
+ {"symbol":"NO-TOKEN","exch_seg":"NSE"},
+ {"token":"999","symbol":"ODD","name":"ODD","exch_seg":"XYZ"}
+])";
+
+static void check_lookups(const InstrumentMaster& im) {
+    assert(im.size() == 7);   // one record had no token
+
+    // same token on two exchanges resolves per exchange
+    auto sbin = im.by_token("NSE", "3045");
+    assert(sbin && sbin->symbol == "SBIN-EQ" && sbin->name == "SBIN" && sbin->lot_size == 1 && sbin->tick_size == 5.0);
+    auto other = im.by_token("NFO", "3045");
+    assert(other && other->symbol == "SOMETHING");
+    assert(!im.by_token("BSE", "3045") && !im.by_token("NSE", "1"));
+
+    auto opt = im.find("NFO:NIFTY26DEC2424000CE");
+    assert(opt && opt->token == "43210" && opt->lot_size == 25 && opt->strike == 2400000.0);
+    assert(opt->instrument_type == "OPTIDX" && opt->expiry == "26DEC2024" && opt->exchange == "NFO");
+    assert(InstrumentMaster::feed_key(*opt) == "nse_fo|43210");
+
+    // numbers are accepted where strings are expected
+    auto idx = im.find("Nifty 50");
+    assert(idx && idx->token == "26000" && idx->lot_size == 1 && idx->tick_size == 0.05 && idx->strike == -1);
+
+    assert(im.find("BSE:SBIN")->token == "500112");
+    assert(!im.find("SBIN") && !im.find("NFO:SBIN-EQ"));
+    assert(InstrumentMaster::feed_key(*im.by_token("XYZ", "999")) == "999");
+    // later duplicates are kept as records but do not shadow the first
+    assert(im.at(5).symbol == "SBIN-DUP" && im.by_symbol("NSE", "SBIN-DUP")->token == "3045");
+    bool threw = false;
+    try {
+        im.at(im.size());
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+int main() {
+    Logger log("instrument_master_test");
+    log.set_level(LogLevel::WARN);
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "alpha-instrument-test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    // Parse, look up, then the same through a cache round trip
+    {
+        InstrumentMaster im(log);
+        std::istringstream in(kMaster);
+        std::string err;
+        assert(im.parse_json(in, "2024-12-02", &err));
+        assert(im.date() == "2024-12-02" && !im.stats().from_cache);
+        check_lookups(im);
+
+        const std::string path = InstrumentMaster::cache_path(dir.string(), "2024-12-02");
+        assert(im.save_cache(path, &err));
+        assert(!std::filesystem::exists(path + ".tmp"));
+
+        InstrumentMaster cached(log);
+        assert(cached.load_cache(path, "2024-12-02", &err));
+        assert(cached.stats().from_cache && cached.stats().image_bytes == std::filesystem::file_size(path));
+        check_lookups(cached);
+
+        // another day's cache is a miss, and so is any damage
+        assert(!cached.load_cache(path, "2024-12-03", &err) && err == "cache is for another date");
+        assert(cached.size() == 7);     // a failed load keeps what was there
+
+        const auto bytes = std::filesystem::file_size(path);
+        std::filesystem::resize_file(path, bytes - 1);
+        assert(!cached.load_cache(path, "2024-12-02", &err) && err == "cache layout corrupt");
+        assert(im.save_cache(path));
+        {
+            std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+            f.seekp(0);
+            f.write("XXXX", 4);
+        }
+        assert(!cached.load_cache(path, "2024-12-02", &err) && err == "not an instrument cache");
+        assert(im.save_cache(path));
+        {
+            // a record's string offset beyond the blob
+            std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+            f.seekp(88 + 56 * 2);
+            const std::uint32_t huge = 0x7fffffff;
+            f.write(reinterpret_cast<const char*>(&huge), 4);
+        }
+        assert(!cached.load_cache(path, "2024-12-02", &err) && err == "cache record corrupt");
+        assert(im.save_cache(path));
+        {
+            // a token table with no empty slot (a lookup miss would never terminate)
+            std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+            std::uint64_t table_off = 0;
+            std::uint32_t slots = 0;
+            f.seekg(56);
+            f.read(reinterpret_cast<char*>(&table_off), 8);
+            f.seekg(72);
+            f.read(reinterpret_cast<char*>(&slots), 4);
+            f.seekp(static_cast<std::streamoff>(table_off));
+            const std::uint32_t first = 1;
+            for (std::uint32_t i = 0; i < slots; ++i) f.write(reinterpret_cast<const char*>(&first), 4);
+        }
+        assert(!cached.load_cache(path, "2024-12-02", &err) && err == "cache index corrupt");
+        assert(im.save_cache(path));
+        {
+            // an offset that would wrap when added to
+            std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+            f.seekp(40);
+            const std::uint64_t wraps = ~std::uint64_t{0} - 8;
+            f.write(reinterpret_cast<const char*>(&wraps), 8);
+        }
+        assert(!cached.load_cache(path, "2024-12-02", &err) && err == "cache layout corrupt");
+        assert(!cached.load_cache((dir / "missing.bin").string(), "2024-12-02", &err));
+
+        // invalid JSON
+        std::istringstream bad(R"([{"token":"1",)");
+        assert(!im.parse_json(bad, "2024-12-02", &err) && err.find("scrip master: unexpected end of input") == 0);
+    }
+
+    // load(): download and write the cache once, then read only the cache
+    {
+        LocalHttpsServer srv(log, {});
+        int downloads = 0;
+        srv.route("GET", "/master.json", [&downloads](const LocalHttpsServer::Request&) {
+            ++downloads;
+            LocalHttpsServer::Response r;
+            r.body = kMaster;
+            return r;
+        });
+        assert(srv.start());
+        HTTPClient::Options o;
+        o.ca_file = srv.cert_file();
+        HTTPClient http(o);
+
+        const InstrumentMaster::LoadOptions lo{srv.url() + "/master.json", (dir / "sub").string(), "2024-12-05"};
+        std::string err;
+        InstrumentMaster a(log);
+        assert(a.load(http, lo, &err) && downloads == 1 && !a.stats().from_cache);
+        check_lookups(a);
+        assert(std::filesystem::exists(InstrumentMaster::cache_path(lo.cache_dir, "2024-12-05")));
+
+        InstrumentMaster b(log);
+        assert(b.load(http, lo, &err) && downloads == 1 && b.stats().from_cache);
+        check_lookups(b);
+
+        InstrumentMaster c(log);
+        assert(!c.load(http, {srv.url() + "/missing.json", "", "2024-12-05"}, &err));
+        assert(err == "scrip master download: HTTP 404" && c.size() == 0 && !c.find("SBIN-EQ"));
+    }
+
+    // Sharder: symbols become tokens; other segments keep theirs
+    {
+        InstrumentMaster im(log);
+        std::istringstream in(kMaster);
+        assert(im.parse_json(in, "2024-12-02"));
+
+        Parser parser;
+        LTPStore store;
+        Sharder::Options so;
+        so.wss_url = "wss://127.0.0.1:1/ws";
+        Sharder sh(log, parser, store, so);
+        const auto missing = sh.set_symbols(im, {"SBIN-EQ", "NFO:NIFTY26DEC2424000CE", "NSE:NOPE", "BSE:SBIN", "NSE:Nifty 50"});
+        assert((missing == std::vector<std::string>{"NSE:NOPE"}));
+        assert((sh.desired_tokens_snapshot() == std::vector<std::string>{"3045", "nse_fo|43210", "bse_cm|500112", "26000"}));
+    }
+
+    std::filesystem::remove_all(dir);
+    std::cout << "instrument master test finished\n";
+    return 0;
+}
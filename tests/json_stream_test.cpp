@@ -0,0 +1,238 @@
+#include "json_stream.h"
+#include "http_client.h"
+#include "local_https_server.h"
+#include "logger.h"
+#include <nlohmann/json.hpp>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Every event as a short token: "{" "}" "[" "]" "k:name" "s:text" "u:1" "i:-1" "f:raw" "t" "F" "n"
+struct Recorder : JsonSaxHandler {
+    std::vector<std::string> ev;
+    bool null() override { ev.push_back("n"); return true; }
+    bool boolean(bool b) override { ev.push_back(b ? "t" : "F"); return true; }
+    bool number_integer(std::int64_t v) override { ev.push_back("i:" + std::to_string(v)); return true; }
+    bool number_unsigned(std::uint64_t v) override { ev.push_back("u:" + std::to_string(v)); return true; }
+    bool number_float(double, std::string_view raw) override { ev.push_back("f:" + std::string(raw)); return true; }
+    bool string(std::string_view s) override { ev.push_back("s:" + std::string(s)); return true; }
+    bool key(std::string_view k) override { ev.push_back("k:" + std::string(k)); return true; }
+    bool start_object() override { ev.push_back("{"); return true; }
+    bool end_object() override { ev.push_back("}"); return true; }
+    bool start_array() override { ev.push_back("["); return true; }
+    bool end_array() override { ev.push_back("]"); return true; }
+};
+
+// Rebuilds the document, to compare with nlohmann's own parse
+struct DomBuilder : JsonSaxHandler {
+    nlohmann::json root;
+    std::vector<nlohmann::json*> stack;
+    std::string pending_key;
+
+    nlohmann::json* put(nlohmann::json v) {
+        if (stack.empty()) {
+            root = std::move(v);
+            return &root;
+        }
+        nlohmann::json& top = *stack.back();
+        if (top.is_array()) {
+            top.push_back(std::move(v));
+            return &top.back();
+        }
+        top[pending_key] = std::move(v);
+        return &top[pending_key];
+    }
+    bool null() override { put(nullptr); return true; }
+    bool boolean(bool b) override { put(b); return true; }
+    bool number_integer(std::int64_t v) override { put(v); return true; }
+    bool number_unsigned(std::uint64_t v) override { put(v); return true; }
+    bool number_float(double d, std::string_view) override { put(d); return true; }
+    bool string(std::string_view s) override { put(std::string(s)); return true; }
+    bool key(std::string_view k) override { pending_key = k; return true; }
+    bool start_object() override { stack.push_back(put(nlohmann::json::object())); return true; }
+    bool end_object() override { stack.pop_back(); return true; }
+    bool start_array() override { stack.push_back(put(nlohmann::json::array())); return true; }
+    bool end_array() override { stack.pop_back(); return true; }
+};
+
+static std::vector<std::string> events(const std::string& doc, std::size_t split = 0, bool bytewise = false) {
+    Recorder r;
+    JsonStreamParser p(r);
+    if (bytewise) {
+        for (char c : doc) assert(p.feed(std::string_view(&c, 1)));
+    } else {
+        assert(p.feed(std::string_view(doc).substr(0, split)));
+        assert(p.feed(std::string_view(doc).substr(split)));
+    }
+    assert(p.finish() && p.values() == 1 && p.bytes() == doc.size());
+    return r.ev;
+}
+
+static std::string error_of(const std::string& doc, JsonStreamParser::Options o = {}) {
+    Recorder r;
+    JsonStreamParser p(r, o);
+    if (p.feed(doc)) p.finish();
+    assert(p.failed());
+    return p.error();
+}
+
+static nlohmann::json random_value(std::mt19937& rng, int depth) {
+    const int kind = static_cast<int>(rng() % (depth > 3 ? 6 : 8));
+    switch (kind) {
+    case 0: return nullptr;
+    case 1: return rng() % 2 == 0;
+    case 2: return static_cast<std::int64_t>(rng()) - (1LL << 31);
+    case 3: return static_cast<double>(rng()) / 977.0;
+    case 4: {
+        std::string s;
+        const char* alphabet[] = {"a", "Z", " ", "\"", "\\", "/", "\n", "\t", "\x01", "\xc3\xa9", "\xe2\x82\xb9", "\xf0\x9f\x98\x80"};
+        for (std::size_t n = rng() % 12; n > 0; --n) s += alphabet[rng() % 12];
+        return s;
+    }
+    case 5: return std::uint64_t{18446744073709551615ULL} - rng() % 10;
+    case 6: {
+        auto a = nlohmann::json::array();
+        for (std::size_t n = rng() % 5; n > 0; --n) a.push_back(random_value(rng, depth + 1));
+        return a;
+    }
+    default: {
+        auto o = nlohmann::json::object();
+        for (std::size_t n = rng() % 5; n > 0; --n) o["k" + std::to_string(rng() % 100)] = random_value(rng, depth + 1);
+        return o;
+    }
+    }
+}
+
+int main() {
+    // Events, identical however the input is split
+    {
+        const std::string doc =
+            R"( {"token":"26000","ltp":101.25,"qty":-5,"lot":50,"ok":true,"off":false,"x":null,)"
+            R"("big":18446744073709551615,"bigger":18446744073709551616,"e":1e-3,)"
+            R"("esc":"a\"b\\c\/d\n\u00e9\ud83d\ude00","arr":[[],{},[1,[2]]]} )";
+        const std::vector<std::string> want = {
+            "{", "k:token", "s:26000", "k:ltp", "f:101.25", "k:qty", "i:-5", "k:lot", "u:50",
+            "k:ok", "t", "k:off", "F", "k:x", "n",
+            "k:big", "u:18446744073709551615", "k:bigger", "f:18446744073709551616", "k:e", "f:1e-3",
+            "k:esc", "s:a\"b\\c/d\n\xc3\xa9\xf0\x9f\x98\x80",
+            "k:arr", "[", "[", "]", "{", "}", "[", "u:1", "[", "u:2", "]", "]", "]", "}"};
+        assert(events(doc, doc.size()) == want);
+        assert(events(doc, 0, true) == want);
+        for (std::size_t i = 0; i <= doc.size(); ++i) assert(events(doc, i) == want);
+
+        // top-level scalars, a number ended only by finish()
+        assert(events("42") == std::vector<std::string>{"u:42"});
+        assert(events("-0.5e+2") == std::vector<std::string>{"f:-0.5e+2"});
+        assert(events("\"s\"") == std::vector<std::string>{"s:s"});
+        // unpaired surrogates become U+FFFD
+        assert(events(R"("\ud83dx\ude00")") == std::vector<std::string>{"s:\xef\xbf\xbdx\xef\xbf\xbd"});
+    }
+
+    // Errors carry the byte offset; nothing is accepted after one
+    {
+        assert(error_of("[1,]") == "unexpected character at byte 3");
+        assert(error_of(R"({"a" 1})") == "expected ':' at byte 5");
+        assert(error_of("[01]").find("invalid number") == 0);
+        assert(error_of("[1.]").find("invalid number") == 0);
+        assert(error_of("[tru]") == "invalid literal at byte 4");
+        assert(error_of("\"abc") == "unexpected end of input at byte 4");
+        assert(error_of("[1] x") == "trailing characters at byte 4");
+        assert(error_of("[1}").find("mismatched bracket") == 0);
+        assert(error_of(R"("\x")").find("invalid escape") == 0);
+        assert(error_of("\"a\nb\"").find("control character") == 0);
+        assert(error_of("{1:2}").find("expected object key") == 0);
+        assert(error_of("").find("empty input") == 0);
+        assert(error_of("[[[]]]", {2, 1 << 20, false}).find("nesting too deep") == 0);
+        assert(error_of("\"abcdef\"", {512, 4, false}).find("string too long") == 0);
+
+        Recorder r;
+        JsonStreamParser p(r);
+        assert(!p.feed("[1,,") && !p.feed("2]") && !p.finish());
+        p.reset();
+        assert(p.feed("[2]") && p.finish());
+    }
+
+    // NDJSON / concatenated values, and a handler that stops the parse
+    {
+        Recorder r;
+        JsonStreamParser p(r, {512, 1 << 20, true});
+        assert(p.feed("{\"a\":1}\n{\"a\":2}\n3 4") && p.finish());
+        assert(p.values() == 4 && r.ev.back() == "u:4");
+
+        struct StopAtThird : JsonSaxHandler {
+            int n = 0;
+            bool number_unsigned(std::uint64_t) override { return ++n < 3; }
+        } stop;
+        JsonStreamParser q(stop);
+        assert(!q.feed("[1,2,3,4]") && q.error() == "stopped by handler at byte 6" && stop.n == 3);
+    }
+
+    // Random documents: same value as nlohmann::json::parse, in random chunks
+    {
+        std::mt19937 rng(7);
+        for (int i = 0; i < 300; ++i) {
+            const nlohmann::json v = random_value(rng, 0);
+            const std::string doc = v.dump(static_cast<int>(rng() % 3) - 1);
+            DomBuilder b;
+            JsonStreamParser p(b);
+            for (std::size_t at = 0; at < doc.size();) {
+                const std::size_t n = 1 + rng() % 16;
+                assert(p.feed(std::string_view(doc).substr(at, n)));
+                at += n;
+            }
+            assert(p.finish());
+            assert(b.root == nlohmann::json::parse(doc));
+        }
+    }
+
+    // Parsing while downloading: a 4 MB instrument list, streamed in chunks
+    {
+        Logger log("json_stream_test");
+        log.set_level(LogLevel::WARN);
+        std::string master = "[";
+        const int n = 20000;
+        for (int i = 0; i < n; ++i) {
+            if (i) master += ',';
+            master += R"({"token":")" + std::to_string(100000 + i) + R"(","symbol":"SYM)" + std::to_string(i)
+                    + R"(-EQ","name":"SYMBOL NUMBER )" + std::to_string(i)
+                    + R"(","expiry":"","strike":"-1.000000","lotsize":"1","instrumenttype":"","exch_seg":"NSE","tick_size":"5.000000"})";
+        }
+        master += "]";
+
+        LocalHttpsServer srv(log, {});
+        srv.route("GET", "/master.json", [&master](const LocalHttpsServer::Request&) {
+            LocalHttpsServer::Response r;
+            r.body = master;
+            return r;
+        });
+        assert(srv.start());
+        HTTPClient::Options o;
+        o.ca_file = srv.cert_file();
+        o.stream_chunk = 16 * 1024;
+        HTTPClient http(o);
+
+        struct Count : JsonSaxHandler {
+            int depth = 0, records = 0;
+            bool saw_last = false;
+            bool start_object() override { ++depth; return true; }
+            bool end_object() override { if (--depth == 0) ++records; return true; }
+            bool string(std::string_view s) override { if (s == "SYM19999-EQ") saw_last = true; return true; }
+        } count;
+        JsonStreamParser parser(count);
+        std::size_t chunks = 0, largest = 0, total = 0;
+        const auto res = http.get_stream(srv.url() + "/master.json", [&](std::string_view c) {
+            ++chunks;
+            largest = std::max(largest, c.size());
+            total += c.size();
+            return parser.feed(c);
+        });
+        assert(res.status == 200 && res.body.empty() && res.headers.at("Content-Type") == "application/json");
+        assert(parser.finish() && count.records == n && count.saw_last);
+        assert(total == master.size() && largest <= o.stream_chunk && chunks >= master.size() / o.stream_chunk);
+    }
+
+    std::cout << "json stream test finished\n";
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include "latency_histogram.h"
+#include "consumer.h"
+#include "logger.h"
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+static bool near(std::uint64_t got, std::uint64_t want) {
+    return std::fabs(static_cast<double>(got) - static_cast<double>(want)) <= 0.04 * static_cast<double>(want) + 1;
+}
+
+int main() {
+    // Bucketing: exact at the bottom, ~3% relative precision above, monotonic
+    for (std::uint64_t v = 0; v < 64; ++v) assert(LatencyHistogram::highest_equivalent(LatencyHistogram::index(v)) == v);
+    std::size_t prev = 0;
+    for (std::uint64_t v = 1; v < (1ull << 30); v = v * 3 / 2 + 1) {
+        const auto i = LatencyHistogram::index(v);
+        assert(i >= prev && i < LatencyHistogram::kBuckets);
+        const auto hi = LatencyHistogram::highest_equivalent(i);
+        assert(hi >= v && hi - v <= v / 16);
+        prev = i;
+    }
+    assert(LatencyHistogram::index(~0ull) == LatencyHistogram::kBuckets - 1);
+
+    // Quantiles of 1..100000
+    LatencyHistogram h;
+    for (std::uint64_t v = 1; v <= 100000; ++v) h.record(v);
+    assert(h.count() == 100000 && h.max() == 100000);
+    assert(near(h.quantile(0.50), 50000));
+    assert(near(h.quantile(0.99), 99000));
+    assert(near(h.quantile(0.999), 99900));
+    assert(h.quantile(1.0) == 100000);
+
+    // Merge: a reader-side copy sums counts and keeps the max
+    LatencyHistogram other;
+    for (int i = 0; i < 100000; ++i) other.record(1000000);
+    LatencyHistogram merged(h);
+    merged.merge_from(other);
+    assert(merged.count() == 200000 && merged.max() == 1000000);
+    assert(near(merged.quantile(0.25), 50000));
+    assert(near(merged.quantile(0.75), 1000000));
+
+    // Concurrent reads while one thread records
+    {
+        LatencyHistogram live;
+        std::atomic<bool> done{false};
+        std::thread writer([&] { for (int i = 0; i < 2000000; ++i) live.record(static_cast<std::uint64_t>(i & 1023)); done = true; });
+        while (!done) { LatencyHistogram snap(live); assert(snap.quantile(1.0) <= 1023); }
+        writer.join();
+        assert(live.count() == 2000000);
+    }
+
+    // TSC calibration and ns summaries
+    const double k = tsc_ns_per_tick();
+    assert(k > 0);
+    const auto t0 = tsc_now();
+    std::this_thread::sleep_for(10ms);
+    const double slept_ns = static_cast<double>(tsc_now() - t0) * k;
+    assert(slept_ns > 9e6 && slept_ns < 1e9);
+
+    // Consumer records every stage for stamped frames; unstamped ones are skipped
+    {
+        Logger log("latency_test");
+        IngestQueue q(64);
+        Parser parser;
+        LTPStore store;
+        StageHistograms timing;
+        Consumer c(q, parser, store, log);
+        c.set_stage_timing(&timing);
+        c.start();
+        const std::string frame = R"({"data":{"token":"26000","ltp":1.5,"exchange_timestamp":1728123456789}})";
+        for (int i = 0; i < 10; ++i) {
+            IngestQueue::Stamp st;
+            st.read_tsc = tsc_now();
+            st.enqueue_tsc = tsc_now();
+            while (!q.try_push_view(frame, st)) std::this_thread::yield();
+        }
+        while (!q.try_push_view(frame)) std::this_thread::yield();
+        for (int i = 0; i < 200 && timing[Stage::Total].count() < 10; ++i) std::this_thread::sleep_for(5ms);
+        std::this_thread::sleep_for(20ms);
+        c.stop();
+        const auto s = timing.summaries();
+        for (std::size_t i = 0; i < kStageCount; ++i) assert(s[i].count == 10);
+        const auto& total = s[static_cast<std::size_t>(Stage::Total)];
+        assert(total.max_ns >= total.p50_ns && total.max_ns > 0);
+        assert(std::string(stage_name(Stage::QueueWait)) == "queue_wait");
+    }
+
+    std::cout << "LatencyHistogram test passed.\n";
+    return 0;
+}
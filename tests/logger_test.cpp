@@ -1,7 +1,17 @@
 #include "logger.h"
+#include <cassert>
 #include <thread>
 #include <vector>
 #include <iostream>
+#include <sstream>
+#include <string>
+
+static std::vector<std::string> lines_of(const std::string& s) {
+    std::vector<std::string> out;
+    std::istringstream in(s);
+    for (std::string l; std::getline(in, l);) out.push_back(l);
+    return out;
+}
 
 int main() {
     Logger log("logger_test");
@@ -22,6 +32,142 @@ int main() {
     }
     for (auto &x : th) x.join();
 
+    // Line format: "YYYY-mm-dd HH:MM:SS.mmm [LEVEL] name: payload"
+    {
+        std::ostringstream out;
+        Logger sync("fmt", out);
+        sync.warn("hello");
+        const std::string l = out.str();
+        assert(l.size() == 23 + std::string(" [WARN] fmt: hello\n").size());
+        assert(l[4] == '-' && l[10] == ' ' && l[19] == '.');
+        assert(l.compare(23, std::string::npos, " [WARN] fmt: hello\n") == 0);
+    }
+
+    // Async: everything logged before stop_async() is written, each thread's lines in order
+    {
+        std::ostringstream out;
+        Logger alog("async", out);
+        alog.start_async();
+        assert(alog.is_async());
+        std::vector<std::thread> ws;
+        for (int t = 0; t < threads; ++t) {
+            ws.emplace_back([t, &alog] {
+                for (int i = 0; i < 1000; ++i) alog.info("t" + std::to_string(t) + " " + std::to_string(i));
+            });
+        }
+        for (auto& w : ws) w.join();
+        alog.debug("filtered");
+        alog.flush();
+        alog.stop_async();
+        assert(!alog.is_async());
+        alog.info("sync again");
+
+        std::vector<int> next(threads, 0);
+        const auto ls = lines_of(out.str());
+        assert(ls.size() == static_cast<std::size_t>(threads * 1000 + 1) && alog.dropped() == 0);
+        for (std::size_t k = 0; k + 1 < ls.size(); ++k) {
+            const auto p = ls[k].find("] async: t");
+            assert(p != std::string::npos);
+            const int t = ls[k][p + 10] - '0';
+            assert(std::stoi(ls[k].substr(p + 12)) == next[static_cast<std::size_t>(t)]++);
+        }
+        assert(ls.back().find("[INFO] async: sync again") != std::string::npos);
+
+        // restart after a stop
+        alog.start_async();
+        alog.warn("again");
+    }   // destructor drains
+
+    // Full ring without blocking: records are dropped, counted and reported
+    {
+        std::ostringstream out;
+        Logger alog("drops", out);
+        Logger::AsyncOptions o;
+        o.ring_bytes = 1024;
+        o.poll_interval = std::chrono::seconds(5);
+        alog.start_async(o);
+        const std::string payload(40, 'x');
+        for (int i = 0; i < 1000; ++i) alog.info(payload);
+        const auto d = alog.dropped();
+        alog.stop_async();
+        assert(d > 0);
+        const auto ls = lines_of(out.str());
+        assert(ls.size() == 1000 - d + 1);
+        assert(ls.back().find(std::to_string(d) + " log records dropped") != std::string::npos);
+    }
+
+    // Formatting: "{}" placeholders and escaped braces, counted at compile time
+    static_assert(logger_detail::count_placeholders("a={} b={} {{x}}") == 2);
+    static_assert(logger_detail::count_placeholders("}}{{") == 0);
+    static_assert(logger_detail::count_placeholders("{:.2f}") == -1 && logger_detail::count_placeholders("a}") == -1);
+    {
+        std::ostringstream out;
+        Logger f("fmt", out);
+        f.info_fmt("token={} ltp={} ok={} {{x}}", "26000", 101.25, true);
+        f.info_fmt("ingested {}{}{}", std::string("26001"), ' ', 7);
+        f.debug_fmt("hidden {}", 1);
+        const auto ls = lines_of(out.str());
+        assert(ls.size() == 2);
+        assert(ls[0].find("fmt: token=26000 ltp=101.25 ok=true {x}") != std::string::npos);
+        assert(ls[1].find("fmt: ingested 26001 7") != std::string::npos);
+    }
+
+    // Lazy, sampled and rate-limited sites: suppressed calls never build the message
+    {
+        std::ostringstream out;
+        Logger l("sites", out);
+        int built = 0;
+        auto msg = [&built](const std::string& m) { ++built; return m; };
+
+        ALPHA_LOG(l, LogLevel::DEBUG, "{}", msg("off"));
+        assert(built == 0);
+        ALPHA_LOG(l, LogLevel::INFO, "{}", msg("on"));
+        assert(built == 1);
+
+        for (int i = 0; i < 100; ++i) ALPHA_LOG_EVERY_N(l, LogLevel::INFO, 10, "sampled {}", msg(std::to_string(i)));
+        assert(built == 11);
+
+        auto burst = [&](int n) {
+            for (int i = 0; i < n; ++i) {
+                ALPHA_LOG_RATE_LIMITED(l, LogLevel::WARN, 3, std::chrono::milliseconds(200), "{}", msg("limited"));
+            }
+        };
+        burst(10);
+        assert(built == 14);
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        burst(1);
+        assert(built == 15);
+
+        const auto ls = lines_of(out.str());
+        assert(ls.size() == 1 + 10 + 4);
+        assert(ls[1].find("sampled 0") != std::string::npos && ls[10].find("sampled 90") != std::string::npos);
+        assert(ls.back().find("[WARN] sites: limited [suppressed 7 messages]") != std::string::npos);
+
+        LogRateLimiter rl(2, std::chrono::hours(1));
+        std::uint64_t sup = 99;
+        assert(rl.allow(sup) && sup == 0 && rl.allow(sup) && !rl.allow(sup) && !rl.allow(sup));
+    }
+
+    // Compile-time minimum level: sites below it do nothing whatever the runtime level
+    {
+        std::ostringstream out;
+        Logger l("min", out);
+        l.set_level(LogLevel::TRACE);
+        int built = 0;
+        auto arg = [&built] { return ++built; };
+        ALPHA_LOG(l, LogLevel::TRACE, "trace {}", arg());
+        ALPHA_LOG_RATE_LIMITED(l, LogLevel::DEBUG, 1, std::chrono::seconds(1), "debug {}", arg());
+        l.trace_fmt("trace_fmt {}", 1);
+        l.debug("debug");
+        l.error_fmt("error {}", 2);
+        const int want_trace = log_compiled(LogLevel::TRACE) ? 1 : 0;
+        const int want_debug = log_compiled(LogLevel::DEBUG) ? 1 : 0;
+        assert(built == want_trace + want_debug);
+        const auto ls = lines_of(out.str());
+        assert(ls.size() == static_cast<std::size_t>(2 * want_trace + 2 * want_debug + 1));
+        assert(ls.back().find("[ERROR] min: error 2") != std::string::npos);
+    }
+
     std::cout << "logger test finished\n";
     return 0;
 }
@@ -0,0 +1,106 @@
+#include "metrics.h"
+#include "logger.h"
+#include <arpa/inet.h>
+#include <cassert>
+#include <iostream>
+#include <netinet/in.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Plain HTTP/1.0 GET against 127.0.0.1; returns the whole response
+static std::string http_get(unsigned short port, const std::string& target) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) { ::close(fd); return {}; }
+    const std::string req = "GET " + target + " HTTP/1.0\r\nHost: localhost\r\n\r\n";
+    (void)!::write(fd, req.data(), req.size());
+    std::string out;
+    char buf[4096];
+    for (ssize_t n; (n = ::read(fd, buf, sizeof(buf))) > 0;) out.append(buf, static_cast<std::size_t>(n));
+    ::close(fd);
+    return out;
+}
+
+int main() {
+    MetricsRegistry reg;
+
+    // Get-or-create by name + labels; references stay put
+    auto& f0 = reg.counter("alpha_ws_frames_total", "WebSocket frames received", {{"shard", "0"}});
+    auto& f1 = reg.counter("alpha_ws_frames_total", "WebSocket frames received", {{"shard", "1"}});
+    assert(&f0 == &reg.counter("alpha_ws_frames_total", "ignored", {{"shard", "0"}}));
+    assert(&f0 != &f1);
+    auto& hwm = reg.gauge("alpha_ingest_queue_high_water", "Peak ingest queue depth", {{"shard", "0"}});
+    // a name keeps its kind, whatever the labels
+    bool refused = false;
+    try {
+        reg.gauge("alpha_ws_frames_total", "WebSocket frames received", {{"shard", "2"}});
+    } catch (const std::invalid_argument&) {
+        refused = true;
+    }
+    assert(refused);
+    refused = false;
+    try {
+        reg.counter("alpha_ingest_queue_high_water", "Peak ingest queue depth", {{"shard", "0"}});
+    } catch (const std::invalid_argument&) {
+        refused = true;
+    }
+    assert(refused);
+
+    // Striped counter: concurrent writers, exact sum
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 8; ++t) {
+        writers.emplace_back([&, t] {
+            for (int i = 0; i < 100000; ++i) {
+                f0.inc();
+                hwm.update_max(t * 1000 + (i % 1000));
+            }
+        });
+    }
+    for (auto& w : writers) w.join();
+    f1.inc(5);
+    assert(f0.value() == 800000);
+    assert(hwm.value() == 7999);
+    hwm.set(3);
+    hwm.add(-1);
+    assert(hwm.value() == 2);
+
+    // Snapshot and label-filtered sums
+    const auto snap = reg.snapshot();
+    assert(snap.size() == 3);
+    assert(snap[0].kind == MetricsRegistry::Kind::Counter && snap[0].value == 800000);
+    assert(reg.value("alpha_ws_frames_total") == 800005);
+    assert(reg.value("alpha_ws_frames_total", {{"shard", "1"}}) == 5);
+    assert(reg.value("missing") == 0);
+
+    // Prometheus text: one HELP/TYPE per family, escaped label values
+    reg.counter("alpha_odd_total", "Odd labels", {{"path", "a\"b\\c"}}).inc();
+    const std::string text = reg.prometheus_text();
+    assert(text.find("# HELP alpha_ws_frames_total WebSocket frames received\n"
+                     "# TYPE alpha_ws_frames_total counter\n"
+                     "alpha_ws_frames_total{shard=\"0\"} 800000\n"
+                     "alpha_ws_frames_total{shard=\"1\"} 5\n") != std::string::npos);
+    assert(text.find("# TYPE alpha_ingest_queue_high_water gauge\nalpha_ingest_queue_high_water{shard=\"0\"} 2\n") != std::string::npos);
+    assert(text.find(R"(alpha_odd_total{path="a\"b\\c"} 1)") != std::string::npos);
+
+    // Scrape endpoint
+    Logger log("metrics_test");
+    MetricsServer srv(log, reg, MetricsServer::Options{});
+    assert(srv.start());
+    assert(srv.port() != 0);
+    const std::string res = http_get(srv.port(), "/metrics");
+    assert(res.rfind("HTTP/1.0 200", 0) == 0 || res.rfind("HTTP/1.1 200", 0) == 0);
+    assert(res.find("text/plain; version=0.0.4") != std::string::npos);
+    assert(res.find("alpha_ws_frames_total{shard=\"1\"} 5") != std::string::npos);
+    assert(http_get(srv.port(), "/nope").find(" 404 ") != std::string::npos);
+    srv.stop();
+
+    std::cout << "Metrics test passed.\n";
+    return 0;
+}
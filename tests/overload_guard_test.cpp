@@ -0,0 +1,131 @@
+#include "overload_guard.h"
+#include "consumer.h"
+#include "logger.h"
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+static std::string tick(const std::string& token, int px) {
+    return R"({"data":{"token":")" + token + R"(","ltp":)" + std::to_string(px) +
+           R"(,"exchange_timestamp":1728123456789}})";
+}
+
+static std::size_t count_lines(const std::string& s, const std::string& needle) {
+    std::size_t n = 0;
+    for (std::size_t p = s.find(needle); p != std::string::npos; p = s.find(needle, p + 1)) ++n;
+    return n;
+}
+
+int main() {
+    std::ostringstream sink;
+    Logger log("overload_test", sink);
+    const IngestQueue::Stamp st{};
+    std::string out;
+
+    // Instrument key straight from the raw frame
+    assert(OverloadGuard::instrument_key(tick("26000", 1)) == "26000");
+    assert(OverloadGuard::instrument_key(R"({"token" : 42, "ltp":1})") == "42");
+    assert(OverloadGuard::instrument_key(R"({"type":"ack"})").empty());
+
+    // Drop newest: the arriving frames are lost, one warning per interval
+    {
+        IngestQueue q(8);
+        OverloadGuard::Options o;
+        o.report_interval = std::chrono::hours(1);
+        OverloadGuard g(q, log, "dn", o);
+        for (int i = 0; i < 1000; ++i) g.offer(std::to_string(i), st);
+        assert(g.stats().dropped == 992);
+        for (int i = 0; i < 8; ++i) assert(q.try_pop(out) && out == std::to_string(i));
+        assert(count_lines(sink.str(), "overloaded on dn") == 1);
+    }
+
+    // Drop oldest: the newest capacity() frames survive
+    {
+        IngestQueue q(8, true);
+        OverloadGuard::Options o;
+        o.policy = OverloadPolicy::DropOldest;
+        OverloadGuard g(q, log, "do", o);
+        for (int i = 0; i < 20; ++i) assert(g.offer(std::to_string(i), st));
+        assert(g.stats().evicted == 12 && g.stats().dropped == 0);
+        for (int i = 12; i < 20; ++i) assert(q.try_pop(out) && out == std::to_string(i));
+    }
+
+    // Conflate: once full, frames park with one slot per instrument, and keep parking
+    // (even with room in the ring) until the consumer takes them
+    {
+        IngestQueue q(8);
+        OverloadGuard::Options o;
+        o.policy = OverloadPolicy::Conflate;
+        o.conflate_capacity = 3;
+        OverloadGuard g(q, log, "cf", o);
+        for (int i = 0; i < 8; ++i) assert(g.offer(tick("1", i), st));
+        for (int i = 0; i < 10; ++i) assert(g.offer(tick(i % 2 ? "X" : "Y", 100 + i), st));
+        assert(g.has_parked());
+        assert(q.try_pop(out));
+        assert(g.offer(tick("X", 200), st));           // ring has room, still parked
+        assert(q.size() == 7);
+        assert(g.offer(R"({"type":"ack"})", st));      // no instrument: own slot
+        assert(!g.offer(tick("Z", 1), st));            // side buffer full
+        const auto s = g.stats();
+        assert(s.parked == 12 && s.conflated == 9 && s.dropped == 1);
+
+        while (q.try_pop(out)) {}
+        std::vector<OverloadGuard::Parked> parked;
+        assert(g.take_parked(parked) == 3);
+        assert(!g.has_parked());
+        assert(parked[0].frame == tick("Y", 108));
+        assert(parked[1].frame == tick("X", 200));
+        assert(parked[2].frame == R"({"type":"ack"})");
+        assert(g.offer(tick("X", 300), st) && q.size() == 1);   // back to the ring
+
+        // spare buffers come back on the next swap
+        assert(g.offer(tick("X", 1), st));
+        for (int i = 0; i < 8; ++i) g.offer(tick("W", i), st);
+        while (q.try_pop(out)) {}
+        assert(g.take_parked(parked) == 1 && parked[0].frame == tick("W", 7));
+    }
+
+    // Conflate end to end: a Consumer drains the ring, then the latest parked update
+    {
+        IngestQueue q(8);
+        Parser parser;
+        LTPStore store;
+        OverloadGuard::Options o;
+        o.policy = OverloadPolicy::Conflate;
+        OverloadGuard g(q, log, "cf2", o);
+        for (int i = 0; i < 500; ++i) g.offer(tick(i % 2 ? "26000" : "26001", i), st);
+        Consumer c(q, parser, store, log);
+        Consumer::SourceOptions so;
+        so.overload = &g;
+        c.configure(so);
+        c.start();
+        for (int i = 0; i < 200 && (!store.get("26000") || store.get("26000")->ltp != 499); ++i) std::this_thread::sleep_for(5ms);
+        c.stop();
+        assert(store.get("26000")->ltp == 499 && store.get("26001")->ltp == 498);
+        assert(!g.has_parked());
+    }
+
+    // Backpressure: the frame that found the queue full is held, not lost
+    {
+        IngestQueue q(8);
+        OverloadGuard::Options o;
+        o.policy = OverloadPolicy::Backpressure;
+        OverloadGuard g(q, log, "bp", o);
+        for (int i = 0; i < 9; ++i) assert(g.offer(std::to_string(i), st));
+        assert(g.stats().read_pauses == 1 && !g.ready());
+        assert(!g.offer("late", st) && g.stats().dropped == 1);
+        assert(q.try_pop(out) && out == "0");
+        assert(g.ready() && g.ready());
+        for (int i = 1; i < 9; ++i) assert(q.try_pop(out) && out == std::to_string(i));
+    }
+
+    assert(std::string(overload_policy_name(OverloadPolicy::Conflate)) == "conflate");
+    std::cout << "OverloadGuard test passed.\n";
+    return 0;
+}
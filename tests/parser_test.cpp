@@ -1,5 +1,6 @@
 #include "parser.h"
 #include <cassert>
+#include <chrono>
 #include <iostream>
 
 static std::string ms_payload() {
@@ -40,6 +41,14 @@ int main() {
     assert(b->token == "26001");
     assert(b->ltp == 101.5);
 
+    // ns and µs epochs land on the same instant as ms
+    auto n = p.parse_ltp(R"({"data":{"token":"26000","ltp":1,"exchange_timestamp":1728123456789123456}})");
+    auto u = p.parse_ltp(R"({"data":{"token":"26000","ltp":1,"exchange_timestamp":1728123456789123}})");
+    assert(n.has_value() && u.has_value());
+    assert(std::chrono::floor<std::chrono::milliseconds>(n->ts) == a->ts);
+    assert(std::chrono::floor<std::chrono::milliseconds>(u->ts) == a->ts);
+    assert(n->ts - u->ts == std::chrono::nanoseconds(456));
+
     // bad payload
     auto c = p.parse_ltp(bad_payload());
     assert(!c.has_value());
@@ -2,9 +2,18 @@
 #include "parser.h"
 #include "ltp_store.h"
 #include "logger.h"
+#include "market_data_server.h"
+#include "metrics.h"
+#include "binary_log.h"
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <unistd.h>
 #include <cassert>
 #include <cstdlib>
 #include <chrono>
+#include <mutex>
+#include <set>
 #include <thread>
 #include <vector>
 #include <iostream>
@@ -32,17 +41,25 @@ int main() {
     Parser parser; parser.set_strip_prefix("nse_cm|");
     LTPStore store;
 
+    // Local TLS server: echoes broadcasts, streams instruments given a rate; override via WS_URL
+    MarketDataServer server(log, MarketDataServer::Options{});
     const char* env = std::getenv("WS_URL");
-    std::string wss = env ? env : "wss://ws.ifelse.io";
+    if (!env) assert(server.start());
+    std::string wss = env ? env : server.url();
 
     Sharder::Options opt;
     opt.wss_url = wss;
+    if (!env) opt.ca_file = server.cert_file();
     opt.max_tokens_per_conn = 2;       // force 2 workers for 3 tokens
     opt.subscribe_batch_size = 2;
     opt.token_prefix = "nse_cm|";
 
     Sharder mgr(log, parser, store, opt);
     mgr.set_tokens({"26000","26001","26002"});
+    const std::string trace_path = "/tmp/alpha-sharder-test-" + std::to_string(::getpid()) + ".binlog";
+    BinaryLogger trace(log, "sharder_test");
+    assert(trace.open(trace_path));
+    mgr.set_trace_log(trace);
 
     assert(mgr.start());
 
@@ -67,7 +84,161 @@ int main() {
     assert(a->ltp == 101.25);
     assert(b->ltp == 202.50);
 
+    // Live reshard: 26003 fits into shard #1, 26004 needs a new shard
+    assert(mgr.num_workers() == 2);
+    mgr.set_tokens({"26000","26001","26002","26003","26004"});
+    assert(mgr.num_workers() == 3);
+    // Removing tokens never tears down workers
+    mgr.set_tokens({"26000","26004"});
+    assert(mgr.num_workers() == 3);
+    assert(mgr.desired_tokens_snapshot().size() == 2);
+    // ...but their instruments' last quotes go, so nobody reads them as live
+    assert(store.get("26000") && !store.get("26001"));
+
+    // Per-shard metrics: both echoed frames were counted, and the local server acks subscribes
+    MetricsRegistry& m = mgr.metrics();
+    assert(m.value("alpha_ws_frames_total") >= 2);
+    assert(m.value("alpha_ticks_total") >= 2);
+    assert(m.value("alpha_ws_bytes_total") >= static_cast<double>(p0.size() + p1.size()));
+    if (!env) {
+        for (int i = 0; i < 100 && m.value("alpha_subscribe_acks_total") < 2; ++i) std::this_thread::sleep_for(50ms);
+        assert(m.value("alpha_subscribe_acks_total") >= 2);
+    }
+    assert(m.prometheus_text().find("alpha_ws_frames_total{shard=\"0\"}") != std::string::npos);
+
     mgr.stop();
+
+    // Per-frame trace: one record per frame read, decoded offline
+    trace.close();
+    assert(trace.stats().records >= static_cast<std::uint64_t>(m.value("alpha_ws_frames_total")));
+    {
+        std::ifstream in(trace_path, std::ios::binary);
+        std::ostringstream text;
+        assert(decode_binary_log(in, text, BinaryLogDecodeOptions{}));
+        assert(text.str().find("[TRACE] sharder_test: frame shard=") != std::string::npos);
+        assert(text.str().find(" queued=true") != std::string::npos);
+    }
+    std::remove(trace_path.c_str());
+
+    // Hot standby: the active connection carries the subscriptions and traffic
+    {
+        LTPStore hs_store;
+        Sharder::Options hs = opt;
+        hs.hot_standby = true;
+        hs.stage_timing = true;
+        Sharder hmgr(log, parser, hs_store, hs);
+        hmgr.set_tokens({"26000"});
+        assert(hmgr.start());
+        assert(retry_broadcast(hmgr, mk_ltp("nse_cm|26000", 99.5, 1728123002000), std::chrono::seconds(12)));
+        for (int i = 0; i < 200 && !hs_store.get("26000"); ++i) std::this_thread::sleep_for(50ms);
+        assert(hs_store.get("26000").has_value());
+        assert(hmgr.recovery_stats().failovers == 0);
+        // Stage stamps ride with the frame from the socket read to the store
+        std::vector<StageHistograms::Summaries> lat;
+        for (int i = 0; i < 100; ++i) {
+            lat = hmgr.stage_latency();
+            if (!lat.empty() && lat[0][static_cast<std::size_t>(Stage::Total)].count >= 1) break;
+            std::this_thread::sleep_for(10ms);
+        }
+        assert(lat.size() == 1 && lat[0][static_cast<std::size_t>(Stage::Total)].count >= 1);
+        if (!env) {
+            // Unsolicited text on the standby never reaches the active connection's queue
+            for (int i = 0; i < 100 && hmgr.recovery_stats().inactive_frames == 0; ++i) {
+                server.notify_idle(R"({"type":"notice"})");
+                std::this_thread::sleep_for(50ms);
+            }
+            assert(hmgr.recovery_stats().inactive_frames >= 1);
+            // Active connection drops: the standby is promoted, resubscribes, and its
+            // subscribe ack ends the outage
+            server.drop_subscribed();
+            for (int i = 0; i < 200 && hmgr.recovery_stats().recoveries == 0; ++i) std::this_thread::sleep_for(50ms);
+            const auto rs = hmgr.recovery_stats();
+            assert(rs.failovers >= 1 && rs.recoveries >= 1);
+            assert(rs.max_recover.count() > 0);
+            assert(retry_broadcast(hmgr, mk_ltp("nse_cm|26000", 99.75, 1728123002500), std::chrono::seconds(12)));
+            for (int i = 0; i < 200 && hs_store.get("26000")->ltp != 99.75; ++i) std::this_thread::sleep_for(50ms);
+            assert(hs_store.get("26000")->ltp == 99.75);
+        }
+        hmgr.stop();
+    }
+
+    // Stalled feed: the server stops streaming on the subscribed connection, so the
+    // watchdog recycles it and the standby takes over
+    if (!env) {
+        server.set_rate("nse_cm|27000", 200);
+        LTPStore wd_store;
+        Sharder::Options wo = opt;
+        wo.hot_standby = true;
+        wo.watchdog.max_silence = 300ms;
+        wo.watchdog.check_interval = 20ms;
+        wo.watchdog.open_minute = wo.watchdog.close_minute = 0;   // always in market hours
+        wo.watchdog.weekdays_only = false;
+        Sharder wmgr(log, parser, wd_store, wo);
+        wmgr.set_tokens({"27000"});
+        assert(wmgr.start());
+        for (int i = 0; i < 200 && !wd_store.get("27000"); ++i) std::this_thread::sleep_for(50ms);
+        assert(wd_store.get("27000").has_value());
+        server.stall_streaming();
+        for (int i = 0; i < 200 && wmgr.recovery_stats().recoveries == 0; ++i) std::this_thread::sleep_for(50ms);
+        const auto rs = wmgr.recovery_stats();
+        assert(wmgr.watchdog_stats().recycles >= 1);
+        assert(rs.failovers >= 1 && rs.recoveries >= 1);
+        assert(rs.max_recover.count() > 0);
+        wmgr.stop();
+    }
+
+    // A/B legs: the broadcast echoes back on each connected leg, and the local server
+    // streams byte-identical ticks for 27000 on both; one copy of each is kept
+    {
+        LTPStore ab_store;
+        Sharder::Options ab = opt;
+        ab.redundant_feeds = true;
+        Sharder amgr(log, parser, ab_store, ab);
+        if (env) amgr.set_tokens({"26000"});
+        else     amgr.set_tokens({"26000", "27000"});
+        assert(amgr.start());
+        assert(retry_broadcast(amgr, mk_ltp("nse_cm|26000", 77.25, 1728123003000), std::chrono::seconds(12)));
+        FeedArbiter::Stats st;
+        for (int i = 0; i < 200; ++i) {
+            st = amgr.arbiter_stats();
+            if (st.legs[0].forwarded + st.legs[1].forwarded >= 1 &&
+                st.legs[0].duplicates + st.legs[1].duplicates >= 1) break;
+            std::this_thread::sleep_for(50ms);
+        }
+        assert(st.legs[0].forwarded + st.legs[1].forwarded >= 1);
+        assert(st.legs[0].duplicates + st.legs[1].duplicates >= 1);
+        assert(ab_store.get("26000") && ab_store.get("26000")->ltp == 77.25);
+        amgr.stop();
+    }
+
+    // Consumer pool: started with no instruments, it still grows to consumer_threads
+    // as a live reshard adds shards
+    {
+        LTPStore pc_store;
+        Sharder::Options po = opt;
+        po.max_tokens_per_conn = 1;
+        po.consumer_threads = 2;
+        Sharder pmgr(log, parser, pc_store, po);
+        std::mutex mu;
+        std::set<std::thread::id> consumers;
+        pmgr.set_sink([&](const LTP&) {
+            std::lock_guard<std::mutex> lk(mu);
+            consumers.insert(std::this_thread::get_id());
+        });
+        assert(pmgr.start());
+        pmgr.set_tokens({"26000", "26001", "26002", "26003"});
+        assert(pmgr.num_workers() == 4);
+        // every connection echoes the broadcast to the consumer draining its shard
+        for (int i = 0; i < 200; ++i) {
+            pmgr.debug_broadcast_text(mk_ltp("nse_cm|26000", 10.0 + i, 1728123004000 + i));
+            std::lock_guard<std::mutex> lk(mu);
+            if (consumers.size() >= 2) break;
+            std::this_thread::sleep_for(50ms);
+        }
+        pmgr.stop();
+        assert(consumers.size() == 2);
+    }
+
     std::cout << "Sharder test passed.\n";
     return 0;
 }
@@ -86,6 +86,70 @@ int main() {
     assert(ju["tokens"].size() == 1);
     assert(ju["tokens"][0] == prefix + to_remove_raw);
 
+    // take_* returns only the delta and records it as applied
+    SubscriptionManager live(log, SubscriptionManager::Mode::LTP, /*batch_size=*/10);
+    live.add_many({"X","Y"});
+    assert(live.take_subscribe_batches().size() == 1);
+    assert(live.take_subscribe_batches().empty());        // nothing new
+    live.add("Z");
+    auto delta = live.take_subscribe_batches();
+    assert(delta.size() == 1);
+    assert(json::parse(delta[0])["tokens"].size() == 1);   // only Z
+    live.remove("X");
+    auto un = live.take_unsubscribe_batches();
+    assert(un.size() == 1 && json::parse(un[0])["tokens"][0] == "X");
+    assert(live.take_unsubscribe_batches().empty());
+    live.reset_active();                                   // reconnect: resend all desired
+    auto again = live.take_subscribe_batches();
+    assert(again.size() == 1 && json::parse(again[0])["tokens"].size() == 2);
+
+    // send_*: batches the connection refuses stay pending
+    SubscriptionManager sent(log, SubscriptionManager::Mode::LTP, /*batch_size=*/2);
+    sent.add_many({"A","B","C"});
+    std::vector<std::string> wire;
+    int accept = 1;
+    auto send = [&](const std::string& p) {
+        if (accept-- <= 0) return false;
+        wire.push_back(p);
+        return true;
+    };
+    assert(sent.send_subscribe_batches(send) == 1);        // second batch refused
+    assert(wire.size() == 1 && sent.active_snapshot().size() == 2);
+    accept = 10;
+    assert(sent.send_subscribe_batches(send) == 1);        // only the refused token again
+    assert(json::parse(wire[1])["tokens"].size() == 1 && sent.active_snapshot().size() == 3);
+    sent.remove("A");
+    accept = 0;
+    assert(sent.send_unsubscribe_batches(send) == 0);
+    assert(sent.active_snapshot().size() == 3);
+    accept = 1;
+    assert(sent.send_unsubscribe_batches(send) == 1 && json::parse(wire[2])["tokens"][0] == "A");
+    assert(sent.active_snapshot().size() == 2);
+
+    // merge_payloads: same action/mode within the cap merge; anything else stays separate
+    live.add("W");
+    std::string first = live.take_subscribe_batches()[0];   // [W]
+    live.add("V");
+    const std::string second = live.take_subscribe_batches()[0]; // [V]
+    assert(SubscriptionManager::merge_payloads(first, second, 10));
+    assert(json::parse(first)["tokens"].size() == 2);
+    assert(!SubscriptionManager::merge_payloads(first, second, 2));  // would exceed cap
+    std::string unsub = un[0];
+    assert(!SubscriptionManager::merge_payloads(unsub, second, 10)); // action differs
+    assert(unsub == un[0]);
+    // frames this class didn't build are never merged, and never throw
+    for (const std::string& other : std::vector<std::string>{R"({"action":1,"mode":"ltp","tokens":["X"]})",
+                                                             R"({"action":"subscribe","mode":["ltp"],"tokens":["X"]})",
+                                                             R"({"action":"subscribe","mode":"ltp","tokens":[1]})",
+                                                             R"({"action":"subscribe","mode":"ltp","tokens":["X"],"debug":true})",
+                                                             R"({"action":"ping","mode":"ltp","tokens":[]})",
+                                                             "not json"}) {
+        std::string p = second;
+        assert(!SubscriptionManager::merge_payloads(p, other, 10) && p == second);
+        std::string o = other;
+        assert(!SubscriptionManager::merge_payloads(o, second, 10) && o == other);
+    }
+
     std::cout << "SubscriptionManager test passed.\n";
     return 0;
 }
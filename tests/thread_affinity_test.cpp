@@ -0,0 +1,56 @@
+#include "thread_affinity.h"
+#include "logger.h"
+#include <sched.h>
+#include <cassert>
+#include <iostream>
+#include <thread>
+
+int main() {
+    Logger log("affinity_test");
+
+    // cpu list parsing
+    auto l = CpuTopology::parse_cpu_list("0-3,8,10-11");
+    assert((l == std::vector<int>{0,1,2,3,8,10,11}));
+    assert(CpuTopology::parse_cpu_list("").empty());
+
+    // topology detection always yields at least one online cpu, all of them ones
+    // this process may run on (containers and cpusets restrict the online set)
+    auto topo = CpuTopology::detect();
+    assert(!topo.online().empty());
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    assert(sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+    for (int cpu : topo.online()) assert(CPU_ISSET(cpu, &allowed));
+    for (int cpu : topo.isolated()) assert(CPU_ISSET(cpu, &allowed));
+
+    // pairs are produced for every shard even on small machines
+    auto pairs = topo.plan_pairs(5);
+    assert(pairs.size() == 5);
+    for (auto& [io, cons] : pairs) {
+        assert(io >= 0 && cons >= 0);
+        assert(CPU_ISSET(io, &allowed) && CPU_ISSET(cons, &allowed));
+    }
+
+    // pin a thread and check where it runs
+    const int target = topo.online().back();
+    std::thread t([&] {
+        ThreadPlacement p;
+        p.cpu = target;
+        assert(apply_thread_placement(p, log, "pinned"));
+        std::this_thread::yield();
+        assert(sched_getcpu() == target);
+        std::cout << describe_thread_placement("pinned") << "\n";
+    });
+    t.join();
+
+    // run_on_cpu executes synchronously, and says when it could not pin
+    int ran_on = -1;
+    assert(run_on_cpu(target, [&] { ran_on = sched_getcpu(); }));
+    assert(ran_on == target);
+    ran_on = -1;
+    assert(!run_on_cpu(CPU_SETSIZE - 1, [&] { ran_on = sched_getcpu(); }));
+    assert(ran_on >= 0);
+
+    std::cout << "ThreadAffinity test passed.\n";
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "thread_log_ring.h"
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using logring::ThreadRings;
+
+static bool put(ThreadRings& rings, std::uint32_t tag, const std::string& s) {
+    ThreadRings::Reservation res;
+    if (rings.reserve(tag, s.size(), res) != ThreadRings::Reserve::Ok) return false;
+    std::memcpy(res.data, s.data(), s.size());
+    ThreadRings::commit(res);
+    return true;
+}
+
+int main() {
+    std::atomic<bool> accepting{false};
+    ThreadRings rings(accepting);
+    std::mutex mu;
+    std::vector<std::string> got;
+    std::vector<ThreadRings::Record> recs;
+    std::string staging;
+    ThreadRings::Options o;
+    o.ring_bytes = 4096;
+    o.poll_interval = std::chrono::milliseconds(5);
+    rings.start(o, [&] {
+        recs.clear();
+        staging.clear();
+        rings.take(recs, staging);
+        std::lock_guard<std::mutex> lk(mu);
+        for (const auto& r : recs) got.push_back(staging.substr(r.off, r.len));
+    });
+    assert(accepting.load());
+
+    // Short-lived threads: each gets a ring, retired at exit and freed once drained
+    for (int round = 0; round < 10; ++round) {
+        std::vector<std::thread> ts;
+        for (int t = 0; t < 8; ++t) {
+            ts.emplace_back([&rings, round, t] {
+                for (int i = 0; i < 3; ++i) assert(put(rings, 1, std::to_string(round) + "/" + std::to_string(t)));
+            });
+        }
+        for (auto& t : ts) t.join();
+        rings.flush();
+        assert(rings.ring_count() == 0);
+    }
+    {
+        std::lock_guard<std::mutex> lk(mu);
+        assert(got.size() == 10 * 8 * 3);
+    }
+
+    // A live thread keeps its ring
+    assert(put(rings, 2, "main"));
+    rings.flush();
+    assert(rings.ring_count() == 1);
+
+    // Oversized records are refused; after stop() everything is Closed
+    assert(rings.max_payload() == 4096 / 4 - 16);
+    ThreadRings::Reservation res;
+    assert(rings.reserve(1, rings.max_payload() + 1, res) == ThreadRings::Reserve::Dropped);
+    rings.stop();
+    assert(!accepting.load());
+    assert(rings.reserve(1, 4, res) == ThreadRings::Reserve::Closed);
+    {
+        std::lock_guard<std::mutex> lk(mu);
+        assert(got.size() == 10 * 8 * 3 + 1 && got.back() == "main");
+    }
+
+    std::cout << "thread log ring test finished\n";
+    return 0;
+}
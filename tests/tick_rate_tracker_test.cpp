@@ -0,0 +1,88 @@
+#include "tick_rate_tracker.h"
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static double shard_load(const TickRateTracker& t, const std::vector<std::string>& shard) {
+    double sum = 0;
+    for (auto& tok : shard) sum += t.rate(tok);
+    return sum;
+}
+
+int main() {
+    TickRateTracker t(std::chrono::seconds(10));
+
+    // Concurrent recording from several threads; hot tokens get 50x the ticks
+    std::vector<std::thread> th;
+    for (int k = 0; k < 4; ++k) {
+        th.emplace_back([&t] {
+            for (int i = 0; i < 5000; ++i) {
+                t.record("HOT1");
+                t.record("HOT2");
+                if (i % 50 == 0) { t.record("COLD1"); t.record("COLD2"); }
+            }
+        });
+    }
+    for (auto& x : th) x.join();
+
+    assert(t.rate("HOT1") > t.rate("COLD1") * 10);
+    assert(t.rate("NEVER") < t.rate("COLD1"));
+
+    // Contiguous slicing would put both hot tokens on one shard; packing splits them
+    auto shards = t.assign({"HOT1", "HOT2", "COLD1", "COLD2"}, 2);
+    assert(shards.size() == 2);
+    for (auto& s : shards) assert(s.size() == 2);
+    const double l0 = shard_load(t, shards[0]), l1 = shard_load(t, shards[1]);
+    assert(l0 < 1.5 * l1 && l1 < 1.5 * l0);
+
+    // No history -> even token counts
+    auto even = t.assign({"a", "b", "c", "d", "e"}, 2);
+    assert(even.size() == 3);
+    for (auto& s : even) assert(!s.empty() && s.size() <= 2);
+
+    // Seeded priors count as expected throughput
+    t.seed("IDX_OPT", 5000.0);
+    assert(t.rate("IDX_OPT") > t.rate("HOT1"));
+
+    // Decay lowers estimates over time
+    const double before = t.rate("HOT1");
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    t.decay();
+    assert(t.rate("HOT1") < before);
+
+    // A 40k-instrument universe: 10 ticks per cold token, 1000 per hot one. Sized
+    // for the universe, cold estimates stay close; the default width drowns them.
+    {
+        const std::size_t n = 40000;
+        assert(TickRateTracker::width_for(0) == 4096 && TickRateTracker::width_for(n) == 262144);
+        TickRateTracker sized(std::chrono::seconds(60), TickRateTracker::width_for(n));
+        TickRateTracker fixed(std::chrono::seconds(60));
+        std::vector<std::string> toks;
+        for (std::size_t i = 0; i < n; ++i) toks.push_back("nse_cm|" + std::to_string(30000 + i));
+        for (std::size_t i = 0; i < n; ++i) {
+            const int ticks = i < 100 ? 1000 : 10;
+            for (int k = 0; k < ticks; ++k) {
+                sized.record(toks[i]);
+                fixed.record(toks[i]);
+            }
+        }
+        // relative to the hot tokens, whose collision noise is negligible
+        const auto mean_error = [&toks](const TickRateTracker& t) {
+            double hot = 0, err = 0;
+            for (std::size_t i = 0; i < 100; ++i) hot += t.rate(toks[i]) / 1000;
+            hot /= 100;
+            for (std::size_t i = 100; i < toks.size(); ++i) err += t.rate(toks[i]) / (10 * hot) - 1;
+            return err / static_cast<double>(toks.size() - 100);
+        };
+        const double e_sized = mean_error(sized), e_fixed = mean_error(fixed);
+        assert(e_sized < 0.05);
+        assert(e_fixed > 0.5);
+        std::cout << "40k tokens: mean cold overestimate " << e_sized * 100 << "% sized, "
+                  << e_fixed * 100 << "% at the default width\n";
+    }
+
+    std::cout << "TickRateTracker test passed.\n";
+    return 0;
+}
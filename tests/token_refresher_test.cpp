@@ -0,0 +1,260 @@
+#include "token_refresher.h"
+#include "auth.h"
+#include "config.h"
+#include "http_client.h"
+#include "local_https_server.h"
+#include "logger.h"
+#include "ltp_store.h"
+#include "market_data_server.h"
+#include "parser.h"
+#include "sharder.h"
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+using json = nlohmann::json;
+
+static std::string b64url(const std::string& in) {
+    static const char* tbl = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    std::string out;
+    unsigned acc = 0, bits = 0;
+    for (unsigned char c : in) {
+        acc = (acc << 8) | c;
+        bits += 8;
+        while (bits >= 6) {
+            bits -= 6;
+            out += tbl[(acc >> bits) & 63];
+        }
+    }
+    if (bits > 0) out += tbl[(acc << (6 - bits)) & 63];
+    return out;
+}
+
+static std::string jwt(long long exp, int n) {
+    return b64url(R"({"alg":"HS512"})") + "." + b64url(json{{"sub", "c"}, {"n", n}, {"exp", exp}}.dump()) + ".sig";
+}
+
+// loginByPassword / generateTokens stand-in. ttl > 0: responses carry expiresIn;
+// 0: only the JWT's exp (an hour out)
+struct AuthServer {
+    std::mutex mu;
+    int ttl = 0;
+    int issued = 0, logins = 0, refreshes = 0;
+    int fail_refreshes = 0;         // next n refreshes get a 500
+    bool refresh_dead = false;      // refresh token rejected for good
+    std::string refresh_token;
+
+    LocalHttpsServer::Response issue(bool login) {
+        LocalHttpsServer::Response r;
+        const long long exp = duration_cast<seconds>(system_clock::now().time_since_epoch()).count() + 3600;
+        ++issued;
+        if (login) refresh_token = "r-" + std::to_string(issued);
+        json d{{"jwtToken", jwt(exp, issued)}, {"refreshToken", refresh_token}, {"feedToken", "f-" + std::to_string(issued)}};
+        if (ttl > 0) d["expiresIn"] = ttl;
+        r.body = json{{"status", true}, {"data", d}}.dump();
+        return r;
+    }
+    LocalHttpsServer::Response login(const LocalHttpsServer::Request&) {
+        std::lock_guard<std::mutex> lk(mu);
+        ++logins;
+        return issue(true);
+    }
+    LocalHttpsServer::Response refresh(const LocalHttpsServer::Request& req) {
+        std::lock_guard<std::mutex> lk(mu);
+        LocalHttpsServer::Response r;
+        if (fail_refreshes > 0) {
+            --fail_refreshes;
+            r.status = 500;
+            return r;
+        }
+        if (refresh_dead || json::parse(req.body).at("refreshToken") != refresh_token) {
+            r.status = 401;
+            return r;
+        }
+        ++refreshes;
+        return issue(false);
+    }
+};
+
+template <typename F>
+static bool wait_for(F done, milliseconds timeout = seconds(10)) {
+    const auto end = steady_clock::now() + timeout;
+    while (steady_clock::now() < end) {
+        if (done()) return true;
+        std::this_thread::sleep_for(milliseconds(10));
+    }
+    return done();
+}
+
+int main() {
+    Logger log("token_refresher_test");
+    log.set_level(LogLevel::ERROR);
+
+    const std::string cfg_path = (std::filesystem::temp_directory_path() / "alpha-token-refresher-cfg.json").string();
+    {
+        std::ofstream f(cfg_path);
+        f << R"({"api_key":"k","client_id":"c","client_secret":"s","tokens":[],"splits":{}})";
+    }
+    const Config cfg = Config::load_from_file(cfg_path);
+
+    AuthServer as;
+    LocalHttpsServer srv(log, LocalHttpsServer::Options{});
+    srv.route("POST", "/rest/auth/angelbroking/user/v1/loginByPassword",
+              [&as](const LocalHttpsServer::Request& r) { return as.login(r); });
+    srv.route("POST", "/rest/auth/angelbroking/jwt/v1/generateTokens",
+              [&as](const LocalHttpsServer::Request& r) { return as.refresh(r); });
+    assert(srv.start());
+
+    HTTPClient::Options ho;
+    ho.ca_file = srv.cert_file();
+    HTTPClient http(ho);
+
+    // No TTL in the response: the expiry is the JWT's exp claim
+    {
+        Auth auth(cfg, http, log, srv.url());
+        const auto before = system_clock::now();
+        assert(auth.login_with_totp("123456"));
+        const auto exp = auth.tokens().expires_at;
+        assert(exp > before + minutes(59) && exp <= system_clock::now() + hours(1));
+        assert(!auth.is_expired());
+
+        // Refresh due an hour out: start() doesn't refresh, the listener gets the login tokens
+        TokenRefresher tr(auth, log, {});
+        std::vector<std::string> seen;
+        tr.add_listener([&seen](const Auth::Tokens& t) { seen.push_back(t.access_token); });
+        assert(seen.size() == 1 && seen[0] == auth.tokens().access_token);
+        assert(tr.start());
+        const auto st = tr.stats();
+        assert(st.refreshes == 0 && st.next > system_clock::now() + minutes(45) && st.next <= exp - minutes(10));
+        tr.stop();
+    }
+
+    // Short-lived tokens are renewed ahead of expiry, listeners in order
+    {
+        {
+            std::lock_guard<std::mutex> lk(as.mu);
+            as.ttl = 2;
+        }
+        Auth auth(cfg, http, log, srv.url());
+        assert(auth.login_with_totp("123456"));
+        TokenRefresher::Options o;
+        o.lead = milliseconds(1500);
+        o.min_interval = milliseconds(100);
+        o.retry_initial = milliseconds(50);
+        o.retry_max = milliseconds(200);
+        TokenRefresher tr(auth, log, o);
+        std::mutex mu;
+        std::vector<std::string> seen;
+        tr.add_listener([&](const Auth::Tokens& t) {
+            std::lock_guard<std::mutex> lk(mu);
+            seen.push_back(t.access_token);
+            assert(t.expires_at > system_clock::now() + seconds(1));
+        });
+        assert(tr.start());
+        assert(wait_for([&] { return tr.stats().refreshes >= 3; }));
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            assert(seen.size() >= 4);
+            for (std::size_t i = 1; i < seen.size(); ++i) assert(seen[i] != seen[i - 1]);
+        }
+        // never let the token lapse
+        assert(!auth.is_expired(seconds(0)));
+
+        // Failures are retried with backoff, then it recovers
+        {
+            std::lock_guard<std::mutex> lk(as.mu);
+            as.fail_refreshes = 3;
+        }
+        const auto ok_before = tr.stats().refreshes;
+        assert(wait_for([&] { return tr.stats().failures >= 3 && tr.stats().refreshes > ok_before; }));
+        assert(tr.stats().failures == 3 && tr.stats().relogins == 0);
+        tr.stop();
+    }
+
+    // A dead refresh token: once the session expires, relogin takes over
+    {
+        Auth auth(cfg, http, log, srv.url());
+        assert(auth.login_with_totp("123456"));
+        {
+            std::lock_guard<std::mutex> lk(as.mu);
+            as.refresh_dead = true;
+        }
+        TokenRefresher::Options o;
+        o.lead = milliseconds(500);
+        o.min_interval = milliseconds(100);
+        o.retry_initial = milliseconds(100);
+        o.retry_max = milliseconds(200);
+        std::atomic<int> relogins{0};
+        o.relogin = [&relogins](Auth& a) {
+            ++relogins;
+            return a.login_with_totp("123456");
+        };
+        TokenRefresher tr(auth, log, o);
+        const auto first = auth.tokens().access_token;
+        assert(tr.start());
+        assert(wait_for([&] { return tr.stats().relogins >= 1; }));
+        assert(relogins >= 1 && tr.stats().failures >= 1 && auth.tokens().access_token != first);
+        tr.stop();
+        std::lock_guard<std::mutex> lk(as.mu);
+        as.refresh_dead = false;
+        as.ttl = 0;
+    }
+
+    // Hot swap: after a refresh, every shard reconnects with the new token on its
+    // first attempt
+    {
+        Auth auth(cfg, http, log, srv.url());
+        assert(auth.login_with_totp("123456"));
+
+        MarketDataServer md(log, MarketDataServer::Options{});
+        md.set_authorization("Bearer " + auth.tokens().access_token);
+        assert(md.start());
+
+        Parser parser;
+        parser.set_strip_prefix("nse_cm|");
+        LTPStore store;
+        Sharder::Options so;
+        so.wss_url = md.url();
+        so.ca_file = md.cert_file();
+        so.max_tokens_per_conn = 1;
+        so.hot_standby = true;
+        Sharder sharder(log, parser, store, so);
+        sharder.set_tokens({"26000", "26001"});
+
+        TokenRefresher tr(auth, log, {});
+        tr.add_listener([&sharder](const Auth::Tokens& t) {
+            sharder.set_access_token("Bearer " + t.access_token, {{"x-feed-token", t.feed_token}});
+        });
+        assert(sharder.start());
+        // 2 shards x (active + standby)
+        assert(wait_for([&] { return md.stats().live_sessions == 4; }));
+
+        assert(tr.refresh_now());
+        md.set_authorization("Bearer " + auth.tokens().access_token);
+        const auto sessions = md.stats().sessions;
+        md.drop_all();
+        assert(wait_for([&] { return md.stats().sessions >= sessions + 4 && md.stats().live_sessions == 4; }));
+        assert(md.stats().rejected == 0);
+
+        // and a stale token would have been refused
+        md.set_authorization("Bearer stale");
+        md.drop_all();
+        assert(wait_for([&] { return md.stats().rejected >= 1; }));
+        sharder.stop();
+        md.stop();
+    }
+
+    srv.stop();
+    std::filesystem::remove(cfg_path);
+    std::cout << "token refresher test finished\n";
+    return 0;
+}
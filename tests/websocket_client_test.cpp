@@ -1,21 +1,17 @@
 #include "websocket_client.h"
+#include "market_data_server.h"
 #include "logger.h"
 
+#include <atomic>
 #include <chrono>
 #include <future>
 #include <iostream>
 #include <string>
 #include <thread>
+#include <vector>
 
-int main() {
-    Logger log("ws_test");
-    // Public echo WSS (override via WS_URL env if you want)
-    const char* env = std::getenv("WS_URL");
-    std::string url = env ? env : "wss://echo.websocket.events";
-
-    WebSocketClient::Options opts{};
-    WebSocketClient ws(url, log, opts);
-
+// Send "hello" once connected and wait up to 5s for the echo. Returns 0 on success.
+static int run_echo(WebSocketClient& ws, Logger& log) {
     std::promise<std::string> got;
     auto fut = got.get_future();
 
@@ -50,9 +46,138 @@ int main() {
         ws.stop();
         return 2;
     }
-
-    std::cout << "WebSocket echo test passed.\n";
     ws.stop();
     return 0;
 }
 
+int main() {
+    Logger log("ws_test");
+    // Local TLS server (echoes non-subscribe frames); override via WS_URL env
+    MarketDataServer::Options so;
+    so.deflate = true;
+    MarketDataServer server(log, so);
+    const char* env = std::getenv("WS_URL");
+    if (!env && !server.start()) return 50;
+    std::string url = env ? env : server.url();
+
+    WebSocketClient::Options opts{};
+    if (!env) opts.ca_file = server.cert_file();
+
+    // Thread-per-connection mode
+    {
+        WebSocketClient ws(url, log, opts);
+        if (int rc = run_echo(ws, log)) return rc;
+    }
+
+    // Async mode on a shared io_context pool
+    {
+        IoContextPool pool(log, IoContextPool::Options{1, {}, "ws-pool"});
+        pool.start();
+        WebSocketClient ws(url, log, opts, pool);
+        if (int rc = run_echo(ws, log)) return 10 + rc;
+        pool.stop();
+    }
+
+    // permessage-deflate offered + byte/CPU accounting
+    {
+        WebSocketClient::Options dopts = opts;
+        dopts.deflate = true;
+        dopts.deflate_window_bits = 12;
+        dopts.measure_read_cpu = true;
+        WebSocketClient ws(url, log, dopts);
+        if (int rc = run_echo(ws, log)) return 20 + rc;
+        const auto st = ws.stats();
+        log.info("deflate=" + std::to_string(st.deflate) +
+                 " rx=" + std::to_string(st.rx_bytes) + " rx_wire=" + std::to_string(st.rx_wire_bytes) +
+                 " tx=" + std::to_string(st.tx_bytes) + " tx_wire=" + std::to_string(st.tx_wire_bytes) +
+                 " read_cpu_ns=" + std::to_string(st.read_cpu_ns));
+        if (st.frames == 0 || st.rx_wire_bytes == 0 || st.tx_wire_bytes == 0 || st.tx_bytes < 5) {
+            std::cerr << "WebSocket echo test: byte counters not populated\n";
+            return 30;
+        }
+    }
+
+    // Concurrent senders, no external locking; queued frames coalesce
+    {
+        WebSocketClient ws(url, log, opts);
+        std::promise<void> up, done;
+        std::atomic<int> xs{0};
+        ws.on_state([&](const std::string& s){ if (s == "connected") up.set_value(); });
+        ws.on_message([&](const std::string& msg){
+            int n = 0;
+            for (char c : msg) n += (c == 'x');
+            if (n && xs.fetch_add(n) + n == 400) done.set_value();
+        });
+        ws.set_coalescer([](std::string& pending, const std::string& next) {
+            if (pending.size() + next.size() > 64) return false;
+            pending += next;
+            return true;
+        });
+        ws.start();
+        if (up.get_future().wait_for(std::chrono::seconds(5)) != std::future_status::ready) return 40;
+        std::vector<std::thread> senders;
+        for (int t = 0; t < 4; ++t) {
+            senders.emplace_back([&ws] { for (int i = 0; i < 100; ++i) ws.send_text("x"); });
+        }
+        for (auto& t : senders) t.join();
+        if (done.get_future().wait_for(std::chrono::seconds(5)) != std::future_status::ready) {
+            std::cerr << "WebSocket echo test: lost frames, got " << xs.load() << " of 400\n";
+            return 41;
+        }
+        const auto st = ws.stats();
+        log.info("write_queue_peak=" + std::to_string(st.write_queue_peak) +
+                 " coalesced=" + std::to_string(st.coalesced));
+        ws.stop();
+    }
+
+    // A non-string action is just text to the local server: echoed, and it stays up
+    if (!env) {
+        WebSocketClient ws(url, log, opts);
+        std::promise<void> up, echoed;
+        ws.on_state([&](const std::string& s){ if (s == "connected") up.set_value(); });
+        ws.on_message([&](const std::string& msg){ if (msg == "after") echoed.set_value(); });
+        ws.start();
+        if (up.get_future().wait_for(std::chrono::seconds(5)) != std::future_status::ready) return 70;
+        ws.send_text(R"({"action":1,"tokens":["nse_cm|27000"]})");
+        ws.send_text(R"({"action":["subscribe"]})");
+        ws.send_text("after");
+        if (echoed.get_future().wait_for(std::chrono::seconds(5)) != std::future_status::ready) return 71;
+        ws.stop();
+    }
+
+    // Streaming: subscribed instruments tick without any client traffic
+    if (!env) {
+        server.set_rate("nse_cm|27000", 500);
+        WebSocketClient ws(url, log, opts);
+        std::promise<void> up, ticked;
+        std::atomic<int> ticks{0};
+        ws.on_state([&](const std::string& s){ if (s == "connected") up.set_value(); });
+        ws.on_message([&](const std::string& msg){
+            if (msg.find("nse_cm|27000") != std::string::npos && ++ticks == 20) ticked.set_value();
+        });
+        std::atomic<bool> gate_open{true};
+        ws.set_read_gate([&] { return gate_open.load(); });
+        ws.start();
+        if (up.get_future().wait_for(std::chrono::seconds(5)) != std::future_status::ready) return 60;
+        ws.send_text(R"({"action":"subscribe","mode":"ltp","tokens":["nse_cm|27000"]})");
+        if (ticked.get_future().wait_for(std::chrono::seconds(5)) != std::future_status::ready) {
+            std::cerr << "WebSocket echo test: no ticks from local server\n";
+            return 61;
+        }
+        // Closed read gate: delivery stops (at most the frame in hand), then resumes
+        gate_open = false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        const int held = ticks.load();
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        if (ticks.load() > held + 1) return 63;
+        gate_open = true;
+        for (int i = 0; i < 100 && ticks.load() < held + 20; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (ticks.load() < held + 20 || ws.stats().read_pauses == 0) return 64;
+        ws.stop();
+        const auto st = server.stats();
+        if (st.subscribes == 0 || st.ticks == 0 || st.frames_sent < 20) return 62;
+    }
+
+    std::cout << "WebSocket echo test passed.\n";
+    return 0;
+}
@@ -0,0 +1,46 @@
+// tools/binlog_decode.cpp
+// Render a BinaryLogger file as text (see include/binary_log.h).
+//
+//   binlog_decode [-l] <file.binlog> [out.txt]
+//     -l   append the call site (file:line) to every line
+#include "binary_log.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+    BinaryLogDecodeOptions opts;
+    int i = 1;
+    if (i < argc && std::strcmp(argv[i], "-l") == 0) {
+        opts.show_location = true;
+        ++i;
+    }
+    if (i >= argc) {
+        std::cerr << "usage: " << argv[0] << " [-l] <file.binlog> [out.txt]\n";
+        return 2;
+    }
+    std::ifstream in(argv[i], std::ios::binary);
+    if (!in) {
+        std::cerr << "cannot open " << argv[i] << "\n";
+        return 1;
+    }
+    std::ofstream file;
+    if (i + 1 < argc) {
+        file.open(argv[i + 1], std::ios::trunc);
+        if (!file) {
+            std::cerr << "cannot create " << argv[i + 1] << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = file.is_open() ? static_cast<std::ostream&>(file) : std::cout;
+
+    std::string err;
+    if (!decode_binary_log(in, out, opts, &err)) {
+        out.flush();
+        std::cerr << argv[i] << ": " << err << "\n";
+        return 1;
+    }
+    return 0;
+}